@@ -214,6 +214,9 @@ const uint8_t app_info_tags[] =
     NANOHUB_HAL_APP_INFO_BSS,
     NANOHUB_HAL_APP_INFO_CHRE_MAJOR,
     NANOHUB_HAL_APP_INFO_CHRE_MINOR,
+    NANOHUB_HAL_APP_INFO_CPU_TIME,
+    NANOHUB_HAL_APP_INFO_CPU_MAX,
+    NANOHUB_HAL_APP_INFO_EVT_COUNT,
     NANOHUB_HAL_APP_INFO_END,
 };
 
@@ -970,6 +973,17 @@ void SystemComm::AppManager::dumpAppInfo(std::string &result)
                     app->chre_major, app->chre_minor);
                 result.append(buffer);
             }
+
+            if (app->running && app->cpu_valid) {
+                snprintf(buffer, sizeof(buffer),
+                    "  cpuTime: %" PRIu64 " us\n"
+                    "  cpuMax: %" PRIu32 " us\n"
+                    "  events: %" PRIu32 "\n",
+                    app->cpu_time_us,
+                    app->cpu_max_us,
+                    app->evt_count);
+                result.append(buffer);
+            }
         }
 
         if (app->cached_napp) {
@@ -1078,6 +1092,7 @@ bool SystemComm::AppManager::restoreApps()
             apps_[id]->loaded = false;
             apps_[id]->running = false;
             apps_[id]->chre = false;
+            apps_[id]->cpu_valid = false;
             apps_[id]->cached_napp = true;
             apps_[id]->cached_version = version;
             apps_[id]->cached_start = start;
@@ -1209,6 +1224,7 @@ uint32_t SystemComm::AppManager::readNanohubAppInfo(MessageBuf &buf)
         apps_[name.id]->cached_napp = false;
     }
     const auto &app = apps_[name.id];
+    app->cpu_valid = false;
 
     while (buf.getRoom() >= 2) {
         tag = buf.readU8();
@@ -1284,6 +1300,25 @@ uint32_t SystemComm::AppManager::readNanohubAppInfo(MessageBuf &buf)
                 } else
                     buf.readRaw(len);
                 break;
+            case NANOHUB_HAL_APP_INFO_CPU_TIME:
+                if (len == sizeof(app->cpu_time_us)) {
+                    app->cpu_valid = true;
+                    app->cpu_time_us = buf.readU64();
+                } else
+                    buf.readRaw(len);
+                break;
+            case NANOHUB_HAL_APP_INFO_CPU_MAX:
+                if (len == sizeof(app->cpu_max_us))
+                    app->cpu_max_us = buf.readU32();
+                else
+                    buf.readRaw(len);
+                break;
+            case NANOHUB_HAL_APP_INFO_EVT_COUNT:
+                if (len == sizeof(app->evt_count))
+                    app->evt_count = buf.readU32();
+                else
+                    buf.readRaw(len);
+                break;
             case NANOHUB_HAL_APP_INFO_END:
                 if (len != 0 || buf.getRoom() != 0) {
                     ALOGE("%s: failed to read object", __func__);
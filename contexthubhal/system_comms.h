@@ -61,6 +61,9 @@
 #define NANOHUB_HAL_APP_INFO_BSS            0x08
 #define NANOHUB_HAL_APP_INFO_CHRE_MAJOR     0x09
 #define NANOHUB_HAL_APP_INFO_CHRE_MINOR     0x0A
+#define NANOHUB_HAL_APP_INFO_CPU_TIME       0x0B
+#define NANOHUB_HAL_APP_INFO_CPU_MAX        0x0C
+#define NANOHUB_HAL_APP_INFO_EVT_COUNT      0x0D
 #define NANOHUB_HAL_APP_INFO_END            0xFF
 
 #define NANOHUB_HAL_SYS_INFO      0x13
@@ -315,6 +318,10 @@ private:
             uint8_t chre_major, chre_minor;
             bool chre, running, loaded;
 
+            bool cpu_valid;
+            uint64_t cpu_time_us;
+            uint32_t cpu_max_us, evt_count;
+
             bool cached_start, cached_napp;
             uint32_t cached_version, cached_crc;
         };
@@ -28,19 +28,24 @@ LOCAL_MODULE_TAGS := optional
 
 LOCAL_SRC_FILES := \
     os/core/appSec.c \
+    os/core/bootCache.c \
     os/core/eventQ.c \
     os/core/floatRt.c \
     os/core/heap.c \
     os/core/hostIntf.c \
     os/core/hostIntfI2c.c \
     os/core/hostIntfSpi.c \
+    os/core/loadGovernor.c \
     os/core/nanohubCommand.c \
     os/core/nanohub_chre.c \
     os/core/osApi.c \
+    os/core/poolStats.c \
     os/core/printf.c \
     os/core/sensors.c \
     os/core/seos.c \
     os/core/simpleQ.c \
+    os/core/sleepPlanner.c \
+    os/core/sleepStats.c \
     os/core/syscall.c \
     os/core/slab.c \
     os/core/spi.c \
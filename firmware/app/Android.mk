@@ -14,5 +14,5 @@
 # limitations under the License.
 #
 
-subdirs := test0.app test1.app chre
+subdirs := test0.app test1.app test2.app chre
 include $(call all-named-subdir-makefiles,$(subdirs))
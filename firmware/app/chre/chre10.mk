@@ -30,4 +30,8 @@ CFLAGS += $(COMMON_FLAGS)
 BIN_POSTPROCESS_ARGS := -c 0x0100
 CFLAGS += -I$(NANOHUB_DIR)/../../../../system/chre/chre_api/legacy/v1_0
 
+ifeq ($(CHRE_HOST_RUNNER),true)
+include $(NANOHUB_DIR)/app/chre/host/host.mk
+else
 include $(NANOHUB_DIR)/app/app.mk
+endif
@@ -89,7 +89,11 @@ void nanoappHandleEvent(uint32_t srcTid, uint16_t evtType, const void* evtData)
                                ") cnt: %d\n", t->timerId, chreGetTime(), mCnt);
         extMsg->msg = 0x01;
         extMsg->val = mCnt;
+#if CHRE_API_VERSION == CHRE_API_VERSION_1_0
+        chreSendMessageToHost(extMsg, sizeof(*extMsg), 0, nanoappFreeMessage);
+#else
         chreSendMessageToHostEndpoint(extMsg, sizeof(*extMsg), 0, CHRE_HOST_ENDPOINT_BROADCAST, nanoappFreeMessage);
+#endif
         if (mCnt-- <= 0)
             chreTimerCancel(t->timerId);
         break;
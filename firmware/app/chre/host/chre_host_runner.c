@@ -0,0 +1,1389 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * CHRE nanoapp host runner.
+ *
+ * Links a nanoapp together with the CHRE 1.0/1.1 app shims into a Linux
+ * executable and plays the part of the hub OS: it serves the CHRE (and the few
+ * OS) syscalls the shims issue, drives the app from a recorded trace of sensor
+ * samples and host messages on a virtual clock, fires its timers, and reports
+ * per-callback CPU time, heap usage and host traffic at the end of the run.
+ *
+ * Trace format: one record per line, '#' starts a comment, timestamps are in
+ * nanoseconds of virtual time and must not decrease:
+ *
+ *   <time> sensor <type> <v0> [<v1> <v2>]    sample for sensor <type>
+ *   <time> host <msgType> [<hex payload>]    message from host to the app
+ *
+ * <type> is a SENS_TYPE_* number or one of the names in mSensorNames below.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <cpu/syscallDo.h>
+#include <eventnums.h>
+#include <nanohub/nanohub.h>
+#include <osApi.h>
+#include <sensors.h>
+#include <seos.h>
+#include <seos_priv.h>
+#include <syscall.h>
+#include <timer.h>
+#include <util.h>
+
+#include <chre.h>
+#include <chreApi.h>
+#include <crt_priv.h>
+
+#ifndef APP_ID
+#define APP_ID                  0
+#endif
+
+#ifndef APP_VERSION
+#define APP_VERSION             0
+#endif
+
+#define RUNNER_APP_TID          1
+#define RUNNER_MAX_TIMERS       32
+#define RUNNER_MAX_EVENTS       64
+#define RUNNER_MAX_BATCH        64
+#define RUNNER_DEFAULT_DURATION UINT64_C(10000000000) // 10 s of virtual time without a trace
+
+/* CHRE 1.0 has no host endpoints; its messages go to all of them */
+#ifndef CHRE_HOST_ENDPOINT_BROADCAST
+#define CHRE_HOST_ENDPOINT_BROADCAST    UINT16_C(0xFFFF)
+#endif
+
+enum RunnerStat {
+    STAT_START,
+    STAT_END,
+    STAT_TIMER,
+    STAT_SENSOR_DATA,
+    STAT_SAMPLING_CHANGE,
+    STAT_HOST_MSG,
+    STAT_USER_EVT,
+    STAT_FREE_CB,
+    STAT_NUM,
+};
+
+struct CallStats {
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
+};
+
+enum EvtOwner {
+    EVT_OWNER_NONE,         // nothing to free
+    EVT_OWNER_RUNNER,       // allocated by us with malloc()
+    EVT_OWNER_APP,          // app's chreSendEvent() data, call its free callback
+};
+
+struct PendingEvt {
+    uint32_t evtType;
+    uint32_t srcTid;
+    void *evtData;
+    enum EvtOwner owner;
+    chreEventCompleteFunction *freeCallback;
+    enum RunnerStat stat;
+};
+
+struct HostTimer {
+    uint32_t id;
+    uint64_t deadline;
+    uint64_t period;
+    const void *cookie;
+    bool oneShot;
+    struct TimerEvent evt;
+};
+
+struct HostSensor {
+    struct SensorInfo si;
+    uint32_t reqRate;
+    uint64_t reqLatency;
+    bool subscribed;
+    uint64_t lastSampleTime;
+    uint64_t batchStart;
+    uint32_t batchLen;
+    uint64_t batchTime[RUNNER_MAX_BATCH];
+    float batchVal[RUNNER_MAX_BATCH][3];
+    uint64_t samplesIn;
+    uint64_t samplesDelivered;
+    uint64_t eventsDelivered;
+};
+
+struct HeapHdr {
+    uint64_t size; // keeps the payload 8-byte aligned on all hosts
+};
+
+struct TraceRecord {
+    uint64_t time;
+    bool valid;
+    bool isSensor;
+    uint32_t sensorType;
+    float val[3];
+    uint32_t msgType;
+    uint32_t msgLen;
+    uint8_t msg[CHRE_MESSAGE_TO_HOST_MAX_SIZE];
+};
+
+static const uint32_t mContinuousRates[] = {
+    SENSOR_HZ(12.5f), SENSOR_HZ(25.0f), SENSOR_HZ(50.0f), SENSOR_HZ(100.0f), SENSOR_HZ(200.0f), 0,
+};
+
+static const uint32_t mOnchangeRates[] = {
+    SENSOR_RATE_ONCHANGE, 0,
+};
+
+static const uint32_t mOneshotRates[] = {
+    SENSOR_RATE_ONESHOT, 0,
+};
+
+static struct HostSensor mSensors[] = {
+    { .si = { "Accelerometer", mContinuousRates, SENS_TYPE_ACCEL,     NUM_AXIS_THREE    } },
+    { .si = { "Gyroscope",     mContinuousRates, SENS_TYPE_GYRO,      NUM_AXIS_THREE    } },
+    { .si = { "Magnetometer",  mContinuousRates, SENS_TYPE_MAG,       NUM_AXIS_THREE    } },
+    { .si = { "Pressure",      mContinuousRates, SENS_TYPE_BARO,      NUM_AXIS_ONE      } },
+    { .si = { "ALS",           mOnchangeRates,   SENS_TYPE_ALS,       NUM_AXIS_EMBEDDED } },
+    { .si = { "Proximity",     mOnchangeRates,   SENS_TYPE_PROX,      NUM_AXIS_EMBEDDED } },
+    { .si = { "Any Motion",    mOneshotRates,    SENS_TYPE_ANY_MOTION, NUM_AXIS_EMBEDDED } },
+    { .si = { "No Motion",     mOneshotRates,    SENS_TYPE_NO_MOTION, NUM_AXIS_EMBEDDED } },
+};
+
+static const struct {
+    const char *name;
+    uint32_t type;
+} mSensorNames[] = {
+    { "accel",  SENS_TYPE_ACCEL },
+    { "gyro",   SENS_TYPE_GYRO },
+    { "mag",    SENS_TYPE_MAG },
+    { "baro",   SENS_TYPE_BARO },
+    { "als",    SENS_TYPE_ALS },
+    { "prox",   SENS_TYPE_PROX },
+    { "motion", SENS_TYPE_ANY_MOTION },
+    { "still",  SENS_TYPE_NO_MOTION },
+};
+
+static const char * const mStatNames[STAT_NUM] = {
+    [STAT_START]            = "nanoappStart",
+    [STAT_END]              = "nanoappEnd",
+    [STAT_TIMER]            = "timer",
+    [STAT_SENSOR_DATA]      = "sensor data",
+    [STAT_SAMPLING_CHANGE]  = "sampling change",
+    [STAT_HOST_MSG]         = "host message",
+    [STAT_USER_EVT]         = "user event",
+    [STAT_FREE_CB]          = "free callback",
+};
+
+static uint64_t mNow;
+static bool mVerbose;
+static bool mQuiet;
+static bool mAborted;
+static uint32_t mAbortCode;
+static jmp_buf mAbortJmp;
+static bool mInApp;
+
+static struct CallStats mStats[STAT_NUM];
+
+static struct PendingEvt mEvtQ[RUNNER_MAX_EVENTS];
+static uint32_t mEvtQHead, mEvtQLen;
+static uint64_t mEvtQDrops;
+
+static struct HostTimer mTimers[RUNNER_MAX_TIMERS];
+static uint32_t mNextTimerId = 1;
+
+static uint64_t mHeapLimit;
+static uint64_t mHeapCur, mHeapPeak;
+static uint64_t mHeapAllocs, mHeapFrees, mHeapFails;
+
+static uint64_t mMsgsToHost, mMsgBytesToHost, mMsgsToHostFailed;
+static uint32_t mMsgMaxToHost;
+static uint64_t mUnhandledSyscalls;
+
+static FILE *mTraceFile;
+static uint32_t mTraceLine;
+static struct TraceRecord mTraceNext;
+
+/* the app's entry points; provided by the CHRE shim (chre_app.c / chre10_app.c) */
+extern const struct AppFuncs _mAppFuncs;
+
+/* the shims run __crt_init()/__crt_exit(); on the host libc did that for us */
+void __crt_init(void)
+{
+}
+
+void __crt_exit(void)
+{
+}
+
+static uint64_t runnerCpuNs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+static void runnerAccount(enum RunnerStat stat, uint64_t startNs)
+{
+    uint64_t ns = runnerCpuNs() - startNs;
+
+    mStats[stat].count++;
+    mStats[stat].totalNs += ns;
+    if (ns > mStats[stat].maxNs)
+        mStats[stat].maxNs = ns;
+}
+
+static struct HostSensor *runnerSensorByHandle(uint32_t handle)
+{
+    if (!handle || handle > ARRAY_SIZE(mSensors))
+        return NULL;
+
+    return &mSensors[handle - 1];
+}
+
+static struct HostSensor *runnerSensorByType(uint32_t sensorType, uint32_t *handleP)
+{
+    uint32_t i;
+
+    for (i = 0; i < ARRAY_SIZE(mSensors); i++) {
+        if (mSensors[i].si.sensorType == sensorType) {
+            if (handleP)
+                *handleP = i + 1;
+            return &mSensors[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool runnerEnqueue(uint32_t evtType, void *evtData, enum EvtOwner owner,
+                          chreEventCompleteFunction *freeCallback, uint32_t srcTid, enum RunnerStat stat)
+{
+    struct PendingEvt *evt;
+
+    if (mEvtQLen == RUNNER_MAX_EVENTS) {
+        mEvtQDrops++;
+        if (owner == EVT_OWNER_RUNNER)
+            free(evtData);
+        return false;
+    }
+
+    evt = &mEvtQ[(mEvtQHead + mEvtQLen++) % RUNNER_MAX_EVENTS];
+    evt->evtType = evtType;
+    evt->srcTid = srcTid;
+    evt->evtData = evtData;
+    evt->owner = owner;
+    evt->freeCallback = freeCallback;
+    evt->stat = stat;
+
+    return true;
+}
+
+/*
+ * Every entry into app code goes through here, so CPU time is charged to the
+ * right bucket and chreAbort() can unwind back to the runner loop.
+ */
+static void runnerAppHandle(uint32_t evtType, uint32_t srcTid, const void *evtData, enum RunnerStat stat)
+{
+    uint64_t start;
+
+    if (mAborted)
+        return;
+
+    start = runnerCpuNs();
+    mInApp = true;
+    if (!setjmp(mAbortJmp))
+        _mAppFuncs.handle(EVENT_WITH_ORIGIN(evtType, srcTid), evtData);
+    mInApp = false;
+    runnerAccount(stat, start);
+}
+
+static void runnerAppFreeEvent(chreEventCompleteFunction *freeCallback, uint16_t evtType, void *evtData)
+{
+    uint64_t start;
+
+    if (!freeCallback || mAborted)
+        return;
+
+    start = runnerCpuNs();
+    mInApp = true;
+    if (!setjmp(mAbortJmp))
+        freeCallback(evtType, evtData);
+    mInApp = false;
+    runnerAccount(STAT_FREE_CB, start);
+}
+
+static void runnerAppFreeMessage(chreMessageFreeFunction *freeCallback, void *message, size_t messageSize)
+{
+    uint64_t start;
+
+    if (!freeCallback || mAborted)
+        return;
+
+    /* may be called from within a syscall, in which case time is already being charged */
+    if (mInApp) {
+        freeCallback(message, messageSize);
+        return;
+    }
+
+    start = runnerCpuNs();
+    mInApp = true;
+    if (!setjmp(mAbortJmp))
+        freeCallback(message, messageSize);
+    mInApp = false;
+    runnerAccount(STAT_FREE_CB, start);
+}
+
+static void runnerDrainEvents(void)
+{
+    struct PendingEvt evt;
+
+    while (mEvtQLen && !mAborted) {
+        evt = mEvtQ[mEvtQHead];
+        mEvtQHead = (mEvtQHead + 1) % RUNNER_MAX_EVENTS;
+        mEvtQLen--;
+
+        runnerAppHandle(evt.evtType, evt.srcTid, evt.evtData, evt.stat);
+
+        if (evt.owner == EVT_OWNER_RUNNER)
+            free(evt.evtData);
+        else if (evt.owner == EVT_OWNER_APP)
+            runnerAppFreeEvent(evt.freeCallback, evt.evtType, evt.evtData);
+    }
+}
+
+/*
+ * Heap
+ */
+
+static void *runnerHeapAlloc(uint32_t size)
+{
+    struct HeapHdr *hdr;
+
+    if (mHeapLimit && mHeapCur + size > mHeapLimit) {
+        mHeapFails++;
+        return NULL;
+    }
+
+    hdr = malloc(sizeof(*hdr) + size);
+    if (!hdr) {
+        mHeapFails++;
+        return NULL;
+    }
+
+    hdr->size = size;
+    mHeapCur += size;
+    mHeapAllocs++;
+    if (mHeapCur > mHeapPeak)
+        mHeapPeak = mHeapCur;
+
+    return hdr + 1;
+}
+
+static void runnerHeapFree(void *ptr)
+{
+    struct HeapHdr *hdr;
+
+    if (!ptr)
+        return;
+
+    hdr = (struct HeapHdr *)ptr - 1;
+    mHeapCur -= hdr->size;
+    mHeapFrees++;
+    free(hdr);
+}
+
+/*
+ * Timers
+ */
+
+static uint32_t runnerTimerSet(uint64_t duration, const void *cookie, bool oneShot)
+{
+    uint32_t i;
+
+    for (i = 0; i < RUNNER_MAX_TIMERS; i++) {
+        if (!mTimers[i].id) {
+            mTimers[i].id = mNextTimerId++;
+            if (!mNextTimerId)
+                mNextTimerId = 1;
+            mTimers[i].deadline = mNow + duration;
+            mTimers[i].period = duration;
+            mTimers[i].cookie = cookie;
+            mTimers[i].oneShot = oneShot;
+            return mTimers[i].id;
+        }
+    }
+
+    return CHRE_TIMER_INVALID;
+}
+
+static bool runnerTimerCancel(uint32_t timerId)
+{
+    uint32_t i;
+
+    for (i = 0; i < RUNNER_MAX_TIMERS; i++) {
+        if (mTimers[i].id && mTimers[i].id == timerId) {
+            mTimers[i].id = 0;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static struct HostTimer *runnerTimerNext(void)
+{
+    struct HostTimer *next = NULL;
+    uint32_t i;
+
+    for (i = 0; i < RUNNER_MAX_TIMERS; i++)
+        if (mTimers[i].id && (!next || mTimers[i].deadline < next->deadline))
+            next = &mTimers[i];
+
+    return next;
+}
+
+static void runnerTimerFire(struct HostTimer *tim)
+{
+    /* deliver synchronously: the event data lives in the timer slot */
+    tim->evt.timerId = tim->id;
+    tim->evt.data = (void *)tim->cookie;
+
+    if (tim->oneShot)
+        tim->id = 0;
+    else
+        tim->deadline += tim->period ? tim->period : 1;
+
+    runnerAppHandle(EVT_APP_TIMER, 0, &tim->evt, STAT_TIMER);
+}
+
+/*
+ * Sensors
+ */
+
+static void runnerSensorSendRateChange(uint32_t handle, struct HostSensor *s)
+{
+    struct SensorRateChangeEvent *evt = malloc(sizeof(*evt));
+
+    if (!evt)
+        return;
+
+    evt->sensorHandle = handle;
+    evt->newRate = s->reqRate;
+    evt->newLatency = s->reqLatency;
+    runnerEnqueue(sensorGetMyCfgEventType(s->si.sensorType), evt, EVT_OWNER_RUNNER, NULL, 0, STAT_SAMPLING_CHANGE);
+}
+
+static void runnerSensorFlush(struct HostSensor *s)
+{
+    uint32_t i;
+
+    if (!s->batchLen)
+        return;
+
+    switch (s->si.numAxis) {
+    case NUM_AXIS_THREE: {
+        struct TripleAxisDataEvent *evt = malloc(sizeof(*evt) + s->batchLen * sizeof(evt->samples[0]));
+
+        if (!evt)
+            break;
+        evt->referenceTime = s->batchTime[0];
+        for (i = 0; i < s->batchLen; i++) {
+            if (i)
+                evt->samples[i].deltaTime = s->batchTime[i] - s->batchTime[i - 1];
+            evt->samples[i].x = s->batchVal[i][0];
+            evt->samples[i].y = s->batchVal[i][1];
+            evt->samples[i].z = s->batchVal[i][2];
+        }
+        memset(&evt->samples[0].firstSample, 0, sizeof(evt->samples[0].firstSample));
+        evt->samples[0].firstSample.numSamples = s->batchLen;
+        runnerEnqueue(sensorGetMyEventType(s->si.sensorType), evt, EVT_OWNER_RUNNER, NULL, 0, STAT_SENSOR_DATA);
+        break;
+    }
+    case NUM_AXIS_ONE: {
+        struct SingleAxisDataEvent *evt = malloc(sizeof(*evt) + s->batchLen * sizeof(evt->samples[0]));
+
+        if (!evt)
+            break;
+        evt->referenceTime = s->batchTime[0];
+        for (i = 0; i < s->batchLen; i++) {
+            if (i)
+                evt->samples[i].deltaTime = s->batchTime[i] - s->batchTime[i - 1];
+            evt->samples[i].fdata = s->batchVal[i][0];
+        }
+        memset(&evt->samples[0].firstSample, 0, sizeof(evt->samples[0].firstSample));
+        evt->samples[0].firstSample.numSamples = s->batchLen;
+        runnerEnqueue(sensorGetMyEventType(s->si.sensorType), evt, EVT_OWNER_RUNNER, NULL, 0, STAT_SENSOR_DATA);
+        break;
+    }
+    default: {
+        /* embedded sensors carry one value and are never batched */
+        union EmbeddedDataPoint data;
+
+        data.vptr = NULL;
+        data.fdata = s->batchVal[0][0];
+        runnerEnqueue(sensorGetMyEventType(s->si.sensorType), data.vptr, EVT_OWNER_NONE, NULL, 0, STAT_SENSOR_DATA);
+        break;
+    }
+    }
+
+    s->samplesDelivered += s->batchLen;
+    s->eventsDelivered++;
+    s->batchLen = 0;
+}
+
+static bool runnerSensorBatching(const struct HostSensor *s)
+{
+    return s->si.numAxis != NUM_AXIS_EMBEDDED && s->reqLatency && s->reqLatency != SENSOR_LATENCY_NODATA;
+}
+
+static uint64_t runnerSensorInterval(const struct HostSensor *s)
+{
+    if (!s->reqRate || s->reqRate >= SENSOR_RATE_ONDEMAND)
+        return 0;
+
+    return UINT64_C(1024000000000) / s->reqRate;
+}
+
+static void runnerSensorSample(struct HostSensor *s, uint64_t time, const float *val)
+{
+    uint64_t interval = runnerSensorInterval(s);
+
+    s->samplesIn++;
+    if (!s->reqRate || !s->subscribed)
+        return;
+
+    /* decimate the trace down to the requested rate, allowing 1/8 jitter */
+    if (interval && s->lastSampleTime && time - s->lastSampleTime < interval - interval / 8)
+        return;
+    s->lastSampleTime = time;
+
+    if (!s->batchLen)
+        s->batchStart = time;
+    s->batchTime[s->batchLen] = time;
+    memcpy(s->batchVal[s->batchLen], val, sizeof(s->batchVal[0]));
+    s->batchLen++;
+
+    if (!runnerSensorBatching(s) || s->batchLen == RUNNER_MAX_BATCH)
+        runnerSensorFlush(s);
+
+    /* one-shot sensors turn themselves off after firing */
+    if (s->si.supportedRates == mOneshotRates)
+        s->reqRate = 0;
+}
+
+static uint64_t runnerSensorNextFlush(void)
+{
+    uint64_t next = UINT64_MAX;
+    uint32_t i;
+
+    for (i = 0; i < ARRAY_SIZE(mSensors); i++)
+        if (mSensors[i].batchLen && mSensors[i].batchStart + mSensors[i].reqLatency < next)
+            next = mSensors[i].batchStart + mSensors[i].reqLatency;
+
+    return next;
+}
+
+static void runnerSensorFlushDue(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < ARRAY_SIZE(mSensors); i++)
+        if (mSensors[i].batchLen && mSensors[i].batchStart + mSensors[i].reqLatency <= mNow)
+            runnerSensorFlush(&mSensors[i]);
+}
+
+static uint32_t runnerSensorPickRate(const struct HostSensor *s, uint32_t rate)
+{
+    const uint32_t *r = s->si.supportedRates;
+    uint32_t best = 0;
+
+    if (r[0] >= SENSOR_RATE_ONDEMAND)
+        return r[0];
+
+    /* like the hub, run at the lowest supported rate not below the request */
+    for (; *r; r++) {
+        best = *r;
+        if (*r >= rate)
+            break;
+    }
+
+    return best;
+}
+
+static bool runnerSensorConfigure(uint32_t handle, enum chreSensorConfigureMode mode,
+                                  uint64_t interval, uint64_t latency)
+{
+    struct HostSensor *s = runnerSensorByHandle(handle);
+    uint32_t rate;
+
+    if (!s)
+        return false;
+
+    if (mode & CHRE_SENSOR_CONFIGURE_RAW_POWER_ON) {
+        if (interval == CHRE_SENSOR_INTERVAL_DEFAULT || interval < 1000)
+            rate = s->si.supportedRates[0];
+        else
+            rate = UINT64_C(1024000000000) / interval;
+        if (!rate)
+            rate = 1;
+        if (latency == CHRE_SENSOR_LATENCY_DEFAULT)
+            latency = 0;
+
+        runnerSensorFlush(s);
+        s->reqRate = runnerSensorPickRate(s, rate);
+        s->reqLatency = latency;
+        s->subscribed = true;
+        s->lastSampleTime = 0;
+        runnerSensorSendRateChange(handle, s);
+    } else if (mode & (CHRE_SENSOR_CONFIGURE_RAW_REPORT_CONTINUOUS|CHRE_SENSOR_CONFIGURE_RAW_REPORT_ONE_SHOT)) {
+        s->subscribed = true;
+    } else {
+        runnerSensorFlush(s);
+        if (s->reqRate) {
+            s->reqRate = 0;
+            s->reqLatency = 0;
+            runnerSensorSendRateChange(handle, s);
+        }
+        s->subscribed = false;
+    }
+
+    return true;
+}
+
+/*
+ * Trace
+ */
+
+static bool runnerParseSensorType(const char *str, uint32_t *type)
+{
+    char *end;
+    uint32_t i;
+
+    for (i = 0; i < ARRAY_SIZE(mSensorNames); i++) {
+        if (!strcmp(str, mSensorNames[i].name)) {
+            *type = mSensorNames[i].type;
+            return true;
+        }
+    }
+
+    *type = strtoul(str, &end, 0);
+    return !*end && runnerSensorByType(*type, NULL);
+}
+
+static bool runnerParseHex(const char *str, uint8_t *buf, uint32_t *len)
+{
+    uint32_t n = 0;
+    unsigned int byte;
+
+    while (str[0] && str[1]) {
+        if (n == CHRE_MESSAGE_TO_HOST_MAX_SIZE || sscanf(str, "%2x", &byte) != 1)
+            return false;
+        buf[n++] = byte;
+        str += 2;
+    }
+    *len = n;
+
+    return !str[0];
+}
+
+static void runnerTraceAdvance(void)
+{
+    char line[1024], kind[16], arg[32], payload[2 * CHRE_MESSAGE_TO_HOST_MAX_SIZE + 1];
+    struct TraceRecord *rec = &mTraceNext;
+    uint64_t prevTime = rec->time;
+    char *hash;
+    int n;
+
+    rec->valid = false;
+    if (!mTraceFile)
+        return;
+
+    while (fgets(line, sizeof(line), mTraceFile)) {
+        mTraceLine++;
+        if ((hash = strchr(line, '#')) != NULL)
+            *hash = 0;
+        n = sscanf(line, "%" SCNu64 " %15s %31s", &rec->time, kind, arg);
+        if (n <= 0)
+            continue;
+        if (n < 3)
+            goto bad;
+
+        if (rec->time < prevTime) {
+            fprintf(stderr, "trace:%" PRIu32 ": timestamps must not decrease\n", mTraceLine);
+            exit(1);
+        }
+
+        if (!strcmp(kind, "sensor")) {
+            rec->isSensor = true;
+            rec->val[0] = rec->val[1] = rec->val[2] = 0.0f;
+            if (!runnerParseSensorType(arg, &rec->sensorType))
+                goto bad;
+            if (sscanf(line, "%*s %*s %*s %f %f %f", &rec->val[0], &rec->val[1], &rec->val[2]) < 1)
+                goto bad;
+        } else if (!strcmp(kind, "host")) {
+            rec->isSensor = false;
+            rec->msgType = strtoul(arg, NULL, 0);
+            rec->msgLen = 0;
+            payload[0] = 0;
+            sscanf(line, "%*s %*s %*s %256s", payload);
+            if (!runnerParseHex(payload, rec->msg, &rec->msgLen))
+                goto bad;
+        } else {
+            goto bad;
+        }
+
+        rec->valid = true;
+        return;
+    }
+
+    return;
+
+bad:
+    fprintf(stderr, "trace:%" PRIu32 ": malformed record\n", mTraceLine);
+    exit(1);
+}
+
+static void runnerTraceDispatch(const struct TraceRecord *rec)
+{
+    if (rec->isSensor) {
+        runnerSensorSample(runnerSensorByType(rec->sensorType, NULL), rec->time, rec->val);
+    } else {
+#if CHRE_API_VERSION == CHRE_API_VERSION_1_0
+        struct NanohubMsgChreHdrV10 *hdr = malloc(sizeof(*hdr) + rec->msgLen);
+#else
+        struct NanohubMsgChreHdr *hdr = malloc(sizeof(*hdr) + rec->msgLen);
+#endif
+
+        if (!hdr)
+            return;
+        hdr->size = rec->msgLen;
+        hdr->appEvent = rec->msgType;
+#if CHRE_API_VERSION != CHRE_API_VERSION_1_0
+        hdr->endpoint = CHRE_HOST_ENDPOINT_UNSPECIFIED;
+#endif
+        memcpy(hdr + 1, rec->msg, rec->msgLen);
+        runnerEnqueue(EVT_APP_FROM_HOST_CHRE, hdr, EVT_OWNER_RUNNER, NULL, 0, STAT_HOST_MSG);
+    }
+}
+
+/*
+ * Syscalls
+ */
+
+uintptr_t cpuSyscallDo(uint32_t syscallNo, void *vaListPtr)
+{
+    SyscallFunc handler = syscallGetHandler(syscallNo);
+    uintptr_t ret = 0;
+
+    if (handler) {
+        handler(&ret, *(va_list *)vaListPtr);
+    } else {
+        if (!mUnhandledSyscalls++ || mVerbose)
+            fprintf(stderr, "runner: unhandled syscall 0x%08" PRIX32 "\n", syscallNo);
+    }
+
+    return ret;
+}
+
+static void runnerOsSensorFind(uintptr_t *retValP, va_list args)
+{
+    uint32_t sensorType = va_arg(args, uint32_t);
+    uint32_t idx = va_arg(args, uint32_t);
+    uint32_t *handleP = va_arg(args, uint32_t *);
+    struct HostSensor *s = idx ? NULL : runnerSensorByType(sensorType, handleP);
+
+    *retValP = (uintptr_t)(s ? &s->si : NULL);
+}
+
+static void runnerOsSensorGetRate(uintptr_t *retValP, va_list args)
+{
+    struct HostSensor *s = runnerSensorByHandle(va_arg(args, uint32_t));
+
+    *retValP = s ? s->reqRate : 0;
+}
+
+static void runnerOsGetTime(uintptr_t *retValP, va_list args)
+{
+    uint64_t *timeNanos = va_arg(args, uint64_t *);
+
+    if (timeNanos)
+        *timeNanos = mNow;
+}
+
+static void runnerChreGetAppId(uintptr_t *retValP, va_list args)
+{
+    uint64_t *appId = va_arg(args, uint64_t *);
+
+    if (appId)
+        *appId = APP_ID;
+}
+
+static void runnerChreGetInstanceId(uintptr_t *retValP, va_list args)
+{
+    *retValP = RUNNER_APP_TID;
+}
+
+static void runnerChreLog(uintptr_t *retValP, va_list args)
+{
+    va_list innerArgs;
+    enum chreLogLevel level = va_arg(args, int /* enums promoted to ints in va_args in C */);
+    static const char levels[] = "EWIDV";
+    char clevel = (level > CHRE_LOG_DEBUG || (int) level < 0) ? 'V' : levels[level];
+    const char *str = va_arg(args, const char*);
+    uintptr_t inner = va_arg(args, uintptr_t);
+
+    if (mQuiet)
+        return;
+
+    va_copy(innerArgs, INTEGER_TO_VA_LIST(inner));
+    printf("[%10" PRIu64 ".%06" PRIu64 "] %c: ", mNow / UINT64_C(1000000000), (mNow / 1000) % 1000000, clevel);
+    vprintf(str, innerArgs);
+    va_end(innerArgs);
+
+    //one line per call, as in the hub log; apps may or may not end with '\n'
+    if (!*str || str[strlen(str) - 1] != '\n')
+        printf("\n");
+}
+
+static void runnerChreHostTimeOffset(uintptr_t *retValP, va_list args)
+{
+    int64_t *timeNanos = va_arg(args, int64_t *);
+
+    if (timeNanos)
+        *timeNanos = 0;
+}
+
+static void runnerChreTimerSet(uintptr_t *retValP, va_list args)
+{
+    uint32_t length_lo = va_arg(args, uint32_t);
+    uint32_t length_hi = va_arg(args, uint32_t);
+    void *cookie = va_arg(args, void *);
+    bool oneshot = va_arg(args, int);
+    uint64_t length = (((uint64_t)length_hi) << 32) | length_lo;
+
+    *retValP = runnerTimerSet(length, cookie, oneshot);
+}
+
+static void runnerChreTimerCancel(uintptr_t *retValP, va_list args)
+{
+    *retValP = runnerTimerCancel(va_arg(args, uint32_t));
+}
+
+static void runnerChreAbort(uintptr_t *retValP, va_list args)
+{
+    mAbortCode = va_arg(args, uint32_t);
+    mAborted = true;
+    fprintf(stderr, "runner: app aborted [code 0x%" PRIX32 "] at %" PRIu64 " ns\n", mAbortCode, mNow);
+    if (mInApp)
+        longjmp(mAbortJmp, 1);
+}
+
+static void runnerChreHeapAlloc(uintptr_t *retValP, va_list args)
+{
+    *retValP = (uintptr_t)runnerHeapAlloc(va_arg(args, uint32_t));
+}
+
+static void runnerChreHeapFree(uintptr_t *retValP, va_list args)
+{
+    runnerHeapFree(va_arg(args, void *));
+}
+
+static void runnerChreSendEvent(uintptr_t *retValP, va_list args)
+{
+    uint16_t evtType = va_arg(args, uint32_t); // stored as 32-bit
+    void *evtData = va_arg(args, void *);
+    chreEventCompleteFunction *freeCallback = va_arg(args, chreEventCompleteFunction *);
+    uint32_t toTid = va_arg(args, uint32_t);
+
+    if (evtType < CHRE_EVENT_FIRST_USER_VALUE || toTid != RUNNER_APP_TID) {
+        if (freeCallback)
+            freeCallback(evtType, evtData);
+        *retValP = false;
+        return;
+    }
+
+    *retValP = runnerEnqueue(evtType, evtData, EVT_OWNER_APP, freeCallback, RUNNER_APP_TID, STAT_USER_EVT);
+}
+
+static bool runnerSendMessageToHost(void *message, uint32_t messageSize, uint32_t messageType,
+                                    uint16_t hostEndpoint, chreMessageFreeFunction *freeCallback)
+{
+    bool result = messageSize <= CHRE_MESSAGE_TO_HOST_MAX_SIZE && (!messageSize || message);
+    uint32_t i;
+
+    if (result) {
+        mMsgsToHost++;
+        mMsgBytesToHost += messageSize;
+        if (messageSize > mMsgMaxToHost)
+            mMsgMaxToHost = messageSize;
+        if (mVerbose) {
+            printf("[%10" PRIu64 ".%06" PRIu64 "] -> host type=%" PRIu32 " endpoint=0x%04" PRIX16 " size=%" PRIu32 ":",
+                   mNow / UINT64_C(1000000000), (mNow / 1000) % 1000000, messageType, hostEndpoint, messageSize);
+            for (i = 0; i < messageSize; i++)
+                printf(" %02" PRIX8, ((uint8_t *)message)[i]);
+            printf("\n");
+        }
+    } else {
+        mMsgsToHostFailed++;
+    }
+
+    runnerAppFreeMessage(freeCallback, message, messageSize);
+
+    return result;
+}
+
+static void runnerChreSendMessageOld(uintptr_t *retValP, va_list args)
+{
+    void *message = va_arg(args, void *);
+    uint32_t messageSize = va_arg(args, uint32_t);
+    uint32_t messageType = va_arg(args, uint32_t);
+    chreMessageFreeFunction *freeCallback = va_arg(args, chreMessageFreeFunction *);
+
+    *retValP = runnerSendMessageToHost(message, messageSize, messageType, CHRE_HOST_ENDPOINT_BROADCAST, freeCallback);
+}
+
+static void runnerChreSendMessage(uintptr_t *retValP, va_list args)
+{
+    void *message = va_arg(args, void *);
+    uint32_t messageSize = va_arg(args, size_t);
+    uint32_t messageType = va_arg(args, uint32_t);
+    uint16_t hostEndpoint = va_arg(args, uint32_t);
+    chreMessageFreeFunction *freeCallback = va_arg(args, chreMessageFreeFunction *);
+
+    *retValP = runnerSendMessageToHost(message, messageSize, messageType, hostEndpoint, freeCallback);
+}
+
+static void runnerChreSensorFindDefault(uintptr_t *retValP, va_list args)
+{
+    uint8_t sensorType = va_arg(args, uint32_t);
+    uint32_t *pHandle = va_arg(args, uint32_t *);
+
+    *retValP = pHandle && runnerSensorByType(sensorType, pHandle);
+}
+
+static void runnerFillSensorInfo(const struct HostSensor *s, struct chreSensorInfo *info)
+{
+    info->sensorName = s->si.sensorName;
+    info->sensorType = s->si.sensorType;
+    info->unusedFlags = 0;
+    info->isOneShot = s->si.supportedRates == mOneshotRates;
+    info->isOnChange = s->si.supportedRates == mOnchangeRates;
+}
+
+static void runnerChreSensorGetInfoOld(uintptr_t *retValP, va_list args)
+{
+    struct HostSensor *s = runnerSensorByHandle(va_arg(args, uint32_t));
+    struct chreSensorInfo *info = va_arg(args, struct chreSensorInfo *);
+
+    if (s && info)
+        runnerFillSensorInfo(s, info);
+    *retValP = s && info;
+}
+
+static void runnerChreSensorGetInfo(uintptr_t *retValP, va_list args)
+{
+    struct HostSensor *s = runnerSensorByHandle(va_arg(args, uint32_t));
+    struct chreSensorInfo *info = va_arg(args, struct chreSensorInfo *);
+    const uint32_t *r;
+
+    if (s && info) {
+        runnerFillSensorInfo(s, info);
+#if CHRE_API_VERSION != CHRE_API_VERSION_1_0
+        info->minInterval = CHRE_SENSOR_INTERVAL_DEFAULT;
+        for (r = s->si.supportedRates; *r && *r < SENSOR_RATE_ONDEMAND; r++)
+            info->minInterval = (UINT32_C(1024000000) / *r) * UINT64_C(1000);
+#else
+        (void)r;
+#endif
+    }
+    *retValP = s && info;
+}
+
+static void runnerChreSensorGetStatus(uintptr_t *retValP, va_list args)
+{
+    struct HostSensor *s = runnerSensorByHandle(va_arg(args, uint32_t));
+    struct chreSensorSamplingStatus *status = va_arg(args, struct chreSensorSamplingStatus *);
+
+    if (!s || !status) {
+        *retValP = false;
+        return;
+    }
+
+    status->enabled = s->reqRate != 0;
+    status->interval = runnerSensorInterval(s);
+    if (s->reqRate && !status->interval)
+        status->interval = CHRE_SENSOR_INTERVAL_DEFAULT;
+    status->latency = s->reqRate ? s->reqLatency : 0;
+    *retValP = true;
+}
+
+static void runnerChreSensorConfig(uintptr_t *retValP, va_list args)
+{
+    uint32_t sensorHandle = va_arg(args, uint32_t);
+    enum chreSensorConfigureMode mode = va_arg(args, int);
+    uint64_t interval = va_arg(args, uint32_t);
+    uint32_t interval_hi = va_arg(args, uint32_t);
+    uint64_t latency = va_arg(args, uint32_t);
+    uint32_t latency_hi = va_arg(args, uint32_t);
+
+    interval |= ((uint64_t)interval_hi) << 32;
+    latency  |= ((uint64_t)latency_hi) << 32;
+
+    *retValP = runnerSensorConfigure(sensorHandle, mode, interval, latency);
+}
+
+static void runnerChreApiVersion(uintptr_t *retValP, va_list args)
+{
+    *retValP = CHRE_API_VERSION;
+}
+
+static void runnerChreOsVersion(uintptr_t *retValP, va_list args)
+{
+    *retValP = CHRE_API_VERSION | NANOHUB_OS_PATCH_LEVEL;
+}
+
+static void runnerChrePlatformId(uintptr_t *retValP, va_list args)
+{
+    uint64_t *pHwId = va_arg(args, uint64_t*);
+
+    if (pHwId)
+        *pHwId = HW_ID_MAKE(NANOHUB_VENDOR_GOOGLE, 0);
+}
+
+#if CHRE_API_VERSION != CHRE_API_VERSION_1_0
+static void runnerChreInfoByAppId(uintptr_t *retValP, va_list args)
+{
+    uint32_t app_lo = va_arg(args, uint32_t);
+    uint32_t app_hi = va_arg(args, uint32_t);
+    struct chreNanoappInfo *info = va_arg(args, struct chreNanoappInfo *);
+    uint64_t appId = (((uint64_t)app_hi) << 32) | app_lo;
+
+    *retValP = false;
+    if (info && appId == (uint64_t)APP_ID) {
+        info->appId = APP_ID;
+        info->version = APP_VERSION;
+        info->instanceId = RUNNER_APP_TID;
+        *retValP = true;
+    }
+}
+
+static void runnerChreInfoByInstId(uintptr_t *retValP, va_list args)
+{
+    uint32_t tid = va_arg(args, uint32_t);
+    struct chreNanoappInfo *info = va_arg(args, struct chreNanoappInfo *);
+
+    *retValP = false;
+    if (info && tid == RUNNER_APP_TID) {
+        info->appId = APP_ID;
+        info->version = APP_VERSION;
+        info->instanceId = RUNNER_APP_TID;
+        *retValP = true;
+    }
+}
+#endif
+
+static void runnerChreNop(uintptr_t *retValP, va_list args)
+{
+}
+
+static void runnerChreTrue(uintptr_t *retValP, va_list args)
+{
+    *retValP = true;
+}
+
+static const struct SyscallTable osMainSensorTable = {
+    .numEntries = SYSCALL_OS_MAIN_SENSOR_LAST,
+    .entry = {
+        [SYSCALL_OS_MAIN_SENSOR_FIND]           = { .func = runnerOsSensorFind },
+        [SYSCALL_OS_MAIN_SENSOR_GET_CUR_RATE]   = { .func = runnerOsSensorGetRate },
+        [SYSCALL_OS_MAIN_SENSOR_GET_REQ_RATE]   = { .func = runnerOsSensorGetRate },
+        [SYSCALL_OS_MAIN_SENSOR_GET_TIME]       = { .func = runnerOsGetTime },
+    },
+};
+
+static const struct SyscallTable osMainTimeTable = {
+    .numEntries = SYSCALL_OS_MAIN_TIME_LAST,
+    .entry = {
+        [SYSCALL_OS_MAIN_TIME_GET_TIME]         = { .func = runnerOsGetTime },
+    },
+};
+
+/* what operator new/delete (lib/libc/new.cpp) use in C++ apps */
+static const struct SyscallTable osMainHeapTable = {
+    .numEntries = SYSCALL_OS_MAIN_HEAP_LAST,
+    .entry = {
+        [SYSCALL_OS_MAIN_HEAP_ALLOC]            = { .func = runnerChreHeapAlloc },
+        [SYSCALL_OS_MAIN_HEAP_FREE]             = { .func = runnerChreHeapFree },
+    },
+};
+
+static const struct SyscallTable osMainTable = {
+    .numEntries = SYSCALL_OS_MAIN_LAST,
+    .entry = {
+        [SYSCALL_OS_MAIN_HEAP]      = { .subtable = (struct SyscallTable*)&osMainHeapTable,   },
+        [SYSCALL_OS_MAIN_SENSOR]    = { .subtable = (struct SyscallTable*)&osMainSensorTable, },
+        [SYSCALL_OS_MAIN_TIME]      = { .subtable = (struct SyscallTable*)&osMainTimeTable,   },
+    },
+};
+
+static const struct SyscallTable osTable = {
+    .numEntries = SYSCALL_OS_LAST,
+    .entry = {
+        [SYSCALL_OS_MAIN]           = { .subtable = (struct SyscallTable*)&osMainTable, },
+    },
+};
+
+static const struct SyscallTable chreMainApiTable = {
+    .numEntries = SYSCALL_CHRE_MAIN_API_LAST,
+    .entry = {
+        [SYSCALL_CHRE_MAIN_API_LOG_OLD]                 = { .func = runnerChreLog },
+        [SYSCALL_CHRE_MAIN_API_LOG]                     = { .func = runnerChreLog },
+        [SYSCALL_CHRE_MAIN_API_GET_APP_ID]              = { .func = runnerChreGetAppId },
+        [SYSCALL_CHRE_MAIN_API_GET_INST_ID]             = { .func = runnerChreGetInstanceId },
+        [SYSCALL_CHRE_MAIN_API_GET_TIME]                = { .func = runnerOsGetTime },
+        [SYSCALL_CHRE_MAIN_API_GET_HOST_TIME_OFFSET]    = { .func = runnerChreHostTimeOffset },
+        [SYSCALL_CHRE_MAIN_API_TIMER_SET]               = { .func = runnerChreTimerSet },
+        [SYSCALL_CHRE_MAIN_API_TIMER_CANCEL]            = { .func = runnerChreTimerCancel },
+        [SYSCALL_CHRE_MAIN_API_ABORT]                   = { .func = runnerChreAbort },
+        [SYSCALL_CHRE_MAIN_API_HEAP_ALLOC]              = { .func = runnerChreHeapAlloc },
+        [SYSCALL_CHRE_MAIN_API_HEAP_FREE]               = { .func = runnerChreHeapFree },
+        [SYSCALL_CHRE_MAIN_API_SEND_EVENT]              = { .func = runnerChreSendEvent },
+        [SYSCALL_CHRE_MAIN_API_SEND_MSG]                = { .func = runnerChreSendMessageOld },
+        [SYSCALL_CHRE_MAIN_API_SENSOR_FIND_DEFAULT]     = { .func = runnerChreSensorFindDefault },
+        [SYSCALL_CHRE_MAIN_API_SENSOR_GET_INFO_OLD]     = { .func = runnerChreSensorGetInfoOld },
+        [SYSCALL_CHRE_MAIN_API_SENSOR_GET_INFO]         = { .func = runnerChreSensorGetInfo },
+        [SYSCALL_CHRE_MAIN_API_SENSOR_GET_STATUS]       = { .func = runnerChreSensorGetStatus },
+        [SYSCALL_CHRE_MAIN_API_SENSOR_CONFIG]           = { .func = runnerChreSensorConfig },
+        [SYSCALL_CHRE_MAIN_API_GET_OS_API_VERSION]      = { .func = runnerChreApiVersion },
+        [SYSCALL_CHRE_MAIN_API_GET_OS_VERSION]          = { .func = runnerChreOsVersion },
+        [SYSCALL_CHRE_MAIN_API_GET_PLATFORM_ID]         = { .func = runnerChrePlatformId },
+    },
+};
+
+static const struct SyscallTable chreMainEventTable = {
+    .numEntries = SYSCALL_CHRE_MAIN_EVENT_LAST,
+    .entry = {
+        [SYSCALL_CHRE_MAIN_EVENT_SEND_EVENT]           = { .func = runnerChreSendEvent },
+        [SYSCALL_CHRE_MAIN_EVENT_SEND_MSG]             = { .func = runnerChreSendMessage },
+#if CHRE_API_VERSION != CHRE_API_VERSION_1_0
+        [SYSCALL_CHRE_MAIN_EVENT_INFO_BY_APP_ID]       = { .func = runnerChreInfoByAppId },
+        [SYSCALL_CHRE_MAIN_EVENT_INFO_BY_INST_ID]      = { .func = runnerChreInfoByInstId },
+#endif
+        [SYSCALL_CHRE_MAIN_EVENT_CFG_INFO]             = { .func = runnerChreNop },
+        [SYSCALL_CHRE_MAIN_EVENT_HOST_SLEEP]           = { .func = runnerChreNop },
+        [SYSCALL_CHRE_MAIN_EVENT_IS_HOST_AWAKE]        = { .func = runnerChreTrue },
+    },
+};
+
+static const struct SyscallTable chreMainTable = {
+    .numEntries = SYSCALL_CHRE_MAIN_LAST,
+    .entry = {
+        [SYSCALL_CHRE_MAIN_API]     = { .subtable = (struct SyscallTable*)&chreMainApiTable,     },
+        [SYSCALL_CHRE_MAIN_EVENT]   = { .subtable = (struct SyscallTable*)&chreMainEventTable,   },
+    },
+};
+
+static const struct SyscallTable chreTable = {
+    .numEntries = SYSCALL_CHRE_LAST,
+    .entry = {
+        [SYSCALL_CHRE_MAIN]    = { .subtable = (struct SyscallTable*)&chreMainTable,    },
+    },
+};
+
+/*
+ * Main loop & report
+ */
+
+/* static constructors of C++ apps already make syscalls, so run before them */
+static void __attribute__((constructor(101))) runnerSyscallInit(void)
+{
+    syscallInit();
+    if (!syscallAddTable(SYSCALL_NO(SYSCALL_DOMAIN_OS,0,0,0), 1, (struct SyscallTable*)&osTable) ||
+        !syscallAddTable(SYSCALL_NO(SYSCALL_DOMAIN_CHRE,0,0,0), 1, (struct SyscallTable*)&chreTable)) {
+        fprintf(stderr, "runner: failed to export syscall tables\n");
+        exit(1);
+    }
+}
+
+static void runnerReport(uint64_t wallNs)
+{
+    uint64_t totalNs = 0;
+    uint32_t i;
+
+    for (i = 0; i < STAT_NUM; i++)
+        totalNs += mStats[i].totalNs;
+
+    printf("\n=== CHRE host runner: app 0x%016" PRIX64 ", %" PRIu64 ".%03" PRIu64 " s virtual time ===\n",
+           (uint64_t)APP_ID, mNow / UINT64_C(1000000000), (mNow / 1000000) % 1000);
+    if (mAborted)
+        printf("app ABORTED with code 0x%08" PRIX32 "\n", mAbortCode);
+
+    printf("\n%-16s %10s %12s %10s %10s\n", "callback", "count", "total us", "avg ns", "max ns");
+    for (i = 0; i < STAT_NUM; i++) {
+        if (!mStats[i].count)
+            continue;
+        printf("%-16s %10" PRIu64 " %12" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n", mStatNames[i],
+               mStats[i].count, mStats[i].totalNs / 1000, mStats[i].totalNs / mStats[i].count, mStats[i].maxNs);
+    }
+    printf("%-16s %10s %12" PRIu64 "\n", "all", "", totalNs / 1000);
+    if (mNow)
+        printf("app cpu load: %.3f%% of virtual time (host cpu)\n", totalNs * 100.0 / mNow);
+
+    printf("\nheap: peak %" PRIu64 " B, in use at exit %" PRIu64 " B, %" PRIu64 " allocs, %" PRIu64 " frees, %" PRIu64 " failed\n",
+           mHeapPeak, mHeapCur, mHeapAllocs, mHeapFrees, mHeapFails);
+    printf("to host: %" PRIu64 " msgs, %" PRIu64 " B (max %" PRIu32 " B), %" PRIu64 " rejected\n",
+           mMsgsToHost, mMsgBytesToHost, mMsgMaxToHost, mMsgsToHostFailed);
+
+    for (i = 0; i < ARRAY_SIZE(mSensors); i++) {
+        if (!mSensors[i].samplesIn && !mSensors[i].eventsDelivered)
+            continue;
+        printf("sensor %-14s in %8" PRIu64 " delivered %8" PRIu64 " samples in %8" PRIu64 " events\n",
+               mSensors[i].si.sensorName, mSensors[i].samplesIn, mSensors[i].samplesDelivered, mSensors[i].eventsDelivered);
+    }
+
+    if (mEvtQDrops)
+        printf("event queue overflows: %" PRIu64 "\n", mEvtQDrops);
+    if (mUnhandledSyscalls)
+        printf("unhandled syscalls: %" PRIu64 "\n", mUnhandledSyscalls);
+    printf("runner wall time: %" PRIu64 " ms\n", wallNs / 1000000);
+}
+
+static void runnerUsage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-t trace] [-d duration_ms] [-H heap_limit_bytes] [-q] [-v]\n"
+            "  -t  sensor/host message trace to replay (see chre_host_runner.c)\n"
+            "  -d  stop after this much virtual time (default: end of trace, or 10 s)\n"
+            "  -H  fail chreHeapAlloc() beyond this many bytes in use (default: unlimited)\n"
+            "  -q  suppress app log output\n"
+            "  -v  print messages to host and every unhandled syscall\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t endTime = 0, wallStart, start, next;
+    struct HostTimer *tim;
+    struct timespec ts;
+    volatile bool ok = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:d:H:qvh")) != -1) {
+        switch (opt) {
+        case 't':
+            mTraceFile = fopen(optarg, "r");
+            if (!mTraceFile) {
+                fprintf(stderr, "cannot open %s: %s\n", optarg, strerror(errno));
+                return 1;
+            }
+            break;
+        case 'd':
+            endTime = strtoull(optarg, NULL, 0) * UINT64_C(1000000);
+            break;
+        case 'H':
+            mHeapLimit = strtoull(optarg, NULL, 0);
+            break;
+        case 'q':
+            mQuiet = true;
+            break;
+        case 'v':
+            mVerbose = true;
+            break;
+        default:
+            runnerUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!endTime && !mTraceFile)
+        endTime = RUNNER_DEFAULT_DURATION;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    wallStart = (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+
+    runnerTraceAdvance();
+
+    start = runnerCpuNs();
+    mInApp = true;
+    if (!setjmp(mAbortJmp))
+        ok = _mAppFuncs.init(RUNNER_APP_TID);
+    mInApp = false;
+    runnerAccount(STAT_START, start);
+    if (!ok && !mAborted)
+        fprintf(stderr, "runner: nanoappStart() failed\n");
+
+    while (ok && !mAborted) {
+        runnerDrainEvents();
+
+        /* without -d, the run ends with the trace */
+        if (!endTime && mTraceFile && !mTraceNext.valid)
+            endTime = mNow;
+
+        next = runnerSensorNextFlush();
+        if ((tim = runnerTimerNext()) != NULL && tim->deadline < next)
+            next = tim->deadline;
+        if (mTraceNext.valid && mTraceNext.time < next)
+            next = mTraceNext.time;
+        if (next == UINT64_MAX || (endTime && next > endTime))
+            break;
+
+        if (next > mNow)
+            mNow = next;
+
+        /* order at equal times: timers, then trace input, then batch deadlines */
+        while ((tim = runnerTimerNext()) != NULL && tim->deadline <= mNow && !mAborted) {
+            runnerTimerFire(tim);
+            runnerDrainEvents();
+        }
+        while (mTraceNext.valid && mTraceNext.time <= mNow) {
+            runnerTraceDispatch(&mTraceNext);
+            runnerTraceAdvance();
+        }
+        runnerSensorFlushDue();
+    }
+
+    if (endTime && endTime > mNow && !mAborted)
+        mNow = endTime;
+
+    if (ok && !mAborted) {
+        start = runnerCpuNs();
+        mInApp = true;
+        if (!setjmp(mAbortJmp))
+            _mAppFuncs.end();
+        mInApp = false;
+        runnerAccount(STAT_END, start);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    runnerReport((uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec - wallStart);
+
+    if (mTraceFile)
+        fclose(mTraceFile);
+
+    return ok && !mAborted ? 0 : 2;
+}
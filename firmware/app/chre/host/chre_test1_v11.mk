@@ -0,0 +1,31 @@
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+################################################################################
+#
+# chre_test1.app built against CHRE API 1.1 for the host runner, see runs.mk
+#
+################################################################################
+
+SRCS := app/chre/chre_test1.app/main.cpp
+BIN := chre_test1_v11
+APP_ID := 476f6f676c549001
+APP_VERSION := 0
+
+NANOHUB_DIR := .
+CHRE_HOST_RUNNER := true
+RUNNER_TRACE := app/chre/host/chre_test1.trace
+
+include $(NANOHUB_DIR)/app/chre/chre11.mk
@@ -0,0 +1,111 @@
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+################################################################################
+################################################################################
+#
+# CHRE nanoapp host runner build
+#
+# Included by chre10.mk / chre11.mk instead of app.mk when the app Makefile is
+# invoked with CHRE_HOST_RUNNER=true. Builds the app together with its CHRE
+# shims and chre_host_runner.c into a Linux executable for profiling:
+#
+#   make CHRE_HOST_RUNNER=true
+#   out/nanohub/host/app/$(BIN)/$(BIN)_runner -t trace.txt
+#
+# The run target replays $(RUNNER_TRACE); runs.mk has a CHRE 1.0 and a CHRE 1.1
+# sample.
+#
+################################################################################
+
+HOST_CC ?= gcc
+HOST_CXX ?= g++
+
+OUT := out/nanohub/host/app/$(BIN)
+RUNNER := $(OUT)/$(BIN)_runner
+
+ifeq ($(APP_VERSION),)
+APP_VERSION := 0
+endif
+
+SRCS += $(NANOHUB_DIR)/app/chre/host/chre_host_runner.c
+SRCS += $(NANOHUB_DIR)/os/core/syscall.c
+SRCS += $(NANOHUB_DIR)/lib/libc/new.cpp
+
+# Defines
+CFLAGS += -DAPP_ID=0x$(APP_ID)
+CFLAGS += -DAPP_VERSION=$(APP_VERSION)
+CFLAGS += -DSYSCALL_PARAMS_PASSED_AS_PTRS
+CFLAGS += -DSYSCALL_VARARGS_PARAMS_PASSED_AS_PTRS
+
+# Optimization/debug: same level as the hub build so the profile is comparable
+CFLAGS += -Os
+CFLAGS += -g
+
+# Include paths
+CFLAGS += -I$(NANOHUB_DIR)/os/inc
+CFLAGS += -I$(NANOHUB_DIR)/os/platform/native/inc
+CFLAGS += -I$(NANOHUB_DIR)/os/cpu/x86/inc
+CFLAGS += -I$(NANOHUB_DIR)/variant/linux/inc
+CFLAGS += -I$(NANOHUB_DIR)/lib/libc
+CFLAGS += -I$(NANOHUB_DIR)/../lib/include
+
+# Warnings/error configuration.
+CFLAGS += -Wall
+CFLAGS += -Werror
+CFLAGS += -Wmissing-declarations
+CFLAGS += -Wshadow
+CFLAGS += -Wno-attributes
+
+# Match the hub's float behavior
+CFLAGS += -fsingle-precision-constant
+CFLAGS += -fno-strict-aliasing
+
+CXX_CFLAGS += -std=c++11
+CXX_CFLAGS += -fno-exceptions
+CXX_CFLAGS += -fno-rtti
+
+C_SRCS := $(filter %.c, $(SRCS))
+CXX_SRCS := $(filter %.cc, $(SRCS))
+CPP_SRCS := $(filter %.cpp, $(SRCS))
+
+OBJS := $(patsubst %.c, $(OUT)/%.o, $(C_SRCS))
+OBJS += $(patsubst %.cc, $(OUT)/%.o, $(CXX_SRCS))
+OBJS += $(patsubst %.cpp, $(OUT)/%.o, $(CPP_SRCS))
+
+.PHONY: all run clean
+all: $(RUNNER)
+
+run: $(RUNNER)
+	$(RUNNER) $(if $(RUNNER_TRACE),-t $(RUNNER_TRACE))
+
+$(RUNNER) : $(OBJS)
+	@mkdir -p $(dir $@)
+	$(HOST_CXX) $(OBJS) -o $@
+
+$(OUT)/%.o : %.c
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(CFLAGS) -DSRC_FILENAME=\"$(notdir $<)\" -c $< -o $@
+
+$(OUT)/%.o : %.cc
+	@mkdir -p $(dir $@)
+	$(HOST_CXX) $(CXX_CFLAGS) $(CFLAGS) -DSRC_FILENAME=\"$(notdir $<)\" -c $< -o $@
+
+$(OUT)/%.o : %.cpp
+	@mkdir -p $(dir $@)
+	$(HOST_CXX) $(CXX_CFLAGS) $(CFLAGS) -DSRC_FILENAME=\"$(notdir $<)\" -c $< -o $@
+
+clean:
+	rm -rf $(OUT)
@@ -0,0 +1,38 @@
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+################################################################################
+################################################################################
+#
+# CHRE host runner sample runs
+#
+# Builds chre_test0.app against CHRE API 1.0 and chre_test1.app against CHRE
+# API 1.1 with the host runner, and replays each one's trace. Needs the legacy
+# CHRE API headers from system/chre, like chre10.mk and chre11.mk. Run from the
+# firmware directory:
+#
+#   make -f app/chre/host/runs.mk
+#
+################################################################################
+
+RUNS := app/chre/host/chre_test0_v10.mk
+RUNS += app/chre/host/chre_test1_v11.mk
+
+.PHONY: all clean
+all:
+	$(foreach run, $(RUNS), $(MAKE) -f $(run) run &&) true
+
+clean:
+	$(foreach run, $(RUNS), $(MAKE) -f $(run) clean &&) true
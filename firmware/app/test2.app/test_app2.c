@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <seos.h>
+#include <syscallDo.h>
+#include <fast_math.h>
+
+// Compares fast_math.h against the fdlibm functions from lib/libm: the
+// largest absolute difference over a sweep of the inputs sensor code sees
+// ([-pi, pi] for the trig functions; os/core/host/fast_math_check.c covers
+// the full ranges documented in fast_math.h against double libm), and
+// the time per call (both sides are called through a pointer, so the
+// numbers include the same call overhead).
+
+#define NUM_INPUTS      256
+#define NUM_REPEATS     16
+
+typedef float (*MathFunc)(float a, float b);
+
+struct MathBench
+{
+    const char *name;
+    MathFunc ref;
+    MathFunc fast;
+    float lo, hi;
+    bool polar;      // inputs are (r sin t, r cos t) for t in [lo, hi)
+};
+
+static uint32_t mMyTid;
+static float mA[NUM_INPUTS], mB[NUM_INPUTS];
+static volatile float mSink;
+
+static float refSqrt(float a, float b) { return sqrtf(a); }
+static float fastSqrt(float a, float b) { return fastSqrtf(a); }
+static float refSin(float a, float b) { return sinf(a); }
+static float fastSin(float a, float b) { return fastSinf(a); }
+static float refCos(float a, float b) { return cosf(a); }
+static float fastCos(float a, float b) { return fastCosf(a); }
+static float refAtan2(float a, float b) { return atan2f(a, b); }
+static float fastAtan2(float a, float b) { return fastAtan2f(a, b); }
+static float refAsin(float a, float b) { return asinf(a); }
+static float fastAsin(float a, float b) { return fastAsinf(a); }
+
+static const struct MathBench mBenches[] = {
+    { "sqrtf",  refSqrt,  fastSqrt,   0.0f,          100.0f,       false },
+    { "sinf",   refSin,   fastSin,    -FAST_MATH_PI, FAST_MATH_PI, false },
+    { "cosf",   refCos,   fastCos,    -FAST_MATH_PI, FAST_MATH_PI, false },
+    { "atan2f", refAtan2, fastAtan2,  -FAST_MATH_PI, FAST_MATH_PI, true  },
+    { "asinf",  refAsin,  fastAsin,   -1.0f,         1.0f,         false },
+};
+
+static uint32_t timeFunc(MathFunc f)
+{
+    uint64_t start;
+    float acc = 0.0f;
+    int i, j;
+
+    start = eOsTimGetTime();
+    for (j = 0; j < NUM_REPEATS; j++)
+        for (i = 0; i < NUM_INPUTS; i++)
+            acc += f(mA[i], mB[i]);
+    mSink = acc;
+
+    return (uint32_t)(eOsTimGetTime() - start) / (NUM_INPUTS * NUM_REPEATS);
+}
+
+static void runBench(const struct MathBench *b)
+{
+    float step = (b->hi - b->lo) / NUM_INPUTS;
+    float x, err, maxErr = 0.0f;
+    uint32_t refNs, fastNs;
+    int i;
+
+    for (i = 0; i < NUM_INPUTS; i++) {
+        x = b->lo + step * i;
+        if (b->polar) {
+            mA[i] = 3.0f * sinf(x);
+            mB[i] = 3.0f * cosf(x);
+        } else {
+            mA[i] = x;
+            mB[i] = 0.0f;
+        }
+        err = fabsf(b->fast(mA[i], mB[i]) - b->ref(mA[i], mB[i]));
+        if (err > maxErr)
+            maxErr = err;
+    }
+
+    refNs = timeFunc(b->ref);
+    fastNs = timeFunc(b->fast);
+
+    eOsLog(LOG_INFO, "%s: fdlibm %lu ns, fast %lu ns, max err %lu e-9\n",
+           b->name, refNs, fastNs, (uint32_t)(maxErr * 1e9f));
+}
+
+static bool start_task(uint32_t myTid)
+{
+    mMyTid = myTid;
+
+    return eOsEventSubscribe(myTid, EVT_APP_START);
+}
+
+static void end_task(void)
+{
+}
+
+static void handle_event(uint32_t evtType, const void* evtData)
+{
+    uint32_t i;
+
+    if (evtType == EVT_APP_START) {
+        for (i = 0; i < sizeof(mBenches) / sizeof(mBenches[0]); i++)
+            runBench(&mBenches[i]);
+    }
+}
+
+APP_INIT(0, start_task, end_task, handle_event);
@@ -65,6 +65,7 @@ NANO_VARIANT_OSCFG_SRC_FILES_$(my_variant) :=                  \
     os/algos/common/math/mat.c                                 \
     os/algos/common/math/quat.c                                \
     os/algos/common/math/vec.c                                 \
+    os/algos/accel_features.c                                  \
     os/algos/fusion.c                                          \
     os/algos/time_sync.c                                       \
     os/drivers/hall/hall.c                                     \
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Checks the C versions of memcpy, memset and memmove in lib/libc on the build
+ * host. memops_check.mk builds the generic FreeBSD versions as bsd_* and the
+ * Cortex-M ones as m4_*; both are checked against a byte at a time reference
+ * for every small length and every alignment of source and destination (and
+ * every overlap for memmove), with guard bytes around the destination.
+ *
+ * This says nothing about their speed on the hub; host timings do not carry
+ * over to the M4.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+void *bsd_memcpy(void *dst, const void *src, size_t len);
+void *bsd_memmove(void *dst, const void *src, size_t len);
+void *bsd_memset(void *dst, int c, size_t len);
+void *m4_memmove(void *dst, const void *src, size_t len);
+void *m4_memset(void *dst, int c, size_t len);
+
+typedef void *(*CopyFunc)(void *dst, const void *src, size_t len);
+typedef void *(*SetFunc)(void *dst, int c, size_t len);
+
+struct CopyImpl {
+    const char *name;
+    CopyFunc func;
+};
+
+struct SetImpl {
+    const char *name;
+    SetFunc func;
+};
+
+static const struct CopyImpl mCopies[] = {
+    { "bsd_memcpy", bsd_memcpy },
+    { "bsd_memmove", bsd_memmove },
+    { "m4_memmove", m4_memmove },
+};
+
+static const struct SetImpl mSets[] = {
+    { "bsd_memset", bsd_memset },
+    { "m4_memset", m4_memset },
+};
+
+#define MAX_CHECK_LEN   300
+#define MAX_OFFSET      8
+#define GUARD           16
+#define BUF_LEN         (GUARD + 4 * MAX_OFFSET + MAX_CHECK_LEN + GUARD)
+#define GUARD_BYTE      0xA5
+
+static uint8_t mSrc[BUF_LEN], mDst[BUF_LEN], mRef[BUF_LEN];
+
+static void fillPattern(uint8_t *buf, size_t len, uint32_t seed)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = seed >> 16;
+    }
+}
+
+static void refMove(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    size_t i;
+
+    if (dst < src) {
+        for (i = 0; i < len; i++)
+            dst[i] = src[i];
+    } else {
+        for (i = len; i > 0; i--)
+            dst[i - 1] = src[i - 1];
+    }
+}
+
+static int checkResult(const char *name, size_t len, int dstOff, int srcOff)
+{
+    if (!memcmp(mDst, mRef, BUF_LEN))
+        return 0;
+
+    fprintf(stderr, "%s: mismatch for len %zu, dst offset %d, src offset %d\n", name, len, dstOff, srcOff);
+    return 1;
+}
+
+static int checkCopies(void)
+{
+    const struct CopyImpl *impl;
+    size_t len;
+    int i, dstOff, srcOff, errors = 0;
+
+    for (i = 0; i < (int)(sizeof(mCopies) / sizeof(mCopies[0])); i++) {
+        impl = &mCopies[i];
+        for (len = 0; len <= MAX_CHECK_LEN; len++) {
+            for (dstOff = 0; dstOff < MAX_OFFSET; dstOff++) {
+                for (srcOff = 0; srcOff < MAX_OFFSET; srcOff++) {
+                    fillPattern(mSrc, BUF_LEN, len);
+                    memset(mDst, GUARD_BYTE, BUF_LEN);
+                    memset(mRef, GUARD_BYTE, BUF_LEN);
+                    refMove(mRef + GUARD + dstOff, mSrc + GUARD + srcOff, len);
+                    if (impl->func(mDst + GUARD + dstOff, mSrc + GUARD + srcOff, len) != mDst + GUARD + dstOff)
+                        errors++;
+                    errors += checkResult(impl->name, len, dstOff, srcOff);
+                }
+            }
+        }
+    }
+
+    return errors;
+}
+
+static int checkOverlaps(void)
+{
+    const struct CopyImpl *impl;
+    size_t len;
+    int i, shift, errors = 0;
+    uint8_t *src;
+
+    //bsd_memcpy is not expected to handle overlaps
+    for (i = 1; i < (int)(sizeof(mCopies) / sizeof(mCopies[0])); i++) {
+        impl = &mCopies[i];
+        for (len = 0; len <= MAX_CHECK_LEN; len++) {
+            for (shift = -2 * MAX_OFFSET - 1; shift <= 2 * MAX_OFFSET + 1; shift++) {
+                fillPattern(mDst, BUF_LEN, len + shift);
+                memcpy(mRef, mDst, BUF_LEN);
+                src = mDst + GUARD + 2 * MAX_OFFSET;
+                refMove(mRef + GUARD + 2 * MAX_OFFSET + shift, mRef + GUARD + 2 * MAX_OFFSET, len);
+                impl->func(src + shift, src, len);
+                errors += checkResult(impl->name, len, shift, 0);
+            }
+        }
+    }
+
+    return errors;
+}
+
+static int checkSets(void)
+{
+    const struct SetImpl *impl;
+    size_t len;
+    int i, dstOff, errors = 0;
+
+    for (i = 0; i < (int)(sizeof(mSets) / sizeof(mSets[0])); i++) {
+        impl = &mSets[i];
+        for (len = 0; len <= MAX_CHECK_LEN; len++) {
+            for (dstOff = 0; dstOff < MAX_OFFSET; dstOff++) {
+                memset(mDst, GUARD_BYTE, BUF_LEN);
+                memset(mRef, GUARD_BYTE, BUF_LEN);
+                memset(mRef + GUARD + dstOff, 0x100 + (int)len, len);
+                if (impl->func(mDst + GUARD + dstOff, 0x100 + (int)len, len) != mDst + GUARD + dstOff)
+                    errors++;
+                errors += checkResult(impl->name, len, dstOff, -1);
+            }
+        }
+    }
+
+    return errors;
+}
+
+int main(void)
+{
+    int errors = checkCopies() + checkOverlaps() + checkSets();
+
+    printf("correctness: %d errors\n", errors);
+
+    return errors ? 1 : 0;
+}
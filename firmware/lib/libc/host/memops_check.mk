@@ -0,0 +1,73 @@
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+################################################################################
+################################################################################
+#
+# libc memory ops check
+#
+# Builds the generic and the Cortex-M C versions of memcpy, memset and memmove
+# side by side (renamed bsd_* and m4_*) into a Linux executable that checks
+# them against a reference. Run from the firmware directory:
+#
+#   make -f lib/libc/host/memops_check.mk
+#   out/nanohub/host/memops_check/memops_check
+#
+################################################################################
+
+HOST_CC ?= gcc
+
+OUT := out/nanohub/host/memops_check
+CHECK := $(OUT)/memops_check
+
+CFLAGS += -O2
+CFLAGS += -g
+CFLAGS += -Wall
+CFLAGS += -Werror
+CFLAGS += -Wshadow
+CFLAGS += -fno-strict-aliasing
+CFLAGS += -fno-builtin
+
+# the FreeBSD sources carry version tags the host headers do not know about
+BSD_FLAGS := -D'__FBSDID(x)=' -Iexternal/freebsd/inc
+
+OBJS := $(OUT)/bsd_memcpy.o
+OBJS += $(OUT)/bsd_memmove.o
+OBJS += $(OUT)/bsd_memset.o
+OBJS += $(OUT)/m4_memmove.o
+OBJS += $(OUT)/m4_memset.o
+OBJS += $(OUT)/memops_check.o
+
+.PHONY: all clean
+all: $(CHECK)
+
+$(CHECK) : $(OBJS)
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(OBJS) -o $@
+
+$(OUT)/bsd_%.o : lib/libc/%.c
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(CFLAGS) $(BSD_FLAGS) -D$*=bsd_$* -c $< -o $@
+
+$(OUT)/m4_%.o : lib/libc/%-armv7m.c
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(CFLAGS) -D$*=m4_$* -c $< -o $@
+
+$(OUT)/memops_check.o : lib/libc/host/memops_check.c
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(CFLAGS) -c $< -o $@
+
+clean:
+	rm -rf $(OUT)
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * memmove for Cortex-M3/M4, built when the variant sets LIBC_MEMOPS := armv7m.
+ * Buffers that do not overlap go to memcpy (memcpy-armv7m.S in the OS).
+ * Overlapping ones are copied in the safe direction: when source and
+ * destination share their alignment, bytes up to a word boundary first, then
+ * 16-byte blocks loaded into four registers before being stored (ldm/stm),
+ * then words, then the tail bytes. Otherwise a byte at a time.
+ *
+ * This is plain C so that lib/libc/host/memops_check.mk can check it on the
+ * build host against the generic FreeBSD version.
+ */
+
+/* keep gcc from turning the loops below into calls to memmove */
+#if defined(__GNUC__) && !defined(__clang__)
+#define NO_LOOP_IDIOMS  __attribute__((optimize("no-tree-loop-distribute-patterns")))
+#else
+#define NO_LOOP_IDIOMS
+#endif
+
+static NO_LOOP_IDIOMS void copyForward(uint8_t *d, const uint8_t *s, size_t len)
+{
+    const uint32_t *ws;
+    uint32_t *wd;
+    uint32_t a, b, c, e;
+
+    if (!(((uintptr_t)d ^ (uintptr_t)s) & 3)) {
+        while (len && ((uintptr_t)d & 3)) {
+            *d++ = *s++;
+            len--;
+        }
+
+        wd = (uint32_t *)d;
+        ws = (const uint32_t *)s;
+
+        //all four loads before any store, in case the destination is just below the source
+        for (; len >= 16; len -= 16, wd += 4, ws += 4) {
+            a = ws[0];
+            b = ws[1];
+            c = ws[2];
+            e = ws[3];
+            wd[0] = a;
+            wd[1] = b;
+            wd[2] = c;
+            wd[3] = e;
+        }
+
+        for (; len >= 4; len -= 4)
+            *wd++ = *ws++;
+
+        d = (uint8_t *)wd;
+        s = (const uint8_t *)ws;
+    }
+
+    while (len--)
+        *d++ = *s++;
+}
+
+static NO_LOOP_IDIOMS void copyBackward(uint8_t *d, const uint8_t *s, size_t len)
+{
+    const uint32_t *ws;
+    uint32_t *wd;
+    uint32_t a, b, c, e;
+
+    d += len;
+    s += len;
+
+    if (!(((uintptr_t)d ^ (uintptr_t)s) & 3)) {
+        while (len && ((uintptr_t)d & 3)) {
+            *--d = *--s;
+            len--;
+        }
+
+        wd = (uint32_t *)d;
+        ws = (const uint32_t *)s;
+
+        for (; len >= 16; len -= 16) {
+            ws -= 4;
+            wd -= 4;
+            e = ws[3];
+            c = ws[2];
+            b = ws[1];
+            a = ws[0];
+            wd[3] = e;
+            wd[2] = c;
+            wd[1] = b;
+            wd[0] = a;
+        }
+
+        for (; len >= 4; len -= 4)
+            *--wd = *--ws;
+
+        d = (uint8_t *)wd;
+        s = (const uint8_t *)ws;
+    }
+
+    while (len--)
+        *--d = *--s;
+}
+
+void *memmove(void *dst, const void *src, size_t len)
+{
+    uintptr_t d = (uintptr_t)dst, s = (uintptr_t)src;
+
+    if (d == s || !len)
+        return dst;
+
+    if (d - s >= len && s - d >= len)
+        return memcpy(dst, src, len);
+
+    if (d < s)
+        copyForward(dst, src, len);
+    else
+        copyBackward(dst, src, len);
+
+    return dst;
+}
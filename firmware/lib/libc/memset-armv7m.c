@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * memset for Cortex-M3/M4, built when the variant sets LIBC_MEMOPS := armv7m.
+ * Short fills just store bytes. Longer ones store up to 3 bytes to word align
+ * the destination, then 32-byte blocks that the compiler emits as store
+ * multiples of a register pair (strd/stm), then the remaining words, then the
+ * tail bytes.
+ *
+ * This is plain C so that lib/libc/host/memops_check.mk can check it on the
+ * build host against the generic FreeBSD version.
+ */
+
+#define SMALL_FILL      16
+
+/* keep gcc from turning the loops below back into calls to memset */
+#if defined(__GNUC__) && !defined(__clang__)
+#define NO_LOOP_IDIOMS  __attribute__((optimize("no-tree-loop-distribute-patterns")))
+#else
+#define NO_LOOP_IDIOMS
+#endif
+
+NO_LOOP_IDIOMS void *memset(void *dst, int c, size_t len)
+{
+    uint8_t *d = dst;
+    uint32_t *w;
+    uint32_t v;
+
+    if (len < SMALL_FILL) {
+        while (len--)
+            *d++ = c;
+        return dst;
+    }
+
+    while ((uintptr_t)d & 3) {
+        *d++ = c;
+        len--;
+    }
+
+    v = (uint8_t)c * 0x01010101UL;
+    w = (uint32_t *)d;
+
+    for (; len >= 32; len -= 32, w += 8) {
+        w[0] = v;
+        w[1] = v;
+        w[2] = v;
+        w[3] = v;
+        w[4] = v;
+        w[5] = v;
+        w[6] = v;
+        w[7] = v;
+    }
+
+    for (; len >= 4; len -= 4)
+        *w++ = v;
+
+    d = (uint8_t *)w;
+    while (len--)
+        *d++ = c;
+
+    return dst;
+}
@@ -66,6 +66,8 @@ NANO_VARIANT_OSCFG_SRC_FILES_$(my_variant) :=                  \
     os/algos/common/math/mat.c                                 \
     os/algos/common/math/quat.c                                \
     os/algos/common/math/vec.c                                 \
+    os/algos/accel_features.c                                  \
+    os/algos/als_prox_onchange.c                               \
     os/algos/fusion.c                                          \
     os/algos/time_sync.c                                       \
     os/drivers/ams_tmd2772/ams_tmd2772.c                       \
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <inttypes.h>
+#include <math.h>
+#include <nanohub_math.h>
+#include <seos.h>
+#include <algos/accel_features.h>
+
+#define RADIANS_TO_DEGREES  (180.0f / (float)M_PI)
+
+static struct AccelFeaturesCache {
+    const struct TripleAxisDataEvent *ev;
+    uint64_t referenceTime;
+    uint32_t numSamples;
+    uint32_t computed;      // ACCEL_FEATURE_* already computed for ev
+
+    struct AccelFeatures features;
+} mCache;
+
+static uint32_t accelFeaturesClosure(uint32_t features)
+{
+    if (features & ACCEL_FEATURE_TILT)
+        features |= ACCEL_FEATURE_UNIT;
+    if (features & ACCEL_FEATURE_UNIT)
+        features |= ACCEL_FEATURE_MAGNITUDE;
+
+    return features;
+}
+
+static void accelFeaturesComputeMissing(struct AccelFeatureSample *f, uint32_t features)
+{
+    float inv, uz;
+
+    if (features & ACCEL_FEATURE_MAGNITUDE) {
+        f->mag2 = f->x * f->x + f->y * f->y + f->z * f->z;
+        f->mag = sqrtf(f->mag2);
+    }
+
+    if (features & ACCEL_FEATURE_UNIT) {
+        if (f->mag > 0.0f) {
+            inv = 1.0f / f->mag;
+            f->ux = f->x * inv;
+            f->uy = f->y * inv;
+            f->uz = f->z * inv;
+        } else {
+            f->ux = f->uy = f->uz = 0.0f;
+        }
+    }
+
+    if (features & ACCEL_FEATURE_TILT) {
+        // rounding can push uz just past +-1
+        uz = f->uz > 1.0f ? 1.0f : (f->uz < -1.0f ? -1.0f : f->uz);
+        f->tilt = asinf(uz) * RADIANS_TO_DEGREES;
+    }
+}
+
+void accelFeaturesCompute(struct AccelFeatureSample *f, uint32_t features)
+{
+    accelFeaturesComputeMissing(f, accelFeaturesClosure(features));
+}
+
+static void accelFeaturesLoad(const struct TripleAxisDataEvent *ev)
+{
+    struct AccelFeatures *feat = &mCache.features;
+    struct AccelFeatureSample *f;
+    uint64_t time = ev->referenceTime;
+    uint32_t numSamples = ev->samples[0].firstSample.numSamples;
+    uint32_t i;
+
+    if (numSamples > ACCEL_FEATURES_MAX_SAMPLES) {
+        osLog(LOG_WARN, "accel features: %" PRIu32 " samples, only using %d\n",
+              numSamples, ACCEL_FEATURES_MAX_SAMPLES);
+        numSamples = ACCEL_FEATURES_MAX_SAMPLES;
+    }
+
+    for (i = 0; i < numSamples; i++) {
+        f = &feat->samples[i];
+
+        if (i > 0)
+            time += ev->samples[i].deltaTime;
+
+        f->time = time;
+        f->x = ev->samples[i].x;
+        f->y = ev->samples[i].y;
+        f->z = ev->samples[i].z;
+    }
+
+    feat->numSamples = numSamples;
+}
+
+const struct AccelFeatures *accelFeaturesGet(const struct TripleAxisDataEvent *ev, uint32_t features)
+{
+    struct AccelFeatures *feat = &mCache.features;
+    uint32_t numSamples = ev->samples[0].firstSample.numSamples;
+    uint32_t missing, i;
+
+    if (mCache.ev != ev || mCache.referenceTime != ev->referenceTime
+            || mCache.numSamples != numSamples) {
+        accelFeaturesLoad(ev);
+        mCache.ev = ev;
+        mCache.referenceTime = ev->referenceTime;
+        mCache.numSamples = numSamples;
+        mCache.computed = 0;
+    }
+
+    missing = accelFeaturesClosure(features) & ~mCache.computed;
+    if (missing) {
+        for (i = 0; i < feat->numSamples; i++)
+            accelFeaturesComputeMissing(&feat->samples[i], missing);
+        mCache.computed |= missing;
+    }
+
+    return feat;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algos/als_prox_onchange.h>
+#include <cpu/cpuMath.h>
+
+void alsProxOnChangeInit(struct AlsProxOnChange *oc, uint16_t maxCount, uint16_t relPermille,
+                         uint16_t minDelta, uint16_t pollMs, uint8_t persistence)
+{
+    oc->maxCount = maxCount;
+    oc->relPermille = relPermille;
+    oc->minDelta = minDelta;
+    oc->pollMs = pollMs;
+    oc->persistence = persistence;
+    oc->startTime = 0;
+    oc->wakeups = 0;
+    oc->reports = 0;
+    alsProxOnChangeInvalidate(oc);
+}
+
+void alsProxOnChangeStart(struct AlsProxOnChange *oc, uint64_t now)
+{
+    oc->startTime = now;
+    oc->wakeups = 0;
+    oc->reports = 0;
+    alsProxOnChangeInvalidate(oc);
+}
+
+void alsProxOnChangeInvalidate(struct AlsProxOnChange *oc)
+{
+    oc->low = oc->maxCount;
+    oc->high = 0;
+    oc->outside = 0;
+    oc->valid = false;
+}
+
+bool alsProxOnChangeSample(struct AlsProxOnChange *oc, uint16_t raw)
+{
+    uint32_t half;
+
+    oc->wakeups++;
+
+    if (oc->valid) {
+        if (raw >= oc->low && raw <= oc->high) {
+            oc->outside = 0;
+            return false;
+        } else if (++oc->outside < oc->persistence) {
+            return false;
+        }
+    }
+
+    half = ((uint32_t)raw * oc->relPermille) / 1000;
+    if (half < oc->minDelta)
+        half = oc->minDelta;
+
+    oc->low = raw > half ? raw - half : 0;
+    oc->high = raw + half < oc->maxCount ? raw + half : oc->maxCount;
+    oc->outside = 0;
+    oc->valid = true;
+    oc->reports++;
+
+    return true;
+}
+
+void alsProxOnChangeSkip(struct AlsProxOnChange *oc)
+{
+    oc->wakeups++;
+}
+
+void alsProxOnChangeGetStats(const struct AlsProxOnChange *oc, uint64_t now,
+                             struct AlsProxOnChangeStats *stats)
+{
+    uint32_t polls;
+
+    stats->elapsedMs = (uint32_t)cpuMathU64DivByU16(cpuMathU64DivByU16(now - oc->startTime, 1000), 1000);
+    stats->wakeups = oc->wakeups;
+    stats->reports = oc->reports;
+
+    polls = oc->pollMs ? stats->elapsedMs / oc->pollMs : 0;
+    stats->saved = polls > oc->wakeups ? polls - oc->wakeups : 0;
+}
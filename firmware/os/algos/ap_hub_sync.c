@@ -16,6 +16,7 @@
 
 #include <algos/ap_hub_sync.h>
 #include <cpu/cpuMath.h>
+#include <floatRt.h>
 
 #include <limits.h>
 #include <seos.h>
@@ -24,8 +25,9 @@
 
 #define SYNC_EXPIRATION     S_IN_NS(50) //50 sec in ns, at max 500us diff
 #define SYNC_WINDOW_TIMEOUT S_IN_NS(2)  //2 sec in ns
-#define SYNC_FILTER_B       8
-#define SYNC_FILTER_A       1
+#define SYNC_MIN_FIT_SPAN   S_IN_NS(6)  //do not estimate skew from less than 6 sec of windows
+#define SYNC_OUTLIER        200000      //200us in ns, windows this far below the fit are dropped
+#define SYNC_MAX_SKEW       0.0002f     //200 ppm, crystals are well within that
 
 #define DEBUG_SYNC          false
 
@@ -37,11 +39,117 @@ enum ApHubSyncState {
 
 void apHubSyncReset(struct ApHubSync* sync) {
     sync->state = 0;
+    sync->numPoints = 0;
+    sync->nextPoint = 0;
     if (DEBUG_SYNC) {
         osLog(LOG_DEBUG, "ApHub sync reset");
     }
 }
 
+static int apHubSyncPointIndex(const struct ApHubSync* sync, int i) {
+    // i-th oldest point
+    int idx = sync->nextPoint - sync->numPoints + i;
+    return idx < 0 ? idx + APHUB_SYNC_NUM_POINTS : idx;
+}
+
+// least squares line through the used points, relative to (refHubTime, refDelta)
+static bool apHubSyncFitLine(const struct ApHubSync* sync, const bool *used, uint64_t refHubTime,
+                             int64_t refDelta, float *meanX, float *meanY, float *skew) {
+    float x[APHUB_SYNC_NUM_POINTS], y[APHUB_SYNC_NUM_POINTS];
+    float sumX = 0.0f, sumY = 0.0f, sxx = 0.0f, sxy = 0.0f;
+    float dx;
+    int i, idx, n = 0;
+
+    for (i = 0; i < sync->numPoints; i++) {
+        if (!used[i])
+            continue;
+        idx = apHubSyncPointIndex(sync, i);
+        x[n] = floatFromInt64(sync->pointHubTime[idx] - refHubTime);
+        y[n] = floatFromInt64(sync->pointDelta[idx] - refDelta);
+        sumX += x[n];
+        sumY += y[n];
+        n++;
+    }
+
+    if (n < 2)
+        return false;
+
+    *meanX = sumX / n;
+    *meanY = sumY / n;
+    for (i = 0; i < n; i++) {
+        dx = x[i] - *meanX;
+        sxx += dx * dx;
+        sxy += dx * (y[i] - *meanY);
+    }
+
+    if (sxx <= 0.0f)
+        return false;
+
+    *skew = sxy / sxx;
+    if (*skew > SYNC_MAX_SKEW)
+        *skew = SYNC_MAX_SKEW;
+    else if (*skew < -SYNC_MAX_SKEW)
+        *skew = -SYNC_MAX_SKEW;
+
+    return true;
+}
+
+static void apHubSyncFit(struct ApHubSync* sync) {
+    bool used[APHUB_SYNC_NUM_POINTS];
+    int newest = apHubSyncPointIndex(sync, sync->numPoints - 1);
+    int oldest = apHubSyncPointIndex(sync, 0);
+    uint64_t refHubTime = sync->pointHubTime[oldest];
+    int64_t refDelta = sync->pointDelta[newest];
+    float meanX, meanY, skew, x, residual, pivot;
+    int i, idx;
+
+    // the line is pivoted on the newest point's hub time, where most queries happen
+    sync->fitHubTime = sync->pointHubTime[newest];
+
+    if (sync->numPoints < 2 || sync->pointHubTime[newest] - refHubTime < SYNC_MIN_FIT_SPAN) {
+        // not enough history for a skew; behave like a plain windowed max
+        sync->fitDelta = refDelta;
+        sync->fitSkew = 0.0f;
+        sync->fitSkewValid = false;
+        return;
+    }
+
+    for (i = 0; i < sync->numPoints; i++)
+        used[i] = true;
+
+    if (!apHubSyncFitLine(sync, used, refHubTime, refDelta, &meanX, &meanY, &skew)) {
+        sync->fitDelta = refDelta;
+        sync->fitSkew = 0.0f;
+        sync->fitSkewValid = false;
+        return;
+    }
+
+    // drop windows that sit well below the envelope and refit once
+    for (i = 0; i < sync->numPoints; i++) {
+        idx = apHubSyncPointIndex(sync, i);
+        x = floatFromInt64(sync->pointHubTime[idx] - refHubTime);
+        residual = floatFromInt64(sync->pointDelta[idx] - refDelta) - (meanY + skew * (x - meanX));
+        if (residual < -SYNC_OUTLIER)
+            used[i] = false;
+    }
+    apHubSyncFitLine(sync, used, refHubTime, refDelta, &meanX, &meanY, &skew);
+
+    pivot = floatFromInt64(sync->fitHubTime - refHubTime);
+    sync->fitDelta = refDelta + floatToInt64(meanY + skew * (pivot - meanX));
+    sync->fitSkew = skew;
+    sync->fitSkewValid = true;
+}
+
+static void apHubSyncAddPoint(struct ApHubSync* sync, uint64_t hubTime, int64_t delta) {
+    sync->pointHubTime[sync->nextPoint] = hubTime;
+    sync->pointDelta[sync->nextPoint] = delta;
+    sync->nextPoint = (sync->nextPoint + 1) % APHUB_SYNC_NUM_POINTS;
+    if (sync->numPoints < APHUB_SYNC_NUM_POINTS)
+        sync->numPoints++;
+
+    apHubSyncFit(sync);
+}
+
 void apHubSyncAddDelta(struct ApHubSync* sync, uint64_t apTime, uint64_t hubTime) {
 
     int64_t delta = apTime - hubTime;
@@ -56,24 +164,24 @@ void apHubSyncAddDelta(struct ApHubSync* sync, uint64_t apTime, uint64_t hubTime
     if (sync->state == NOT_INITED) {
         // setup the windowMax before switching state
         sync->windowMax = delta;
+        sync->windowMaxHubTime = hubTime;
         sync->windowTimeout = apTime + SYNC_WINDOW_TIMEOUT;
 
         sync->state = USE_MAX;
     } else {
-        sync->windowMax = (delta > sync->windowMax) ? delta : sync->windowMax;
+        if (delta > sync->windowMax) {
+            sync->windowMax = delta;
+            sync->windowMaxHubTime = hubTime;
+        }
         if (apTime > sync->windowTimeout) {
             // collected a window
 
-            // setup deltaEstimation before switching state
-            if (sync->state == USE_MAX) {
-                sync->deltaEstimation = sync->windowMax;
-            } else {
-                sync->deltaEstimation = ((SYNC_FILTER_B - SYNC_FILTER_A) * sync->deltaEstimation +
-                                   SYNC_FILTER_A * sync->windowMax) / SYNC_FILTER_B;
-            }
+            // setup the fit before switching state
+            apHubSyncAddPoint(sync, sync->windowMaxHubTime, sync->windowMax);
             sync->state = USE_FILTERED;
             if (DEBUG_SYNC) {
-                osLog(LOG_DEBUG, "ApHub new sync offset = %" PRId64, sync->deltaEstimation);
+                osLog(LOG_DEBUG, "ApHub new sync offset = %" PRId64 ", skew = %" PRId32 " ppb",
+                      sync->fitDelta, (int32_t)(sync->fitSkew * 1e9f));
             }
             // start new window by resetting windowMax and windowTimeout after this window is done
             sync->windowMax = INT64_MIN;
@@ -92,7 +200,9 @@ int64_t apHubSyncGetDelta(struct ApHubSync* sync, uint64_t hubTime) {
             ret = sync->windowMax;
             break;
         case USE_FILTERED:
-            ret = sync->deltaEstimation;
+            ret = sync->fitDelta;
+            if (sync->fitSkewValid)
+                ret += floatToInt64(sync->fitSkew * floatFromInt64(hubTime - sync->fitHubTime));
             break;
         default:
             // indicate error, should never happen
@@ -102,5 +212,3 @@ int64_t apHubSyncGetDelta(struct ApHubSync* sync, uint64_t hubTime) {
     }
     return ret;
 }
-
-
@@ -16,6 +16,7 @@
 
 #include "calibration/diversity_checker/diversity_checker.h"
 
+#include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -23,6 +24,12 @@
 #include "common/math/vec.h"
 #include "chre/util/nanoapp/assert.h"
 
+// Fraction of max_distance the bounding sphere has to stay within for the
+// max_distance check to be skipped, and how much the sphere is grown on top of
+// what is needed; both keep float rounding on the safe side.
+#define FAR_MARGIN (0.99f)
+#define BOUND_SLACK (1.0e-5f)
+
 // Struct initialization.
 void diversityCheckerInit(struct DiversityChecker* diverse_data,
                           const struct DiversityCheckerParameters* parameters) {
@@ -69,6 +76,52 @@ void diversityCheckerReset(struct DiversityChecker* diverse_data) {
   diverse_data->num_points = 0;
   diverse_data->num_max_dist_violations = 0;
   diverse_data->data_full = false;
+
+  diverse_data->bound_radius = -1.0f;
+  diverse_data->last_near = 0;
+}
+
+// Grows the bounding sphere to include vec.
+static void diversityCheckerBoundAdd(struct DiversityChecker* diverse_data,
+                                     const float* vec) {
+  float vec_diff[THREE_AXIS_DATA_DIM];
+  float dist, radius;
+
+  if (diverse_data->bound_radius < 0.0f) {
+    memcpy(diverse_data->bound_center, vec,
+           sizeof(diverse_data->bound_center));
+    diverse_data->bound_radius =
+        BOUND_SLACK * vecMaxAbsoluteValue(vec, THREE_AXIS_DATA_DIM);
+    return;
+  }
+
+  vecSub(vec_diff, vec, diverse_data->bound_center, THREE_AXIS_DATA_DIM);
+  dist = sqrtf(vecNormSquared(vec_diff, THREE_AXIS_DATA_DIM));
+  if (dist <= diverse_data->bound_radius) {
+    return;
+  }
+
+  // Smallest sphere holding both the old sphere and vec.
+  radius = 0.5f * (diverse_data->bound_radius + dist);
+  vecScalarMulInPlace(vec_diff, (radius - diverse_data->bound_radius) / dist,
+                      THREE_AXIS_DATA_DIM);
+  vecAddInPlace(diverse_data->bound_center, vec_diff, THREE_AXIS_DATA_DIM);
+  diverse_data->bound_radius =
+      radius + BOUND_SLACK * (radius + vecMaxAbsoluteValue(
+                                           diverse_data->bound_center,
+                                           THREE_AXIS_DATA_DIM));
+}
+
+// Returns true if no data point can violate max_distance against vec.
+static bool diversityCheckerAllWithinReach(
+    const struct DiversityChecker* diverse_data, const float* vec) {
+  float vec_diff[THREE_AXIS_DATA_DIM];
+  float reach;
+
+  vecSub(vec_diff, vec, diverse_data->bound_center, THREE_AXIS_DATA_DIM);
+  reach = sqrtf(vecNormSquared(vec_diff, THREE_AXIS_DATA_DIM)) +
+          diverse_data->bound_radius;
+  return reach * reach <= diverse_data->max_distance * FAR_MARGIN;
 }
 
 bool diversityCheckerFindNearestPoint(struct DiversityChecker* diverse_data,
@@ -82,7 +135,29 @@ bool diversityCheckerFindNearestPoint(struct DiversityChecker* diverse_data,
   // normSquared result (k)
   float norm_squared_result;
 
-  size_t i;
+  size_t i, n;
+
+  // When no point can be too far away, the answer only depends on whether one
+  // is too close, and the points can be checked in any order.
+  if (diverse_data->num_points > 0 &&
+      diversityCheckerAllWithinReach(diverse_data, vec)) {
+    i = diverse_data->last_near < diverse_data->num_points
+            ? diverse_data->last_near
+            : 0;
+    for (n = 0; n < diverse_data->num_points; ++n) {
+      vecSub(vec_diff, &diverse_data->diverse_data[i * THREE_AXIS_DATA_DIM],
+             vec, THREE_AXIS_DATA_DIM);
+      norm_squared_result = vecNormSquared(vec_diff, THREE_AXIS_DATA_DIM);
+      if (norm_squared_result < diverse_data->threshold) {
+        diverse_data->last_near = i;
+        return false;
+      }
+      if (++i == diverse_data->num_points) {
+        i = 0;
+      }
+    }
+    return true;
+  }
 
   // Running over all existing data points
   for (i = 0; i < diverse_data->num_points; ++i) {
@@ -95,6 +170,7 @@ bool diversityCheckerFindNearestPoint(struct DiversityChecker* diverse_data,
 
     // if k < Threshold then leave the function.
     if (norm_squared_result < diverse_data->threshold) {
+      diverse_data->last_near = i;
       return false;
     }
 
@@ -125,6 +201,8 @@ void diversityCheckerUpdate(struct DiversityChecker* diverse_data, float x,
                ->diverse_data[diverse_data->num_points * THREE_AXIS_DATA_DIM],
           vec, sizeof(float) * THREE_AXIS_DATA_DIM);
 
+      diversityCheckerBoundAdd(diverse_data, vec);
+
       // Count new data point.
       diverse_data->num_points++;
 
@@ -39,6 +39,13 @@
  *
  * Notice, this function stops to check if data is diverse, once the memory is
  * full. This has been done in order to save processing power.
+ *
+ * To keep the per-sample cost down as the memory fills, a sphere enclosing all
+ * stored vectors is maintained. When it shows that no stored vector can be
+ * further than max_distance, the search starts at the vector that was too
+ * close last time (consecutive samples are close to each other); otherwise all
+ * vectors are checked in order as before. Either way the results are the same
+ * as checking all vectors in order.
  */
 
 #ifndef LOCATION_LBS_CONTEXTHUB_NANOAPPS_CALIBRATION_DIVERSITY_CHECKER_DIVERSITY_CHECKER_H_
@@ -112,6 +119,13 @@ struct DiversityChecker {
   // Data full bit.
   bool data_full;
 
+  // Sphere enclosing all data points, bound_radius < 0 when empty.
+  float bound_center[THREE_AXIS_DATA_DIM];
+  float bound_radius;
+
+  // Data point that was too close to the last rejected input.
+  size_t last_near;
+
   // Setup variables for NormQuality check.
   size_t min_num_diverse_vectors;
   size_t max_num_max_distance;
@@ -17,8 +17,10 @@
 // adapted from frameworks/native/services/sensorservice/Fusion.cpp
 
 #include <algos/fusion.h>
+#include <algos/accel_features.h>
 
 #include <errno.h>
+#include <fast_math.h>
 #include <nanohub_math.h>
 #include <stdio.h>
 
@@ -288,12 +290,18 @@ static void fusionPredict(struct Fusion *fusion, const struct Vec3 *w) {
     float lwedT = norm_we * dT;
     float hlwedT = 0.5f * lwedT;
     float ilwe = 1.0f / norm_we;
-    float k0 = (1.0f - cosf(lwedT)) * (ilwe * ilwe);
-    float k1 = sinf(lwedT);
-    float k2 = cosf(hlwedT);
+    float shlwedT, chlwedT;
+
+    // everything below derives from the half angle:
+    // 1 - cos(a) = 2 sin^2(a/2), sin(a) = 2 sin(a/2) cos(a/2)
+    fastSinCosf(hlwedT, &shlwedT, &chlwedT);
+
+    float k0 = 2.0f * shlwedT * shlwedT * (ilwe * ilwe);
+    float k1 = 2.0f * shlwedT * chlwedT;
+    float k2 = chlwedT;
 
     struct Vec3 psi = we;
-    vec3ScalarMul(&psi, sinf(hlwedT) * ilwe);
+    vec3ScalarMul(&psi, shlwedT * ilwe);
 
     struct Vec3 negPsi = psi;
     vec3ScalarMul(&negPsi, -1.0f);
@@ -511,18 +519,29 @@ static void fusionUpdate(
 #define ACC_COS_CONV_LIMIT   3.f
 
 int fusionHandleAcc(struct Fusion *fusion, const struct Vec3 *a, float dT) {
-    if (!fusion_init_complete(fusion, ACC, a,  dT)) {
+    struct AccelFeatureSample f;
+
+    f.x = a->x;
+    f.y = a->y;
+    f.z = a->z;
+    accelFeaturesCompute(&f, ACCEL_FEATURE_UNIT);
+
+    return fusionHandleAccFeatures(fusion, &f, dT);
+}
+
+int fusionHandleAccFeatures(struct Fusion *fusion, const struct AccelFeatureSample *f, float dT) {
+    struct Vec3 a;
+
+    initVec3(&a, f->x, f->y, f->z);
+    if (!fusion_init_complete(fusion, ACC, &a,  dT)) {
         return -EINVAL;
     }
 
-    float norm2 = vec3NormSquared(a);
-
-    if (norm2 < FREE_FALL_THRESHOLD_SQ) {
+    if (f->mag2 < FREE_FALL_THRESHOLD_SQ) {
         return -EINVAL;
     }
 
-    float l = sqrtf(norm2);
-    float l_inv = 1.0f / l;
+    float l = f->mag;
 
     if (!(fusion->flags & FUSION_USE_GYRO)) {
         // geo mag mode
@@ -552,8 +571,8 @@ int fusionHandleAcc(struct Fusion *fusion, const struct Vec3 *a, float dT) {
         fusion->fake_mag_decimation = 0.f;
     }
 
-    struct Vec3 unityA = *a;
-    vec3ScalarMul(&unityA, l_inv);
+    struct Vec3 unityA;
+    initVec3(&unityA, f->ux, f->uy, f->uz);
 
     float d = fabsf(l - NOMINAL_GRAVITY);
     float p;
@@ -61,6 +61,7 @@ extern uint8_t __code_start[];
 extern uint8_t __code_end[];
 extern uint8_t __shared_start[];
 extern uint8_t __shared_end[];
+extern volatile uint32_t __bl_flash_gen[];
 
 enum BlFlashType
 {
@@ -125,6 +126,17 @@ static uint32_t blExtApiGetVersion(void)
     return BL_VERSION_CUR;
 }
 
+static uint32_t blExtApiGetFlashGen(void)
+{
+    return __bl_flash_gen[0];
+}
+
+//called before the flash is touched, so that a write cut short by a reset is seen as one
+static void blFlashGenAdvance(void)
+{
+    __bl_flash_gen[0]++;
+}
+
 static bool blProgramFlash(uint8_t *dst, const uint8_t *src, uint32_t length, uint32_t key1, uint32_t key2)
 {
     const uint32_t sector_cnt = sizeof(mBlFlashTable) / sizeof(struct blFlashTable);
@@ -167,6 +179,7 @@ static bool blProgramFlash(uint8_t *dst, const uint8_t *src, uint32_t length, ui
         }
     }
 
+    blFlashGenAdvance();
     if (!blPlatProgramFlash(dst, src, length, key1, key2))
         return false;
 
@@ -222,8 +235,10 @@ static bool blEraseTypedArea(uint32_t type, uint32_t key1, uint32_t key2)
         }
     }
 
-    if (erase_cnt)
+    if (erase_cnt) {
+        blFlashGenAdvance();
         blEraseSectors(sector_cnt, erase_mask, key1, key2);
+    }
 
     return true; //we assume erase worked
 }
@@ -715,4 +730,5 @@ const struct BlApiTable __attribute__((section(".blapi"))) __BL_API =
     .blAesCbcDecr = &aesCbcDecr,
     .blSigPaddingVerify = &blExtApiSigPaddingVerify,
     .blVerifyOsUpdate = &blExtApiVerifyOsUpdate,
+    .blGetFlashGen = &blExtApiGetFlashGen,
 };
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include <bl.h>
+#include <bootCache.h>
+#include <cpu.h>
+
+#include <nanohub/crc.h>
+
+#define BOOT_CACHE_MAGIC    0x48434256 //"VBCH"
+
+struct BootCacheEntry {
+    uint32_t start;
+    uint32_t len;
+    uint32_t crc;               //as stored with the segment
+};
+
+struct BootCache {
+    uint32_t magic;
+    uint32_t self;              //where the record was sealed; a different OS build may put it elsewhere
+    uint32_t flashGen;          //bootloader flash generation the entries are good for
+    uint32_t num;
+    struct BootCacheEntry entries[BOOT_CACHE_MAX_ENTRIES];
+    uint32_t seal;              //crc of all of the above
+};
+
+//not zeroed at boot: a warm reset finds it as it was left
+static struct BootCache __attribute__((section(".neverinit"))) mBootCache;
+
+static struct BootStats mStats;
+static uint32_t mLastCycles;
+static uint32_t mNowUs;
+
+//older bootloaders neither count flash writes nor start the cycle counter
+static bool bootCacheBlCurrent(void)
+{
+    return BL.blGetVersion() >= BL_VERSION_2;
+}
+
+static uint32_t bootCacheFlashGen(void)
+{
+    return bootCacheBlCurrent() ? BL.blGetFlashGen() : 0;
+}
+
+static uint32_t bootCacheCalcSeal(void)
+{
+    return soft_crc32(&mBootCache, offsetof(struct BootCache, seal), ~0);
+}
+
+static void bootCacheSeal(void)
+{
+    mBootCache.seal = bootCacheCalcSeal();
+}
+
+void bootCacheClear(void)
+{
+    mBootCache.magic = BOOT_CACHE_MAGIC;
+    mBootCache.self = (uint32_t)(uintptr_t)&mBootCache;
+    mBootCache.num = 0;
+    memset(mBootCache.entries, 0, sizeof(mBootCache.entries));
+    bootCacheSeal();
+}
+
+void bootCacheInit(bool warm)
+{
+    uint32_t flashGen = bootCacheFlashGen();
+    bool valid = mBootCache.magic == BOOT_CACHE_MAGIC &&
+                 mBootCache.self == (uint32_t)(uintptr_t)&mBootCache &&
+                 mBootCache.num <= BOOT_CACHE_MAX_ENTRIES &&
+                 mBootCache.seal == bootCacheCalcSeal();
+
+    //flash written since the record was sealed (by the bootloader for the host, or by an OS
+    //that was reset before it could account for its own write) may have changed any segment
+    mStats.warm = warm && valid && bootCacheBlCurrent() && mBootCache.flashGen == flashGen;
+    if (!mStats.warm) {
+        mBootCache.flashGen = flashGen;
+        bootCacheClear();
+    }
+}
+
+void bootCacheFlashWritten(void)
+{
+    mBootCache.flashGen = bootCacheFlashGen();
+    bootCacheSeal();
+}
+
+static struct BootCacheEntry *bootCacheFind(uint32_t start)
+{
+    uint32_t i;
+
+    for (i = 0; i < mBootCache.num; i++) {
+        if (mBootCache.entries[i].start == start)
+            return &mBootCache.entries[i];
+    }
+
+    return NULL;
+}
+
+bool bootCacheCheck(const void *start, uint32_t len, uint32_t crc)
+{
+    struct BootCacheEntry *entry = bootCacheFind((uintptr_t)start);
+
+    if (entry && entry->len == len && entry->crc == crc) {
+        mStats.appsCached++;
+        return true;
+    }
+
+    mStats.appsChecked++;
+    return false;
+}
+
+void bootCacheAdd(const void *start, uint32_t len, uint32_t crc)
+{
+    struct BootCacheEntry *entry = bootCacheFind((uintptr_t)start);
+
+    if (!entry) {
+        if (mBootCache.num == BOOT_CACHE_MAX_ENTRIES)
+            return;
+        entry = &mBootCache.entries[mBootCache.num++];
+    }
+
+    entry->start = (uintptr_t)start;
+    entry->len = len;
+    entry->crc = crc;
+    bootCacheSeal();
+}
+
+void bootCacheForget(const void *start, uint32_t len)
+{
+    uint32_t begin = (uintptr_t)start, end = begin + len;
+    struct BootCacheEntry *entry;
+    uint32_t i;
+
+    for (i = 0; i < mBootCache.num; ) {
+        entry = &mBootCache.entries[i];
+        if (entry->start < end && begin < entry->start + entry->len)
+            *entry = mBootCache.entries[--mBootCache.num];
+        else
+            i++;
+    }
+    bootCacheSeal();
+}
+
+void bootPhaseStart(void)
+{
+    //without a count from bootloader entry the bootloader phase reads as 0
+    mLastCycles = bootCacheBlCurrent() ? 0 : cpuGetCycles();
+    bootPhaseMark(BOOT_PHASE_BL);
+}
+
+void bootPhaseMark(enum BootPhase phase)
+{
+    uint32_t cycles = cpuGetCycles();
+    uint32_t perUs = cpuGetCyclesPerUs();
+
+    //the clock may change during boot, so convert each step at the speed it ended at
+    mNowUs += (cycles - mLastCycles) / (perUs ? perUs : 1);
+    mLastCycles = cycles;
+
+    if (phase < BOOT_PHASE_NUM)
+        mStats.phaseUs[phase] = mNowUs;
+}
+
+void bootStatsGet(struct BootStats *stats)
+{
+    *stats = mStats;
+}
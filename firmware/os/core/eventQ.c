@@ -20,6 +20,7 @@
 #include <timer.h>
 #include <stdio.h>
 #include <heap.h>
+#include <poolStats.h>
 #include <slab.h>
 #include <cpu.h>
 #include <util.h>
@@ -46,6 +47,10 @@ struct EvtQueue {
     struct EvtList head;
     struct SlabAllocator *evtsSlab;
     EvtQueueForciblyDiscardEvtCbkF forceDiscardCbk;
+    uint32_t count;
+    uint32_t peak;
+    uint32_t fails;
+    uint32_t discards;
 };
 
 static inline void __evtListDel(struct EvtList *prev, struct EvtList *next)
@@ -71,6 +76,10 @@ struct EvtQueue* evtQueueAlloc(uint32_t size, EvtQueueForciblyDiscardEvtCbkF for
         q->evtsSlab = slab;
         q->head.next = &q->head;
         q->head.prev = &q->head;
+        q->count = 0;
+        q->peak = 0;
+        q->fails = 0;
+        q->discards = 0;
         return q;
     }
 
@@ -119,6 +128,8 @@ bool evtQueueEnqueue(struct EvtQueue* q, uint32_t evtType, void *evtData,
                 continue;
             q->forceDiscardCbk(rec->evtType, rec->evtData, rec->evtFreeData);
             evtListDel(pos);
+            q->count--;
+            q->discards++;
             item = pos;
         }
         cpuIntsRestore (intSta);
@@ -126,8 +137,12 @@ bool evtQueueEnqueue(struct EvtQueue* q, uint32_t evtType, void *evtData,
         item = &rec->item;
     }
 
-    if (!item)
+    if (!item) {
+        intSta = cpuIntsOff();
+        q->fails++;
+        cpuIntsRestore(intSta);
         return false;
+    }
 
     item->prev = item->next = NULL;
 
@@ -149,6 +164,8 @@ bool evtQueueEnqueue(struct EvtQueue* q, uint32_t evtType, void *evtData,
     item->prev = a;
     b->prev = item;
     item->next = b;
+    if (++q->count > q->peak)
+        q->peak = q->count;
 
     cpuIntsRestore(intSta);
     platWake();
@@ -168,6 +185,7 @@ void evtQueueRemoveAllMatching(struct EvtQueue* q,
         if (match(rec->evtType, rec->evtData, context)) {
             q->forceDiscardCbk(rec->evtType, rec->evtData, rec->evtFreeData);
             evtListDel(pos);
+            q->count--;
             slabAllocatorFree(q->evtsSlab, rec);
         }
     }
@@ -188,6 +206,7 @@ bool evtQueueDequeue(struct EvtQueue* q, uint32_t *evtTypeP, void **evtDataP,
         if (pos != &q->head) {
             rec = container_of(pos, struct EvtRecord, item);
             evtListDel(pos);
+            q->count--;
             break;
         }
         else if (!sleepIfNone)
@@ -214,3 +233,27 @@ bool evtQueueDequeue(struct EvtQueue* q, uint32_t *evtTypeP, void **evtDataP,
 
     return true;
 }
+
+uint32_t evtQueueGetCount(struct EvtQueue* q)
+{
+    return q->count;
+}
+
+void evtQueueGetStats(struct EvtQueue* q, struct PoolStats *stats, bool reset)
+{
+    uint64_t intSta = cpuIntsOff();
+
+    stats->size = slabAllocatorGetNumItems(q->evtsSlab);
+    stats->used = q->count;
+    stats->peak = q->peak;
+    stats->fails = q->fails;
+    stats->discards = q->discards;
+
+    if (reset) {
+        q->peak = q->count;
+        q->fails = 0;
+        q->discards = 0;
+    }
+
+    cpuIntsRestore(intSta);
+}
@@ -59,14 +59,51 @@ struct HeapNode {
 
 #endif
 
-static struct HeapNode* gHeapHead;
+/*
+ * With app isolation (see cpuAppIsolationInit) the end of the heap is given
+ * to a second heap in RAM that isolated apps may write. Only heapAllocApp()
+ * allocates there, for memory handed to apps; everything the OS keeps for
+ * itself comes from the main heap, even while an app's syscall is running.
+ * A chunk is freed in whichever heap holds it. Apps can corrupt the headers
+ * in their heap, so walking it never leaves it.
+ */
+enum HeapZoneId {
+    HEAP_ZONE_OS,
+    HEAP_ZONE_APPS,
+
+    HEAP_ZONE_NUM
+};
+
+struct HeapZone {
+    struct HeapNode *head;  /* NULL if not set up */
+    struct HeapNode *tail;
+    uint8_t *end;
+    volatile uint8_t needFreeMerge; /* cannot be bool since its size is ill defined */
+};
+
+static struct HeapZone gHeaps[HEAP_ZONE_NUM];
 static TRYLOCK_DECL_STATIC(gHeapLock) = TRYLOCK_INIT_STATIC();
-static volatile uint8_t gNeedFreeMerge = false; /* cannot be bool since its size is ill defined */
-static struct HeapNode *gHeapTail;
 
-static inline struct HeapNode* heapPrvGetNext(struct HeapNode* node)
+static inline bool heapPrvInZone(const struct HeapZone *zone, const struct HeapNode *node)
+{
+    return node >= zone->head && node <= zone->tail;
+}
+
+static inline struct HeapNode* heapPrvGetNext(const struct HeapZone *zone, struct HeapNode* node)
 {
-    return (gHeapTail == node) ? NULL : (struct HeapNode*)(node->data + node->size);
+    struct HeapNode *next = (struct HeapNode*)(node->data + node->size);
+
+    return (zone->tail == node || next > zone->tail) ? NULL : next;
+}
+
+static struct HeapZone *heapPrvZoneOf(const void *ptr)
+{
+    struct HeapZone *apps = &gHeaps[HEAP_ZONE_APPS];
+
+    if ((const uint8_t*)ptr > (const uint8_t*)apps->head && (const uint8_t*)ptr < apps->end)
+        return apps;
+
+    return &gHeaps[HEAP_ZONE_OS];
 }
 
 bool heapInit(void)
@@ -74,12 +111,13 @@ bool heapInit(void)
     uint32_t size = REAL_HEAP_SIZE;
     struct HeapNode* node;
 
-    node = gHeapHead = (struct HeapNode*)ALIGNED_HEAP_START;
+    node = (struct HeapNode*)ALIGNED_HEAP_START;
 
     if (size < sizeof(struct HeapNode))
         return false;
 
-    gHeapTail = node;
+    gHeaps[HEAP_ZONE_OS].head = gHeaps[HEAP_ZONE_OS].tail = node;
+    gHeaps[HEAP_ZONE_OS].end = (uint8_t*)node + size;
 
     node->used = 0;
     node->prev = NULL;
@@ -89,22 +127,22 @@ bool heapInit(void)
 }
 
 //called to merge free chunks in case free() was unable to last time it tried. only call with lock held please
-static void heapMergeFreeChunks(void)
+static void heapMergeFreeChunks(struct HeapZone *zone)
 {
-    while (atomicXchgByte(&gNeedFreeMerge, false)) {
-        struct HeapNode *node = gHeapHead, *next;
+    while (atomicXchgByte(&zone->needFreeMerge, false)) {
+        struct HeapNode *node = zone->head, *next;
 
         while (node) {
-            next = heapPrvGetNext(node);
+            next = heapPrvGetNext(zone, node);
 
             if (!node->used && next && !next->used) { /* merged */
                 node->size += sizeof(struct HeapNode) + next->size;
 
-                next = heapPrvGetNext(node);
+                next = heapPrvGetNext(zone, node);
                 if (next)
                     next->prev = node;
                 else
-                    gHeapTail = node;
+                    zone->tail = node;
             }
             else
                 node = next;
@@ -112,7 +150,42 @@ static void heapMergeFreeChunks(void)
     }
 }
 
-void* heapAlloc(uint32_t sz)
+bool heapInitApps(void *start, uint32_t size)
+{
+    struct HeapZone *zone = &gHeaps[HEAP_ZONE_OS];
+    struct HeapNode *tail, *node = (struct HeapNode*)start;
+    bool ret = false;
+
+    if (((uintptr_t)start & 7) || (size & 7) || size <= sizeof(struct HeapNode))
+        return false;
+
+    if (!trylockTryTake(&gHeapLock))
+        return false;
+
+    //only the free end of the heap can be given away
+    heapMergeFreeChunks(zone);
+    tail = zone->tail;
+    if (!tail->used && (uint8_t*)node >= tail->data &&
+        (uint8_t*)node + size <= tail->data + tail->size) {
+
+        tail->size = (uint8_t*)node - tail->data;
+
+        node->used = 0;
+        node->tidx = 0;
+        node->prev = NULL;
+        node->size = size - sizeof(struct HeapNode);
+
+        gHeaps[HEAP_ZONE_APPS].head = gHeaps[HEAP_ZONE_APPS].tail = node;
+        gHeaps[HEAP_ZONE_APPS].end = (uint8_t*)node + size;
+        zone->end = (uint8_t*)node;
+        ret = true;
+    }
+
+    trylockRelease(&gHeapLock);
+    return ret;
+}
+
+static void* heapPrvAlloc(struct HeapZone *zone, uint32_t sz)
 {
     struct HeapNode *node, *best = NULL;
     void* ret = NULL;
@@ -121,10 +194,10 @@ void* heapAlloc(uint32_t sz)
         return NULL;
 
     /* merge free chunks to help better use space */
-    heapMergeFreeChunks();
+    heapMergeFreeChunks(zone);
 
     sz = (sz + 3) &~ 3;
-    node = gHeapHead;
+    node = zone->head;
 
     while (node) {
         if (!node->used && node->size >= sz && (!best || best->size > node->size)) {
@@ -133,7 +206,7 @@ void* heapAlloc(uint32_t sz)
                 break;
         }
 
-        node = heapPrvGetNext(node);
+        node = heapPrvGetNext(zone, node);
     }
 
     if (!best) //alloc failed
@@ -148,10 +221,10 @@ void* heapAlloc(uint32_t sz)
         node->size = best->size - sz - sizeof(struct HeapNode);
         node->prev = best;
 
-        if (best != gHeapTail)
-            heapPrvGetNext(node)->prev = node;
+        if (best != zone->tail)
+            heapPrvGetNext(zone, node)->prev = node;
         else
-            gHeapTail = node;
+            zone->tail = node;
 
         best->size = sz;
     }
@@ -165,8 +238,19 @@ out:
     return ret;
 }
 
+void* heapAlloc(uint32_t sz)
+{
+    return heapPrvAlloc(&gHeaps[HEAP_ZONE_OS], sz);
+}
+
+void* heapAllocApp(uint32_t sz)
+{
+    return heapPrvAlloc(&gHeaps[gHeaps[HEAP_ZONE_APPS].head ? HEAP_ZONE_APPS : HEAP_ZONE_OS], sz);
+}
+
 void heapFree(void* ptr)
 {
+    struct HeapZone *zone;
     struct HeapNode *node, *t;
     bool haveLock;
 
@@ -178,35 +262,37 @@ void heapFree(void* ptr)
 
     haveLock = trylockTryTake(&gHeapLock);
 
+    zone = heapPrvZoneOf(ptr);
     node = ((struct HeapNode*)ptr) - 1;
     node->used = 0;
     node->tidx = 0;
 
     if (haveLock) {
 
-        while (node->prev && !node->prev->used)
+        while (node->prev && heapPrvInZone(zone, node->prev) && !node->prev->used)
             node = node->prev;
 
-        while ((t = heapPrvGetNext(node)) && !t->used) {
+        while ((t = heapPrvGetNext(zone, node)) && !t->used) {
             node->size += sizeof(struct HeapNode) + t->size;
-            if (gHeapTail == t)
-                gHeapTail = node;
+            if (zone->tail == t)
+                zone->tail = node;
         }
 
-        if ((t = heapPrvGetNext(node)))
+        if ((t = heapPrvGetNext(zone, node)))
             t->prev = node;
 
         trylockRelease(&gHeapLock);
     }
     else
-        gNeedFreeMerge = true;
+        zone->needFreeMerge = true;
 }
 
 int heapFreeAll(uint32_t tid)
 {
+    struct HeapZone *zone;
     struct HeapNode *node;
     bool haveLock;
-    int count = 0;
+    int count = 0, zoneCount;
 
     if (!tid)
         return -1;
@@ -217,14 +303,18 @@ int heapFreeAll(uint32_t tid)
         return -1;
 
     tid &= TIDX_MASK;
-    for (node = gHeapHead; node; node = heapPrvGetNext(node)) {
-        if (node->tidx == tid) {
-            node->used = 0;
-            node->tidx = 0;
-            count++;
+    for (zone = gHeaps; zone < gHeaps + HEAP_ZONE_NUM; zone++) {
+        zoneCount = 0;
+        for (node = zone->head; node; node = heapPrvGetNext(zone, node)) {
+            if (node->tidx == tid) {
+                node->used = 0;
+                node->tidx = 0;
+                zoneCount++;
+            }
         }
+        zone->needFreeMerge = zoneCount > 0;
+        count += zoneCount;
     }
-    gNeedFreeMerge = count > 0;
     trylockRelease(&gHeapLock);
 
     return count;
@@ -232,6 +322,7 @@ int heapFreeAll(uint32_t tid)
 
 int heapGetFreeSize(int *numChunks, int *largestChunk)
 {
+    struct HeapZone *zone;
     struct HeapNode *node;
     bool haveLock;
     int bytes = 0;
@@ -242,12 +333,14 @@ int heapGetFreeSize(int *numChunks, int *largestChunk)
     if (!haveLock)
         return -1;
 
-    for (node = gHeapHead; node; node = heapPrvGetNext(node)) {
-        if (!node->used) {
-            if (node->size > *largestChunk)
-                *largestChunk = node->size;
-            bytes += node->size + sizeof(struct HeapNode);
-            (*numChunks)++;
+    for (zone = gHeaps; zone < gHeaps + HEAP_ZONE_NUM; zone++) {
+        for (node = zone->head; node; node = heapPrvGetNext(zone, node)) {
+            if (!node->used) {
+                if (node->size > *largestChunk)
+                    *largestChunk = node->size;
+                bytes += node->size + sizeof(struct HeapNode);
+                (*numChunks)++;
+            }
         }
     }
     trylockRelease(&gHeapLock);
@@ -257,6 +350,7 @@ int heapGetFreeSize(int *numChunks, int *largestChunk)
 
 int heapGetTaskSize(uint32_t tid)
 {
+    struct HeapZone *zone;
     struct HeapNode *node;
     bool haveLock;
     int bytes = 0;
@@ -267,9 +361,11 @@ int heapGetTaskSize(uint32_t tid)
         return -1;
 
     tid &= TIDX_MASK;
-    for (node = gHeapHead; node; node = heapPrvGetNext(node)) {
-        if (node->used && node->tidx == tid) {
-            bytes += node->size + sizeof(struct HeapNode);
+    for (zone = gHeaps; zone < gHeaps + HEAP_ZONE_NUM; zone++) {
+        for (node = zone->head; node; node = heapPrvGetNext(zone, node)) {
+            if (node->used && node->tidx == tid) {
+                bytes += node->size + sizeof(struct HeapNode);
+            }
         }
     }
     trylockRelease(&gHeapLock);
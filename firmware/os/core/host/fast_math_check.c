@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Checks the error bounds documented in fast_math.h against double precision
+ * libm on the build host. Single argument functions are swept over their
+ * whole stated range: every float below the smallest normal, then one in
+ * every STRIDE. fastAtan2f() gets random pairs over the full float range,
+ * half of them of similar magnitude.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fast_math.h>
+
+#define STRIDE          61
+#define ATAN2_PAIRS     20000000
+
+enum Func {
+    FUNC_SQRT,
+    FUNC_SIN,
+    FUNC_COS,
+    FUNC_SINCOS,
+    FUNC_ASIN,
+    FUNC_ATAN2,
+};
+
+struct Bound {
+    const char *name;
+    float hi;           // checked over [-hi, hi], or [0, hi] for sqrt
+    double maxErr;      // absolute; sqrt must match exactly
+};
+
+static const struct Bound mBounds[] = {
+    [FUNC_SQRT]   = { "fastSqrtf",   1.0e30f, 0.0 },
+    [FUNC_SIN]    = { "fastSinf",    8192.0f, 1.5e-7 },
+    [FUNC_COS]    = { "fastCosf",    8192.0f, 1.5e-7 },
+    [FUNC_SINCOS] = { "fastSinCosf", 8192.0f, 1.5e-7 },
+    [FUNC_ASIN]   = { "fastAsinf",   1.0f,    3.5e-7 },
+    [FUNC_ATAN2]  = { "fastAtan2f",  0.0f,    1.2e-5 },
+};
+
+static float fromBits(uint32_t u)
+{
+    float f;
+
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static uint32_t toBits(float f)
+{
+    uint32_t u;
+
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static double funcError(enum Func func, float x)
+{
+    float s, c;
+
+    switch (func) {
+    case FUNC_SQRT:
+        return fastSqrtf(x) != (float)sqrt(x);
+    case FUNC_SIN:
+        return fabs(fastSinf(x) - sin(x));
+    case FUNC_COS:
+        return fabs(fastCosf(x) - cos(x));
+    case FUNC_SINCOS:
+        fastSinCosf(x, &s, &c);
+        return fmax(fabs(s - sin(x)), fabs(c - cos(x)));
+    default:
+        return fabs(fastAsinf(x) - asin(x));
+    }
+}
+
+static bool checkSweep(enum Func func)
+{
+    const struct Bound *b = &mBounds[func];
+    uint32_t u, hiBits = toBits(b->hi);
+    double err, maxErr = 0.0;
+    float x, worst = 0.0f;
+    int sign;
+
+    for (sign = func == FUNC_SQRT ? 1 : -1; sign <= 1; sign += 2) {
+        for (u = 0; u <= hiBits + STRIDE; u += u < 0x00800000 ? 1 : STRIDE) {
+            x = sign * (u < hiBits ? fromBits(u) : b->hi);
+            err = funcError(func, x);
+            if (err > maxErr) {
+                maxErr = err;
+                worst = x;
+            }
+        }
+    }
+
+    printf("%-12s |x| <= %-8g max err %.3g at %.9g (bound %.3g)\n",
+           b->name, b->hi, maxErr, worst, b->maxErr);
+    return maxErr <= b->maxErr;
+}
+
+static uint32_t nextRand(uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed;
+}
+
+static bool checkAtan2(void)
+{
+    const struct Bound *b = &mBounds[FUNC_ATAN2];
+    uint32_t seed = 1;
+    double err, maxErr = 0.0;
+    float x, y, worstX = 0.0f, worstY = 0.0f;
+    int i;
+
+    for (i = 0; i < ATAN2_PAIRS; i++) {
+        // random sign, exponent and mantissa, but no inf/nan
+        x = fromBits(nextRand(&seed) & 0xfeffffff);
+        y = fromBits(nextRand(&seed) & 0xfeffffff);
+        if (i & 1)
+            y = copysignf(fabsf(x), y) * (float)(nextRand(&seed) >> 8) / (1 << 22);
+        if (x == 0.0f && y == 0.0f)
+            continue;
+        // y = -0 with x < 0 gives pi, not -pi: the same angle
+        err = fabs(remainder(fastAtan2f(y, x) - atan2(y, x), 2.0 * M_PI));
+        if (err > maxErr) {
+            maxErr = err;
+            worstX = x;
+            worstY = y;
+        }
+    }
+
+    printf("%-12s %d pairs   max err %.3g at (%.9g, %.9g) (bound %.3g)\n",
+           b->name, ATAN2_PAIRS, maxErr, worstY, worstX, b->maxErr);
+    return maxErr <= b->maxErr;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    failed += !checkSweep(FUNC_SQRT);
+    failed += !checkSweep(FUNC_SIN);
+    failed += !checkSweep(FUNC_COS);
+    failed += !checkSweep(FUNC_SINCOS);
+    failed += !checkSweep(FUNC_ASIN);
+    failed += !checkAtan2();
+
+    printf("%s\n", failed ? "FAILED" : "PASSED");
+    return failed ? 1 : 0;
+}
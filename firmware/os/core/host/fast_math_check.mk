@@ -0,0 +1,61 @@
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+################################################################################
+################################################################################
+#
+# fast_math.h accuracy check
+#
+# Builds fast_math_check.c into a Linux executable that checks the error bounds
+# documented in os/inc/fast_math.h against double precision libm, with the
+# same -fsingle-precision-constant as the firmware. Run from the firmware
+# directory:
+#
+#   make -f os/core/host/fast_math_check.mk
+#   out/nanohub/host/fast_math_check/fast_math_check
+#
+################################################################################
+
+HOST_CC ?= gcc
+
+OUT := out/nanohub/host/fast_math_check
+CHECK := $(OUT)/fast_math_check
+
+SRCS := os/core/host/fast_math_check.c
+
+CFLAGS += -Ios/inc
+CFLAGS += -O2
+CFLAGS += -g
+CFLAGS += -Wall
+CFLAGS += -Werror
+CFLAGS += -Wmissing-declarations
+CFLAGS += -Wshadow
+CFLAGS += -fsingle-precision-constant
+
+OBJS := $(patsubst %.c, $(OUT)/%.o, $(SRCS))
+
+.PHONY: all clean
+all: $(CHECK)
+
+$(CHECK) : $(OBJS)
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(OBJS) -lm -o $@
+
+$(OUT)/%.o : %.c
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(CFLAGS) -c $< -o $@
+
+clean:
+	rm -rf $(OUT)
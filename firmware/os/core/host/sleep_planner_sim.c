@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Sleep planner simulator.
+ *
+ * Replays a recorded trace of idle periods through os/core/sleepPlanner.c and
+ * reports the energy each policy would have spent with a given power model:
+ *
+ *   greedy   the first usable state in table order (what platSleep() did
+ *            before it had a power model)
+ *   planner  what platSleep() does now: lowest expected energy for the
+ *            predicted idle length
+ *   oracle   the planner with the actual idle length in place of the
+ *            prediction, as a lower bound
+ *
+ * Trace format: one idle period per line, '#' starts a comment:
+ *
+ *   <timer_ns> <idle_ns> [<devs_to_keep_alive>]
+ *
+ * <timer_ns> is the time to the next timer when going to sleep (0 if none was
+ * set) and <idle_ns> how long the hub then actually stayed idle. Devices kept
+ * alive only allow states that wake up within their latency, which a
+ *
+ *   latency <dev> <max_wakeup_ns>
+ *
+ * line sets for the periods after it, as platRequestDevInSleepMode() and
+ * platAdjustDevInSleepMode() do. It defaults to the 12ns the stm32 bus drivers
+ * ask for. os/core/host/sleep_planner_trace.txt is a sample.
+ *
+ * Power model format (-m): one state per line, deepest first, as in the
+ * platform table:
+ *
+ *   <name> <resolution_ns> <max_counter> <jitter_ppm> <drift_ppm>
+ *          <max_wakeup_ns> <devs_avail> <power_uw> <transition_nj>
+ *
+ * Without -m the stm32f411 states from plat/sleepStates.h are used, with the
+ * stm32 device numbers.
+ *
+ *   make -f os/core/host/sleep_planner_sim.mk
+ *   out/nanohub/host/sleep_planner_sim/sleep_planner_sim -t os/core/host/sleep_planner_trace.txt
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sleepPlanner.h>
+#include <plat/sleepStates.h>
+
+#define MAX_STATES      16
+#define MAX_DEVS        32
+#define NAME_LEN        16
+#define DEFAULT_LATENCY 12
+
+struct SimState {
+    struct SleepPlannerOption opt;
+    char name[NAME_LEN];
+};
+
+enum SimPolicy {
+    SIM_GREEDY,
+    SIM_PLANNER,
+    SIM_ORACLE,
+
+    SIM_NUM_POLICIES
+};
+
+struct SimResult {
+    struct SleepPlannerHistory hist;
+    uint64_t energy;                //fJ
+    uint64_t counts[MAX_STATES];
+    uint64_t unusable;
+};
+
+static const char * const mPolicyNames[SIM_NUM_POLICIES] = { "greedy", "planner", "oracle" };
+
+static struct SimState mStates[MAX_STATES] = {
+    { STM32_SLEEP_PLAN_LPLV, "LPLV" },
+    { STM32_SLEEP_PLAN_LPFD, "LPFD" },
+    { STM32_SLEEP_PLAN_MRFPD, "MRFPD" },
+    { STM32_SLEEP_PLAN_MR, "MR" },
+    { STM32_SLEEP_PLAN_TIM2, "TIM2" },
+    { STM32_SLEEP_PLAN_WFI, "WFI" },
+};
+static uint32_t mNumStates = 6;
+static uint32_t mDevsMaxWakeTime[MAX_DEVS];
+
+static void showHelp(void)
+{
+    printf("Usage: sleep_planner_sim [-h] -t <trace> [-m <power_model>] [-j <max_jitter_ppm>]\n"
+           "                         [-d <max_drift_ppm>] [-v]\n");
+}
+
+static bool loadModel(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    uint32_t n = 0;
+
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        struct SimState *s = &mStates[n];
+        char *hash = strchr(line, '#');
+
+        if (hash)
+            *hash = 0;
+        if (strspn(line, " \t\r\n") == strlen(line))
+            continue;
+
+        if (n == MAX_STATES) {
+            fprintf(stderr, "%s: more than %d states\n", path, MAX_STATES);
+            fclose(f);
+            return false;
+        }
+
+        if (sscanf(line, "%15s %" SCNu64 " %" SCNi32 " %" SCNu32 " %" SCNu32 " %" SCNu32 " %" SCNi32 " %" SCNu32 " %" SCNu32,
+                   s->name, &s->opt.resolution, &s->opt.maxCounter, &s->opt.jitterPpm, &s->opt.driftPpm,
+                   &s->opt.maxWakeupTime, &s->opt.devsAvail, &s->opt.powerUw, &s->opt.transitionNj) != 9) {
+            fprintf(stderr, "%s: bad state: %s", path, line);
+            fclose(f);
+            return false;
+        }
+        n++;
+    }
+
+    fclose(f);
+    mNumStates = n;
+    return n > 0;
+}
+
+static void simulate(struct SimResult *res, enum SimPolicy policy, struct SleepPlannerRequest *req, uint64_t idle)
+{
+    const struct SleepPlannerOption *opt;
+    bool tooShort;
+    int32_t idx = -1;
+    uint32_t i;
+
+    if (policy == SIM_GREEDY) {
+        for (i = 0; i < mNumStates && idx < 0; i++) {
+            if (sleepPlannerUsable(&mStates[i].opt, req, &tooShort))
+                idx = i;
+        }
+    } else {
+        req->predictedIdle = policy == SIM_ORACLE ? idle : sleepPlannerPredict(&res->hist, req->timerLength);
+        idx = sleepPlannerPick(&mStates[0].opt, mNumStates, sizeof(mStates[0]), req);
+    }
+
+    if (idx < 0) {
+        res->unusable++;
+    } else {
+        opt = &mStates[idx].opt;
+        res->counts[idx]++;
+        res->energy += sleepPlannerEnergy(opt, idle);
+    }
+
+    sleepPlannerRecord(&res->hist, req->timerLength, idle);
+}
+
+int main(int argc, char **argv)
+{
+    struct SimResult results[SIM_NUM_POLICIES];
+    struct SleepPlannerRequest req;
+    const char *tracePath = NULL;
+    uint32_t maxJitterPpm = 0, maxDriftPpm = 50;
+    uint64_t timerLength, idle, totalTime = 0, periods = 0;
+    bool verbose = false;
+    char line[256];
+    FILE *trace;
+    int opt, lineNo = 0;
+    uint32_t p, i;
+
+    while ((opt = getopt(argc, argv, "ht:m:j:d:v")) != -1) {
+        switch (opt) {
+        case 't':
+            tracePath = optarg;
+            break;
+        case 'm':
+            if (!loadModel(optarg))
+                return 1;
+            break;
+        case 'j':
+            maxJitterPpm = strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            maxDriftPpm = strtoul(optarg, NULL, 0);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            showHelp();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (!tracePath) {
+        showHelp();
+        return 1;
+    }
+
+    trace = strcmp(tracePath, "-") ? fopen(tracePath, "r") : stdin;
+    if (!trace) {
+        perror(tracePath);
+        return 1;
+    }
+
+    memset(results, 0x00, sizeof(results));
+    for (p = 0; p < SIM_NUM_POLICIES; p++)
+        sleepPlannerInit(&results[p].hist);
+
+    for (i = 0; i < MAX_DEVS; i++)
+        mDevsMaxWakeTime[i] = DEFAULT_LATENCY;
+
+    memset(&req, 0x00, sizeof(req));
+    req.maxJitterPpm = maxJitterPpm;
+    req.maxDriftPpm = maxDriftPpm;
+    req.numDevs = MAX_DEVS;
+    req.devsMaxWakeTime = mDevsMaxWakeTime;
+
+    while (fgets(line, sizeof(line), trace)) {
+        char *hash = strchr(line, '#');
+        uint32_t devs = 0, dev, latency;
+        int n;
+
+        lineNo++;
+        if (hash)
+            *hash = 0;
+        if (strspn(line, " \t\r\n") == strlen(line))
+            continue;
+
+        if (sscanf(line, " latency %" SCNu32 " %" SCNu32, &dev, &latency) == 2) {
+            if (dev >= MAX_DEVS) {
+                fprintf(stderr, "%s:%d: bad device: %s", tracePath, lineNo, line);
+                return 1;
+            }
+            mDevsMaxWakeTime[dev] = latency;
+            continue;
+        }
+
+        n = sscanf(line, "%" SCNu64 " %" SCNu64 " %" SCNi32, &timerLength, &idle, &devs);
+        if (n < 2) {
+            fprintf(stderr, "%s:%d: bad idle period: %s", tracePath, lineNo, line);
+            return 1;
+        }
+
+        //a timer always ends the idle period
+        if (timerLength && idle > timerLength)
+            idle = timerLength;
+
+        req.timerLength = timerLength;
+        req.devsToKeepAlive = devs;
+
+        for (p = 0; p < SIM_NUM_POLICIES; p++)
+            simulate(&results[p], p, &req, idle);
+
+        totalTime += idle;
+        periods++;
+    }
+
+    if (trace != stdin)
+        fclose(trace);
+
+    printf("%" PRIu64 " idle periods, %" PRIu64 ".%03" PRIu64 " s idle\n",
+           periods, totalTime / 1000000000, totalTime / 1000000 % 1000);
+    if (!totalTime)
+        return 0;
+
+    for (p = 0; p < SIM_NUM_POLICIES; p++) {
+        const struct SimResult *res = &results[p];
+
+        //fJ / ns = uW
+        printf("%-8s %12" PRIu64 " nJ  avg %8.2f uW", mPolicyNames[p],
+               res->energy / 1000000, (double)res->energy / totalTime);
+        if (p != SIM_GREEDY && results[SIM_GREEDY].energy)
+            printf("  (%+.1f%% vs greedy)",
+                   100.0 * ((double)res->energy - results[SIM_GREEDY].energy) / results[SIM_GREEDY].energy);
+        printf("\n");
+
+        if (!verbose)
+            continue;
+
+        for (i = 0; i < mNumStates; i++) {
+            if (res->counts[i])
+                printf("    %-8s %10" PRIu64 "\n", mStates[i].name, res->counts[i]);
+        }
+        if (res->unusable)
+            printf("    %-8s %10" PRIu64 "\n", "(none)", res->unusable);
+    }
+
+    return 0;
+}
@@ -0,0 +1,61 @@
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+################################################################################
+################################################################################
+#
+# Sleep planner simulator build
+#
+# Builds os/core/sleepPlanner.c together with sleep_planner_sim.c into a Linux
+# executable that replays recorded idle traces against a power model. Run
+# from the firmware directory:
+#
+#   make -f os/core/host/sleep_planner_sim.mk
+#   out/nanohub/host/sleep_planner_sim/sleep_planner_sim -t os/core/host/sleep_planner_trace.txt -v
+#
+################################################################################
+
+HOST_CC ?= gcc
+
+OUT := out/nanohub/host/sleep_planner_sim
+SIM := $(OUT)/sleep_planner_sim
+
+SRCS := os/core/sleepPlanner.c
+SRCS += os/core/host/sleep_planner_sim.c
+
+CFLAGS += -Ios/inc
+CFLAGS += -Ios/platform/stm32/inc
+CFLAGS += -O2
+CFLAGS += -g
+CFLAGS += -Wall
+CFLAGS += -Werror
+CFLAGS += -Wmissing-declarations
+CFLAGS += -Wshadow
+
+OBJS := $(patsubst %.c, $(OUT)/%.o, $(SRCS))
+
+.PHONY: all clean
+all: $(SIM)
+
+$(SIM) : $(OBJS)
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(OBJS) -o $@
+
+$(OUT)/%.o : %.c
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(CFLAGS) -c $< -o $@
+
+clean:
+	rm -rf $(OUT)
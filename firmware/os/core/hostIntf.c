@@ -44,6 +44,8 @@
 #include <sensors.h>
 #include <timer.h>
 #include <heap.h>
+#include <loadGovernor.h>
+#include <poolStats.h>
 #include <simpleQ.h>
 
 #define HOSTINTF_MAX_ERR_MSG    8
@@ -113,6 +115,29 @@ static uint8_t mNumSensors;
 static uint8_t mLastSensor;
 
 static const struct HostIntfComm *mComm;
+
+enum HostIntfJobState
+{
+    HOSTINTF_JOB_FREE,
+    HOSTINTF_JOB_QUEUED,
+    HOSTINTF_JOB_DONE,
+};
+
+// a request queued with NANOHUB_REASON_FLAG_QUEUE
+struct HostIntfJob
+{
+    const struct NanohubCommand *cmd;
+    uint64_t timestamp;
+    uint32_t seq;
+    uint8_t state;
+    uint8_t len; // request length while queued, response length when done
+    uint8_t data[NANOHUB_PACKET_PAYLOAD_MAX];
+};
+static struct HostIntfJob mJobs[NANOHUB_QUEUED_MAX];
+static uint8_t mJobRx[NANOHUB_PACKET_PAYLOAD_MAX];
+static const struct NanohubCommand mGetResponseCmd = {
+    .reason = NANOHUB_REASON_GET_RESPONSE,
+};
 static bool mBusy;
 static uint64_t mRxTimestamp;
 static uint8_t mRxBuf[NANOHUB_PACKET_SIZE_MAX];
@@ -123,13 +148,17 @@ static struct
     uint32_t seq;
     bool seqMatch;
 } mTxRetrans;
-static struct
+static struct HostIntfTxFrame
 {
     uint8_t pad; // packet header is 10 bytes. + 2 to word align
     uint8_t prePreamble;
     uint8_t buf[NANOHUB_PACKET_SIZE_MAX];
     uint8_t postPreamble;
-} mTxBuf;
+} __attribute__((aligned(4))) mTxFrames[2];
+// mTxBuf is the frame on the wire (and kept for retransmission), mTxSpare is
+// where the next response may be built ahead of time
+static struct HostIntfTxFrame *mTxBuf = &mTxFrames[0];
+static struct HostIntfTxFrame *mTxSpare = &mTxFrames[1];
 static struct
 {
     uint8_t pad; // packet header is 10 bytes. + 2 to word align
@@ -271,9 +300,14 @@ static inline const struct NanohubCommand *hostIntfFindHandler(uint8_t *buf, siz
     if (mBusy)
         return NULL;
 
-    packetReason = le32toh(packet->reason);
+    packetReason = le32toh(packet->reason) & ~NANOHUB_REASON_FLAG_QUEUE;
+
+    if (packetReason == NANOHUB_REASON_GET_RESPONSE)
+        cmd = &mGetResponseCmd;
+    else
+        cmd = nanohubFindCommand(packetReason);
 
-    if ((cmd = nanohubFindCommand(packetReason)) != NULL) {
+    if (cmd) {
         if (packet->len < cmd->minDataLen || packet->len > cmd->maxDataLen) {
             hostIntfDeferErrLog(LOG_WARN, HOSTINTF_ERR_PKG_PAYLOAD_SIZE, __func__);
             return NULL;
@@ -296,17 +330,17 @@ static void hostIntfTxBuf(int size, uint8_t *buf, HostIntfCommCallbackF callback
 static void hostIntfTxPacket(__le32 reason, uint8_t len, uint32_t seq,
         HostIntfCommCallbackF callback)
 {
-    struct NanohubPacket *txPacket = (struct NanohubPacket *)(mTxBuf.buf);
+    struct NanohubPacket *txPacket = (struct NanohubPacket *)(mTxBuf->buf);
     txPacket->reason = reason;
     txPacket->seq = seq;
     txPacket->sync = NANOHUB_SYNC_BYTE;
     txPacket->len = len;
 
-    struct NanohubPacketFooter *txFooter = hostIntfGetFooter(mTxBuf.buf);
-    txFooter->crc = hostIntfComputeCrc(mTxBuf.buf);
+    struct NanohubPacketFooter *txFooter = hostIntfGetFooter(mTxBuf->buf);
+    txFooter->crc = hostIntfComputeCrc(mTxBuf->buf);
 
     // send starting with the prePremable byte
-    hostIntfTxBuf(1+NANOHUB_PACKET_SIZE(len), &mTxBuf.prePreamble, callback);
+    hostIntfTxBuf(1+NANOHUB_PACKET_SIZE(len), &mTxBuf->prePreamble, callback);
 }
 
 static void hostIntfTxNakPacket(__le32 reason, uint32_t seq,
@@ -347,8 +381,10 @@ static bool hostIntfRequest(uint32_t tid)
 #ifdef AP_INT_NONWAKEUP
     hostIntfSetInterruptMask(NANOHUB_INT_NONWAKEUP);
 #endif
-    mTxBuf.prePreamble = NANOHUB_PREAMBLE_BYTE;
-    mTxBuf.postPreamble = NANOHUB_PREAMBLE_BYTE;
+    mTxFrames[0].prePreamble = NANOHUB_PREAMBLE_BYTE;
+    mTxFrames[0].postPreamble = NANOHUB_PREAMBLE_BYTE;
+    mTxFrames[1].prePreamble = NANOHUB_PREAMBLE_BYTE;
+    mTxFrames[1].postPreamble = NANOHUB_PREAMBLE_BYTE;
     mTxNakBuf.prePreamble = NANOHUB_PREAMBLE_BYTE;
     mTxNakBuf.postPreamble = NANOHUB_PREAMBLE_BYTE;
 
@@ -404,7 +440,7 @@ static void hostIntfRxDone(size_t rx, int err)
 
 static void hostIntfTxSendAck(uint32_t resp)
 {
-    void *txPayload = hostIntfGetPayload(mTxBuf.buf);
+    void *txPayload = hostIntfGetPayload(mTxBuf->buf);
 
     if (resp == NANOHUB_FAST_UNHANDLED_ACK) {
         hostIntfCopyInterrupts(txPayload, HOSTINTF_MAX_INTERRUPTS);
@@ -418,17 +454,133 @@ static void hostIntfTxSendAck(uint32_t resp)
 
 void hostIntfTxAck(void *buffer, uint8_t len)
 {
-    void *txPayload = hostIntfGetPayload(mTxBuf.buf);
+    void *txPayload = hostIntfGetPayload(mTxBuf->buf);
 
     memcpy(txPayload, buffer, len);
 
     hostIntfTxSendAck(len);
 }
 
+void *hostIntfGetSpareTxPayload(void)
+{
+    return hostIntfGetPayload(mTxSpare->buf);
+}
+
+void hostIntfSwapTxBuf(void)
+{
+    struct HostIntfTxFrame *frame = mTxBuf;
+
+    mTxBuf = mTxSpare;
+    mTxSpare = frame;
+}
+
+void hostIntfTxAckSpare(uint8_t len)
+{
+    hostIntfSwapTxBuf();
+    hostIntfTxSendAck(len);
+}
+
+static void hostIntfRunJob(void *cookie)
+{
+    struct HostIntfJob *job = cookie;
+    uint64_t state;
+
+    memcpy(mJobRx, job->data, job->len);
+    job->len = job->cmd->handler(mJobRx, job->len, job->data, job->timestamp);
+
+    // the host interrupt must not outlive the last response it announces
+    state = cpuIntsOff();
+    atomicWriteByte(&job->state, HOSTINTF_JOB_DONE);
+    hostIntfSetInterrupt(NANOHUB_INT_RESPONSE);
+    cpuIntsRestore(state);
+}
+
+static bool hostIntfQueueJob(uint32_t seq)
+{
+    struct HostIntfJob *job;
+    uint32_t i;
+
+    for (i = 0; i < NANOHUB_QUEUED_MAX; i++) {
+        job = &mJobs[i];
+        if (atomicReadByte(&job->state) != HOSTINTF_JOB_FREE)
+            continue;
+
+        job->cmd = mRxCmd;
+        job->timestamp = mRxTimestamp;
+        job->seq = seq;
+        job->len = hostIntfGetPayloadLen(mRxBuf);
+        memcpy(job->data, hostIntfGetPayload(mRxBuf), job->len);
+        atomicWriteByte(&job->state, HOSTINTF_JOB_QUEUED);
+
+        if (osDefer(hostIntfRunJob, job, false))
+            return true;
+
+        atomicWriteByte(&job->state, HOSTINTF_JOB_FREE);
+        return false;
+    }
+
+    return false;
+}
+
+static void hostIntfTxNakNoRetrans(__le32 reason, uint32_t seq)
+{
+    mRxCmd = NULL;
+    mTxRetrans.seq = 0;
+    mTxRetrans.cmd = NULL;
+    hostIntfTxNakPacket(reason, seq, hostIntfTxAckDone);
+}
+
+static void hostIntfTxQueuedAck(uint32_t seq)
+{
+    void *txPayload = hostIntfGetPayload(mTxBuf->buf);
+
+    if (hostIntfQueueJob(seq)) {
+        hostIntfCopyInterrupts(txPayload, HOSTINTF_MAX_INTERRUPTS);
+        hostIntfTxPacket(NANOHUB_REASON_ACK_QUEUED, 32, seq, hostIntfTxPayloadDone);
+    } else {
+        hostIntfTxNakNoRetrans(NANOHUB_REASON_NAK_BUSY, seq);
+    }
+}
+
+static void hostIntfTxJobResponse(uint32_t seq)
+{
+    struct HostIntfJob *job = NULL;
+    bool queued = false, done = false;
+    uint32_t i;
+    uint8_t state;
+
+    for (i = 0; i < NANOHUB_QUEUED_MAX; i++) {
+        state = atomicReadByte(&mJobs[i].state);
+        if (state == HOSTINTF_JOB_DONE && !job)
+            job = &mJobs[i];
+        else if (state == HOSTINTF_JOB_DONE)
+            done = true;
+        else if (state == HOSTINTF_JOB_QUEUED)
+            queued = true;
+    }
+
+    if (!done)
+        hostIntfClearInterrupt(NANOHUB_INT_RESPONSE);
+
+    if (job) {
+        memcpy(hostIntfGetPayload(mTxBuf->buf), job->data, job->len);
+        atomicWriteByte(&job->state, HOSTINTF_JOB_FREE);
+        hostIntfTxPacket(job->cmd->reason, job->len, job->seq, hostIntfTxPayloadDone);
+    } else {
+        hostIntfTxNakNoRetrans(queued ? NANOHUB_REASON_NAK_BUSY : NANOHUB_REASON_NAK, seq);
+    }
+}
+
+static inline bool hostIntfRxQueued(void)
+{
+    struct NanohubPacket *packet = (struct NanohubPacket *)mRxBuf;
+    return le32toh(packet->reason) & NANOHUB_REASON_FLAG_QUEUE;
+}
+
 static void hostIntfGenerateAck(void *cookie)
 {
     uint32_t seq = 0;
-    void *txPayload = hostIntfGetPayload(mTxBuf.buf);
+    void *txPayload = hostIntfGetPayload(mTxBuf->buf);
     void *rxPayload = hostIntfGetPayload(mRxBuf);
     uint8_t rx_len = hostIntfGetPayloadLen(mRxBuf);
     uint32_t resp = NANOHUB_FAST_UNHANDLED_ACK;
@@ -439,14 +591,27 @@ static void hostIntfGenerateAck(void *cookie)
 
     if (mRxCmd) {
         if (mTxRetrans.seqMatch) {
-            hostIntfTxBuf(mTxSize, &mTxBuf.prePreamble, hostIntfTxPayloadDone);
+            hostIntfTxBuf(mTxSize, &mTxBuf->prePreamble, hostIntfTxPayloadDone);
         } else {
             mTxRetrans.seq = seq;
             mTxRetrans.cmd = mRxCmd;
+            if (hostIntfRxQueued() && !mRxCmd->queueable) {
+                // e.g. READ_EVENT swaps the tx frames; it must not run behind the bus's back
+                hostIntfTxNakNoRetrans(NANOHUB_REASON_NAK, seq);
+                return;
+            }
+            if (mRxCmd == &mGetResponseCmd) {
+                hostIntfTxJobResponse(seq);
+                return;
+            }
+
             if (mRxCmd->fastHandler)
                 resp = mRxCmd->fastHandler(rxPayload, rx_len, txPayload, mRxTimestamp);
 
-            hostIntfTxSendAck(resp);
+            if (resp == NANOHUB_FAST_UNHANDLED_ACK && mRxCmd->handler && hostIntfRxQueued())
+                hostIntfTxQueuedAck(seq);
+            else
+                hostIntfTxSendAck(resp);
         }
     } else {
         if (mBusy)
@@ -506,7 +671,7 @@ static void hostIntfGenerateResponse(void *cookie)
 {
     void *rxPayload = hostIntfGetPayload(mRxBuf);
     uint8_t rx_len = hostIntfGetPayloadLen(mRxBuf);
-    void *txPayload = hostIntfGetPayload(mTxBuf.buf);
+    void *txPayload = hostIntfGetPayload(mTxBuf->buf);
     uint8_t respLen = mRxCmd->handler(rxPayload, rx_len, txPayload, mRxTimestamp);
 
     hostIntfTxPacket(mRxCmd->reason, respLen, mTxRetrans.seq, hostIntfTxPayloadDone);
@@ -752,6 +917,7 @@ static bool initSensors()
     }
 
     memset(mActiveSensorTable, 0x00, numSensors * sizeof(struct ActiveSensor));
+    poolStatsAddSimpleQueue(POOL_HOST_OUTPUT, mOutputQ);
 
     for (i = SENS_TYPE_INVALID; i < SENS_TYPE_LAST_USER; i++) {
         mSensorList[i] = MAX_REGISTERED_SENSORS;
@@ -847,6 +1013,7 @@ static bool enqueueSensorBuffer(struct ActiveSensor *sensor)
         else if (sensor->interrupt == NANOHUB_INT_NONWAKEUP)
             mNonWakeupBlocks--;
         sensor->curSamples -= sensor->buffer.firstSample.numSamples;
+        loadGovReportDrop();
     }
     resetBuffer(sensor);
     return queued;
@@ -1143,6 +1310,11 @@ static void hostIntfNotifyReboot(uint32_t reason)
 
 static void queueFlush(struct ActiveSensor *sensor)
 {
+    // all flushes pending on a sensor ride in its current packet as a single
+    // count; only start another packet once that count would wrap
+    if (sensor->buffer.length > 0 && sensor->buffer.firstSample.numFlushes == UINT8_MAX)
+        enqueueSensorBuffer(sensor);
+
     if (sensor->buffer.length == 0) {
         sensor->buffer.length = sizeof(sensor->buffer.referenceTime) + sizeof(struct SensorFirstSample);
         sensor->buffer.referenceTime = 0ull;
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h>
+
+#include <atomic.h>
+#include <loadGovernor.h>
+#include <nanohubCommand.h>
+#include <sensors.h>
+#include <seos.h>
+#include <seos_priv.h>
+#include <sleepStats.h>
+#include <timer.h>
+
+#define LOAD_GOV_WINDOW         250000000ULL   /* ns */
+#define LOAD_GOV_BUSY_HIGH      85             /* % awake that counts as overloaded */
+#define LOAD_GOV_BUSY_LOW       60             /* % awake that counts as calm */
+#define LOAD_GOV_PENDING_HIGH   128            /* queued events that count as overloaded */
+#define LOAD_GOV_PENDING_LOW    16             /* queued events that count as calm */
+#define LOAD_GOV_DROPS_HIGH     8              /* losses in a window that count as overloaded */
+#define LOAD_GOV_UP_WINDOWS     2              /* overloaded windows in a row before shedding more */
+#define LOAD_GOV_DOWN_WINDOWS   8              /* calm windows in a row before restoring a level */
+
+static struct LoadStats mStats;
+static volatile uint32_t mDrops;
+
+static uint64_t mWindowStart;
+static uint64_t mWindowSlept;
+static uint32_t mWindowDrops;
+static uint32_t mHotWindows;
+static uint32_t mCalmWindows;
+static uint32_t mTimer;
+
+void loadGovReportDrop(void)
+{
+    atomicAdd32bits(&mDrops, 1);
+}
+
+static uint32_t loadGovPercent(uint64_t part, uint64_t whole)
+{
+    //no 64-bit division: scale both down until the product fits
+    while (whole > UINT32_MAX / 100) {
+        part >>= 1;
+        whole >>= 1;
+    }
+
+    return whole ? (uint32_t)part * 100 / (uint32_t)whole : 0;
+}
+
+static void loadGovWake(void *cookie)
+{
+    //nothing to do: the main loop polls after this event like after any other
+}
+
+static void loadGovTimerCbk(uint32_t timerId, void *data)
+{
+    osDefer(loadGovWake, NULL, false);
+}
+
+static void loadGovSetLevel(uint32_t level)
+{
+    uint32_t old = mStats.level;
+
+    mStats.level = level;
+    mStats.changes++;
+
+    osLog(LOG_INFO, "Load level %" PRIu32 " -> %" PRIu32 " (busy %u%%, pending %" PRIu32 ", drops %" PRIu32 ")\n",
+          old, level, mStats.busy, mStats.pending, mStats.drops);
+
+    sensorsSetThrottle(level >= LOAD_LEVEL_THROTTLE);
+    sensorsSetCalDeferred(level >= LOAD_LEVEL_DEFER_CAL);
+
+    if ((level >= LOAD_LEVEL_OVERLOAD) != (old >= LOAD_LEVEL_OVERLOAD))
+        nanohubHalSendLoadStats(0);
+
+    //an idle hub does not run the main loop; keep windows closing while there is something to restore
+    if (level != LOAD_LEVEL_NORMAL && !mTimer) {
+        mTimer = timTimerSet(LOAD_GOV_WINDOW, 0, 50, loadGovTimerCbk, NULL, false);
+    } else if (level == LOAD_LEVEL_NORMAL && mTimer) {
+        timTimerCancel(mTimer);
+        mTimer = 0;
+    }
+}
+
+void loadGovInit(void)
+{
+    mWindowStart = timGetTime();
+    mWindowSlept = sleepStatsGetSlept(NULL);
+}
+
+void loadGovPoll(void)
+{
+    uint64_t now = timGetTime();
+    uint64_t elapsed = now - mWindowStart;
+    uint64_t slept;
+    uint32_t sleeps, drops, windowDrops;
+    bool hot, calm;
+
+    if (elapsed < LOAD_GOV_WINDOW)
+        return;
+
+    slept = sleepStatsGetSlept(&sleeps) - mWindowSlept;
+    drops = atomicRead32bits(&mDrops);
+    windowDrops = drops - mWindowDrops;
+
+    //a platform that does not report its sleeps gives no CPU figure
+    mStats.busy = sleeps && slept < elapsed ? loadGovPercent(elapsed - slept, elapsed) : 0;
+    mStats.pending = osGetPendingEvents();
+    mStats.drops = drops;
+    mStats.levelTime[mStats.level] += elapsed;
+
+    mWindowStart = now;
+    mWindowSlept += slept;
+    mWindowDrops = drops;
+
+    hot = windowDrops >= LOAD_GOV_DROPS_HIGH || mStats.busy >= LOAD_GOV_BUSY_HIGH || mStats.pending >= LOAD_GOV_PENDING_HIGH;
+    calm = !windowDrops && mStats.busy < LOAD_GOV_BUSY_LOW && mStats.pending < LOAD_GOV_PENDING_LOW;
+
+    if (hot) {
+        mCalmWindows = 0;
+        //steady losses do not wait for a second window
+        if ((++mHotWindows >= LOAD_GOV_UP_WINDOWS || windowDrops >= LOAD_GOV_DROPS_HIGH) && mStats.level < LOAD_LEVEL_OVERLOAD) {
+            mHotWindows = 0;
+            loadGovSetLevel(mStats.level + 1);
+        }
+    } else if (calm) {
+        mHotWindows = 0;
+        if (++mCalmWindows >= LOAD_GOV_DOWN_WINDOWS && mStats.level > LOAD_LEVEL_NORMAL) {
+            mCalmWindows = 0;
+            loadGovSetLevel(mStats.level - 1);
+        }
+    } else {
+        mHotWindows = 0;
+        mCalmWindows = 0;
+    }
+}
+
+void loadGovGetStats(struct LoadStats *stats)
+{
+    *stats = mStats;
+    stats->levelTime[mStats.level] += timGetTime() - mWindowStart;
+}
@@ -44,6 +44,10 @@
 #include <mpu.h>
 #include <heap.h>
 #include <slab.h>
+#include <sleepStats.h>
+#include <bootCache.h>
+#include <loadGovernor.h>
+#include <poolStats.h>
 #include <sensType.h>
 #include <timer.h>
 #include <appSec.h>
@@ -54,9 +58,10 @@
 
 #include <chre.h>
 
-#define NANOHUB_COMMAND(_reason, _fastHandler, _handler, _minReqType, _maxReqType) \
+#define NANOHUB_COMMAND(_reason, _fastHandler, _handler, _minReqType, _maxReqType, _queueable) \
         { .reason = _reason, .fastHandler = _fastHandler, .handler = _handler, \
-          .minDataLen = sizeof(_minReqType), .maxDataLen = sizeof(_maxReqType) }
+          .minDataLen = sizeof(_minReqType), .maxDataLen = sizeof(_maxReqType), \
+          .queueable = _queueable }
 
 #define NANOHUB_HAL_LEGACY_COMMAND(_msg, _handler) \
         { .msg = _msg, .handler = _handler }
@@ -99,12 +104,19 @@ static struct DownloadState *mDownloadState;
 static AppSecErr mAppSecStatus;
 static struct AppHdr *mApp;
 static struct SlabAllocator *mEventSlab;
-static struct HostIntfDataBuffer mTxCurr, mTxNext;
+// the next batch of events is built in hostIntf's spare transmit frame
+// (txCurr()) so it can be sent without another copy
+static struct HostIntfDataBuffer mTxNext;
 static uint8_t mTxCurrLength, mTxNextLength;
 static uint8_t mPrefetchActive, mPrefetchTx;
 static uint32_t mTxWakeCnt[2];
 static struct ApHubSync mTimeSync;
 
+static inline struct HostIntfDataBuffer *txCurr(void)
+{
+    return hostIntfGetSpareTxPayload();
+}
+
 static inline bool isSensorEvent(uint32_t evtType)
 {
     return evtType > EVT_NO_FIRST_SENSOR_EVENT && evtType <= EVT_NO_FIRST_SENSOR_EVENT + SENS_TYPE_LAST_USER;
@@ -765,8 +777,10 @@ static int fillBuffer(void *tx, uint32_t totLength, uint32_t *wakeup, uint32_t *
             }
         } else {
             packet->evtType = htole32(EVT_NO_FIRST_SENSOR_EVENT + packet->sensType);
+            // map at the packet's own hub time so that clock drift since the last exchange
+            // is accounted for in long batches
             if (packet->referenceTime)
-                packet->referenceTime += getAvgDelta(&mTimeSync);
+                packet->referenceTime += apHubSyncGetDelta(&mTimeSync, packet->referenceTime);
 
             if (*wakeup > 0)
                 packet->firstSample.interrupt = NANOHUB_INT_WAKEUP;
@@ -812,6 +826,7 @@ static void updateInterrupts(void)
 
 void nanohubPrefetchTx(uint32_t interrupt, uint32_t wakeup, uint32_t nonwakeup)
 {
+    struct HostIntfDataBuffer *curr;
     uint64_t state;
 
     if (wakeup < atomicRead32bits(&mTxWakeCnt[0]))
@@ -823,20 +838,24 @@ void nanohubPrefetchTx(uint32_t interrupt, uint32_t wakeup, uint32_t nonwakeup)
     if (interrupt == HOSTINTF_MAX_INTERRUPTS && !hostIntfGetInterrupt(NANOHUB_INT_WAKEUP) && !hostIntfGetInterrupt(NANOHUB_INT_NONWAKEUP))
         return;
 
-    atomicWriteByte(&mPrefetchActive, 1);
-
     if (interrupt < HOSTINTF_MAX_INTERRUPTS)
         hostIntfSetInterrupt(interrupt);
 
     do {
+        // readEventFast() swaps the spare frame unless this is set, so it is
+        // set on every pass (the previous one may have cleared it) and the
+        // frame is only looked up once it is held
+        atomicWriteByte(&mPrefetchActive, 1);
+        curr = txCurr();
+
         if (atomicReadByte(&mTxCurrLength) == 0 && mTxNextLength > 0) {
-            memcpy(&mTxCurr, &mTxNext, mTxNextLength);
+            memcpy(curr, &mTxNext, mTxNextLength);
             atomicWriteByte(&mTxCurrLength, mTxNextLength);
             mTxNextLength = 0;
         }
 
         if (mTxNextLength == 0) {
-            atomicWriteByte(&mTxCurrLength, fillBuffer(&mTxCurr, atomicReadByte(&mTxCurrLength), &wakeup, &nonwakeup));
+            atomicWriteByte(&mTxCurrLength, fillBuffer(curr, atomicReadByte(&mTxCurrLength), &wakeup, &nonwakeup));
             atomicWrite32bits(&mTxWakeCnt[0], wakeup);
             atomicWrite32bits(&mTxWakeCnt[1], nonwakeup);
         }
@@ -848,7 +867,7 @@ void nanohubPrefetchTx(uint32_t interrupt, uint32_t wakeup, uint32_t nonwakeup)
 
             // interrupt occured during this call
             // take care of it
-            hostIntfTxAck(&mTxCurr, atomicReadByte(&mTxCurrLength));
+            hostIntfTxAckSpare(atomicReadByte(&mTxCurrLength));
             atomicWriteByte(&mPrefetchTx, 0);
             atomicWriteByte(&mTxCurrLength, 0);
 
@@ -878,7 +897,7 @@ static uint32_t readEventFast(void *rx, uint8_t rx_len, void *tx, uint64_t times
         if ((ret = atomicReadByte(&mTxCurrLength))) {
             addDelta(&mTimeSync, req->apBootTime, timestamp);
 
-            memcpy(tx, &mTxCurr, ret);
+            hostIntfSwapTxBuf();
             atomicWriteByte(&mTxCurrLength, 0);
 
             updateInterrupts();
@@ -901,7 +920,7 @@ static uint32_t readEvent(void *rx, uint8_t rx_len, void *tx, uint64_t timestamp
     addDelta(&mTimeSync, req->apBootTime, timestamp);
 
     if ((totLength = atomicReadByte(&mTxCurrLength))) {
-        memcpy(tx, &mTxCurr, totLength);
+        hostIntfSwapTxBuf();
         atomicWriteByte(&mTxCurrLength, 0);
         updateInterrupts();
         return totLength;
@@ -1052,57 +1071,68 @@ const static struct NanohubCommand mBuiltinCommands[] = {
                     getOsHwVersion,
                     getOsHwVersion,
                     struct NanohubOsHwVersionsRequest,
-                    struct NanohubOsHwVersionsRequest),
+                    struct NanohubOsHwVersionsRequest,
+                    false),
     NANOHUB_COMMAND(NANOHUB_REASON_GET_APP_VERSIONS,
                     NULL,
                     getAppVersion,
                     struct NanohubAppVersionsRequest,
-                    struct NanohubAppVersionsRequest),
+                    struct NanohubAppVersionsRequest,
+                    true),
     NANOHUB_COMMAND(NANOHUB_REASON_QUERY_APP_INFO,
                     NULL,
                     queryAppInfo,
                     struct NanohubAppInfoRequest,
-                    struct NanohubAppInfoRequest),
+                    struct NanohubAppInfoRequest,
+                    true),
     NANOHUB_COMMAND(NANOHUB_REASON_START_FIRMWARE_UPLOAD,
                     NULL,
                     startFirmwareUpload,
                     struct NanohubStartFirmwareUploadRequest,
-                    struct NanohubStartFirmwareUploadRequest),
+                    struct NanohubStartFirmwareUploadRequest,
+                    false),
     NANOHUB_COMMAND(NANOHUB_REASON_FIRMWARE_CHUNK,
                     NULL,
                     firmwareChunk,
                     __le32,
-                    struct NanohubFirmwareChunkRequest),
+                    struct NanohubFirmwareChunkRequest,
+                    true),
     NANOHUB_COMMAND(NANOHUB_REASON_FINISH_FIRMWARE_UPLOAD,
                     NULL,
                     finishFirmwareUpload,
                     struct NanohubFinishFirmwareUploadRequest,
-                    struct NanohubFinishFirmwareUploadRequest),
+                    struct NanohubFinishFirmwareUploadRequest,
+                    true),
     NANOHUB_COMMAND(NANOHUB_REASON_GET_INTERRUPT,
                     getInterrupt,
                     getInterrupt,
                     struct { },
-                    struct NanohubGetInterruptRequest),
+                    struct NanohubGetInterruptRequest,
+                    false),
     NANOHUB_COMMAND(NANOHUB_REASON_MASK_INTERRUPT,
                     maskInterrupt,
                     maskInterrupt,
                     struct NanohubMaskInterruptRequest,
-                    struct NanohubMaskInterruptRequest),
+                    struct NanohubMaskInterruptRequest,
+                    false),
     NANOHUB_COMMAND(NANOHUB_REASON_UNMASK_INTERRUPT,
                     unmaskInterrupt,
                     unmaskInterrupt,
                     struct NanohubUnmaskInterruptRequest,
-                    struct NanohubUnmaskInterruptRequest),
+                    struct NanohubUnmaskInterruptRequest,
+                    false),
     NANOHUB_COMMAND(NANOHUB_REASON_READ_EVENT,
                     readEventFast,
                     readEvent,
                     struct NanohubReadEventRequest,
-                    struct NanohubReadEventRequest),
+                    struct NanohubReadEventRequest,
+                    false),
     NANOHUB_COMMAND(NANOHUB_REASON_WRITE_EVENT,
                     writeEvent,
                     writeEvent,
                     __le32,
-                    struct NanohubWriteEventRequest),
+                    struct NanohubWriteEventRequest,
+                    false),
 };
 
 const struct NanohubCommand *nanohubFindCommand(uint32_t packetReason)
@@ -1564,6 +1594,24 @@ static int processAppTags(const struct AppHdr *app, uint32_t crc, uint32_t size,
             else
                 success = copyTLVEmpty(data, &offset, max_len, tags[i]);
             break;
+        case NANOHUB_HAL_APP_INFO_CPU_TIME:
+            if (tid_valid)
+                success = copyTLV64(data, &offset, max_len, tags[i], cpuMathU64DivByU16(task->cpuCycles, cpuGetCyclesPerUs()));
+            else
+                success = copyTLVEmpty(data, &offset, max_len, tags[i]);
+            break;
+        case NANOHUB_HAL_APP_INFO_CPU_MAX:
+            if (tid_valid)
+                success = copyTLV32(data, &offset, max_len, tags[i], task->cpuCyclesMax / cpuGetCyclesPerUs());
+            else
+                success = copyTLVEmpty(data, &offset, max_len, tags[i]);
+            break;
+        case NANOHUB_HAL_APP_INFO_EVT_COUNT:
+            if (tid_valid)
+                success = copyTLV32(data, &offset, max_len, tags[i], task->evtCount);
+            else
+                success = copyTLVEmpty(data, &offset, max_len, tags[i]);
+            break;
         case NANOHUB_HAL_APP_INFO_END:
         default:
             success = false;
@@ -1849,6 +1897,150 @@ static void halFinishUpload(void *rx, uint8_t rx_len, uint32_t transactionId)
     osEnqueueEvtOrFree(EVT_APP_TO_HOST_CHRE, resp, heapFree);
 }
 
+static void halSleepStats(void *rx, uint8_t rx_len, uint32_t transactionId)
+{
+    struct NanohubHalSleepStatsRx *req = rx;
+    struct NanohubHalSleepStatsTx *resp;
+    struct SleepStat stat;
+    uint32_t total = sleepStatsCount();
+    uint32_t i;
+
+    if (!(resp = heapAlloc(sizeof(*resp))))
+        return;
+
+    resp->hdr = (struct NanohubHalHdr) {
+        .appId = APP_ID_MAKE(NANOHUB_VENDOR_GOOGLE, 0),
+        .len = sizeof(*resp) - sizeof(resp->hdr) - sizeof(resp->stats),
+        .transactionId = transactionId,
+    };
+    resp->ret = (struct NanohubHalRet) {
+        .msg = NANOHUB_HAL_SLEEP_STATS,
+    };
+    resp->total = total;
+    resp->offset = req->offset;
+
+    for (i = 0; i < NANOHUB_HAL_SLEEP_STATS_MAX && sleepStatsGet(req->offset + i, &stat); i++) {
+        resp->stats[i].type = stat.type;
+        resp->stats[i].index = stat.index;
+        resp->stats[i].count = htole32(stat.count);
+        resp->stats[i].time = htole64(stat.time);
+    }
+    resp->count = i;
+    resp->hdr.len += i * sizeof(resp->stats[0]);
+
+    if (req->flags & NANOHUB_HAL_SLEEP_STATS_RESET)
+        sleepStatsReset();
+
+    osEnqueueEvtOrFree(EVT_APP_TO_HOST_CHRE, resp, heapFree);
+}
+
+static void halBootStats(void *rx, uint8_t rx_len, uint32_t transactionId)
+{
+    struct NanohubHalBootStatsTx *resp;
+    struct BootStats stats;
+    uint32_t i;
+
+    if (!(resp = heapAlloc(sizeof(*resp))))
+        return;
+
+    bootStatsGet(&stats);
+
+    resp->hdr = (struct NanohubHalHdr) {
+        .appId = APP_ID_MAKE(NANOHUB_VENDOR_GOOGLE, 0),
+        .len = sizeof(*resp) - sizeof(resp->hdr) - sizeof(resp->phaseUs),
+        .transactionId = transactionId,
+    };
+    resp->ret = (struct NanohubHalRet) {
+        .msg = NANOHUB_HAL_BOOT_STATS,
+    };
+    resp->flags = stats.warm ? NANOHUB_HAL_BOOT_STATS_WARM : 0;
+    resp->appsChecked = htole16(stats.appsChecked);
+    resp->appsCached = htole16(stats.appsCached);
+
+    for (i = 0; i < BOOT_PHASE_NUM && i < NANOHUB_HAL_BOOT_PHASE_MAX; i++)
+        resp->phaseUs[i] = htole32(stats.phaseUs[i]);
+    resp->numPhases = i;
+    resp->hdr.len += i * sizeof(resp->phaseUs[0]);
+
+    osEnqueueEvtOrFree(EVT_APP_TO_HOST_CHRE, resp, heapFree);
+}
+
+C_STATIC_ASSERT(load_levels, LOAD_LEVEL_NUM == NANOHUB_HAL_LOAD_LEVEL_MAX);
+
+void nanohubHalSendLoadStats(uint32_t transactionId)
+{
+    struct NanohubHalLoadStatsTx *resp;
+    struct LoadStats stats;
+    uint32_t i;
+
+    if (!(resp = heapAlloc(sizeof(*resp))))
+        return;
+
+    loadGovGetStats(&stats);
+
+    resp->hdr = (struct NanohubHalHdr) {
+        .appId = APP_ID_MAKE(NANOHUB_VENDOR_GOOGLE, 0),
+        .len = sizeof(*resp) - sizeof(resp->hdr) - sizeof(resp->levelTime),
+        .transactionId = transactionId,
+    };
+    resp->ret = (struct NanohubHalRet) {
+        .msg = NANOHUB_HAL_LOAD_STATS,
+    };
+    resp->level = stats.level;
+    resp->busy = stats.busy;
+    resp->pending = htole16(stats.pending);
+    resp->drops = htole32(stats.drops);
+    resp->changes = htole32(stats.changes);
+
+    for (i = 0; i < LOAD_LEVEL_NUM; i++)
+        resp->levelTime[i] = htole64(stats.levelTime[i]);
+    resp->numLevels = i;
+    resp->hdr.len += i * sizeof(resp->levelTime[0]);
+
+    osEnqueueEvtOrFree(EVT_APP_TO_HOST_CHRE, resp, heapFree);
+}
+
+static void halLoadStats(void *rx, uint8_t rx_len, uint32_t transactionId)
+{
+    nanohubHalSendLoadStats(transactionId);
+}
+
+static void halPoolStats(void *rx, uint8_t rx_len, uint32_t transactionId)
+{
+    struct NanohubHalPoolStatsRx *req = rx;
+    struct NanohubHalPoolStatsTx *resp;
+    struct PoolStats stats;
+    uint32_t i, n = 0;
+
+    if (!(resp = heapAlloc(sizeof(*resp))))
+        return;
+
+    resp->hdr = (struct NanohubHalHdr) {
+        .appId = APP_ID_MAKE(NANOHUB_VENDOR_GOOGLE, 0),
+        .len = sizeof(*resp) - sizeof(resp->hdr) - sizeof(resp->stats),
+        .transactionId = transactionId,
+    };
+    resp->ret = (struct NanohubHalRet) {
+        .msg = NANOHUB_HAL_POOL_STATS,
+    };
+
+    for (i = 0; i < POOL_NUM && n < NANOHUB_HAL_POOL_STATS_MAX; i++) {
+        if (!poolStatsGet(i, &stats, req->flags & NANOHUB_HAL_POOL_STATS_RESET))
+            continue;
+        resp->stats[n].id = i;
+        resp->stats[n].size = htole16(stats.size);
+        resp->stats[n].used = htole16(stats.used);
+        resp->stats[n].peak = htole16(stats.peak);
+        resp->stats[n].fails = htole32(stats.fails);
+        resp->stats[n].discards = htole32(stats.discards);
+        n++;
+    }
+    resp->count = n;
+    resp->hdr.len += n * sizeof(resp->stats[0]);
+
+    osEnqueueEvtOrFree(EVT_APP_TO_HOST_CHRE, resp, heapFree);
+}
+
 const static struct NanohubHalCommand mBuiltinHalCommands[] = {
     NANOHUB_HAL_COMMAND(NANOHUB_HAL_APP_MGMT,
                             halAppMgmt,
@@ -1882,6 +2074,22 @@ const static struct NanohubHalCommand mBuiltinHalCommands[] = {
                             halFinishUpload,
                             struct { },
                             struct { }),
+    NANOHUB_HAL_COMMAND(NANOHUB_HAL_SLEEP_STATS,
+                            halSleepStats,
+                            struct NanohubHalSleepStatsRx,
+                            struct NanohubHalSleepStatsRx),
+    NANOHUB_HAL_COMMAND(NANOHUB_HAL_BOOT_STATS,
+                            halBootStats,
+                            struct { },
+                            struct { }),
+    NANOHUB_HAL_COMMAND(NANOHUB_HAL_LOAD_STATS,
+                            halLoadStats,
+                            struct { },
+                            struct { }),
+    NANOHUB_HAL_COMMAND(NANOHUB_HAL_POOL_STATS,
+                            halPoolStats,
+                            struct NanohubHalPoolStatsRx,
+                            struct NanohubHalPoolStatsRx),
 };
 
 const struct NanohubHalCommand *nanohubHalFindCommand(uint8_t msg)
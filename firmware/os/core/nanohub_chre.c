@@ -164,7 +164,7 @@ static void osChreApiAbort(uintptr_t *retValP, va_list args)
 static void osChreApiHeapAlloc(uintptr_t *retValP, va_list args)
 {
     uint32_t size = va_arg(args, uint32_t);
-    *retValP = (uintptr_t)heapAlloc(size);
+    *retValP = (uintptr_t)heapAllocApp(size);
 }
 
 static void osChreApiHeapFree(uintptr_t *retValP, va_list args)
@@ -241,6 +241,204 @@ static void osChreApiSendMessageToHost(uintptr_t *retValP, va_list args)
     *retValP = osChreSendMessageToHost(message, messageSize, messageType, CHRE_HOST_ENDPOINT_BROADCAST, freeCallback);
 }
 
+/*
+ * CHRE apps tend to reconfigure their sensors often (duty cycling), so the
+ * per-app subscription state and the aggregate sampling status are cached
+ * here instead of rescanning the sensor core tables on every call.
+ * The aggregate status is revalidated against the sensor's cfgSeq. Changes
+ * reach the apps through the sensor core's config event broadcast, which
+ * carries the rate the driver confirmed and which the app runtime turns into
+ * CHRE_EVENT_SENSOR_SAMPLING_CHANGE.
+ * A state is found through a small open addressed hash on the handle and
+ * links the subscriptions to its sensor. There is room for a state per
+ * registered sensor, so states stay cached until their sensor goes away.
+ */
+#define MAX_CHRE_SENSOR_SUBS    32 /* MAX(numChreApps * numSensorsPerApp) */
+#define MAX_CHRE_SENSOR_STATES  MAX_REGISTERED_SENSORS
+#define CHRE_SENSOR_HASH_SIZE   64 /* power of 2, at least twice MAX_CHRE_SENSOR_STATES */
+#define CHRE_SENSOR_HASH_MASK   (CHRE_SENSOR_HASH_SIZE - 1)
+
+struct ChreSensorSub;
+
+struct ChreSensorState {
+    struct Sensor *s;
+    struct ChreSensorSub *subs;
+    uint32_t handle;    /* here 0 means free */
+    uint32_t cfgSeq;
+    uint32_t rate;
+    uint64_t latency;
+};
+
+struct ChreSensorSub {
+    struct ChreSensorState *st;
+    struct ChreSensorSub *next; /* next subscription to the same sensor */
+    uint32_t handle;    /* here 0 means free */
+    uint16_t tid;
+    uint16_t requested; /* holds a sensorRequest() on behalf of the app */
+};
+
+static struct ChreSensorState mChreSensorStates[MAX_CHRE_SENSOR_STATES];
+static struct ChreSensorSub mChreSensorSubs[MAX_CHRE_SENSOR_SUBS];
+static uint8_t mChreSensorHash[CHRE_SENSOR_HASH_SIZE]; /* 1 + index into mChreSensorStates, 0 means empty */
+
+static uint32_t osChreSensorHash(uint32_t handle)
+{
+    /* handles are (tid << 16) | sequence */
+    return (handle ^ (handle >> 16)) & CHRE_SENSOR_HASH_MASK;
+}
+
+/* bucket holding handle, or the empty one it would go in; the hash is never more than half full */
+static uint32_t osChreSensorHashFind(uint32_t handle)
+{
+    uint32_t h = osChreSensorHash(handle);
+
+    while (mChreSensorHash[h] && mChreSensorStates[mChreSensorHash[h] - 1].handle != handle)
+        h = (h + 1) & CHRE_SENSOR_HASH_MASK;
+
+    return h;
+}
+
+static void osChreSensorStateDrop(struct ChreSensorState *st)
+{
+    struct ChreSensorSub *sub;
+    uint32_t hole = osChreSensorHashFind(st->handle), h, home;
+
+    /* the sensor is gone, and so are the subscriptions to it */
+    for (sub = st->subs; sub; sub = sub->next) {
+        sub->handle = 0;
+        sub->st = NULL;
+    }
+    st->subs = NULL;
+    st->handle = 0;
+
+    /* close the gap, so that no later entry of the probe sequence is cut off */
+    mChreSensorHash[hole] = 0;
+    for (h = (hole + 1) & CHRE_SENSOR_HASH_MASK; mChreSensorHash[h]; h = (h + 1) & CHRE_SENSOR_HASH_MASK) {
+        home = osChreSensorHash(mChreSensorStates[mChreSensorHash[h] - 1].handle);
+        if (((h - home) & CHRE_SENSOR_HASH_MASK) >= ((h - hole) & CHRE_SENSOR_HASH_MASK)) {
+            mChreSensorHash[hole] = mChreSensorHash[h];
+            mChreSensorHash[h] = 0;
+            hole = h;
+        }
+    }
+}
+
+static struct ChreSensorState *osChreSensorStateGet(uint32_t sensorHandle)
+{
+    struct ChreSensorState *st = NULL;
+    struct Sensor *s;
+    uint32_t h;
+    int i;
+
+    if (!sensorHandle)
+        return NULL;
+
+    h = osChreSensorHashFind(sensorHandle);
+    if (mChreSensorHash[h]) {
+        st = &mChreSensorStates[mChreSensorHash[h] - 1];
+        if (st->s->handle == sensorHandle)
+            return st;
+
+        /* sensor was unregistered since we looked it up */
+        osChreSensorStateDrop(st);
+        st = NULL;
+    }
+
+    s = sensorFindByHandle(sensorHandle);
+    if (!s)
+        return NULL;
+
+    /* there are as many states as sensors, so one is free or belongs to a sensor that is gone */
+    for (i = 0; i < MAX_CHRE_SENSOR_STATES && !st; i++) {
+        if (mChreSensorStates[i].handle && mChreSensorStates[i].s->handle != mChreSensorStates[i].handle)
+            osChreSensorStateDrop(&mChreSensorStates[i]);
+        if (!mChreSensorStates[i].handle)
+            st = &mChreSensorStates[i];
+    }
+    if (!st)
+        return NULL;
+
+    st->s = s;
+    st->subs = NULL;
+    st->handle = sensorHandle;
+    st->cfgSeq = s->cfgSeq;
+    st->rate = sensorGetHwRate(sensorHandle);
+    st->latency = sensorGetHwLatency(sensorHandle);
+    mChreSensorHash[osChreSensorHashFind(sensorHandle)] = st - mChreSensorStates + 1;
+
+    return st;
+}
+
+static void osChreSensorStateRefresh(struct ChreSensorState *st)
+{
+    if (st->cfgSeq == st->s->cfgSeq)
+        return;
+
+    st->cfgSeq = st->s->cfgSeq;
+    st->rate = sensorGetHwRate(st->handle);
+    st->latency = sensorGetHwLatency(st->handle);
+}
+
+static struct ChreSensorSub *osChreSensorSubFind(struct ChreSensorState *st, uint16_t tid)
+{
+    struct ChreSensorSub *sub;
+
+    for (sub = st->subs; sub; sub = sub->next)
+        if (sub->tid == tid)
+            return sub;
+
+    return NULL;
+}
+
+static struct ChreSensorSub *osChreSensorSubAdd(struct ChreSensorState *st, uint16_t tid)
+{
+    int i;
+
+    for (i = 0; i < MAX_CHRE_SENSOR_SUBS; i++) {
+        struct ChreSensorSub *sub = &mChreSensorSubs[i];
+
+        if (!sub->handle) {
+            sub->st = st;
+            sub->tid = tid;
+            sub->requested = false;
+            sub->handle = st->handle;
+            sub->next = st->subs;
+            st->subs = sub;
+            return sub;
+        }
+    }
+
+    return NULL;
+}
+
+static void osChreSensorSubDel(struct ChreSensorSub *sub)
+{
+    struct ChreSensorSub **p;
+
+    for (p = &sub->st->subs; *p; p = &(*p)->next) {
+        if (*p == sub) {
+            *p = sub->next;
+            break;
+        }
+    }
+
+    sub->handle = 0;
+    sub->st = NULL;
+}
+
+void osChreSensorFreeAll(uint32_t tid)
+{
+    int i;
+
+    /* the sensor core has already dropped this app's requests */
+    for (i = 0; i < MAX_CHRE_SENSOR_SUBS; i++) {
+        struct ChreSensorSub *sub = &mChreSensorSubs[i];
+
+        if (sub->handle && sub->tid == tid)
+            osChreSensorSubDel(sub);
+    }
+}
+
 static bool osChreSensorFindDefault(uint8_t sensorType, uint32_t *pHandle)
 {
     if (!pHandle)
@@ -327,19 +525,9 @@ static void osChreApiSensorGetInfo(uintptr_t *retValP, va_list args)
     *retValP = osChreSensorGetInfo(sensorHandle, info);
 }
 
-static bool osChreSensorGetSamplingStatus(uint32_t sensorHandle,
-                                 struct chreSensorSamplingStatus *status)
+static void osChreSensorRateToStatus(uint32_t rate, uint64_t latency,
+                                     struct chreSensorSamplingStatus *status)
 {
-    struct Sensor *s = sensorFindByHandle(sensorHandle);
-    uint32_t rate;
-    uint64_t latency;
-
-    if (!s || !status)
-        return false;
-
-    rate = sensorGetHwRate(sensorHandle);
-    latency = sensorGetHwLatency(sensorHandle);
-
     if (rate == SENSOR_RATE_OFF) {
         status->enabled = 0;
         status->interval = 0;
@@ -358,6 +546,18 @@ static bool osChreSensorGetSamplingStatus(uint32_t sensorHandle,
         else
             status->latency = latency;
     }
+}
+
+static bool osChreSensorGetSamplingStatus(uint32_t sensorHandle,
+                                 struct chreSensorSamplingStatus *status)
+{
+    struct ChreSensorState *st = osChreSensorStateGet(sensorHandle);
+
+    if (!st || !status)
+        return false;
+
+    osChreSensorStateRefresh(st);
+    osChreSensorRateToStatus(st->rate, st->latency, status);
 
     return true;
 }
@@ -375,11 +575,17 @@ static bool osChreSensorConfigure(uint32_t sensorHandle,
 {
     uint32_t rate, interval_us;
     bool ret;
-    struct Sensor *s = sensorFindByHandle(sensorHandle);
+    struct ChreSensorState *st = osChreSensorStateGet(sensorHandle);
+    uint16_t tid = osGetCurrentTid();
+    struct ChreSensorSub *sub;
+    struct Sensor *s;
     int i;
-    if (!s)
+    if (!st)
         return false;
 
+    s = st->s;
+    sub = osChreSensorSubFind(st, tid);
+
     if (mode & CHRE_SENSOR_CONFIGURE_RAW_POWER_ON) {
         if (interval == CHRE_SENSOR_INTERVAL_DEFAULT) {
             // use first rate in supported rates list > minimum (if avaliable)
@@ -404,26 +610,38 @@ static bool osChreSensorConfigure(uint32_t sensorHandle,
             rate = 1;
         if (latency == CHRE_SENSOR_LATENCY_DEFAULT)
             latency = 0ULL;
-        if (sensorGetReqRate(sensorHandle) == SENSOR_RATE_OFF) {
+        if (!sub || !sub->requested) {
+            if (!sub && !(sub = osChreSensorSubAdd(st, tid)))
+                return false;
             if ((ret = sensorRequest(0, sensorHandle, rate, latency))) {
                 if (!(ret = osEventsSubscribe(2, sensorGetMyEventType(s->si->sensorType), sensorGetMyCfgEventType(s->si->sensorType))))
                     sensorRelease(0, sensorHandle);
             }
+            if (ret)
+                sub->requested = true;
+            else
+                osChreSensorSubDel(sub);
         } else {
             ret = sensorRequestRateChange(0, sensorHandle, rate, latency);
         }
     } else if (mode & (CHRE_SENSOR_CONFIGURE_RAW_REPORT_CONTINUOUS|CHRE_SENSOR_CONFIGURE_RAW_REPORT_ONE_SHOT)) {
-        if (sensorGetReqRate(sensorHandle) == SENSOR_RATE_OFF)
-            ret = osEventsSubscribe(2, sensorGetMyEventType(s->si->sensorType), sensorGetMyCfgEventType(s->si->sensorType));
-        else
+        if (!sub) {
+            if (!(sub = osChreSensorSubAdd(st, tid)))
+                return false;
+            if (!(ret = osEventsSubscribe(2, sensorGetMyEventType(s->si->sensorType), sensorGetMyCfgEventType(s->si->sensorType))))
+                osChreSensorSubDel(sub);
+        } else {
             ret = true;
+        }
     } else {
-        if (sensorGetReqRate(sensorHandle) != SENSOR_RATE_OFF) {
+        if (sub && sub->requested) {
             if ((ret = sensorRelease(0, sensorHandle)))
                 ret = osEventsUnsubscribe(2, sensorGetMyEventType(s->si->sensorType), sensorGetMyCfgEventType(s->si->sensorType));
         } else {
             ret = osEventsUnsubscribe(2, sensorGetMyEventType(s->si->sensorType), sensorGetMyCfgEventType(s->si->sensorType));
         }
+        if (sub)
+            osChreSensorSubDel(sub);
     }
 
     return ret;
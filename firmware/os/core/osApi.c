@@ -230,7 +230,7 @@ static void osExpApiHeapAlloc(uintptr_t *retValP, va_list args)
 {
     uint32_t sz = va_arg(args, uint32_t);
 
-    *retValP = (uintptr_t)heapAlloc(sz);
+    *retValP = (uintptr_t)heapAllocApp(sz);
 }
 
 static void osExpApiHeapFree(uintptr_t *retValP, va_list args)
@@ -246,7 +246,7 @@ static void osExpApiSlabNew(uintptr_t *retValP, va_list args)
     uint32_t itemAlign = va_arg(args, uint32_t);
     uint32_t numItems = va_arg(args, uint32_t);
 
-    *retValP = (uintptr_t)slabAllocatorNew(itemSz, itemAlign, numItems);
+    *retValP = (uintptr_t)slabAllocatorNewApp(itemSz, itemAlign, numItems);
 }
 
 static void osExpApiSlabDestroy(uintptr_t *retValP, va_list args)
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <eventQ.h>
+#include <poolStats.h>
+#include <simpleQ.h>
+#include <slab.h>
+
+enum PoolType {
+    POOL_TYPE_NONE,
+    POOL_TYPE_SLAB,
+    POOL_TYPE_EVT_QUEUE,
+    POOL_TYPE_SIMPLE_QUEUE,
+};
+
+struct Pool {
+    enum PoolType type;
+    void *pool;
+};
+
+static struct Pool mPools[POOL_NUM];
+
+static void poolStatsAdd(enum PoolId id, enum PoolType type, void *pool)
+{
+    if (id < POOL_NUM && pool) {
+        mPools[id].type = type;
+        mPools[id].pool = pool;
+    }
+}
+
+void poolStatsAddSlab(enum PoolId id, struct SlabAllocator *slab)
+{
+    poolStatsAdd(id, POOL_TYPE_SLAB, slab);
+}
+
+void poolStatsAddEvtQueue(enum PoolId id, struct EvtQueue *q)
+{
+    poolStatsAdd(id, POOL_TYPE_EVT_QUEUE, q);
+}
+
+void poolStatsAddSimpleQueue(enum PoolId id, struct SimpleQueue *sq)
+{
+    poolStatsAdd(id, POOL_TYPE_SIMPLE_QUEUE, sq);
+}
+
+bool poolStatsGet(enum PoolId id, struct PoolStats *stats, bool reset)
+{
+    memset(stats, 0x00, sizeof(*stats));
+
+    if (id >= POOL_NUM)
+        return false;
+
+    switch (mPools[id].type) {
+    case POOL_TYPE_SLAB:
+        slabAllocatorGetStats(mPools[id].pool, stats, reset);
+        return true;
+    case POOL_TYPE_EVT_QUEUE:
+        evtQueueGetStats(mPools[id].pool, stats, reset);
+        return true;
+    case POOL_TYPE_SIMPLE_QUEUE:
+        simpleQueueGetStats(mPools[id].pool, stats, reset);
+        return true;
+    default:
+        return false;
+    }
+}
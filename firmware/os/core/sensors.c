@@ -21,6 +21,7 @@
 #include <inttypes.h>
 #include <sensors.h>
 #include <atomic.h>
+#include <poolStats.h>
 #include <stdio.h>
 #include <slab.h>
 #include <seos.h>
@@ -34,6 +35,9 @@ ATOMIC_BITSET_DECL(mSensorsUsed, MAX_REGISTERED_SENSORS, static);
 static struct SlabAllocator *mInternalEvents;
 static struct SlabAllocator *mCliSensMatrix;
 static uint32_t mNextSensorHandle;
+static uint32_t mOnchangeCacheTypes[(SENS_TYPE_FIRST_USER + 31) / 32];
+static bool mThrottle;
+static bool mCalDeferred;
 struct SingleAxisDataEvent singleAxisFlush = { .referenceTime = 0 };
 struct TripleAxisDataEvent tripleAxisFlush = { .referenceTime = 0 };
 
@@ -53,8 +57,11 @@ bool sensorsInit(void)
         return false;
 
     mCliSensMatrix = slabAllocatorNew(sizeof(struct SensorsClientRequest), alignof(struct SensorsClientRequest), MAX_CLI_SENS_MATRIX_SZ);
-    if (mCliSensMatrix)
+    if (mCliSensMatrix) {
+        poolStatsAddSlab(POOL_SENSOR_EVENTS, mInternalEvents);
+        poolStatsAddSlab(POOL_SENSOR_REQUESTS, mCliSensMatrix);
         return true;
+    }
 
     slabAllocatorDestroy(mInternalEvents);
 
@@ -112,11 +119,13 @@ static uint32_t sensorRegisterEx(const struct SensorInfo *si, TaggedPtr callInfo
     s->callInfo = callInfo;
     // TODO: is internal app, callinfo is OPS struct; shall we validate it here?
     s->callData = callData;
+    s->cfgSeq = 0;
     s->initComplete = initComplete ? 1 : 0;
     mem_reorder_barrier();
     s->handle = handle;
     s->hasOnchange = 0;
     s->hasOndemand = 0;
+    s->lastOnchangeValid = false;
 
     if (si->supportedRates) {
         for (i = 0; si->supportedRates[i]; i++) {
@@ -127,6 +136,11 @@ static uint32_t sensorRegisterEx(const struct SensorInfo *si, TaggedPtr callInfo
         }
     }
 
+    s->calPending = 0;
+    s->cachesOnchange = s->hasOnchange && si->numAxis == NUM_AXIS_EMBEDDED && si->sensorType < SENS_TYPE_FIRST_USER;
+    if (s->cachesOnchange)
+        mOnchangeCacheTypes[si->sensorType / 32] |= 1UL << (si->sensorType % 32);
+
     return handle;
 }
 
@@ -188,6 +202,9 @@ static void sensorCallFuncPowerEvtFreeF(void* event)
 
 static bool sensorCallFuncPower(struct Sensor* s, bool on)
 {
+    /* whatever the sensor reported before this is no longer its current state */
+    s->lastOnchangeValid = false;
+
     if (IS_LOCAL_APP(s)) {
         INVOKE_AS_OWNER_AND_RETURN(LOCAL_APP_OPS(s)->sensorPower, on, s->callData);
     } else {
@@ -347,8 +364,70 @@ static bool sensorCallFuncSendOneDirectEvt(struct Sensor* s, uint32_t tid)
     return false;
 }
 
+/*
+ * drivers broadcast from timer, deferred and bus completion callbacks too, where
+ * the origin tid may not be the sensor's owner, so the event is matched to the
+ * sensor by type; the origin only picks between sensors of the same type, and
+ * when it does not pick exactly one their caches are dropped rather than left
+ * stale
+ */
+void sensorCacheOnchangeEvt(uint32_t originTid, uint32_t evtType, void *evtData)
+{
+    uint32_t sensorType = evtType - EVT_NO_FIRST_SENSOR_EVENT;
+    struct Sensor *s, *only = NULL, *owned = NULL;
+    uint32_t i, count = 0, ownedCount = 0;
+
+    if (sensorType >= SENS_TYPE_FIRST_USER || evtData == SENSOR_DATA_EVENT_FLUSH ||
+        !(mOnchangeCacheTypes[sensorType / 32] & (1UL << (sensorType % 32))))
+        return;
+
+    for (i = 0; i < MAX_REGISTERED_SENSORS; i++) {
+        s = mSensors + i;
+        if (!s->handle || !s->cachesOnchange || s->si->sensorType != sensorType)
+            continue;
+        only = s;
+        count++;
+        if (HANDLE_TO_TID(s->handle) == originTid) {
+            owned = s;
+            ownedCount++;
+        }
+    }
+
+    s = count == 1 ? only : ownedCount == 1 ? owned : NULL;
+    if (s) {
+        s->lastOnchange = evtData;
+        mem_reorder_barrier();
+        s->lastOnchangeValid = true;
+    } else {
+        for (i = 0; i < MAX_REGISTERED_SENSORS; i++) {
+            s = mSensors + i;
+            if (s->handle && s->cachesOnchange && s->si->sensorType == sensorType)
+                s->lastOnchangeValid = false;
+        }
+    }
+}
+
+/* answer a new onchange client from the cache; only bother the sensor if it has not reported yet */
+static bool sensorSendLastOnchange(struct Sensor* s, uint32_t tid)
+{
+    uint16_t oldTid;
+    bool done;
+
+    if (!s->cachesOnchange || !s->lastOnchangeValid)
+        return sensorCallFuncSendOneDirectEvt(s, tid);
+
+    oldTid = osSetCurrentTid(HANDLE_TO_TID(s->handle));
+    done = osEnqueuePrivateEvt(sensorGetMyEventType(s->si->sensorType), s->lastOnchange, NULL, tid);
+    osSetCurrentTid(oldTid);
+
+    return done;
+}
+
 static void sensorReconfig(struct Sensor* s, uint32_t newHwRate, uint64_t newHwLatency)
 {
+    /* the set of requests (or the state derived from it) may have changed */
+    s->cfgSeq++;
+
     if (s->currentRate == newHwRate && s->currentLatency == newHwLatency) {
         /* do nothing */
     }
@@ -453,6 +532,10 @@ static uint32_t sensorCalcHwRate(struct Sensor* s, uint32_t extraReqedRate, uint
             return SENSOR_RATE_ONDEMAND;
     }
 
+    /* under load, sensors that allow it run at the first supported rate above half of what was asked */
+    if (mThrottle && (s->si->flags1 & SENSOR_INFO_FLAGS1_THROTTLE))
+        highestReq = (highestReq + 1) / 2;
+
     for (i = 0; s->si->supportedRates && s->si->supportedRates[i]; i++)
         if (s->si->supportedRates[i] >= highestReq)
             return s->si->supportedRates[i];
@@ -660,8 +743,8 @@ bool sensorRequest(uint32_t unusedTid, uint32_t sensorHandle, uint32_t rate, uin
     /* update actual sensor if needed */
     sensorReconfig(s, newSensorRate, sensorCalcHwLatency(s));
 
-    /* if onchange request, ask sensor to send last state */
-    if (s->hasOnchange && !sensorCallFuncSendOneDirectEvt(s, clientTid))
+    /* if onchange request, send last state */
+    if (s->hasOnchange && !sensorSendLastOnchange(s, clientTid))
         osLog(LOG_WARN, "Cannot send last state for onchange sensor: enqueue fail");
 
     return true;
@@ -778,9 +861,56 @@ bool sensorCalibrate(uint32_t sensorHandle)
     if (!s)
         return false;
 
+    /* run once the load governor allows it again */
+    if (mCalDeferred) {
+        s->calPending = 1;
+        return true;
+    }
+
     return sensorCallFuncCalibrate(s);
 }
 
+bool sensorCalDeferred(void)
+{
+    return mCalDeferred;
+}
+
+void sensorsSetCalDeferred(bool defer)
+{
+    uint32_t i;
+
+    if (mCalDeferred == defer)
+        return;
+
+    mCalDeferred = defer;
+    if (defer)
+        return;
+
+    for (i = 0; i < MAX_REGISTERED_SENSORS; i++) {
+        if (mSensors[i].handle && mSensors[i].calPending) {
+            mSensors[i].calPending = 0;
+            (void)sensorCallFuncCalibrate(mSensors + i);
+        }
+    }
+}
+
+void sensorsSetThrottle(bool throttle)
+{
+    struct Sensor *s;
+    uint32_t i;
+
+    if (mThrottle == throttle)
+        return;
+
+    mThrottle = throttle;
+
+    for (i = 0; i < MAX_REGISTERED_SENSORS; i++) {
+        s = mSensors + i;
+        if (s->handle && s->initComplete && (s->si->flags1 & SENSOR_INFO_FLAGS1_THROTTLE))
+            sensorReconfig(s, sensorCalcHwRate(s, 0, 0), sensorCalcHwLatency(s));
+    }
+}
+
 bool sensorSelfTest(uint32_t sensorHandle)
 {
     struct Sensor* s = sensorFindByHandle(sensorHandle);
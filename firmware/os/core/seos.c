@@ -26,17 +26,21 @@
 #include <apInt.h>
 #include <atomic.h>
 #include <bl.h>
+#include <bootCache.h>
 #include <cpu.h>
 #include <crc.h>
 #include <eventQ.h>
 #include <heap.h>
 #include <hostIntf.h>
+#include <loadGovernor.h>
 #include <mpu.h>
 #include <nanohubPacket.h>
 #include <osApi.h>
 #include <platform.h>
+#include <poolStats.h>
 #include <printf.h>
 #include <sensors.h>
+#include <sensors_priv.h>
 #include <seos.h>
 #include <seos_priv.h>
 #include <slab.h>
@@ -290,10 +294,41 @@ struct Task* osTaskFindByTid(uint32_t tid)
     return idx < MAX_TASKS ? &mTaskPool.data[idx] : NULL;
 }
 
+/*
+ * Cycles spent by accounted calls nested inside the one currently being
+ * measured (e.g. a free callback invoked from another app's handler); these
+ * are charged to the inner task only.
+ */
+static uint32_t mTaskCpuNested;
+
+void osTaskCpuBegin(struct TaskCpuMark *mark)
+{
+    mark->nested = mTaskCpuNested;
+    mTaskCpuNested = 0;
+    mark->start = cpuGetCycles();
+}
+
+void osTaskCpuEnd(struct Task *task, struct TaskCpuMark *mark)
+{
+    uint32_t total = cpuGetCycles() - mark->start;
+    uint32_t own = total - mTaskCpuNested;
+
+    mTaskCpuNested = mark->nested + total;
+
+    if (task) {
+        task->cpuCycles += own;
+        if (own > task->cpuCyclesMax)
+            task->cpuCyclesMax = own;
+    }
+}
+
 static inline bool osTaskInit(struct Task *task)
 {
+    struct TaskCpuMark mark;
     struct Task *preempted = osSetCurrentTask(task);
+    osTaskCpuBegin(&mark);
     bool done = cpuAppInit(task->app, &task->platInfo, task->tid);
+    osTaskCpuEnd(task, &mark);
     osSetCurrentTask(preempted);
     return done;
 }
@@ -312,6 +347,7 @@ static void osTaskRelease(struct Task *task)
 
     platErr = platFreeResources(taskTid); // HW resources cleanup (IRQ, DMA etc)
     sensorErr = sensorFreeAll(taskTid);
+    osChreSensorFreeAll(taskTid);
     timErr = timTimerCancelAll(taskTid);
     heapErr = heapFreeAll(taskTid);
 
@@ -337,27 +373,90 @@ static inline void osTaskEnd(struct Task *task)
 
 static inline void osTaskHandle(struct Task *task, uint16_t evtType, uint16_t fromTid, const void* evtData)
 {
+    struct TaskCpuMark mark;
     struct Task *preempted = osSetCurrentTask(task);
+    osTaskCpuBegin(&mark);
     cpuAppHandle(task->app, &task->platInfo,
                  EVENT_WITH_ORIGIN(evtType, osTaskIsChre(task) ? fromTid : 0),
                  evtData);
+    osTaskCpuEnd(task, &mark);
+    task->evtCount++;
     osSetCurrentTask(preempted);
 }
 
+static void osTaskInvokeFreeCallback(struct Task *task, uintptr_t method, uintptr_t arg1, uintptr_t arg2);
+
+static void osTaskDeferredAppCall(void *cookie)
+{
+    union SeosInternalSlabData *act = cookie;
+    struct Task *task = osTaskFindByTid(act->appCall.tid);
+    uintptr_t method = act->appCall.method;
+    uintptr_t arg1 = act->appCall.arg1;
+    uintptr_t arg2 = act->appCall.arg2;
+    struct Task *preempted;
+
+    slabAllocatorFree(mMiscInternalThingsSlab, act);
+
+    // an app that has gone since took the memory with it
+    if (!task)
+        return;
+
+    if (method) {
+        preempted = osSetCurrentTask(task);
+        osTaskInvokeFreeCallback(task, method, arg1, arg2);
+        osSetCurrentTask(preempted);
+    } else {
+        struct AppEventFreeData fd = {.evtType = arg1, .evtData = (void *)arg2};
+        osTaskHandle(task, EVT_APP_FREE_EVT_DATA, OS_SYSTEM_TID, &fd);
+    }
+}
+
+// frees can come due in a syscall or with interrupts off, where an isolated app may not run; those wait for the main loop
+static bool osTaskDeferAppCall(struct Task *task, uintptr_t method, uintptr_t arg1, uintptr_t arg2)
+{
+    union SeosInternalSlabData *act;
+
+    if (cpuAppCanCall(&task->platInfo))
+        return false;
+
+    act = slabAllocatorAlloc(mMiscInternalThingsSlab);
+    if (act) {
+        act->appCall.method = method;
+        act->appCall.arg1 = arg1;
+        act->appCall.arg2 = arg2;
+        act->appCall.tid = task->tid;
+        if (osDefer(osTaskDeferredAppCall, act, false))
+            return true;
+        slabAllocatorFree(mMiscInternalThingsSlab, act);
+    }
+
+    osLog(LOG_ERROR, "TID %04" PRIX16 ": free callback dropped, no room to defer it\n", task->tid);
+    return true;
+}
+
+static void osTaskInvokeFreeCallback(struct Task *task, uintptr_t method, uintptr_t arg1, uintptr_t arg2)
+{
+    struct TaskCpuMark mark;
+
+    if (osTaskDeferAppCall(task, method, arg1, arg2))
+        return;
+    osTaskCpuBegin(&mark);
+    cpuAppInvoke(task->app, &task->platInfo, (void (*)(uintptr_t,uintptr_t))method, arg1, arg2);
+    osTaskCpuEnd(task, &mark);
+}
+
 void osTaskInvokeMessageFreeCallback(struct Task *task, void (*freeCallback)(void *, size_t), void *message, uint32_t messageSize)
 {
     if (!task || !freeCallback)
         return;
-    cpuAppInvoke(task->app, &task->platInfo, (void (*)(uintptr_t,uintptr_t))freeCallback, (uintptr_t)message, (uintptr_t)messageSize);
+    osTaskInvokeFreeCallback(task, (uintptr_t)freeCallback, (uintptr_t)message, (uintptr_t)messageSize);
 }
 
 void osTaskInvokeEventFreeCallback(struct Task *task, void (*freeCallback)(uint16_t, void *), uint16_t event, void *data)
 {
     if (!task || !freeCallback)
         return;
-    cpuAppInvoke(task->app, &task->platInfo,
-                 (void (*)(uintptr_t,uintptr_t))freeCallback,
-                 (uintptr_t)event, (uintptr_t)data);
+    osTaskInvokeFreeCallback(task, (uintptr_t)freeCallback, (uintptr_t)event, (uintptr_t)data);
 }
 
 static void osPrivateEvtFreeF(void *event)
@@ -392,7 +491,8 @@ static void osPrivateEvtFreeF(void *event)
     } else if (taggedPtrIsUint(evtFreeInfo)) {
         // this is for external non-CHRE tasks
         struct AppEventFreeData fd = {.evtType = evtType, .evtData = evtData};
-        osTaskHandle(srcTask, EVT_APP_FREE_EVT_DATA, OS_SYSTEM_TID, &fd);
+        if (!osTaskDeferAppCall(srcTask, 0, fd.evtType, (uintptr_t)fd.evtData))
+            osTaskHandle(srcTask, EVT_APP_FREE_EVT_DATA, OS_SYSTEM_TID, &fd);
     }
 
     osTaskAddIoCount(srcTask, -1);
@@ -420,7 +520,8 @@ static void handleEventFreeing(uint32_t evtType, void *evtData, TaggedPtr evtFre
     } else if (taggedPtrIsUint(evtFreeData)) {
         // this is for external non-CHRE tasks
         struct AppEventFreeData fd = {.evtType = EVENT_GET_EVENT(evtType), .evtData = evtData};
-        osTaskHandle(srcTask, EVT_APP_FREE_EVT_DATA, OS_SYSTEM_TID, &fd);
+        if (!osTaskDeferAppCall(srcTask, 0, fd.evtType, (uintptr_t)fd.evtData))
+            osTaskHandle(srcTask, EVT_APP_FREE_EVT_DATA, OS_SYSTEM_TID, &fd);
     }
 
     osTaskAddIoCount(srcTask, -1);
@@ -445,6 +546,9 @@ static void osInit(void)
         osLog(LOG_INFO, "deferred actions list failed to init\n");
         return;
     }
+
+    poolStatsAddEvtQueue(POOL_OS_EVENTS, mEvtsInternal);
+    poolStatsAddSlab(POOL_OS_MISC, mMiscInternalThingsSlab);
 }
 
 static struct Task* osTaskFindByAppID(uint64_t appID)
@@ -478,11 +582,13 @@ bool osAppSegmentSetState(const struct AppHdr *app, uint32_t segState)
     if (!seg)
         return false;
 
+    bootCacheForget(&seg->state, sizeof(state));
     mpuAllowRamExecution(true);
     mpuAllowRomWrite(true);
     done = BL.blProgramShared(&seg->state, &state, sizeof(state), BL_FLASH_KEY1, BL_FLASH_KEY2);
     mpuAllowRomWrite(false);
     mpuAllowRamExecution(false);
+    bootCacheFlashWritten();
 
     return done;
 }
@@ -544,12 +650,14 @@ struct Segment *osGetSegment(const struct AppHdr *app)
 
 bool osEraseShared()
 {
+    bootCacheClear();
     wdtDisableClk();
     mpuAllowRamExecution(true);
     mpuAllowRomWrite(true);
     (void)BL.blEraseShared(BL_FLASH_KEY1, BL_FLASH_KEY2);
     mpuAllowRomWrite(false);
     mpuAllowRamExecution(false);
+    bootCacheFlashWritten();
     wdtEnableClk();
     return true;
 }
@@ -558,11 +666,13 @@ bool osWriteShared(void *dest, const void *src, uint32_t len)
 {
     bool ret;
 
+    bootCacheForget(dest, len);
     mpuAllowRamExecution(true);
     mpuAllowRomWrite(true);
     ret = BL.blProgramShared(dest, src, len, BL_FLASH_KEY1, BL_FLASH_KEY2);
     mpuAllowRomWrite(false);
     mpuAllowRamExecution(false);
+    bootCacheFlashWritten();
 
     if (!ret)
         osLog(LOG_ERROR, "osWriteShared: blProgramShared return false\n");
@@ -689,12 +799,29 @@ static inline bool osAppIsValid(const struct AppHdr *app)
            app->hdr.payInfoType == LAYOUT_APP;
 }
 
+// segments that passed before a warm reset are not checked again
+static bool osExtAppCrcIsValid(const struct AppHdr *app)
+{
+    struct Segment *seg = osGetSegment(app);
+    uint32_t size = osSegmentSizeAlignedWithFooter(osSegmentGetSize(seg)) + sizeof(*seg);
+    uint32_t crc = osSegmentGetCrc(seg);
+
+    if (bootCacheCheck(seg, size, crc))
+        return true;
+
+    if (osAppSegmentCalcCrcResidue(app) != CRC_RESIDUE)
+        return false;
+
+    bootCacheAdd(seg, size, crc);
+    return true;
+}
+
 static bool osExtAppIsValid(const struct AppHdr *app, uint32_t len)
 {
     return  osAppIsValid(app) &&
             len >= sizeof(*app) &&
             osAppSegmentGetState(app) == SEG_ST_VALID &&
-            osAppSegmentCalcCrcResidue(app) == CRC_RESIDUE &&
+            osExtAppCrcIsValid(app) &&
             !(app->hdr.fwFlags & FL_APP_HDR_INTERNAL);
 }
 
@@ -1030,9 +1157,11 @@ static void osStartTasks(void)
         if (osStartApp(app))
             taskCnt++;
     }
+    bootPhaseMark(BOOT_PHASE_INT_APPS);
 
     osLog(LOG_DEBUG, "Starting external apps...\n");
     status = osExtAppStartApps(matchAutoStart, (void *)true);
+    bootPhaseMark(BOOT_PHASE_EXT_APPS);
     osLog(LOG_DEBUG, "Started %" PRIu32 " internal apps; EXT status: %08" PRIX32 "\n", taskCnt, status);
 }
 
@@ -1154,9 +1283,14 @@ void osFreeRetainedEvent(uint32_t evtType, void *evtData, TaggedPtr *evtFreeingI
 
 void osMainInit(void)
 {
+    struct BootStats stats;
+
+    bootPhaseStart();
     cpuInit();
     cpuIntsOff();
     osInit();
+    bootCacheInit(platIsWarmReset());
+    bootPhaseMark(BOOT_PHASE_OS_INIT);
     timInit();
     sensorsInit();
     syscallInit();
@@ -1164,11 +1298,23 @@ void osMainInit(void)
     osChreApiExport();
     apIntInit();
     cpuIntsOn();
+    cpuAppIsolationInit();
     wdtInit();
+    loadGovInit();
+    bootPhaseMark(BOOT_PHASE_SERVICES);
     osStartTasks();
 
     //broadcast app start to all already-loaded apps
     (void)osEnqueueEvt(EVT_APP_START, NULL, NULL);
+    bootPhaseMark(BOOT_PHASE_READY);
+
+    bootStatsGet(&stats);
+    osLog(LOG_INFO, "%s boot; apps checked: %" PRIu32 ", cached: %" PRIu32
+                    "; bl: %" PRIu32 "us, init: %" PRIu32 "us, services: %" PRIu32 "us, apps: %" PRIu32 "/%" PRIu32 "us, ready: %" PRIu32 "us\n",
+          stats.warm ? "Warm" : "Cold", stats.appsChecked, stats.appsCached,
+          stats.phaseUs[BOOT_PHASE_BL], stats.phaseUs[BOOT_PHASE_OS_INIT], stats.phaseUs[BOOT_PHASE_SERVICES],
+          stats.phaseUs[BOOT_PHASE_INT_APPS], stats.phaseUs[BOOT_PHASE_EXT_APPS],
+          stats.phaseUs[BOOT_PHASE_READY]);
 }
 
 void osMainDequeueLoop(void)
@@ -1209,6 +1355,8 @@ void osMainDequeueLoop(void)
 
     /* avoid some possible errors */
     mCurEvtEventFreeingInfo = NULL;
+
+    loadGovPoll();
 }
 
 void __attribute__((noreturn)) osMain(void)
@@ -1307,15 +1455,28 @@ static bool osEnqueueEvtCommon(uint32_t evt, void *evtData, TaggedPtr evtFreeInf
 
     osTaskAddIoCount(task, 1);
 
-    if (osTaskTestFlags(task, FL_TASK_STOPPED) ||
-        !evtQueueEnqueue(mEvtsInternal, evtType, evtData, evtFreeInfo, urgent)) {
+    if (osTaskTestFlags(task, FL_TASK_STOPPED)) {
         osTaskAddIoCount(task, -1);
         return false;
     }
 
+    if (!evtQueueEnqueue(mEvtsInternal, evtType, evtData, evtFreeInfo, urgent)) {
+        osTaskAddIoCount(task, -1);
+        loadGovReportDrop();
+        return false;
+    }
+
+    if (EVENT_GET_EVENT(evt) >= EVT_NO_FIRST_SENSOR_EVENT && taggedPtrIsPtr(evtFreeInfo) && !taggedPtrToPtr(evtFreeInfo))
+        sensorCacheOnchangeEvt(EVENT_GET_ORIGIN(evtType), EVENT_GET_EVENT(evt), evtData);
+
     return true;
 }
 
+uint32_t osGetPendingEvents(void)
+{
+    return evtQueueGetCount(mEvtsInternal);
+}
+
 void osRemovePendingEvents(bool (*match)(uint32_t evtType, const void *evtData, void *context), void *context)
 {
     evtQueueRemoveAllMatching(mEvtsInternal, match, context);
@@ -1368,6 +1529,7 @@ static bool osEnqueuePrivateEvtEx(uint32_t evtType, void *evtData, TaggedPtr evt
 
     if (!act) {
         osLog(LOG_ERROR, "[seos] ERROR: osEnqueuePrivateEvtEx: call to slabAllocatorAlloc() failed\n");
+        loadGovReportDrop();
         return false;
     }
     struct Task *task = osGetCurrentTask();
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <poolStats.h>
 #include <simpleQ.h>
 #include <stddef.h>
 #include <string.h>
@@ -30,6 +31,7 @@ struct SimpleQueueEntry {
 struct SimpleQueue {
     SimpleQueueForciblyDiscardCbkF discardCbk;
     uint32_t head, tail, num, freeHead, entrySz;
+    uint32_t used, peak, fails, discards;
     uint8_t data[];
 };
 
@@ -109,6 +111,7 @@ bool simpleQueueDequeue(struct SimpleQueue* sq, void *data)
 
     e->nextIdx = sq->freeHead;
     sq->freeHead = simpleQueueGetIdx(sq, e);
+    sq->used--;
 
     return true;
 }
@@ -136,6 +139,8 @@ static struct SimpleQueueEntry* simpleQueueAllocWithDiscard(struct SimpleQueue*
             if (sq->tail == idx)
                 sq->tail = prev;
 
+            sq->used--;
+            sq->discards++;
             return cur;
         }
     }
@@ -161,8 +166,10 @@ bool simpleQueueEnqueue(struct SimpleQueue* sq, const void *data, int length, bo
         e = simpleQueueAllocWithDiscard(sq);
 
     //and we may have to give up
-    if (!e)
+    if (!e) {
+        sq->fails++;
         return false;
+    }
 
     //link it in
     e->nextIdx = SIMPLE_QUEUE_IDX_NONE;
@@ -171,6 +178,8 @@ bool simpleQueueEnqueue(struct SimpleQueue* sq, const void *data, int length, bo
     else
         simpleQueueGetNth(sq, sq->tail)->nextIdx = simpleQueueGetIdx(sq, e);
     sq->tail = simpleQueueGetIdx(sq, e);
+    if (++sq->used > sq->peak)
+        sq->peak = sq->used;
 
     //fill in the data
     memcpy(e->data, data, length);
@@ -178,3 +187,18 @@ bool simpleQueueEnqueue(struct SimpleQueue* sq, const void *data, int length, bo
 
     return true;
 }
+
+void simpleQueueGetStats(struct SimpleQueue* sq, struct PoolStats *stats, bool reset)
+{
+    stats->size = sq->num;
+    stats->used = sq->used;
+    stats->peak = sq->peak;
+    stats->fails = sq->fails;
+    stats->discards = sq->discards;
+
+    if (reset) {
+        sq->peak = sq->used;
+        sq->fails = 0;
+        sq->discards = 0;
+    }
+}
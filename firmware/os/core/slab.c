@@ -15,20 +15,27 @@
  */
 
 #include <atomicBitset.h>
+#include <atomic.h>
 #include <stdio.h>
 #include <heap.h>
 #include <slab.h>
+#include <poolStats.h>
 
 struct SlabAllocator {
 
     uint32_t itemSz;
-    uint8_t *dataChunks;
+    uint8_t *dataChunks;        //separate heap chunk for app slabs, right after the bitset otherwise
+    bool appData;
+    volatile uint32_t used;
+    volatile uint32_t peak;     //may miss a racing allocation; good enough for sizing
+    volatile uint32_t fails;
     struct AtomicBitset bitset[0];
 };
 
-struct SlabAllocator* slabAllocatorNew(uint32_t itemSz, uint32_t itemAlign, uint32_t numItems)
+static struct SlabAllocator* slabAllocatorPrvNew(uint32_t itemSz, uint32_t itemAlign, uint32_t numItems, bool appData)
 {
     struct SlabAllocator *allocator;
+    uint8_t *data = NULL;
     uint32_t bitsetSz, dataSz;
 
     /* calcualte size */
@@ -39,27 +46,60 @@ struct SlabAllocator* slabAllocatorNew(uint32_t itemSz, uint32_t itemAlign, uint
     dataSz = itemSz * numItems;
 
     /* allocate & init*/
+    if (appData) {
+        //apps write the items, never the bookkeeping
+        data = heapAllocApp(dataSz);
+        if (!data)
+            return NULL;
+        dataSz = 0;
+    }
+
     allocator = (struct SlabAllocator*)heapAlloc(sizeof(struct SlabAllocator) + bitsetSz + dataSz);
     if (allocator) {
         allocator->itemSz = itemSz;
-        allocator->dataChunks = ((uint8_t*)allocator->bitset) + bitsetSz;
+        allocator->dataChunks = appData ? data : ((uint8_t*)allocator->bitset) + bitsetSz;
+        allocator->appData = appData;
+        allocator->used = 0;
+        allocator->peak = 0;
+        allocator->fails = 0;
         atomicBitsetInit(allocator->bitset, numItems);
+    } else if (data) {
+        heapFree(data);
     }
 
     return allocator;
 }
 
+struct SlabAllocator* slabAllocatorNew(uint32_t itemSz, uint32_t itemAlign, uint32_t numItems)
+{
+    return slabAllocatorPrvNew(itemSz, itemAlign, numItems, false);
+}
+
+struct SlabAllocator* slabAllocatorNewApp(uint32_t itemSz, uint32_t itemAlign, uint32_t numItems)
+{
+    return slabAllocatorPrvNew(itemSz, itemAlign, numItems, true);
+}
+
 void slabAllocatorDestroy(struct SlabAllocator *allocator)
 {
+    if (allocator->appData)
+        heapFree(allocator->dataChunks);
     heapFree(allocator);
 }
 
 void* slabAllocatorAlloc(struct SlabAllocator *allocator)
 {
     int32_t itemIdx = atomicBitsetFindClearAndSet(allocator->bitset);
+    uint32_t used;
 
-    if (itemIdx < 0)
+    if (itemIdx < 0) {
+        atomicAdd32bits(&allocator->fails, 1);
         return NULL;
+    }
+
+    used = atomicAdd32bits(&allocator->used, 1) + 1;
+    if (used > allocator->peak)
+        allocator->peak = used;
 
     return allocator->dataChunks + allocator->itemSz * itemIdx;
 }
@@ -75,6 +115,7 @@ void slabAllocatorFree(struct SlabAllocator *allocator, void* ptrP)
         return;
 
     atomicBitsetClearBit(allocator->bitset, itemIdx);
+    atomicAdd32bits(&allocator->used, (uint32_t)-1);
 }
 
 void* slabAllocatorGetNth(struct SlabAllocator *allocator, uint32_t idx)
@@ -102,4 +143,16 @@ uint32_t slabAllocatorGetNumItems(struct SlabAllocator *allocator)
     return atomicBitsetGetNumBits(allocator->bitset);
 }
 
-
+void slabAllocatorGetStats(struct SlabAllocator *allocator, struct PoolStats *stats, bool reset)
+{
+    stats->size = atomicBitsetGetNumBits(allocator->bitset);
+    stats->used = allocator->used;
+    stats->peak = allocator->peak;
+    stats->fails = allocator->fails;
+    stats->discards = 0;
+
+    if (reset) {
+        allocator->peak = allocator->used;
+        allocator->fails = 0;
+    }
+}
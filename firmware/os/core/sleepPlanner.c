@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sleepPlanner.h>
+
+#define AVG_SHIFT           3   //running averages weigh each new period 1/8
+#define RATIO_ONE           1024
+
+void sleepPlannerInit(struct SleepPlannerHistory *hist)
+{
+    hist->untimedIdle = 0;
+    hist->timedRatio = RATIO_ONE;
+}
+
+uint64_t sleepPlannerPredict(const struct SleepPlannerHistory *hist, uint64_t timerLength)
+{
+    if (!timerLength)
+        return hist->untimedIdle ? hist->untimedIdle : SLEEP_PLANNER_MAX_IDLE;
+
+    if (timerLength > SLEEP_PLANNER_MAX_IDLE)
+        timerLength = SLEEP_PLANNER_MAX_IDLE;
+
+    //timerLength * timedRatio / RATIO_ONE; the ratio never exceeds RATIO_ONE
+    return (timerLength >> 10) * hist->timedRatio + (((timerLength & 1023) * hist->timedRatio) >> 10);
+}
+
+void sleepPlannerRecord(struct SleepPlannerHistory *hist, uint64_t timerLength, uint64_t slept)
+{
+    uint32_t ratio;
+
+    if (slept > SLEEP_PLANNER_MAX_IDLE)
+        slept = SLEEP_PLANNER_MAX_IDLE;
+
+    if (!timerLength) {
+        if (hist->untimedIdle)
+            hist->untimedIdle += (slept >> AVG_SHIFT) - (hist->untimedIdle >> AVG_SHIFT);
+        else
+            hist->untimedIdle = slept;
+        return;
+    }
+
+    if (slept >= timerLength) {
+        ratio = RATIO_ONE;
+    } else {
+        //scale both down so that a 32-bit divide does (no 64-bit division here)
+        while (timerLength >= (1UL << 22)) {
+            timerLength >>= 1;
+            slept >>= 1;
+        }
+        ratio = ((uint32_t)slept << 10) / (uint32_t)timerLength;
+    }
+
+    hist->timedRatio += (ratio >> AVG_SHIFT) - (hist->timedRatio >> AVG_SHIFT);
+}
+
+bool sleepPlannerUsable(const struct SleepPlannerOption *opt, const struct SleepPlannerRequest *req, bool *tooShort)
+{
+    uint32_t i;
+
+    *tooShort = false;
+
+    //if we have timers, consider them
+    if (req->timerLength) {
+        //skip options with too much jitter
+        if (opt->jitterPpm > req->maxJitterPpm)
+            return false;
+
+        //skip options that will take too long to wake up to be of use
+        if (opt->resolution + opt->maxWakeupTime > req->timerLength)
+            return false;
+
+        //skip options with too much drift
+        if (opt->driftPpm > req->maxDriftPpm)
+            return false;
+
+        //options that do not let us sleep enough are only a last resort
+        if (req->timerLength > opt->resolution * opt->maxCounter)
+            *tooShort = true;
+    }
+
+    //skip all options that do not keep enough devices awake
+    if ((opt->devsAvail & req->devsToKeepAlive) != req->devsToKeepAlive)
+        return false;
+
+    //skip all options that wake up too slowly
+    for (i = 0; i < req->numDevs; i++) {
+        if ((req->devsToKeepAlive & (1UL << i)) && req->devsMaxWakeTime[i] < opt->maxWakeupTime)
+            return false;
+    }
+
+    return true;
+}
+
+uint64_t sleepPlannerEnergy(const struct SleepPlannerOption *opt, uint64_t idle)
+{
+    if (idle > SLEEP_PLANNER_MAX_IDLE)
+        idle = SLEEP_PLANNER_MAX_IDLE;
+
+    return opt->powerUw * idle + opt->transitionNj * 1000000ULL;
+}
+
+int32_t sleepPlannerPick(const struct SleepPlannerOption *opts, uint32_t numOpts, size_t stride, const struct SleepPlannerRequest *req)
+{
+    const struct SleepPlannerOption *opt;
+    int32_t best = -1, fallback = -1;
+    uint64_t energy, bestEnergy = 0;
+    bool tooShort;
+    uint32_t i;
+
+    for (i = 0; i < numOpts; i++) {
+        opt = (const struct SleepPlannerOption *)((const uint8_t *)opts + i * stride);
+
+        if (!sleepPlannerUsable(opt, req, &tooShort))
+            continue;
+
+        if (tooShort) {
+            if (fallback < 0)
+                fallback = i;
+            continue;
+        }
+
+        //ties go to the earlier (deeper) state, as without a power model
+        energy = sleepPlannerEnergy(opt, req->predictedIdle);
+        if (best < 0 || energy < bestEnergy) {
+            best = i;
+            bestEnergy = energy;
+        }
+    }
+
+    return best >= 0 ? best : fallback;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include <sleepPlanner.h>
+#include <sleepStats.h>
+#include <timer.h>
+
+struct SleepCounter {
+    uint32_t count;
+    uint64_t time;
+};
+
+//all zero at boot, which is when timGetTime() starts too
+static struct {
+    uint64_t resetTime;
+    uint32_t numStates;         //states seen so far; they stay listed across resets
+    uint32_t sleeps;
+    struct SleepCounter states[SLEEP_STATS_MAX_STATES];
+    struct SleepCounter wakes[SLEEP_WAKE_NUM];
+    struct SleepCounter lines[SLEEP_STATS_MAX_LINES];
+    struct SleepCounter predict[2];
+} mSleepStats;
+
+//since boot, not cleared by sleepStatsReset()
+static uint64_t mSleptTotal;
+static uint32_t mSleepsTotal;
+
+void sleepStatsReset(void)
+{
+    uint32_t numStates = mSleepStats.numStates;
+
+    memset(&mSleepStats, 0x00, sizeof(mSleepStats));
+    mSleepStats.numStates = numStates;
+    mSleepStats.resetTime = timGetTime();
+}
+
+static void sleepCounterAdd(struct SleepCounter *counter, uint64_t time)
+{
+    counter->count++;
+    counter->time += time;
+}
+
+void sleepStatsRecord(uint32_t state, enum SleepWakeReason reason, uint32_t line,
+                      uint64_t timerLength, uint64_t predicted, uint64_t slept)
+{
+    mSleepStats.sleeps++;
+    mSleepsTotal++;
+    mSleptTotal += slept;
+
+    if (state < SLEEP_STATS_MAX_STATES) {
+        sleepCounterAdd(&mSleepStats.states[state], slept);
+        if (state >= mSleepStats.numStates)
+            mSleepStats.numStates = state + 1;
+    }
+
+    if (reason < SLEEP_WAKE_NUM)
+        sleepCounterAdd(&mSleepStats.wakes[reason], slept);
+    if (reason == SLEEP_WAKE_LINE && line < SLEEP_STATS_MAX_LINES)
+        sleepCounterAdd(&mSleepStats.lines[line], slept);
+
+    //no prediction is made before the first untimed sleep
+    if (predicted < SLEEP_PLANNER_MAX_IDLE)
+        sleepCounterAdd(&mSleepStats.predict[timerLength ? 0 : 1],
+                        predicted > slept ? predicted - slept : slept - predicted);
+}
+
+uint64_t sleepStatsGetSlept(uint32_t *sleepsP)
+{
+    if (sleepsP)
+        *sleepsP = mSleepsTotal;
+
+    return mSleptTotal;
+}
+
+uint32_t sleepStatsCount(void)
+{
+    return 1 + mSleepStats.numStates + SLEEP_WAKE_NUM + SLEEP_STATS_MAX_LINES + 2;
+}
+
+static bool sleepStatFill(struct SleepStat *stat, uint8_t type, uint32_t *idx, const struct SleepCounter *counters, uint32_t num)
+{
+    if (*idx >= num) {
+        *idx -= num;
+        return false;
+    }
+
+    stat->type = type;
+    stat->index = *idx;
+    stat->count = counters[*idx].count;
+    stat->time = counters[*idx].time;
+
+    return true;
+}
+
+bool sleepStatsGet(uint32_t idx, struct SleepStat *stat)
+{
+    if (idx == 0) {
+        stat->type = SLEEP_STAT_ELAPSED;
+        stat->index = 0;
+        stat->count = mSleepStats.sleeps;
+        stat->time = timGetTime() - mSleepStats.resetTime;
+        return true;
+    }
+    idx--;
+
+    return sleepStatFill(stat, SLEEP_STAT_STATE, &idx, mSleepStats.states, mSleepStats.numStates) ||
+           sleepStatFill(stat, SLEEP_STAT_WAKE, &idx, mSleepStats.wakes, SLEEP_WAKE_NUM) ||
+           sleepStatFill(stat, SLEEP_STAT_WAKE_LINE, &idx, mSleepStats.lines, SLEEP_STATS_MAX_LINES) ||
+           sleepStatFill(stat, SLEEP_STAT_PREDICT, &idx, mSleepStats.predict, 2);
+}
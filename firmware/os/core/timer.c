@@ -18,6 +18,7 @@
 #include <plat/rtc.h>
 #include <atomicBitset.h>
 #include <platform.h>
+#include <poolStats.h>
 #include <atomic.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -92,8 +93,12 @@ static void timCallFunc(struct Timer *tim)
     TaggedPtr callInfo = tim->callInfo;
 
     if (taggedPtrIsPtr(callInfo)) {
+        struct TaskCpuMark mark;
+
         osSetCurrentTid(tim->tid);
+        osTaskCpuBegin(&mark);
         ((TimTimerCbkF)taggedPtrToPtr(callInfo))(tim->id, tim->callData);
+        osTaskCpuEnd(osTaskFindByTid(tim->tid), &mark);
     } else {
         osSetCurrentTid(OS_SYSTEM_TID);
         if ((evt = slabAllocatorAlloc(mInternalEvents)) != 0) {
@@ -297,4 +302,5 @@ void timInit(void)
     atomicBitsetInit(mTimersValid, MAX_TIMERS);
 
     mInternalEvents = slabAllocatorNew(sizeof(struct TimerEvent), alignof(struct TimerEvent), MAX_INTERNAL_EVENTS);
+    poolStatsAddSlab(POOL_TIMER_EVENTS, mInternalEvents);
 }
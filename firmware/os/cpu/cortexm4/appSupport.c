@@ -19,10 +19,13 @@
 #include <string.h>
 #include <stdint.h>
 #include <heap.h>
+#include <mpu.h>
 #include <seos.h>
+#include <seos_priv.h>
 #include <cpu.h>
 
 #include <plat/cmsis.h>
+#include <plat/wdt.h>
 
 //reloc types for this cpu type
 #define NANO_RELOC_TYPE_RAM	0
@@ -32,6 +35,45 @@
 #define APP_FLASH_RELOC_BASE(_base) APP_FLASH_RELOC(_base, 0)
 #define APP_VEC(_app) ((struct AppFuncs*)&((_app)->vec))
 
+/*
+ * App isolation
+ *
+ * External apps run unprivileged, on a stack (PSP) at the top of the RAM the
+ * MPU lets them write (mpuGetAppRam()); the rest of that RAM, less a guard
+ * below the stack that nothing may touch, is the heap their data segments and
+ * the memory they ask for (heapAllocApp()) come from.
+ * To them all other RAM is read only and peripherals are out of reach, so a
+ * stray write faults instead of corrupting the OS. The fault handler stops
+ * the app and resumes its caller as if the app had returned.
+ *
+ * This keeps apps away from the OS, not from each other: they all share the
+ * one app RAM region, so an app can still corrupt another app's memory. The
+ * MPU layout is the same for every task, so task switches cost nothing;
+ * entering an app costs a CONTROL write and leaving it an SVC, which
+ * cpuAppIsolationInit() measures and logs.
+ *
+ * Internal apps are called directly as before. External apps are only ever
+ * entered through callIsolated(), which needs thread mode with interrupts on;
+ * the OS checks cpuAppCanCall() and leaves callbacks that come due in a
+ * syscall or with interrupts off (free callbacks, mostly) to the main loop.
+ * A faulting app does not give back s16-s31; nothing on the dispatch path
+ * keeps floating point values across an app call.
+ */
+#ifndef APP_STACK_SIZE
+#define APP_STACK_SIZE      2048
+#endif
+
+// an overflow that skips further than this, in one frame, is not caught
+#ifndef APP_STACK_GUARD_SIZE
+#define APP_STACK_GUARD_SIZE 256
+#endif
+
+#define XPSR_THUMB          0x01000000
+
+#define APP_ISOLATION_CAL_CALLS 64
+
+static uintptr_t __attribute__((used)) mAppStackTop; // 0 if apps are not isolated
+
 static bool handleRelNumber(uint32_t *ofstP, uint32_t type, uint32_t flashAddr, uint32_t ramAddr, uint32_t *mem, uint32_t value)
 {
     uint32_t base, where;
@@ -143,7 +185,7 @@ bool cpuAppLoad(const struct AppHdr *app, struct PlatAppInfo *platInfo)
     const struct SectInfo *sect = &app->sect;
     const uint8_t *relocsStart = (const uint8_t*)APP_FLASH_RELOC(app, sect->rel_start);
     const uint8_t *relocsEnd = (const uint8_t*)APP_FLASH_RELOC(app, sect->rel_end);
-    uint8_t *mem = heapAlloc(sect->bss_end);
+    uint8_t *mem = heapAllocApp(sect->bss_end);
 
     if (!mem)
         return false;
@@ -188,10 +230,59 @@ static uintptr_t __attribute__((naked)) callWithR9(const void *base, uint32_t of
     return 0; //dummy to fool gcc
 }
 
+// same as callWithR9, but unprivileged on the app stack; cpuAppIsolatedReturn is where the app comes back to
+static uintptr_t __attribute__((naked)) callIsolated(const void *base, uint32_t offset, void *data, uintptr_t arg1, uintptr_t arg2)
+{
+    asm volatile (
+        "add  r12, r0, r1               \n"
+        "mov  r0,  r3                   \n"
+        "ldr  r1,  [sp]                 \n"
+        "push {r3-r11, lr}              \n" // r3 keeps the stack 8-byte aligned; all are needed if the app faults
+        "mov  r9, r2                    \n"
+        "ldr  r2, =mAppStackTop         \n"
+        "ldr  r2, [r2]                  \n"
+        "msr  psp, r2                   \n"
+        "mrs  r2, control               \n"
+        "orr  r2, r2, #3                \n" // CONTROL: unprivileged, process stack
+        "msr  control, r2               \n"
+        "isb                            \n"
+        "blx  r12                       \n"
+        ".global cpuAppIsolatedReturn   \n"
+        "cpuAppIsolatedReturn:          \n"
+        "svc  #2                        \n" // only allowed from here; see syscallHandler()
+        "mrs  r1, control               \n"
+        "bic  r1, r1, #3                \n" // privileged again since the svc, back to the main stack
+        "msr  control, r1               \n"
+        "isb                            \n"
+        "pop  {r3-r11, pc}              \n"
+    );
+
+    return 0; //dummy to fool gcc
+}
+
+bool cpuAppCanCall(const struct PlatAppInfo *platInfo)
+{
+    // the svc on the way back must not escalate, and the app stack is only free in thread mode
+    return !platInfo->data || !mAppStackTop || (!__get_IPSR() && !__get_PRIMASK());
+}
+
+static uintptr_t cpuAppCall(const void *base, uint32_t offset, struct PlatAppInfo *platInfo, uintptr_t arg1, uintptr_t arg2)
+{
+    if (!mAppStackTop)
+        return callWithR9(base, offset, platInfo->data, arg1, arg2);
+
+    if (!cpuAppCanCall(platInfo)) {
+        osLog(LOG_ERROR, "App at 0x%08" PRIX32 " called from IPSR %" PRIu32 ", refused\n", (uint32_t)base + offset, __get_IPSR());
+        return 0;
+    }
+
+    return callIsolated(base, offset, platInfo->data, arg1, arg2);
+}
+
 bool cpuAppInit(const struct AppHdr *app, struct PlatAppInfo *platInfo, uint32_t tid)
 {
     if (platInfo->data)
-        return callWithR9((const void*)APP_FLASH_RELOC_BASE(app), app->vec.init, platInfo->data, tid, 0);
+        return cpuAppCall((const void*)APP_FLASH_RELOC_BASE(app), app->vec.init, platInfo, tid, 0);
     else
         return APP_VEC(app)->init(tid);
 }
@@ -199,7 +290,7 @@ bool cpuAppInit(const struct AppHdr *app, struct PlatAppInfo *platInfo, uint32_t
 void cpuAppEnd(const struct AppHdr *app, struct PlatAppInfo *platInfo)
 {
     if (platInfo->data)
-        (void)callWithR9((const void*)APP_FLASH_RELOC_BASE(app), app->vec.end, platInfo->data, 0, 0);
+        (void)cpuAppCall((const void*)APP_FLASH_RELOC_BASE(app), app->vec.end, platInfo, 0, 0);
     else
         APP_VEC(app)->end();
     osLog(LOG_INFO, "App ID %016" PRIX64 "; TID=%04" PRIX32 " terminated\n", app->hdr.appId, osGetCurrentTid());
@@ -208,7 +299,7 @@ void cpuAppEnd(const struct AppHdr *app, struct PlatAppInfo *platInfo)
 void cpuAppHandle(const struct AppHdr *app, struct PlatAppInfo *platInfo, uint32_t evtType, const void* evtData)
 {
     if (platInfo->data)
-        (void)callWithR9((const void*)APP_FLASH_RELOC_BASE(app), app->vec.handle, platInfo->data, evtType, (uintptr_t)evtData);
+        (void)cpuAppCall((const void*)APP_FLASH_RELOC_BASE(app), app->vec.handle, platInfo, evtType, (uintptr_t)evtData);
     else
         APP_VEC(app)->handle(evtType, evtData);
 }
@@ -216,7 +307,9 @@ void cpuAppHandle(const struct AppHdr *app, struct PlatAppInfo *platInfo, uint32
 void cpuAppInvoke(const struct AppHdr *app, struct PlatAppInfo *platInfo,
                   void (*method)(uintptr_t, uintptr_t),uintptr_t arg1, uintptr_t arg2)
 {
-    if (platInfo->data) {
+    if (platInfo->data && mAppStackTop) {
+        (void)cpuAppCall(0, (uint32_t)method, platInfo, arg1, arg2);
+    } else if (platInfo->data) {
         uint32_t hasSvcAct = SCB->SHCSR & SCB_SHCSR_SVCALLACT_Msk;
 
         SCB->SHCSR &= ~SCB_SHCSR_SVCALLACT_Msk;
@@ -226,3 +319,86 @@ void cpuAppInvoke(const struct AppHdr *app, struct PlatAppInfo *platInfo,
         method(arg1, arg2);
     }
 }
+
+static uintptr_t cpuAppCalNop(uintptr_t arg1, uintptr_t arg2)
+{
+    return arg1;
+}
+
+void cpuAppIsolationInit(void)
+{
+    uint32_t size, i, start, direct, isolated;
+    uint8_t *ram = mpuGetAppRam(&size);
+
+    if (!ram || size <= APP_STACK_SIZE + APP_STACK_GUARD_SIZE ||
+        !mpuSetGuard(ram + size - APP_STACK_SIZE - APP_STACK_GUARD_SIZE, APP_STACK_GUARD_SIZE) ||
+        !heapInitApps(ram, size - APP_STACK_SIZE - APP_STACK_GUARD_SIZE)) {
+        osLog(LOG_INFO, "Apps are not isolated\n");
+        return;
+    }
+
+    mAppStackTop = (uintptr_t)ram + size;
+
+    start = cpuGetCycles();
+    for (i = 0; i < APP_ISOLATION_CAL_CALLS; i++)
+        (void)callWithR9(0, (uint32_t)&cpuAppCalNop, NULL, i, 0);
+    direct = cpuGetCycles() - start;
+
+    start = cpuGetCycles();
+    for (i = 0; i < APP_ISOLATION_CAL_CALLS; i++)
+        (void)callIsolated(0, (uint32_t)&cpuAppCalNop, NULL, i, 0);
+    isolated = cpuGetCycles() - start;
+
+    osLog(LOG_INFO, "Apps isolated in %" PRIu32 " KiB at 0x%08" PRIX32 ", %" PRIu32 " extra cycles per call\n",
+          size >> 10, (uint32_t)ram, isolated > direct ? (isolated - direct) / APP_ISOLATION_CAL_CALLS : 0);
+}
+
+/*
+ * Called from cpuCommonFaultCode() for faults in thread mode on the process
+ * stack, which only isolated apps use. Stops the app and returns the stack
+ * pointer to resume it with: at cpuAppIsolatedReturn, returning 0.
+ */
+static uintptr_t __attribute__((used)) cpuAppFault(uint32_t code, const uintptr_t *excRegs)
+{
+    extern const uint16_t cpuAppIsolatedReturn[];
+    uintptr_t *frame = (uintptr_t *)mAppStackTop - 8;
+    struct Task *task = osGetCurrentTask();
+    uintptr_t pc = 0;
+
+    wdtPing();
+
+    // the faulting frame may not have made it to the stack
+    if ((uintptr_t)excRegs >= mAppStackTop - APP_STACK_SIZE && (uintptr_t)(excRegs + 8) <= mAppStackTop)
+        pc = excRegs[6];
+
+    osLog(LOG_ERROR, "App TID=%04" PRIX16 " faulted [code %" PRIu32 "] at 0x%08" PRIX32
+          ", CFSR 0x%08" PRIX32 " MMFAR 0x%08" PRIX32 "; stopping it\n",
+          task ? task->tid : 0, code, (uint32_t)pc, SCB->CFSR, SCB->MMFAR);
+
+    // fault status is write-one-to-clear; a pending lazy FP save would go to the old frame
+    SCB->CFSR = SCB->CFSR;
+    SCB->HFSR = SCB->HFSR;
+    FPU->FPCCR &= ~FPU_FPCCR_LSPACT_Msk;
+
+    if (task)
+        osTaskAbort(task);
+
+    memset(frame, 0, 8 * sizeof(*frame));
+    frame[6] = (uintptr_t)cpuAppIsolatedReturn & ~1;
+    frame[7] = XPSR_THUMB;
+
+    return (uintptr_t)frame;
+}
+
+void cpuAppFaultHandler(void);
+void __attribute__((naked)) cpuAppFaultHandler(void)
+{
+    // r0 contains Fault IRQ code
+    asm volatile(
+        "mrs  r1, psp               \n"
+        "bl   cpuAppFault           \n"
+        "msr  psp, r0               \n"
+        "mvn  lr, #2                \n" // EXC_RETURN: thread mode, process stack, no FP state
+        "bx   lr                    \n"
+    );
+}
@@ -36,12 +36,28 @@ SRCS_os += \
 #cpu runtime for bootloader
 SRCS_bl += os/cpu/$(CPU)/cpu.c
 
+#memset and memmove: the generic C ones unless the variant opts in to the
+#Cortex-M C ones (LIBC_MEMOPS := armv7m in <variant>_conf.mk or on the command
+#line); lib/libc/host/memops_check.mk checks both on the host, but neither has
+#been timed on the hub, so the generic ones stay the default
+LIBC_MEMOPS ?= generic
+ifeq ($(LIBC_MEMOPS),armv7m)
+LIBC_MEMOPS_SRCS := \
+    $(LIB_PATH)/libc/memset-armv7m.c \
+    $(LIB_PATH)/libc/memmove-armv7m.c \
+
+else
+LIBC_MEMOPS_SRCS := \
+    $(LIB_PATH)/libc/memset.c \
+    $(LIB_PATH)/libc/memmove.c \
+
+endif
+
 #c runtime
 SRCS_os += \
     $(LIB_PATH)/libc/memcpy-armv7m.S \
-    $(LIB_PATH)/libc/memset.c \
+    $(LIBC_MEMOPS_SRCS) \
     $(LIB_PATH)/libc/memcmp.c \
-    $(LIB_PATH)/libc/memmove.c \
 
 #c runtime for bootloader
 SRCS_bl += \
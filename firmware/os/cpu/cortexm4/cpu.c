@@ -86,6 +86,21 @@ void cpuInit(void)
 
     /* FPU on */
     SCB->CPACR |= 0x00F00000;
+
+    /* cycle counter on, for per-task cpu accounting; not zeroed, boot timing counts from bootloader entry */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t cpuGetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+uint32_t cpuGetCyclesPerUs(void)
+{
+    /* core runs off AHB clock */
+    return pwrGetBusSpeed(PERIPH_BUS_AHB1) / 1000000;
 }
 
 //pack all our SR regs into 45 bits
@@ -238,6 +253,7 @@ void cpuIntsRestore(uint64_t state)
 
 static void __attribute__((used)) syscallHandler(uintptr_t *excRegs)
 {
+    extern const uint16_t cpuAppIsolatedReturn[]; // see appSupport.c
     uint16_t *svcPC = ((uint16_t *)(excRegs[6])) - 1;
     uint32_t svcNo = (*svcPC) & 0xFF;
     uint32_t syscallNr = excRegs[0];
@@ -246,7 +262,9 @@ static void __attribute__((used)) syscallHandler(uintptr_t *excRegs)
     uintptr_t *fastParams = excRegs + 1;
     va_list args_fast = *(va_list*)(&fastParams);
 
-    if (svcNo > 1)
+    if (svcNo == 2 && (uintptr_t)svcPC == ((uintptr_t)cpuAppIsolatedReturn & ~1))
+        __set_CONTROL(__get_CONTROL() & ~1); // an isolated app returned; its caller runs privileged again
+    else if (svcNo > 1)
         osLog(LOG_WARN, "Unknown SVC 0x%02lX called at 0x%08lX\n", svcNo, (unsigned long)svcPC);
     else if (!(handler = syscallGetHandler(syscallNr)))
         osLog(LOG_WARN, "Unknown syscall 0x%08lX called at 0x%08lX\n", (unsigned long)syscallNr, (unsigned long)svcPC);
@@ -303,7 +321,11 @@ void cpuCommonFaultCode(void);
 void __attribute__((naked)) cpuCommonFaultCode(void)
 {
     // r0 contains Fault IRQ code
+    // faults in thread mode on the process stack are an isolated app's; see appSupport.c
     asm volatile(
+        "and r3, lr, #0xC          \n"
+        "cmp r3, #0xC              \n"
+        "beq cpuAppFaultHandler    \n"
         "ldr r3, =__stack_bottom + 64 \n"
         "cmp sp, r3                \n"
         "itte le                   \n"
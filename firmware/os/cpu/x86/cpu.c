@@ -15,6 +15,7 @@
  */
 
 #include <cpu.h>
+#include <time.h>
 
 
 void cpuInit(void)
@@ -22,6 +23,21 @@ void cpuInit(void)
     /* nothing to do for x86 */
 }
 
+uint32_t cpuGetCycles(void)
+{
+    struct timespec ts;
+
+    /* no portable cycle counter; use a nanosecond clock instead */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+uint32_t cpuGetCyclesPerUs(void)
+{
+    return 1000;
+}
+
 uint64_t cpuIntsOff(void)
 {
     /* no such luck */
@@ -42,3 +58,7 @@ void cpuIntsRestore(uint64_t state)
 
 }
 
+void cpuAppIsolationInit(void)
+{
+    /* apps are not isolated on x86 */
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _X86_SYSCALL_DO_H_
+#define _X86_SYSCALL_DO_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _OS_BUILD_
+    #error "Syscalls should not be called from OS code"
+#endif
+
+
+#include <stdint.h>
+#include <stdarg.h>
+
+/*
+ * There is no privilege boundary on x86: apps share the address space with
+ * whoever hosts them (the native OS build or the CHRE host runner), so a
+ * "syscall" is a plain call into the host's dispatcher. va_list is not a
+ * 32-bit scalar here, so it is always passed by pointer
+ * (SYSCALL_PARAMS_PASSED_AS_PTRS must be defined).
+ */
+#ifndef SYSCALL_PARAMS_PASSED_AS_PTRS
+    #error "x86 apps must be built with SYSCALL_PARAMS_PASSED_AS_PTRS"
+#endif
+
+uintptr_t cpuSyscallDo(uint32_t syscallNo, void *vaListPtr);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
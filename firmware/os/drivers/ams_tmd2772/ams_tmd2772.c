@@ -28,7 +28,9 @@
 #include <eventnums.h>
 #include <util.h>
 
-#define AMS_TMD2772_APP_VERSION 3
+#include <algos/als_prox_onchange.h>
+
+#define AMS_TMD2772_APP_VERSION 4
 
 #define DRIVER_NAME                            "AMS: "
 
@@ -100,6 +102,13 @@
 
 #define AMS_TMD2772_ALS_INVALID                UINT32_MAX
 
+// Report only when C0 leaves a window around the last reported count. The INT line is not wired,
+// so the part is polled; the window alone filters flicker, and a software persistence filter
+// would hold every real change back by a whole poll period.
+#define AMS_TMD2772_ALS_WINDOW_PERMILLE        50
+#define AMS_TMD2772_ALS_WINDOW_MIN             2
+#define AMS_TMD2772_ALS_PERSISTENCE            1
+
 /* Used when SENSOR_RATE_ONCHANGE is requested */
 #define AMS_TMD2772_DEFAULT_RATE               SENSOR_HZ(5)
 
@@ -179,6 +188,7 @@ struct SensorData
     struct I2cTransfer transfers[AMS_TMD2772_MAX_PENDING_I2C_REQUESTS];
 
     union EmbeddedDataPoint lastAlsSample;
+    struct AlsProxOnChange alsOnChange;
 
     uint8_t calibrationSampleCount;
     uint8_t proxState; // enum ProxState
@@ -320,8 +330,18 @@ static void setMode(bool alsOn, bool proxOn, uint8_t state)
 
 static bool sensorPowerAls(bool on, void *cookie)
 {
+    struct AlsProxOnChangeStats stats;
+
     osLog(LOG_INFO, DRIVER_NAME "sensorPowerAls: %d\n", on);
 
+    if (on && !mData.alsOn) {
+        alsProxOnChangeStart(&mData.alsOnChange, sensorGetTime());
+    } else if (!on && mData.alsOn) {
+        alsProxOnChangeGetStats(&mData.alsOnChange, sensorGetTime(), &stats);
+        osLog(LOG_INFO, DRIVER_NAME "als: %lu samples, %lu reports in %lu ms\n",
+              stats.wakeups, stats.reports, stats.elapsedMs);
+    }
+
     if (mData.alsTimerHandle) {
         timTimerCancel(mData.alsTimerHandle);
         mData.alsTimerHandle = 0;
@@ -616,7 +636,8 @@ static void handle_i2c_event(struct I2cTransfer *xfer)
 #endif
 
         if (mData.alsOn && mData.alsReading &&
-            (xfer->txrxBuf.sample.status & ALS_VALID_BIT)) {
+            (xfer->txrxBuf.sample.status & ALS_VALID_BIT) &&
+            alsProxOnChangeSample(&mData.alsOnChange, xfer->txrxBuf.sample.als[0])) {
             /* Create event */
             sample.fdata = getLuxFromAlsData(xfer->txrxBuf.sample.als[0],
                                              xfer->txrxBuf.sample.als[1]);
@@ -682,6 +703,8 @@ static bool init_app(uint32_t myTid)
     mData.proxReading = false;
     mData.lastAlsSample.idata = AMS_TMD2772_ALS_INVALID;
     mData.proxState = PROX_STATE_INIT;
+    alsProxOnChangeInit(&mData.alsOnChange, AMS_TMD2772_ALS_MAX_CHANNEL_COUNT, AMS_TMD2772_ALS_WINDOW_PERMILLE,
+                        AMS_TMD2772_ALS_WINDOW_MIN, 0, AMS_TMD2772_ALS_PERSISTENCE);
 
     /* Register sensors */
     mData.alsHandle = sensorRegister(&sensorInfoAls, &sensorOpsAls, NULL, false);
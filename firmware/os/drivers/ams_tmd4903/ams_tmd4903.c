@@ -30,13 +30,15 @@
 #include <sensors.h>
 #include <seos.h>
 
+#include <algos/als_prox_onchange.h>
+
 #include <plat/exti.h>
 #include <plat/gpio.h>
 #include <plat/syscfg.h>
 #include <variant/variant.h>
 
 #define AMS_TMD4903_APP_ID      APP_ID_MAKE(NANOHUB_VENDOR_GOOGLE, 12)
-#define AMS_TMD4903_APP_VERSION 14
+#define AMS_TMD4903_APP_VERSION 15
 
 #ifndef PROX_INT_PIN
 #error "PROX_INT_PIN is not defined; please define in variant.h"
@@ -111,6 +113,13 @@
 #define AMS_TMD4903_ALS_GAIN_16X_THOLD         1000.0f
 #define AMS_TMD4903_ALS_GAIN_64X_THOLD         250.0f
 
+// CDATA threshold window around the last reported count, and ALS persistence (APERS: 2 cycles).
+// Persistence is off (interrupt every cycle) while calibrating or waiting for the gain to settle.
+#define AMS_TMD4903_ALS_WINDOW_PERMILLE        50
+#define AMS_TMD4903_ALS_WINDOW_MIN             4
+#define AMS_TMD4903_ALS_PERSISTENCE            0x02
+#define AMS_TMD4903_ALS_PERSISTENCE_OFF        0x00
+
 /* AMS_TMD4903_REG_ENABLE */
 #define PROX_INT_ENABLE_BIT                    (1 << 5)
 #define ALS_INT_ENABLE_BIT                     (1 << 4)
@@ -121,6 +130,9 @@
 /* AMS_TMD4903_REG_INTENAB */
 #define CAL_INT_ENABLE_BIT                     (1 << 1)
 
+/* AMS_TMD4903_REG_INTCLEAR */
+#define ALS_INT_CLEAR_BIT                      (1 << 4)
+
 #define AMS_TMD4903_REPORT_NEAR_VALUE          0.0f // centimeters
 #define AMS_TMD4903_REPORT_FAR_VALUE           5.0f // centimeters
 #define AMS_TMD4903_PROX_THRESHOLD_HIGH        350  // value in PS_DATA
@@ -129,6 +141,7 @@
 #define AMS_TMD4903_ALS_INVALID                UINT32_MAX
 
 #define AMS_TMD4903_ALS_TIMER_DELAY            200000000ULL
+#define AMS_TMD4903_ALS_POLL_MS                200
 
 #define AMS_TMD4903_MAX_PENDING_I2C_REQUESTS   8
 #define AMS_TMD4903_MAX_I2C_TRANSFER_SIZE      18
@@ -235,6 +248,7 @@ struct SensorData
     float alsOffset;
 
     union EmbeddedDataPoint lastAlsSample;
+    struct AlsProxOnChange alsOnChange;
 
     struct AlsProxTransfer transfers[AMS_TMD4903_MAX_PENDING_I2C_REQUESTS];
 
@@ -243,6 +257,7 @@ struct SensorData
     uint8_t alsGain;
     uint8_t nextAlsGain;
     uint8_t alsDebounceSamples;
+    uint8_t alsPersistence;
 
     bool alsOn;
     bool proxOn;
@@ -344,7 +359,7 @@ static bool proxIsr(struct ChainedIsr *localIsr)
             osEnqueuePrivateEvt(EVT_SENSOR_PROX_INTERRUPT, NULL, NULL, mTask.tid);
         }
 #endif
-    } else if (data->alsOn && data->alsCalibrating && !pinState) {
+    } else if (data->alsOn && !pinState) {
         osEnqueuePrivateEvt(EVT_SENSOR_ALS_INTERRUPT, NULL, NULL, mTask.tid);
     }
 
@@ -419,6 +434,9 @@ static bool checkForAlsAutoGain(float sample)
     } else if ((mTask.alsGain != ALS_GAIN_1X) && (sample >= AMS_TMD4903_ALS_GAIN_4X_THOLD)) {
         mTask.alsDebounceSamples = (mTask.nextAlsGain == ALS_GAIN_1X) ? (mTask.alsDebounceSamples + 1) : 1;
         mTask.nextAlsGain = ALS_GAIN_1X;
+    } else {
+        // back in the range of the current gain
+        mTask.alsDebounceSamples = 0;
     }
 
     return (mTask.alsDebounceSamples >= AMS_TMD4903_ALS_DEBOUNCE_SAMPLES);
@@ -465,26 +483,83 @@ static void sendCalibrationResultProx(uint8_t status, int16_t *offsets) {
         osLog(LOG_WARN, "Couldn't send prox cal result evt");
 }
 
+// The INT pin is shared, and while prox is on it belongs to prox (direct mode drives it with the
+// prox state). Otherwise ALS runs off the threshold interrupt instead of the polling timer.
+static inline bool alsUsesInterrupt(void)
+{
+    return mTask.alsOn && !mTask.proxOn && !mTask.alsCalibrating;
+}
+
 static void setMode(bool alsOn, bool proxOn, uint8_t state)
 {
     uint8_t regEnable =
         ((alsOn || proxOn) ? POWER_ON_BIT : 0) |
         (alsOn ? ALS_ENABLE_BIT : 0) |
+        ((alsOn && !proxOn) ? ALS_INT_ENABLE_BIT : 0) |
         (proxOn ? (PROX_INT_ENABLE_BIT | PROX_ENABLE_BIT) : 0);
     writeRegister(AMS_TMD4903_REG_ENABLE, regEnable, state);
 }
 
-static bool sensorPowerAls(bool on, void *cookie)
+static void writeAlsThresholds(uint16_t low, uint16_t high)
 {
-    DEBUG_PRINT("sensorPowerAls: %d\n", on);
+    struct AlsProxTransfer *xfer = allocXfer(SENSOR_STATE_IDLE);
+
+    if (xfer != NULL) {
+        xfer->txrxBuf[0] = AMS_TMD4903_REG_AILTL;
+        xfer->txrxBuf[1] = low & 0xFF;
+        xfer->txrxBuf[2] = (low >> 8) & 0xFF;
+        xfer->txrxBuf[3] = high & 0xFF;
+        xfer->txrxBuf[4] = (high >> 8) & 0xFF;
+        i2cMasterTx(I2C_BUS_ID, I2C_ADDR, xfer->txrxBuf, 5, i2cCallback, xfer);
+    }
+}
+
+static void writeAlsPersistence(uint8_t pers)
+{
+    // PPERS (high nibble) stays 0: prox interrupts every cycle
+    if (mTask.alsPersistence != pers && writeRegister(AMS_TMD4903_REG_PERS, pers, SENSOR_STATE_IDLE))
+        mTask.alsPersistence = pers;
+}
 
-    if (on && !mTask.alsTimerHandle) {
+static void configAlsWakeup(void)
+{
+    bool alsTimer = mTask.alsOn && mTask.proxOn;
+
+    if (alsTimer && !mTask.alsTimerHandle) {
         mTask.alsTimerHandle = timTimerSet(AMS_TMD4903_ALS_TIMER_DELAY, 0, 50, alsTimerCallback, NULL, false);
-    } else if (!on && mTask.alsTimerHandle) {
+    } else if (!alsTimer && mTask.alsTimerHandle) {
         timTimerCancel(mTask.alsTimerHandle);
         mTask.alsTimerHandle = 0;
     }
 
+    if (alsUsesInterrupt()) {
+        // the window may have moved while polling; start from "anything is reportable"
+        alsProxOnChangeInvalidate(&mTask.alsOnChange);
+        writeAlsThresholds(mTask.alsOnChange.low, mTask.alsOnChange.high);
+        writeAlsPersistence(AMS_TMD4903_ALS_PERSISTENCE_OFF);
+        writeRegister(AMS_TMD4903_REG_INTCLEAR, ALS_INT_CLEAR_BIT, SENSOR_STATE_IDLE);
+        extiClearPendingGpio(mTask.pin);
+        enableInterrupt(mTask.pin, &mTask.isr, EXTI_TRIGGER_FALLING);
+    } else if (!mTask.proxOn) {
+        disableInterrupt(mTask.pin, &mTask.isr);
+        extiClearPendingGpio(mTask.pin);
+    }
+}
+
+static bool sensorPowerAls(bool on, void *cookie)
+{
+    struct AlsProxOnChangeStats stats;
+
+    DEBUG_PRINT("sensorPowerAls: %d\n", on);
+
+    if (on && !mTask.alsOn) {
+        alsProxOnChangeStart(&mTask.alsOnChange, sensorGetTime());
+    } else if (!on && mTask.alsOn) {
+        alsProxOnChangeGetStats(&mTask.alsOnChange, sensorGetTime(), &stats);
+        INFO_PRINT("als: %lu wakeups, %lu reports in %lu ms; %lu wakeups saved\n",
+                   stats.wakeups, stats.reports, stats.elapsedMs, stats.saved);
+    }
+
     mTask.lastAlsSample.idata = AMS_TMD4903_ALS_INVALID;
     mTask.alsOn = on;
     mTask.nextAlsGain = ALS_GAIN_4X;
@@ -494,6 +569,7 @@ static bool sensorPowerAls(bool on, void *cookie)
     mTask.alsDebounceSamples = 0;
 
     setMode(on, mTask.proxOn, (on) ? SENSOR_STATE_ENABLING_ALS : SENSOR_STATE_DISABLING_ALS);
+    configAlsWakeup();
     return true;
 }
 
@@ -534,6 +610,11 @@ static bool sensorCalibrateAls(void *cookie)
     mTask.alsChangingGain = false;
     mTask.alsSkipSample = false;
 
+    // fire on the first conversion regardless of where the last ALS session left the window
+    alsProxOnChangeInvalidate(&mTask.alsOnChange);
+    writeAlsThresholds(mTask.alsOnChange.low, mTask.alsOnChange.high);
+    writeAlsPersistence(AMS_TMD4903_ALS_PERSISTENCE_OFF);
+
     extiClearPendingGpio(mTask.pin);
     enableInterrupt(mTask.pin, &mTask.isr, EXTI_TRIGGER_FALLING);
 
@@ -581,6 +662,7 @@ static bool sensorPowerProx(bool on, void *cookie)
     mTask.proxDirectMode = false;
 
     setMode(mTask.alsOn, on, (on) ? SENSOR_STATE_ENABLING_PROX : SENSOR_STATE_DISABLING_PROX);
+    configAlsWakeup();
     return true;
 }
 
@@ -735,11 +817,12 @@ static void verifySensorId(const struct AlsProxTransfer *xfer)
     nextXfer->txrxBuf[10] = (AMS_TMD4903_PROX_THRESHOLD_LOW >> 8) & 0xFF;  // REG_PILTH
     nextXfer->txrxBuf[11] = (AMS_TMD4903_PROX_THRESHOLD_HIGH & 0xFF);      // REG_PIHTL
     nextXfer->txrxBuf[12] = (AMS_TMD4903_PROX_THRESHOLD_HIGH >> 8) & 0xFF; // REG_PIHTH
-    nextXfer->txrxBuf[13] = 0x00;                                          // REG_PERS - reset value from datasheet
+    nextXfer->txrxBuf[13] = AMS_TMD4903_ALS_PERSISTENCE;                   // REG_PERS - APERS, PPERS every cycle
     nextXfer->txrxBuf[14] = 0xa0;                                          // REG_CFG0 - reset value from datasheet
     nextXfer->txrxBuf[15] = AMS_TMD4903_PGCFG0_SETTING;                    // REG_PGCFG0
     nextXfer->txrxBuf[16] = AMS_TMD4903_PGCFG1_SETTING;                    // REG_PGCFG1
     nextXfer->txrxBuf[17] = mTask.alsGain;                                 // REG_CFG1
+    mTask.alsPersistence = AMS_TMD4903_ALS_PERSISTENCE;
 
     i2cMasterTx(I2C_BUS_ID, I2C_ADDR, nextXfer->txrxBuf, 18, i2cCallback, nextXfer);
 }
@@ -763,11 +846,13 @@ static void handleAlsSample(const struct AlsProxTransfer *xfer)
             mTask.alsOn = false;
             mTask.alsCalibrating = false;
 
+            writeAlsPersistence(AMS_TMD4903_ALS_PERSISTENCE);
             writeRegister(AMS_TMD4903_REG_ENABLE, 0, SENSOR_STATE_IDLE);
-        } else if (mTask.alsSkipSample) {
+        } else if (mTask.alsSkipSample || mTask.alsChangingGain) {
+            alsProxOnChangeSkip(&mTask.alsOnChange);
             mTask.alsSkipSample = false;
-        } else if (!mTask.alsChangingGain) {
-            if (mTask.lastAlsSample.idata != sample.idata) {
+        } else {
+            if (alsProxOnChangeSample(&mTask.alsOnChange, c) && mTask.lastAlsSample.idata != sample.idata) {
                 osEnqueueEvt(sensorGetMyEventType(SENS_TYPE_ALS), sample.vptr, NULL);
                 mTask.lastAlsSample.fdata = sample.fdata;
             }
@@ -781,6 +866,18 @@ static void handleAlsSample(const struct AlsProxTransfer *xfer)
                 }
             }
         }
+
+        if (alsUsesInterrupt()) {
+            // keep waking up every conversion while the gain is settling (low > high always fires)
+            if (mTask.alsSkipSample || mTask.alsChangingGain || mTask.alsDebounceSamples) {
+                writeAlsThresholds(AMS_TMD4903_MAX_ALS_CHANNEL_COUNT, 0);
+                writeAlsPersistence(AMS_TMD4903_ALS_PERSISTENCE_OFF);
+            } else {
+                writeAlsThresholds(mTask.alsOnChange.low, mTask.alsOnChange.high);
+                writeAlsPersistence(AMS_TMD4903_ALS_PERSISTENCE);
+            }
+            writeRegister(AMS_TMD4903_REG_INTCLEAR, ALS_INT_CLEAR_BIT, SENSOR_STATE_IDLE);
+        }
     }
 }
 
@@ -941,6 +1038,7 @@ static void handle_i2c_event(struct AlsProxTransfer *xfer)
             mTask.alsGain = mTask.nextAlsGain;
             mTask.alsDebounceSamples = 0;
             mTask.alsSkipSample = true;
+            alsProxOnChangeInvalidate(&mTask.alsOnChange);
         }
         break;
 
@@ -982,6 +1080,8 @@ static bool init_app(uint32_t myTid)
     mTask.proxCalibrating = false;
     mTask.alsOffset = 1.0f;
     mTask.alsGain = ALS_GAIN_4X;
+    alsProxOnChangeInit(&mTask.alsOnChange, AMS_TMD4903_MAX_ALS_CHANNEL_COUNT, AMS_TMD4903_ALS_WINDOW_PERMILLE,
+                        AMS_TMD4903_ALS_WINDOW_MIN, AMS_TMD4903_ALS_POLL_MS, 1);
 
     mTask.pin = gpioRequest(PROX_INT_PIN);
     gpioConfigInput(mTask.pin, GPIO_SPEED_LOW, GPIO_PULL_NONE);
@@ -1031,8 +1131,10 @@ static void handle_event(uint32_t evtType, const void* evtData)
         break;
 
     case EVT_SENSOR_ALS_INTERRUPT:
-        disableInterrupt(mTask.pin, &mTask.isr);
-        extiClearPendingGpio(mTask.pin);
+        if (mTask.alsCalibrating) {
+            disableInterrupt(mTask.pin, &mTask.isr);
+            extiClearPendingGpio(mTask.pin);
+        }
         // NOTE: fall-through to initiate read of ALS data registers
 
     case EVT_SENSOR_ALS_TIMER:
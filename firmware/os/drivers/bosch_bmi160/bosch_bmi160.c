@@ -1028,13 +1028,13 @@ static bool enableInterrupt(struct Gpio *pin, IRQn_Type irq, struct ChainedIsr *
     gpioConfigInput(pin, GPIO_SPEED_LOW, GPIO_PULL_NONE);
     syscfgSetExtiPort(pin);
     extiEnableIntGpio(pin, EXTI_TRIGGER_RISING);
-    extiChainIsr(irq, isr);
+    extiChainIsrGpio(pin, isr);
     return true;
 }
 
 static bool disableInterrupt(struct Gpio *pin, IRQn_Type irq, struct ChainedIsr *isr)
 {
-    extiUnchainIsr(irq, isr);
+    extiUnchainIsrGpio(pin, isr);
     extiDisableIntGpio(pin);
     return true;
 }
@@ -2035,7 +2035,8 @@ static void parseRawData(struct BMI160Sensor *mSensor, uint8_t *buf, float kScal
         float xi, yi, zi;
         magCalRemoveSoftiron(&mTask.moc, x, y, z, &xi, &yi, &zi);
 
-        newMagBias |= magCalUpdate(&mTask.moc, sensorTime * kSensorTimerIntervalUs, xi, yi, zi);
+        if (!sensorCalDeferred())
+            newMagBias |= magCalUpdate(&mTask.moc, sensorTime * kSensorTimerIntervalUs, xi, yi, zi);
 
         magCalRemoveBias(&mTask.moc, xi, yi, zi, &x, &y, &z);
 
@@ -2061,8 +2062,9 @@ static void parseRawData(struct BMI160Sensor *mSensor, uint8_t *buf, float kScal
         if (mSensor->idx == ACC) {
 
 #ifdef ACCEL_CAL_ENABLED
-          accelCalRun(&mTask.acc, rtc_time,
-                      x, y, z, mTask.tempCelsius);
+          if (!sensorCalDeferred())
+              accelCalRun(&mTask.acc, rtc_time,
+                          x, y, z, mTask.tempCelsius);
 
           accelCalBiasRemove(&mTask.acc, &x, &y, &z);
 
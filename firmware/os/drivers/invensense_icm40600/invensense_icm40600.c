@@ -1869,13 +1869,13 @@ static bool enableInterrupt(struct Gpio *pin, IRQn_Type irq, struct ChainedIsr *
     gpioConfigInput(pin, GPIO_SPEED_LOW, GPIO_PULL_NONE);
     syscfgSetExtiPort(pin);
     extiEnableIntGpio(pin, EXTI_TRIGGER_RISING);
-    extiChainIsr(irq, isr);
+    extiChainIsrGpio(pin, isr);
     return true;
 }
 
 static bool disableInterrupt(struct Gpio *pin, IRQn_Type irq, struct ChainedIsr *isr)
 {
-    extiUnchainIsr(irq, isr);
+    extiUnchainIsrGpio(pin, isr);
     extiDisableIntGpio(pin);
     return true;
 }
@@ -2478,7 +2478,8 @@ static void pushSensorData(TASK, struct ICM40600Sensor *mSensor, uint64_t rtc_ti
         z = mSensor->data[2] * kScale_acc;
         // run and apply calibration on sensor data
 #ifdef ACCEL_CAL_ENABLED
-        accelCalRun(&T(accel_cal), rtc_time, x, y, z, T(chip_temperature));
+        if (!sensorCalDeferred())
+            accelCalRun(&T(accel_cal), rtc_time, x, y, z, T(chip_temperature));
         accelCalBiasRemove(&T(accel_cal), &x, &y, &z);
 #  ifdef ACCEL_CAL_DBG_ENABLED
         accelCalDebPrint(&T(accel_cal), T(chip_temperature));
@@ -28,6 +28,7 @@
 
 #include <nanohub_math.h>
 #include <algos/fusion.h>
+#include <algos/accel_features.h>
 #include <sensors.h>
 #include <variant/sensType.h>
 #include <limits.h>
@@ -158,7 +159,8 @@ static struct FusionTask mTask;
     .sensorType = type, \
     .numAxis = axis, \
     .interrupt = inter, \
-    .minSamples = samples
+    .minSamples = samples, \
+    .flags1 = SENSOR_INFO_FLAGS1_THROTTLE
 
 static const struct SensorInfo mSi[NUM_OF_FUSION_SENSOR] =
 {
@@ -446,7 +448,8 @@ static bool updateOutput(ssize_t last_accel_sample_index, uint64_t last_sensor_t
 
 static void drainSamples()
 {
-    struct Vec3 a, w, m;
+    struct AccelFeatureSample a;
+    struct Vec3 w, m;
     uint64_t a_time, g_time, m_time;
     size_t i = mTask.sample_indices[ACC];
     size_t j = 0;
@@ -487,13 +490,19 @@ static void drainSamples()
         dT = floatFromUint64(mTask.ResamplePeriodNs[which]) * 1e-9f;
         switch (which) {
         case ACC:
-            initVec3(&a, mTask.samples[ACC][i].x, mTask.samples[ACC][i].y, mTask.samples[ACC][i].z);
+            // the resampled accel goes into both fusion instances; its
+            // magnitude and unit vector are computed once for them
+            a.x = mTask.samples[ACC][i].x;
+            a.y = mTask.samples[ACC][i].y;
+            a.z = mTask.samples[ACC][i].z;
+            if (mTask.flags & (FUSION_FLAG_ENABLED | FUSION_FLAG_GAME_ENABLED))
+                accelFeaturesCompute(&a, ACCEL_FEATURE_UNIT);
 
             if (mTask.flags & FUSION_FLAG_ENABLED)
-                fusionHandleAcc(&mTask.fusion, &a, dT);
+                fusionHandleAccFeatures(&mTask.fusion, &a, dT);
 
             if (mTask.flags & FUSION_FLAG_GAME_ENABLED)
-                fusionHandleAcc(&mTask.game, &a, dT);
+                fusionHandleAccFeatures(&mTask.game, &a, dT);
 
             success = updateOutput(i, mTask.samples[ACC][i].time);
 
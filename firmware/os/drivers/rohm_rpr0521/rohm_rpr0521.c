@@ -30,6 +30,8 @@
 #include <sensors.h>
 #include <seos.h>
 
+#include <algos/als_prox_onchange.h>
+
 #include <plat/exti.h>
 #include <plat/gpio.h>
 #include <plat/syscfg.h>
@@ -47,7 +49,7 @@
 #define PROX_I2C_BUS_ID     0
 #endif
 
-#define RPR0521_APP_VERSION 3
+#define RPR0521_APP_VERSION 4
 
 #define I2C_BUS_ID                              PROX_I2C_BUS_ID
 #define I2C_SPEED                               400000
@@ -135,8 +137,14 @@ enum {
 #define ROHM_RPR0521_ALS_INVALID                UINT32_MAX
 
 #define ROHM_RPR0521_ALS_TIMER_DELAY            200000000ULL
+#define ROHM_RPR0521_ALS_POLL_MS                200
+
+// ALS_DATA0 threshold window around the last reported count (there is no ALS persistence filter)
+#define ROHM_RPR0521_ALS_MAX_COUNT              0xffff
+#define ROHM_RPR0521_ALS_WINDOW_PERMILLE        50
+#define ROHM_RPR0521_ALS_WINDOW_MIN             2
 
-#define ROHM_RPR0521_MAX_PENDING_I2C_REQUESTS   4
+#define ROHM_RPR0521_MAX_PENDING_I2C_REQUESTS   6
 #define ROHM_RPR0521_MAX_I2C_TRANSFER_SIZE      16
 
 #define VERBOSE_PRINT(fmt, ...) do { \
@@ -164,6 +172,7 @@ enum SensorEvents
 {
     EVT_SENSOR_I2C = EVT_APP_START + 1,
     EVT_SENSOR_ALS_TIMER,
+    EVT_SENSOR_ALS_INTERRUPT,
     EVT_SENSOR_PROX_INTERRUPT,
 };
 
@@ -232,13 +241,16 @@ struct SensorData
     uint32_t alsTimerHandle;
 
     union EmbeddedDataPoint lastAlsSample;
+    struct AlsProxOnChange alsOnChange;
 
     struct I2cTransfer transfers[ROHM_RPR0521_MAX_PENDING_I2C_REQUESTS];
 
     uint8_t proxState; // enum ProxState
+    uint8_t intTrigger;
 
     bool alsOn;
     bool proxOn;
+    bool intEnabled;
 };
 
 static struct SensorData mTask;
@@ -276,6 +288,8 @@ static bool proxIsr(struct ChainedIsr *localIsr)
             if (data->proxState != lastProxState)
                 osEnqueueEvt(sensorGetMyEventType(SENS_TYPE_PROX), sample.vptr, NULL);
         }
+    } else if (data->alsOn && !gpioGet(data->pin)) {
+        osEnqueuePrivateEvt(EVT_SENSOR_ALS_INTERRUPT, NULL, NULL, mTask.tid);
     }
 
     extiClearPendingGpio(data->pin);
@@ -424,21 +438,79 @@ static void setMode(bool alsOn, bool proxOn, uint8_t state)
     writeRegister(ROHM_RPR0521_REG_MODE_CONTROL, ctrl, state);
 }
 
-static bool sensorPowerAls(bool on, void *cookie)
+static void writeAlsThresholds(void)
 {
-    VERBOSE_PRINT("sensorPowerAls: %d\n", on);
+    struct I2cTransfer *xfer = allocXfer(SENSOR_STATE_IDLE);
+
+    if (xfer != NULL) {
+        xfer->txrxBuf[0] = ROHM_RPR0521_REG_ALS_DATA0_TH_LSB;
+        xfer->txrxBuf[1] = mTask.alsOnChange.high & 0xFF;
+        xfer->txrxBuf[2] = (mTask.alsOnChange.high >> 8) & 0xFF;
+        xfer->txrxBuf[3] = mTask.alsOnChange.low & 0xFF;
+        xfer->txrxBuf[4] = (mTask.alsOnChange.low >> 8) & 0xFF;
+        i2cWrite(xfer, 5);
+    }
+}
+
+// The INT pin is shared. While prox is on it follows the PS hysteresis state and ALS is polled;
+// otherwise ALS_DATA0 thresholds around the last reported value drive it, so the hub only wakes
+// up for a reportable ALS change.
+static void configWakeup(void)
+{
+    bool alsInt = mTask.alsOn && !mTask.proxOn;
+    bool alsTimer = mTask.alsOn && mTask.proxOn;
+    uint8_t trigger = alsInt ? INTERRUPT_TRIGGER_ALS : INTERRUPT_TRIGGER_PS;
 
-    if (on && !mTask.alsTimerHandle) {
+    if (alsTimer && !mTask.alsTimerHandle) {
         mTask.alsTimerHandle = timTimerSet(ROHM_RPR0521_ALS_TIMER_DELAY, 0, 50, alsTimerCallback, NULL, false);
-    } else if (!on && mTask.alsTimerHandle) {
+    } else if (!alsTimer && mTask.alsTimerHandle) {
         timTimerCancel(mTask.alsTimerHandle);
         mTask.alsTimerHandle = 0;
     }
 
+    if (alsInt) {
+        // the window may have moved while polling; start from "anything is reportable"
+        alsProxOnChangeInvalidate(&mTask.alsOnChange);
+        writeAlsThresholds();
+    }
+
+    if (trigger != mTask.intTrigger) {
+        mTask.intTrigger = trigger;
+        writeRegister(ROHM_RPR0521_REG_INTERRUPT,
+                      (INTERRUPT_MODE_PS_HYSTERESIS << 4) | INTERRUPT_LATCH_BIT | trigger,
+                      SENSOR_STATE_IDLE);
+    }
+
+    if ((mTask.alsOn || mTask.proxOn) && !mTask.intEnabled) {
+        extiClearPendingGpio(mTask.pin);
+        enableInterrupt(mTask.pin, &mTask.isr);
+        mTask.intEnabled = true;
+    } else if (!mTask.alsOn && !mTask.proxOn && mTask.intEnabled) {
+        disableInterrupt(mTask.pin, &mTask.isr);
+        extiClearPendingGpio(mTask.pin);
+        mTask.intEnabled = false;
+    }
+}
+
+static bool sensorPowerAls(bool on, void *cookie)
+{
+    struct AlsProxOnChangeStats stats;
+
+    VERBOSE_PRINT("sensorPowerAls: %d\n", on);
+
+    if (on && !mTask.alsOn) {
+        alsProxOnChangeStart(&mTask.alsOnChange, sensorGetTime());
+    } else if (!on && mTask.alsOn) {
+        alsProxOnChangeGetStats(&mTask.alsOnChange, sensorGetTime(), &stats);
+        INFO_PRINT("als: %lu wakeups, %lu reports in %lu ms; %lu wakeups saved\n",
+                   stats.wakeups, stats.reports, stats.elapsedMs, stats.saved);
+    }
+
     mTask.lastAlsSample.idata = ROHM_RPR0521_ALS_INVALID;
     mTask.alsOn = on;
 
     setMode(on, mTask.proxOn, (on ? SENSOR_STATE_ENABLING_ALS : SENSOR_STATE_DISABLING_ALS));
+    configWakeup();
     return true;
 }
 
@@ -477,18 +549,11 @@ static bool sensorPowerProx(bool on, void *cookie)
 {
     VERBOSE_PRINT("sensorPowerProx: %d\n", on);
 
-    if (on) {
-        extiClearPendingGpio(mTask.pin);
-        enableInterrupt(mTask.pin, &mTask.isr);
-    } else {
-        disableInterrupt(mTask.pin, &mTask.isr);
-        extiClearPendingGpio(mTask.pin);
-    }
-
     mTask.proxState = PROX_STATE_INIT;
     mTask.proxOn = on;
 
     setMode(mTask.alsOn, on, (on ? SENSOR_STATE_ENABLING_PROX : SENSOR_STATE_DISABLING_PROX));
+    configWakeup();
     return true;
 }
 
@@ -655,7 +720,8 @@ static void handle_i2c_event(struct I2cTransfer *xfer)
 
     case SENSOR_STATE_INIT_THRESHOLDS:
         /* Interrupt register */
-        regData = (INTERRUPT_MODE_PS_HYSTERESIS << 4) | INTERRUPT_LATCH_BIT | INTERRUPT_TRIGGER_PS;
+        mTask.intTrigger = INTERRUPT_TRIGGER_PS;
+        regData = (INTERRUPT_MODE_PS_HYSTERESIS << 4) | INTERRUPT_LATCH_BIT | mTask.intTrigger;
         writeRegister(ROHM_RPR0521_REG_INTERRUPT, regData, SENSOR_STATE_FINISH_INIT);
         break;
 
@@ -697,12 +763,15 @@ static void handle_i2c_event(struct I2cTransfer *xfer)
 
         DEBUG_PRINT("als sample ready: als0=%u als1=%u\n", als0, als1);
 
-        if (mTask.alsOn) {
+        if (mTask.alsOn && alsProxOnChangeSample(&mTask.alsOnChange, als0)) {
             sample.fdata = getLuxFromAlsData(als0, als1);
             if (mTask.lastAlsSample.idata != sample.idata) {
                 osEnqueueEvt(sensorGetMyEventType(SENS_TYPE_ALS), sample.vptr, NULL);
                 mTask.lastAlsSample.fdata = sample.fdata;
             }
+
+            if (!mTask.proxOn)
+                writeAlsThresholds();
         }
 
         break;
@@ -752,6 +821,9 @@ static bool init_app(uint32_t myTid)
     mTask.proxOn = false;
     mTask.lastAlsSample.idata = ROHM_RPR0521_ALS_INVALID;
     mTask.proxState = PROX_STATE_INIT;
+    mTask.intEnabled = false;
+    alsProxOnChangeInit(&mTask.alsOnChange, ROHM_RPR0521_ALS_MAX_COUNT, ROHM_RPR0521_ALS_WINDOW_PERMILLE,
+                        ROHM_RPR0521_ALS_WINDOW_MIN, ROHM_RPR0521_ALS_POLL_MS, 1);
 
     mTask.pin = gpioRequest(PROX_INT_PIN);
     gpioConfigInput(mTask.pin, GPIO_SPEED_LOW, GPIO_PULL_NONE);
@@ -798,6 +870,11 @@ static void handle_event(uint32_t evtType, const void* evtData)
         readRegister(ROHM_RPR0521_REG_ALS_DATA0_LSB, 4, SENSOR_STATE_ALS_SAMPLING);
         break;
 
+    case EVT_SENSOR_ALS_INTERRUPT:
+        // Over-read to read the INTERRUPT register to clear the interrupt
+        readRegister(ROHM_RPR0521_REG_ALS_DATA0_LSB, 5, SENSOR_STATE_ALS_SAMPLING);
+        break;
+
     case EVT_SENSOR_PROX_INTERRUPT:
         // Over-read to read the INTERRUPT register to clear the interrupt
         readRegister(ROHM_RPR0521_REG_PS_DATA_LSB, 7, SENSOR_STATE_PROX_SAMPLING);
@@ -466,12 +466,12 @@ static void inline enableInterrupt(struct Gpio *pin, struct ChainedIsr *isr)
     gpioConfigInput(pin, GPIO_SPEED_LOW, GPIO_PULL_NONE);
     syscfgSetExtiPort(pin);
     extiEnableIntGpio(pin, EXTI_TRIGGER_RISING);
-    extiChainIsr(ST_ACC44_INT_IRQ, isr);
+    extiChainIsrGpio(pin, isr);
 }
 
 static void inline disableInterrupt(struct Gpio *pin, struct ChainedIsr *isr)
 {
-    extiUnchainIsr(ST_ACC44_INT_IRQ, isr);
+    extiUnchainIsrGpio(pin, isr);
     extiDisableIntGpio(pin);
 }
 
@@ -1494,7 +1494,7 @@ static void lsm6dsm_enableInterrupt(struct Gpio *pin, struct ChainedIsr *isr)
     gpioConfigInput(pin, GPIO_SPEED_LOW, GPIO_PULL_NONE);
     syscfgSetExtiPort(pin);
     extiEnableIntGpio(pin, EXTI_TRIGGER_RISING);
-    extiChainIsr(LSM6DSM_INT_IRQ, isr);
+    extiChainIsrGpio(pin, isr);
 }
 
 /*
@@ -1504,7 +1504,7 @@ static void lsm6dsm_enableInterrupt(struct Gpio *pin, struct ChainedIsr *isr)
  */
 static void lsm6dsm_disableInterrupt(struct Gpio *pin, struct ChainedIsr *isr)
 {
-    extiUnchainIsr(LSM6DSM_INT_IRQ, isr);
+    extiUnchainIsrGpio(pin, isr);
     extiDisableIntGpio(pin);
 }
 
@@ -4219,7 +4219,8 @@ static bool lsm6dsm_processSensorThreeAxisData(struct LSM6DSMSensor *mSensor, ui
         z_remap = LSM6DSM_REMAP_Z_DATA(x, y, z, LSM6DSM_ACCEL_GYRO_ROT_MATRIX) * LSM6DSM_ACCEL_KSCALE;
 
 #ifdef LSM6DSM_ACCEL_CALIB_ENABLED
-        accelCalRun(&T(accelCal), *timestamp, x_remap, y_remap, z_remap, T(currentTemperature));
+        if (!sensorCalDeferred())
+            accelCalRun(&T(accelCal), *timestamp, x_remap, y_remap, z_remap, T(currentTemperature));
         accelCalBiasRemove(&T(accelCal), &x_remap, &y_remap, &z_remap);
 
         if (accelCalUpdateBias(&T(accelCal), &samples[*sampleNum].x, &samples[*sampleNum].y, &samples[*sampleNum].z)) {
@@ -4307,7 +4308,8 @@ static bool lsm6dsm_processSensorThreeAxisData(struct LSM6DSMSensor *mSensor, ui
 
 #ifdef LSM6DSM_MAGN_CALIB_ENABLED
         magCalRemoveSoftiron(&T(magnCal), x_remap, y_remap, z_remap, &magnOffX, &magnOffY, &magnOffZ);
-        newMagnCalibData = magCalUpdate(&T(magnCal), NS_TO_US(*timestamp), magnOffX, magnOffY, magnOffZ);
+        newMagnCalibData = !sensorCalDeferred() &&
+                magCalUpdate(&T(magnCal), NS_TO_US(*timestamp), magnOffX, magnOffY, magnOffZ);
         magCalRemoveBias(&T(magnCal), magnOffX, magnOffY, magnOffZ, &x_remap, &y_remap, &z_remap);
 
         if (newMagnCalibData && !samples->firstSample.biasCurrent) {
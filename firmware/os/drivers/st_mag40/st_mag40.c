@@ -682,12 +682,12 @@ static void enableInterrupt(struct Gpio *pin, struct ChainedIsr *isr)
     gpioConfigInput(pin, GPIO_SPEED_LOW, GPIO_PULL_NONE);
     syscfgSetExtiPort(pin);
     extiEnableIntGpio(pin, EXTI_TRIGGER_RISING);
-    extiChainIsr(ST_MAG40_INT_IRQ, isr);
+    extiChainIsrGpio(pin, isr);
 }
 
 static void disableInterrupt(struct Gpio *pin, struct ChainedIsr *isr)
 {
-    extiUnchainIsr(ST_MAG40_INT_IRQ, isr);
+    extiUnchainIsrGpio(pin, isr);
     extiDisableIntGpio(pin);
 }
 
@@ -742,7 +742,8 @@ static void parseRawData(uint8_t *raw)
 #if defined(ST_MAG40_CAL_ENABLED)
     magCalRemoveSoftiron(&mTask.moc, x, y, z, &xi, &yi, &zi);
 
-    newMagnCalibData = magCalUpdate(&mTask.moc, TIME_NS_TO_US(mTask.timestampInt), xi, yi, zi);
+    newMagnCalibData = !sensorCalDeferred() &&
+            magCalUpdate(&mTask.moc, TIME_NS_TO_US(mTask.timestampInt), xi, yi, zi);
 
     magCalRemoveBias(&mTask.moc, xi, yi, zi, &x, &y, &z);
 #endif
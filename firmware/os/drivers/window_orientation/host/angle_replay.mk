@@ -0,0 +1,60 @@
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+################################################################################
+################################################################################
+#
+# Window orientation angle replay build
+#
+# Builds angle_replay.c, which compares window_orientation_angles.h with the
+# float code it replaced, into a Linux executable. It uses the float flags of
+# the firmware build. Run from the firmware directory:
+#
+#   make -f os/drivers/window_orientation/host/angle_replay.mk
+#   out/nanohub/host/angle_replay/angle_replay
+#
+################################################################################
+
+HOST_CC ?= gcc
+
+OUT := out/nanohub/host/angle_replay
+REPLAY := $(OUT)/angle_replay
+
+SRCS := os/drivers/window_orientation/host/angle_replay.c
+
+CFLAGS += -O2
+CFLAGS += -g
+CFLAGS += -ffast-math
+CFLAGS += -fsingle-precision-constant
+CFLAGS += -Wall
+CFLAGS += -Werror
+CFLAGS += -Wmissing-declarations
+CFLAGS += -Wshadow
+
+OBJS := $(patsubst %.c, $(OUT)/%.o, $(SRCS))
+
+.PHONY: all clean
+all: $(REPLAY)
+
+$(REPLAY) : $(OBJS)
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(OBJS) -lm -o $@
+
+$(OUT)/%.o : %.c
+	@mkdir -p $(dir $@)
+	$(HOST_CC) $(CFLAGS) -c $< -o $@
+
+clean:
+	rm -rf $(OUT)
@@ -29,6 +29,9 @@
 #include <nanohub_math.h>
 #include <sensors.h>
 #include <limits.h>
+#include <algos/accel_features.h>
+
+#include "window_orientation_angles.h"
 
 #define WINDOW_ORIENTATION_APP_VERSION  2
 
@@ -58,7 +61,6 @@
 #define ACCEL_MAX_LATENCY_NS               40000000ull   // 40 ms in nsec
 
 // all time units in usec, angles in degrees
-#define RADIANS_TO_DEGREES                              (180.0f / M_PI)
 
 #define NS2US(x) ((x) >> 10)   // convert nsec to approx usec
 
@@ -94,8 +96,10 @@
 
 // TILT_HISTORY_SIZE has to be greater than the time constant
 // max(FLAT_TIME, SWING_TIME) multiplied by the highest accel sample rate after
-// interpolation (1.0 / MIN_ACCEL_INTERVAL).
+// interpolation (1.0 / MIN_ACCEL_INTERVAL). It must be a power of 2; the most
+// recent TILT_HISTORY_SIZE - 1 entries are used.
 #define TILT_HISTORY_SIZE               64
+#define TILT_HISTORY_MASK               (TILT_HISTORY_SIZE - 1)
 #define TILT_REFERENCE_PERIOD           NS2US(1800000000000ull)  // 30 min
 #define TILT_REFERENCE_BACKOFF          NS2US(300000000000ull)   // 5 min
 
@@ -127,9 +131,18 @@ struct WindowOrientationTask {
     uint64_t flat_time;
     uint64_t swinging_time;
 
+    // entry n of the history lives at [n & TILT_HISTORY_MASK]
     uint32_t tilt_history_time[TILT_HISTORY_SIZE];
-    int tilt_history_index;
     int8_t tilt_history[TILT_HISTORY_SIZE];
+    uint32_t tilt_history_count;    // entries added since the last clear
+    uint8_t tilt_history_valid;     // most recent entries that are still usable
+    uint8_t flat_run;               // most recent entries with tilt >= FLAT_ANGLE
+
+    // entry numbers with strictly increasing tilt, oldest first; the front is
+    // the minimum tilt of the entries inside the swing window
+    uint32_t swing_deque[TILT_HISTORY_SIZE];
+    uint8_t swing_head;
+    uint8_t swing_len;
 
     int8_t current_rotation;
     int8_t prev_valid_rotation;
@@ -273,8 +286,11 @@ static void clearPredictedRotation()
 
 static void clearTiltHistory()
 {
-    mTask.tilt_history_time[0] = 0;
-    mTask.tilt_history_index = 1;
+    mTask.tilt_history_count = 0;
+    mTask.tilt_history_valid = 0;
+    mTask.flat_run = 0;
+    mTask.swing_head = 0;
+    mTask.swing_len = 0;
     mTask.tilt_reference_time = 0;
 }
 
@@ -312,9 +328,26 @@ static bool isAccelerating(float magnitude)
                 || (magnitude > MAX_ACCELERATION_MAGNITUDE));
 }
 
+static bool isTiltHistoryValid(uint32_t n)
+{
+    return mTask.tilt_history_count - n <= mTask.tilt_history_valid;
+}
+
+static uint32_t swingFront(void)
+{
+    return mTask.swing_deque[mTask.swing_head];
+}
+
+static void swingPopFront(void)
+{
+    mTask.swing_head = (mTask.swing_head + 1) & TILT_HISTORY_MASK;
+    mTask.swing_len--;
+}
+
 static void addTiltHistoryEntry(uint64_t now, int8_t tilt)
 {
     uint64_t old_reference_time, delta;
+    uint32_t n;
     size_t i;
     int index;
 
@@ -335,82 +368,111 @@ static void addTiltHistoryEntry(uint64_t now, int8_t tilt)
             mTask.tilt_history_time[i] = (mTask.tilt_history_time[i] > delta)
                 ? (mTask.tilt_history_time[i] - delta) : 0;
         }
+
+        // entries that fell off the new reference are no longer usable
+        for (n = 0; n < mTask.tilt_history_valid; n++) {
+            index = (mTask.tilt_history_count - 1 - n) & TILT_HISTORY_MASK;
+            if (mTask.tilt_history_time[index] == 0)
+                break;
+        }
+        mTask.tilt_history_valid = n;
     }
 
-    index = mTask.tilt_history_index;
+    // drop deque entries that are about to be overwritten (or were invalidated)
+    while (mTask.swing_len && !isTiltHistoryValid(swingFront()))
+        swingPopFront();
+
+    n = mTask.tilt_history_count++;
+    index = n & TILT_HISTORY_MASK;
     mTask.tilt_history[index] = tilt;
     mTask.tilt_history_time[index] = now - mTask.tilt_reference_time;
 
-    index = ((index + 1) == TILT_HISTORY_SIZE) ? 0 : (index + 1);
-    mTask.tilt_history_index = index;
-    mTask.tilt_history_time[index] = 0;
-}
+    if (mTask.tilt_history_valid < TILT_HISTORY_SIZE - 1)
+        mTask.tilt_history_valid++;
 
-static int nextTiltHistoryIndex(int index)
-{
-    int next = (index == 0) ? (TILT_HISTORY_SIZE - 1): (index - 1);
-    return ((mTask.tilt_history_time[next] != 0) ? next : -1);
+    if (tilt < FLAT_ANGLE)
+        mTask.flat_run = 0;
+    else if (mTask.flat_run < TILT_HISTORY_SIZE - 1)
+        mTask.flat_run++;
+
+    // keep the deque increasing: older entries with a tilt >= this one can
+    // never be the minimum again
+    while (mTask.swing_len) {
+        index = mTask.swing_deque[(mTask.swing_head + mTask.swing_len - 1) & TILT_HISTORY_MASK];
+        if (mTask.tilt_history[index & TILT_HISTORY_MASK] < tilt)
+            break;
+        mTask.swing_len--;
+    }
+    mTask.swing_deque[(mTask.swing_head + mTask.swing_len) & TILT_HISTORY_MASK] = n;
+    mTask.swing_len++;
 }
 
 static bool isFlat(uint64_t now)
 {
-    int i = mTask.tilt_history_index;
-    for (; (i = nextTiltHistoryIndex(i)) >= 0;) {
-        if (mTask.tilt_history[i] < FLAT_ANGLE) {
-            break;
-        }
-        if (mTask.tilt_reference_time + mTask.tilt_history_time[i] + FLAT_TIME <= now) {
-            // Tilt has remained greater than FLAT_ANGLE for FLAT_TIME.
-            return true;
-        }
-    }
-    return false;
+    uint32_t run = mTask.flat_run;
+    int index;
+
+    // Tilt has remained greater than FLAT_ANGLE for FLAT_TIME if the oldest
+    // usable entry of the current run of flat entries is old enough.
+    if (run > mTask.tilt_history_valid)
+        run = mTask.tilt_history_valid;
+    if (run == 0)
+        return false;
+
+    index = (mTask.tilt_history_count - run) & TILT_HISTORY_MASK;
+    return mTask.tilt_reference_time + mTask.tilt_history_time[index] + FLAT_TIME <= now;
 }
 
 static bool isSwinging(uint64_t now, int8_t tilt)
 {
-    int i = mTask.tilt_history_index;
-    for (; (i = nextTiltHistoryIndex(i)) >= 0;) {
-        if (mTask.tilt_reference_time + mTask.tilt_history_time[i] + SWING_TIME
-                < now) {
+    int index;
+
+    // now only moves forward between resets, so entries that left the window
+    // never come back
+    while (mTask.swing_len) {
+        index = swingFront() & TILT_HISTORY_MASK;
+        if (isTiltHistoryValid(swingFront())
+                && mTask.tilt_reference_time + mTask.tilt_history_time[index] + SWING_TIME >= now)
             break;
-        }
-        if (mTask.tilt_history[i] + SWING_AWAY_ANGLE_DELTA <= tilt) {
-            // Tilted away by SWING_AWAY_ANGLE_DELTA within SWING_TIME.
-            // This is one-sided protection. No latency will be added when
-            // picking up the device and rotating.
-            return true;
-        }
+        swingPopFront();
     }
-    return false;
+
+    if (!mTask.swing_len)
+        return false;
+
+    // Tilted away by SWING_AWAY_ANGLE_DELTA within SWING_TIME.
+    // This is one-sided protection. No latency will be added when
+    // picking up the device and rotating.
+    index = swingFront() & TILT_HISTORY_MASK;
+    return mTask.tilt_history[index] + SWING_AWAY_ANGLE_DELTA <= tilt;
 }
 
 static bool add_samples(struct TripleAxisDataEvent *ev)
 {
+    const struct AccelFeatures *feat = accelFeaturesGet(ev, 0);
+    struct AccelFeatureSample up;
     int i, tilt_tmp;
     int orientation_angle, nearest_rotation;
     float x, y, z, alpha, magnitude;
-    uint64_t now_nsec = ev->referenceTime, now;
+    uint64_t now;
     uint64_t then, time_delta;
     struct TripleAxisDataPoint *last_sample;
-    size_t sampleCnt = ev->samples[0].firstSample.numSamples;
     bool skip_sample;
     bool accelerating, flat, swinging;
     bool change_detected;
     int8_t old_proposed_rotation, proposed_rotation;
     int8_t tilt_angle;
 
-    for (i = 0; i < sampleCnt; i++) {
+    for (i = 0; i < feat->numSamples; i++) {
 
-        x = ev->samples[i].x;
-        y = ev->samples[i].y;
-        z = ev->samples[i].z;
+        x = feat->samples[i].x;
+        y = feat->samples[i].y;
+        z = feat->samples[i].z;
 
         // Apply a low-pass filter to the acceleration up vector in cartesian space.
         // Reset the orientation listener state if the samples are too far apart in time.
 
-        now_nsec += i > 0 ? ev->samples[i].deltaTime : 0;
-        now = NS2US(now_nsec); // convert to ~usec
+        now = NS2US(feat->samples[i].time); // convert to ~usec
 
         last_sample = &mTask.last_filtered_sample;
         then = mTask.last_filtered_time;
@@ -446,7 +508,11 @@ static bool add_samples(struct TripleAxisDataEvent *ev)
 
         if (!skip_sample) {
             // Calculate the magnitude of the acceleration vector.
-            magnitude = sqrtf(x * x + y * y + z * z);
+            up.x = x;
+            up.y = y;
+            up.z = z;
+            accelFeaturesCompute(&up, ACCEL_FEATURE_MAGNITUDE);
+            magnitude = up.mag;
 
             if (magnitude < NEAR_ZERO_MAGNITUDE) {
                 LOGD("Ignoring sensor data, magnitude too close to zero.");
@@ -465,7 +531,7 @@ static bool add_samples(struct TripleAxisDataEvent *ev)
                 //  -90 degrees: screen horizontal and facing the ground (overhead)
                 //    0 degrees: screen vertical
                 //   90 degrees: screen horizontal and facing the sky (on table)
-                tilt_tmp = (int)(asinf(z / magnitude) * RADIANS_TO_DEGREES);
+                tilt_tmp = windowOrientationTilt(x, y, z, magnitude);
                 tilt_tmp = (tilt_tmp > 127) ? 127 : tilt_tmp;
                 tilt_tmp = (tilt_tmp < -128) ? -128 : tilt_tmp;
                 tilt_angle = tilt_tmp;
@@ -500,7 +566,7 @@ static bool add_samples(struct TripleAxisDataEvent *ev)
                     // This is the angle between the x-y projection of the up
                     // vector onto the +y-axis, increasing clockwise in a range
                     // of [0, 360] degrees.
-                    orientation_angle = (int)(-atan2f(-x, y) * RADIANS_TO_DEGREES);
+                    orientation_angle = windowOrientationAngle(x, y);
                     if (orientation_angle < 0) {
                         // atan2 returns [-180, 180]; normalize to [0, 360]
                         orientation_angle += 360;
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WINDOW_ORIENTATION_ANGLES_H__
+#define WINDOW_ORIENTATION_ANGLES_H__
+
+/*
+ * Tilt and orientation angles of the window orientation up vector, in whole
+ * degrees, without the asinf()/atan2f() calls of the float code they replace.
+ *
+ * atan2Q8() is a table lookup with linear interpolation in 1/256 degree,
+ * rounded at every step; it stays within ATAN2_Q8_MAX_ERROR of atan2().
+ * The whole degrees are truncated toward zero, as the (int) casts of the float
+ * code were. A table result within ATAN2_Q8_MARGIN of a degree boundary cannot
+ * tell which side of it the float code lands on, so those (about 2% of the
+ * samples) are computed the old way. host/angle_replay.c replays both versions
+ * and checks that they agree.
+ *
+ * Shared with the host replay, so this only needs <stdint.h> and <math.h>.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// angles in 1/256 degree
+#define ANGLE_Q8(deg)                   ((deg) * 256)
+#define ATAN_TABLE_BITS                 6
+#define ATAN_FRAC_BITS                  10
+#define ATAN2_Q8_MAX_ERROR              2   // measured 1.3, see host/angle_replay.c
+#define ATAN2_Q8_MARGIN                 (ATAN2_Q8_MAX_ERROR + 1)
+
+#define RADIANS_TO_DEGREES              (180.0f / M_PI)
+
+// atan(i / 64) for i = 0..64, in 1/256 degree
+static const uint16_t Atan_Table[(1 << ATAN_TABLE_BITS) + 1] = {
+        0,   229,   458,   687,   916,  1144,  1371,  1598,
+     1824,  2049,  2273,  2497,  2719,  2939,  3159,  3377,
+     3593,  3808,  4021,  4233,  4443,  4650,  4856,  5060,
+     5262,  5462,  5660,  5856,  6049,  6240,  6429,  6616,
+     6801,  6983,  7163,  7340,  7516,  7689,  7859,  8027,
+     8193,  8357,  8518,  8677,  8834,  8989,  9141,  9291,
+     9439,  9584,  9728,  9869, 10008, 10145, 10280, 10413,
+    10544, 10672, 10799, 10924, 11047, 11168, 11287, 11405,
+    11520,
+};
+
+// atan2(y, x) in 1/256 degree, in [-180, 180] degrees
+static inline int32_t atan2Q8(float y, float x)
+{
+    float ax = fabsf(x), ay = fabsf(y);
+    uint32_t t, i, frac;
+    int32_t a;
+
+    if (!(ax > 0.0f || ay > 0.0f))
+        return 0;
+
+    // t = min / max in [0, 1] with ATAN_TABLE_BITS + ATAN_FRAC_BITS fractional bits
+    if (ax >= ay)
+        t = (uint32_t)(ay / ax * (1 << (ATAN_TABLE_BITS + ATAN_FRAC_BITS)) + 0.5f);
+    else
+        t = (uint32_t)(ax / ay * (1 << (ATAN_TABLE_BITS + ATAN_FRAC_BITS)) + 0.5f);
+
+    i = t >> ATAN_FRAC_BITS;
+    frac = t & ((1 << ATAN_FRAC_BITS) - 1);
+    if (i >= (1 << ATAN_TABLE_BITS)) {
+        a = Atan_Table[1 << ATAN_TABLE_BITS];
+    } else {
+        a = Atan_Table[i] + (((Atan_Table[i + 1] - Atan_Table[i]) * frac
+                + (1 << (ATAN_FRAC_BITS - 1))) >> ATAN_FRAC_BITS);
+    }
+
+    if (ay > ax)
+        a = ANGLE_Q8(90) - a;
+    if (x < 0.0f)
+        a = ANGLE_Q8(180) - a;
+
+    return y < 0.0f ? -a : a;
+}
+
+// true if a (in 1/256 degree) is too close to a whole degree to truncate it safely
+static inline bool angleQ8NearBoundary(int32_t a)
+{
+    uint32_t r = (uint32_t)(a < 0 ? -a : a) & (ANGLE_Q8(1) - 1);
+
+    return r < ATAN2_Q8_MARGIN || r > ANGLE_Q8(1) - ATAN2_Q8_MARGIN;
+}
+
+// angle between (x, y, z) and the x-y plane in [-90, 90] degrees; magnitude is |(x, y, z)| > 0
+static inline int windowOrientationTilt(float x, float y, float z, float magnitude)
+{
+    // the sqrtf is a single VSQRT.F32 on the M4F (built with -ffast-math), the
+    // asinf it replaces is a library call
+    int32_t a = atan2Q8(z, sqrtf(x * x + y * y));
+
+    if (angleQ8NearBoundary(a))
+        return (int)(asinf(z / magnitude) * RADIANS_TO_DEGREES);
+
+    return a / ANGLE_Q8(1);
+}
+
+// angle between the x-y projection of the up vector and the +y axis,
+// increasing clockwise, in [-180, 180] degrees
+static inline int windowOrientationAngle(float x, float y)
+{
+    int32_t a = -atan2Q8(-x, y);
+
+    if (angleQ8NearBoundary(a))
+        return (int)(-atan2f(-x, y) * RADIANS_TO_DEGREES);
+
+    return a / ANGLE_Q8(1);
+}
+
+#endif  // WINDOW_ORIENTATION_ANGLES_H__
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ACCEL_FEATURES_H__
+#define ACCEL_FEATURES_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sensors.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shared accelerometer feature extraction.
+ *
+ * Several sensors subscribe to the same accel stream and each used to walk every
+ * TripleAxisDataEvent rebuilding timestamps and deriving the same per-sample quantities on their
+ * own. This stage computes those once per sample: the first consumer of an event pays for it,
+ * every other consumer of the same event gets the cached result. Only the features a consumer
+ * asks for are computed, so users of the raw samples do not pay for the rest.
+ *
+ * All accel events are dispatched to every subscriber before the next one is dequeued, so a
+ * single cached event is enough. The features are stateless; filters that depend on how a
+ * consumer decimates the stream (e.g. window orientation's up vector) stay with that consumer.
+ */
+
+#define ACCEL_FEATURES_MAX_SAMPLES      16              // accel drivers send at most 15 per event
+
+// features beyond time and raw values, computed on request; each implies the ones it needs
+#define ACCEL_FEATURE_MAGNITUDE         0x01            // mag2, mag
+#define ACCEL_FEATURE_UNIT              0x02            // ux, uy, uz (and the magnitude)
+#define ACCEL_FEATURE_TILT              0x04            // tilt (and the unit vector)
+
+struct AccelFeatureSample {
+    uint64_t time;          // absolute sample time, ns
+    float x, y, z;          // raw sample, m/s^2
+    float mag2, mag;        // squared and plain magnitude
+    float ux, uy, uz;       // sample / mag, all 0 when mag is 0
+    float tilt;             // angle between the sample and the x-y plane, degrees in [-90, 90]
+};
+
+struct AccelFeatures {
+    uint32_t numSamples;
+    struct AccelFeatureSample samples[ACCEL_FEATURES_MAX_SAMPLES];
+};
+
+// returns times, raw values and the requested ACCEL_FEATURE_* of every sample in ev; computed on
+// first use of ev, cached afterwards
+const struct AccelFeatures *accelFeaturesGet(const struct TripleAxisDataEvent *ev, uint32_t features);
+// fills in the requested ACCEL_FEATURE_* of a sample that is not part of an event (resampled or
+// filtered data); x, y and z must be set
+void accelFeaturesCompute(struct AccelFeatureSample *f, uint32_t features);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ACCEL_FEATURES_H__
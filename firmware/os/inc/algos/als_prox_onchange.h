@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ALS_PROX_ONCHANGE_H__
+#define ALS_PROX_ONCHANGE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shared on-change engine for ALS/prox parts with hardware threshold interrupts.
+ *
+ * The sensor only needs to wake the hub when a reading is different enough from the last
+ * reported one to be worth an on-change event. This keeps a threshold window around the last
+ * reported raw count (a fraction of that count, but at least a fixed number of counts) that the
+ * driver programs into the part's interrupt low/high threshold registers, along with the
+ * hardware persistence filter where the part has one. Every sample the driver does get is run
+ * through alsProxOnChangeSample(), which re-centres the window when the sample is reportable.
+ * Parts that are polled (no interrupt line) can ask for the persistence filter in software.
+ *
+ * It also counts wakeups against the polling rate the driver would otherwise run at, so the
+ * driver can report how many wakeups the thresholds saved.
+ *
+ * Raw counts use the part's convention: an interrupt fires when count < low or count > high.
+ * An invalid window (low = maxCount, high = 0) makes every sample reportable.
+ */
+
+struct AlsProxOnChange {
+    uint64_t startTime;     // sensor enable time, for the wakeup accounting
+    uint32_t wakeups;       // samples handled since startTime
+    uint32_t reports;       // of those, samples that were outside the window
+    uint16_t low;           // current window; program these into the part
+    uint16_t high;
+    uint16_t maxCount;      // full scale of the thresholded channel
+    uint16_t relPermille;   // window half width, relative to the last reported count
+    uint16_t minDelta;      // window half width, minimum in counts
+    uint16_t pollMs;        // polling period the thresholds replace, 0 if the part is polled
+    uint8_t persistence;    // consecutive samples outside the window needed to report
+    uint8_t outside;
+    bool valid;
+};
+
+struct AlsProxOnChangeStats {
+    uint32_t elapsedMs;
+    uint32_t wakeups;
+    uint32_t reports;
+    uint32_t saved;         // polls at pollMs over elapsedMs that did not wake the hub
+};
+
+// persistence is the software filter; use 1 when the part filters in hardware
+void alsProxOnChangeInit(struct AlsProxOnChange *oc, uint16_t maxCount, uint16_t relPermille,
+                         uint16_t minDelta, uint16_t pollMs, uint8_t persistence);
+
+// sensor enabled: reset the accounting and invalidate the window
+void alsProxOnChangeStart(struct AlsProxOnChange *oc, uint64_t now);
+
+// next sample is reportable regardless of the window (e.g. after a gain change)
+void alsProxOnChangeInvalidate(struct AlsProxOnChange *oc);
+
+// account a wakeup for sample raw; returns true (and moves the window to raw) if it is reportable
+bool alsProxOnChangeSample(struct AlsProxOnChange *oc, uint16_t raw);
+
+// account a wakeup whose sample is thrown away (partial integration, gain change in flight)
+void alsProxOnChangeSkip(struct AlsProxOnChange *oc);
+
+void alsProxOnChangeGetStats(const struct AlsProxOnChange *oc, uint64_t now,
+                             struct AlsProxOnChangeStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ALS_PROX_ONCHANGE_H__
@@ -30,21 +30,38 @@ extern "C" {
  * avoiding communication latency jitter.
  *
  * It uses max of (apTime - hubTime) in a window, which is more consistent than average, to
- * establish mapping between ap timestamp and hub stamp. Additional low pass filtering is added
- * to further lowering jitter (it is not expected for two clocks to drift much in short time).
+ * establish mapping between ap timestamp and hub stamp. The window maxima of the last
+ * APHUB_SYNC_NUM_POINTS windows form the envelope of the exchanges; a line (offset + skew) is fitted
+ * through them, so the delta can be evaluated at any hub time and batched samples timestamped long
+ * before the last exchange still map correctly even though the two clocks drift apart.
  *
  * Max is slightly anti-intuitive here because difference is defined as apTime - hubTime. Max of
  * that is equivalent to min of hubTime - apTime, which corresponds to a packet that get delayed
- * by system scheduling minimally (closer to the more consistent hardware related latency).
+ * by system scheduling minimally (closer to the more consistent hardware related latency). Windows
+ * in which every exchange was delayed fall well below the line and are dropped from the fit.
  */
 
+#define APHUB_SYNC_NUM_POINTS   16
+
 struct ApHubSync {
     uint64_t lastTs;           // AP time of previous data point, used for control expiration
-    int64_t deltaEstimation;   // the estimated delta between two clocks, filtered.
 
     int64_t windowMax;         // track the maximum timestamp difference in a window
+    uint64_t windowMaxHubTime; // hub time at which windowMax was seen
     uint64_t windowTimeout;    // track window expiration time
     uint8_t state;             // internal state of the sync
+
+    // envelope points (window maxima), ring buffer
+    uint64_t pointHubTime[APHUB_SYNC_NUM_POINTS];
+    int64_t pointDelta[APHUB_SYNC_NUM_POINTS];
+    uint8_t numPoints;
+    uint8_t nextPoint;
+
+    // fitted model: delta(hubTime) = fitDelta + fitSkew * (hubTime - fitHubTime)
+    uint64_t fitHubTime;
+    int64_t fitDelta;
+    float fitSkew;
+    bool fitSkewValid;         // false while the model is a plain windowed max
 };
 
 // reset data structure
@@ -53,7 +70,7 @@ void apHubSyncReset(struct ApHubSync* sync);
 // add a data point (a pair of apTime and the corresponding hub time).
 void apHubSyncAddDelta(struct ApHubSync* sync, uint64_t apTime, uint64_t hubTime);
 
-// get the estimation of time delta
+// get the estimation of time delta (apTime - hubTime) at the given hub time
 int64_t apHubSyncGetDelta(struct ApHubSync* sync, uint64_t hubTime);
 
 #ifdef __cplusplus
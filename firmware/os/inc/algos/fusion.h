@@ -72,10 +72,15 @@ enum MagTrustMode {
     MANUAL_MAG_CAL   // right after a manual calibration
 };
 
+struct AccelFeatureSample;
+
 void initFusion(struct Fusion *fusion, uint32_t flags);
 
 void fusionHandleGyro(struct Fusion *fusion, const struct Vec3 *w, float dT);
 int fusionHandleAcc(struct Fusion *fusion, const struct Vec3 *a, float dT);
+// same, with the magnitude and unit vector of the sample already computed
+// (ACCEL_FEATURE_UNIT), so several fusion instances can share them
+int fusionHandleAccFeatures(struct Fusion *fusion, const struct AccelFeatureSample *a, float dT);
 int fusionHandleMag(struct Fusion *fusion, const struct Vec3 *m, float dT);
 
 // set trust mode of mag sensors depending on scenarios, see MagTrustMode
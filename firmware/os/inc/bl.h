@@ -32,7 +32,8 @@
 #define BL_SCAN_OFFSET      0x00000100
 
 #define BL_VERSION_1        1
-#define BL_VERSION_CUR      BL_VERSION_1
+#define BL_VERSION_2        2   /* starts the cycle counter at entry and counts flash writes, see blGetFlashGen */
+#define BL_VERSION_CUR      BL_VERSION_2
 
 #define BL _BL.api
 
@@ -75,6 +76,12 @@ struct BlApiTable {
 
     // extension: for binary compatibility, placed here
     uint32_t        (*blVerifyOsUpdate)(void);
+
+    //ver 2 bl supports:
+
+    // changes before every flash write or erase, whether made for the OS or for the host in the
+    // loader; kept in RAM the OS does not initialize, so it survives resets that keep RAM
+    uint32_t        (*blGetFlashGen)(void);
 };
 
 struct BlTable {
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BOOT_CACHE_H_
+#define _BOOT_CACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Verified boot cache and boot progress.
+ *
+ * Every boot checks the CRC of each external app segment before starting
+ * it. The cache remembers, in RAM that is not initialized at boot, which
+ * segments (address, length and stored CRC) passed that check. After a warm
+ * reset (software, pin or watchdog) a segment found in the cache is taken
+ * as checked; a cold boot drops the cache and checks everything again. The
+ * record is sealed with its own CRC, so RAM that lost its contents or an OS
+ * with a different layout does not pass for it.
+ *
+ * The record also holds the bootloader's flash generation (blGetFlashGen),
+ * which changes on every flash write or erase, including those the loader
+ * makes for the host. If it moved since the record was sealed, the whole
+ * cache is dropped. Writes the OS makes itself forget the entries they
+ * touch and then take the new generation with bootCacheFlashWritten().
+ *
+ * Boot phases are timestamped from bootloader entry and can be read by the
+ * host (NANOHUB_HAL_BOOT_STATS, "nanotool -x boot_stats").
+ */
+
+#define BOOT_CACHE_MAX_ENTRIES      16
+
+//values are part of the host protocol, see NANOHUB_HAL_BOOT_STATS
+enum BootPhase {
+    BOOT_PHASE_BL,              //bootloader done, OS entered
+    BOOT_PHASE_OS_INIT,         //platform and OS core set up
+    BOOT_PHASE_SERVICES,        //timers, sensors, syscalls, host interrupt and watchdog up
+    BOOT_PHASE_INT_APPS,        //internal apps started
+    BOOT_PHASE_EXT_APPS,        //external apps checked and started
+    BOOT_PHASE_READY,           //about to handle the first event
+
+    BOOT_PHASE_NUM
+};
+
+struct BootStats {
+    bool warm;                  //the cache survived the last reset
+    uint32_t appsChecked;       //segments whose CRC was computed
+    uint32_t appsCached;        //segments taken from the cache
+    uint32_t phaseUs[BOOT_PHASE_NUM]; //since bootloader entry; 0 if not reached or not timed
+};
+
+void bootCacheInit(bool warm);
+bool bootCacheCheck(const void *start, uint32_t len, uint32_t crc);
+void bootCacheAdd(const void *start, uint32_t len, uint32_t crc);
+void bootCacheForget(const void *start, uint32_t len);
+void bootCacheClear(void);
+void bootCacheFlashWritten(void);
+
+//first thing the OS does: closes the bootloader phase
+void bootPhaseStart(void);
+void bootPhaseMark(enum BootPhase phase);
+void bootStatsGet(struct BootStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -115,5 +115,7 @@ C_STATIC_ASSERT(uintptr_size, sizeof(uintptr_t) >= sizeof(uint32_t));
 void osChreApiExport(void);
 // release CHRE event and optionally call completion callback
 void osChreFreeEvent(uint32_t tid, void (*free_info)(uint16_t, void *), uint32_t evtType, void * evtData);
+// drop cached sensor subscriptions of an app; called after the sensor core released them
+void osChreSensorFreeAll(uint32_t tid);
 
 #endif
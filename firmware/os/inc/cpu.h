@@ -44,6 +44,14 @@ void cpuAppHandle(const struct AppHdr *appHdr, struct PlatAppInfo *platInfo, uin
 void cpuAppInvoke(const struct AppHdr *app, struct PlatAppInfo *platInfo,
                   void (*method)(uintptr_t, uintptr_t), uintptr_t arg1, uintptr_t arg2);
 
+/* app isolation, where the cpu and platform support it; a no-op otherwise */
+void cpuAppIsolationInit(void);                                 /* before any app is loaded, with interrupts on */
+bool cpuAppCanCall(const struct PlatAppInfo *platInfo);         /* false if the app may not be entered here; call it later from the main loop */
+
+/* free-running cycle counter for cpu time accounting; wraps around */
+uint32_t cpuGetCycles(void);
+uint32_t cpuGetCyclesPerUs(void);
+
 /* these default to false, there is CPU_NUM_PERSISTENT_RAM_BITS of them */
 bool cpuRamPersistentBitGet(uint32_t which);
 void cpuRamPersistentBitSet(uint32_t which, bool on);
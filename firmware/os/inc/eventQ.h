@@ -27,6 +27,7 @@
 #define EVENT_TYPE_BIT_DISCARDABLE               0x8000 /* set for events we can afford to lose */
 
 struct EvtQueue;
+struct PoolStats;
 
 typedef void (*EvtQueueForciblyDiscardEvtCbkF)(uint32_t evtType, void *evtData, TaggedPtr evtFreeData);
 
@@ -37,5 +38,7 @@ void evtQueueFree(struct EvtQueue* q);
 bool evtQueueEnqueue(struct EvtQueue* q, uint32_t evtType, void *evtData, TaggedPtr evtFreeData, bool atFront /* do not set this unless you know the repercussions. read: never set this in new code */);
 bool evtQueueDequeue(struct EvtQueue* q, uint32_t *evtTypeP, void **evtDataP, TaggedPtr *evtFreeDataP, bool sleepIfNone);
 void evtQueueRemoveAllMatching(struct EvtQueue* q,  bool (*match)(uint32_t evtType, const void *data, void *context), void *context);
+uint32_t evtQueueGetCount(struct EvtQueue* q);
+void evtQueueGetStats(struct EvtQueue* q, struct PoolStats *stats, bool reset); //see poolStats.h
 
 #endif
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FAST_MATH_H_
+#define _FAST_MATH_H_
+
+#include <stdint.h>
+#include <math.h>
+
+/*
+ * Approximate single precision math for per-sample sensor code.
+ *
+ * These are not drop-in replacements for libm: there is no errno, no special
+ * handling of inf/nan, and the argument ranges below are assumed. The error
+ * bounds are absolute and include float rounding. os/core/host/fast_math_check.c
+ * checks them against double precision libm over the whole stated range on
+ * the build host; app/test2.app compares against the fdlibm versions in
+ * lib/libm on the hub, over [-pi, pi] for the trig functions, and times both.
+ *
+ *   fastSqrtf(x)      x >= 0               exact (IEEE sqrt; VSQRT on M4)
+ *   fastSinf(x)       |x| <= 8192          < 1.5e-7 (measured 9.2e-8)
+ *   fastCosf(x)       |x| <= 8192          < 1.5e-7 (measured 9.1e-8)
+ *   fastSinCosf(x)    |x| <= 8192          < 1.5e-7 (one range reduction)
+ *   fastAtan2f(y, x)  finite, not both 0   < 1.2e-5 rad (measured 1.17e-5;
+ *                                          y = -0, x < 0 gives pi, not -pi)
+ *   fastAsinf(x)      |x| <= 1             < 3.5e-7 rad (measured 2.9e-7;
+ *                                          |x| > 1 clamps)
+ */
+
+#define FAST_MATH_PI            3.14159265358979f
+#define FAST_MATH_PI_2          1.57079632679490f
+#define FAST_MATH_2_PI          0.63661977236758f
+
+// pi/2 split so that k * FAST_MATH_PI_2_A and k * FAST_MATH_PI_2_B are exact
+// for |k| <= 8192 (Cody-Waite reduction)
+#define FAST_MATH_PI_2_A        1.5703125f
+#define FAST_MATH_PI_2_B        4.837512969970703125e-4f
+#define FAST_MATH_PI_2_C        7.54978995489188216e-8f
+
+static inline float fastSqrtf(float x)
+{
+#if defined(__arm__) && defined(__ARM_FP)
+    float ret;
+
+    asm(
+        "vsqrt.f32 %0, %1"
+        : "=w" (ret)
+        : "w" (x)
+    );
+
+    return ret;
+#else
+    return sqrtf(x);
+#endif
+}
+
+// minimax polynomials for |r| <= pi/4 (cephes sinf/cosf coefficients)
+static inline float fastSinPoly(float r, float z)
+{
+    return r + r * z * ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f);
+}
+
+static inline float fastCosPoly(float z)
+{
+    return 1.0f - 0.5f * z + z * z * ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f);
+}
+
+// reduce x to r in [-pi/4, pi/4], returning the quadrant (x = q * pi/2 + r)
+static inline uint32_t fastTrigReduce(float x, float *r)
+{
+    int32_t k = (int32_t)(x * FAST_MATH_2_PI + (x >= 0.0f ? 0.5f : -0.5f));
+    float kf = (float)k;
+
+    *r = ((x - kf * FAST_MATH_PI_2_A) - kf * FAST_MATH_PI_2_B) - kf * FAST_MATH_PI_2_C;
+
+    return (uint32_t)k & 3;
+}
+
+static inline void fastSinCosf(float x, float *sinP, float *cosP)
+{
+    float r, z, s, c;
+    uint32_t q = fastTrigReduce(x, &r);
+
+    z = r * r;
+    s = fastSinPoly(r, z);
+    c = fastCosPoly(z);
+
+    switch (q) {
+    case 0:
+        *sinP = s;
+        *cosP = c;
+        break;
+    case 1:
+        *sinP = c;
+        *cosP = -s;
+        break;
+    case 2:
+        *sinP = -s;
+        *cosP = -c;
+        break;
+    default:
+        *sinP = -c;
+        *cosP = s;
+        break;
+    }
+}
+
+static inline float fastSinf(float x)
+{
+    float r;
+    uint32_t q = fastTrigReduce(x, &r);
+    float v = (q & 1) ? fastCosPoly(r * r) : fastSinPoly(r, r * r);
+
+    return (q & 2) ? -v : v;
+}
+
+static inline float fastCosf(float x)
+{
+    float r;
+    uint32_t q = fastTrigReduce(x, &r);
+    float v = (q & 1) ? fastSinPoly(r, r * r) : fastCosPoly(r * r);
+
+    return ((q + 1) & 2) ? -v : v;
+}
+
+static inline float fastAtan2f(float y, float x)
+{
+    float ax = fabsf(x), ay = fabsf(y);
+    float t, z, a;
+
+    if (!(ax > 0.0f || ay > 0.0f))
+        return 0.0f;
+
+    // atan(t) for 0 <= t <= 1 (Abramowitz & Stegun 4.4.47)
+    t = ax >= ay ? ay / ax : ax / ay;
+    z = t * t;
+    a = t * (0.9998660f + z * (-0.3302995f + z * (0.1801410f + z * (-0.0851330f + z * 0.0208351f))));
+
+    if (ay > ax)
+        a = FAST_MATH_PI_2 - a;
+    if (x < 0.0f)
+        a = FAST_MATH_PI - a;
+
+    return y < 0.0f ? -a : a;
+}
+
+static inline float fastAsinf(float x)
+{
+    float ax = fabsf(x);
+    float a;
+
+    if (ax >= 1.0f) {
+        a = FAST_MATH_PI_2;
+    } else {
+        // asin(x) for 0 <= x <= 1 (Abramowitz & Stegun 4.4.46)
+        a = 1.5707963050f + ax * (-0.2145988016f + ax * (0.0889789874f + ax * (-0.0501743046f +
+            ax * (0.0308918810f + ax * (-0.0170881256f + ax * (0.0066700901f + ax * -0.0012624911f))))));
+        a = FAST_MATH_PI_2 - fastSqrtf(1.0f - ax) * a;
+    }
+
+    return x < 0.0f ? -a : a;
+}
+
+#endif
@@ -31,6 +31,17 @@ int heapFreeAll(uint32_t tid);
 int heapGetFreeSize(int *numChunks, int *largestChunk);
 int heapGetTaskSize(uint32_t tid);
 
+/*
+ * Isolated apps may only write RAM set aside for them (see cpuAppIsolationInit).
+ * heapInitApps() takes [start, start + size) from the free end of the heap for
+ * a second heap; anything past it is left to the caller. heapAllocApp()
+ * allocates there (or from the main heap without isolation) for memory apps
+ * write: their data segments and what their syscalls ask for. heapAlloc()
+ * always uses the main heap. heapFree() and the rest work on both heaps.
+ */
+bool heapInitApps(void *start, uint32_t size);
+void* heapAllocApp(uint32_t sz);
+
 #ifdef __cplusplus
 }
 #endif
@@ -83,4 +83,12 @@ void hostIntfSetBusy(bool busy);
 void hostIntfRxPacket(bool wakeupActive);
 void hostIntfTxAck(void *buffer, uint8_t len);
 
+/* Responses can be built ahead of time in the spare transmit frame and put
+ * on the wire by swapping frames instead of copying them in (hostIntfTxAck).
+ * Only the owner of the spare frame may write to it; a fast handler that
+ * swaps must not touch the payload pointer it was given afterwards. */
+void *hostIntfGetSpareTxPayload(void);
+void hostIntfSwapTxBuf(void);
+void hostIntfTxAckSpare(uint8_t len);
+
 #endif /* __HOSTINTF_H */
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOAD_GOVERNOR_H_
+#define _LOAD_GOVERNOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Load governor.
+ *
+ * Once per window the OS looks at how much of the time the CPU was awake,
+ * how many events are waiting in the OS queue and how much data was lost
+ * (OS event queue or private event slab full, host output queue refusing a
+ * buffer). Batches the host output queue overwrites to make room, as it does
+ * for non-wakeup sensors while the AP sleeps, are not lost data. A hub that
+ * stays overloaded sheds work one level at a time, and gets it back one
+ * level at a time after it has been calm for a while:
+ *
+ *   LOAD_LEVEL_THROTTLE   sensors marked SENSOR_INFO_FLAGS1_THROTTLE run at
+ *                         about half the rate asked for
+ *   LOAD_LEVEL_DEFER_CAL  calibration requests wait, drivers skip runtime
+ *                         calibration updates (sensorCalDeferred())
+ *   LOAD_LEVEL_OVERLOAD   the host is told (unsolicited NANOHUB_HAL_LOAD_STATS)
+ *
+ * The windows are timed from the main loop, so an idle hub is not woken up
+ * for this; a timer only runs while some level is in effect.
+ */
+
+//values are part of the host protocol, see NANOHUB_HAL_LOAD_STATS
+enum LoadLevel {
+    LOAD_LEVEL_NORMAL,
+    LOAD_LEVEL_THROTTLE,
+    LOAD_LEVEL_DEFER_CAL,
+    LOAD_LEVEL_OVERLOAD,
+
+    LOAD_LEVEL_NUM
+};
+
+struct LoadStats {
+    uint8_t level;              //enum LoadLevel
+    uint8_t busy;               //% of the last window the CPU was awake
+    uint32_t pending;           //events queued at the end of the last window
+    uint32_t drops;             //since boot
+    uint32_t changes;           //level changes since boot
+    uint64_t levelTime[LOAD_LEVEL_NUM]; //ns spent at each level
+};
+
+void loadGovInit(void);
+void loadGovPoll(void);         //called by the OS after every event
+void loadGovReportDrop(void);   //any context
+void loadGovGetStats(struct LoadStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
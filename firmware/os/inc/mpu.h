@@ -33,6 +33,8 @@ void mpuStart(void);
 void mpuAllowRamExecution(bool allowSvcExecute);         /* for Supervisor only, if possible */
 void mpuAllowRomWrite(bool allowSvcWrite);     /* for Supervisor only, if possible */
 void mpuShow(void);
+void *mpuGetAppRam(uint32_t *sizeP);                  /* RAM isolated apps may write, NULL if none */
+bool mpuSetGuard(void *start, uint32_t size);         /* no access at all, e.g. below a stack; size is a power of 2 of at least 32, start aligned to it */
 
 
 #ifdef __cplusplus
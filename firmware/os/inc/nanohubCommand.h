@@ -17,6 +17,7 @@
 #ifndef __NANOHUBCOMMAND_H
 #define __NANOHUBCOMMAND_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #define NANOHUB_FAST_DONT_ACK       0xFFFFFFFE
@@ -28,6 +29,7 @@ struct NanohubCommand {
     uint32_t (*handler)(void *, uint8_t, void *, uint64_t);
     uint8_t minDataLen;
     uint8_t maxDataLen;
+    bool queueable; // handler may run as a NANOHUB_REASON_FLAG_QUEUE job; must not touch hostIntf tx state
 };
 
 void nanohubInitCommand(void);
@@ -49,6 +51,7 @@ struct NanohubHalCommand {
 };
 
 const struct NanohubHalCommand *nanohubHalFindCommand(uint8_t msg);
+void nanohubHalSendLoadStats(uint32_t transactionId);
 uint64_t hostGetTime(void);
 int64_t hostGetTimeDelta(void);
 
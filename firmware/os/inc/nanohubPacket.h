@@ -77,10 +77,38 @@ static inline struct NanohubPacketFooter *nanohubGetPacketFooter(struct NanohubP
 #define NANOHUB_INT_WAKEUP            1
 #define NANOHUB_INT_NONWAKEUP         2
 #define NANOHUB_INT_CMD_WAIT          3
+#define NANOHUB_INT_RESPONSE          4
 
 #define NANOHUB_REASON_ACK                    0x00000000
 #define NANOHUB_REASON_NAK                    0x00000001
 #define NANOHUB_REASON_NAK_BUSY               0x00000002
+#define NANOHUB_REASON_ACK_QUEUED             0x00000003
+
+/**
+ * PIPELINED REQUESTS
+ *
+ * A request whose reason has NANOHUB_REASON_FLAG_QUEUE set does not hold
+ * the bus while it is handled: unless it can be answered right away, it is
+ * acknowledged with NANOHUB_REASON_ACK_QUEUED (same payload as
+ * NANOHUB_REASON_ACK) and runs in the background, so other requests (e.g.
+ * NANOHUB_REASON_READ_EVENT) can be sent while it is in progress. Up to
+ * NANOHUB_QUEUED_MAX requests may be queued; more get NANOHUB_REASON_NAK_BUSY.
+ * Only NANOHUB_REASON_GET_APP_VERSIONS, NANOHUB_REASON_QUERY_APP_INFO,
+ * NANOHUB_REASON_FIRMWARE_CHUNK and NANOHUB_REASON_FINISH_FIRMWARE_UPLOAD may
+ * be queued; any other request with the flag set gets NANOHUB_REASON_NAK
+ * (NANOHUB_REASON_WRITE_EVENT is always answered right away).
+ *
+ * NANOHUB_INT_RESPONSE is set while finished responses are waiting. Each
+ * NANOHUB_REASON_GET_RESPONSE returns one of them, in any order, as the packet
+ * the request would have got (the request's seq and reason, flag cleared).
+ * With nothing finished it gets NANOHUB_REASON_NAK_BUSY, or NANOHUB_REASON_NAK
+ * if nothing is queued either.
+ */
+
+#define NANOHUB_REASON_FLAG_QUEUE             0x80000000
+#define NANOHUB_QUEUED_MAX                    4
+
+#define NANOHUB_REASON_GET_RESPONSE           0x00001010
 
 /**
  * INFORMATIONAL
@@ -490,6 +518,9 @@ SET_PACKED_STRUCT_MODE_OFF
 #define NANOHUB_HAL_APP_INFO_BSS            0x08
 #define NANOHUB_HAL_APP_INFO_CHRE_MAJOR     0x09
 #define NANOHUB_HAL_APP_INFO_CHRE_MINOR     0x0A
+#define NANOHUB_HAL_APP_INFO_CPU_TIME       0x0B /* cumulative, in us */
+#define NANOHUB_HAL_APP_INFO_CPU_MAX        0x0C /* longest single entry, in us */
+#define NANOHUB_HAL_APP_INFO_EVT_COUNT      0x0D
 #define NANOHUB_HAL_APP_INFO_END            0xFF
 
 SET_PACKED_STRUCT_MODE_ON
@@ -587,4 +618,134 @@ struct NanohubHalFinishUploadTx {
 } ATTRIBUTE_PACKED;
 SET_PACKED_STRUCT_MODE_OFF
 
+#define NANOHUB_HAL_SLEEP_STATS         0x19
+
+#define NANOHUB_HAL_SLEEP_STATS_RESET       0x01 /* clear the stats once this response is built */
+
+SET_PACKED_STRUCT_MODE_ON
+struct NanohubHalSleepStatsRx {
+    uint8_t offset;
+    uint8_t flags;
+} ATTRIBUTE_PACKED;
+SET_PACKED_STRUCT_MODE_OFF
+
+#define NANOHUB_HAL_SLEEP_STAT_ELAPSED      0x00 /* count: sleeps, time: since reset */
+#define NANOHUB_HAL_SLEEP_STAT_STATE        0x01 /* index: sleep state, time: residency */
+#define NANOHUB_HAL_SLEEP_STAT_WAKE         0x02 /* index: wake reason, time: sleep it ended */
+#define NANOHUB_HAL_SLEEP_STAT_WAKE_LINE    0x03 /* index: interrupt line, time: sleep it ended */
+#define NANOHUB_HAL_SLEEP_STAT_PREDICT      0x04 /* index: 0 timed, 1 untimed; time: sum of prediction errors */
+
+#define NANOHUB_HAL_SLEEP_WAKE_OTHER        0x00
+#define NANOHUB_HAL_SLEEP_WAKE_TIMER        0x01
+#define NANOHUB_HAL_SLEEP_WAKE_HOST         0x02
+#define NANOHUB_HAL_SLEEP_WAKE_DMA          0x03
+#define NANOHUB_HAL_SLEEP_WAKE_LINE         0x04
+
+SET_PACKED_STRUCT_MODE_ON
+struct NanohubHalSleepStat {
+    uint8_t type;
+    uint8_t index;
+    __le32 count;
+    __le64 time; /* ns */
+} ATTRIBUTE_PACKED;
+SET_PACKED_STRUCT_MODE_OFF
+
+#define NANOHUB_HAL_SLEEP_STATS_MAX         8
+
+SET_PACKED_STRUCT_MODE_ON
+struct NanohubHalSleepStatsTx {
+    struct NanohubHalHdr hdr;
+    struct NanohubHalRet ret;
+    uint8_t total;
+    uint8_t offset;
+    uint8_t count;
+    struct NanohubHalSleepStat stats[NANOHUB_HAL_SLEEP_STATS_MAX];
+} ATTRIBUTE_PACKED;
+SET_PACKED_STRUCT_MODE_OFF
+
+#define NANOHUB_HAL_BOOT_STATS          0x1A
+
+#define NANOHUB_HAL_BOOT_STATS_WARM         0x01 /* apps checked before the last reset were not checked again */
+
+#define NANOHUB_HAL_BOOT_PHASE_BL           0x00 /* 0 if the bootloader does not time itself */
+#define NANOHUB_HAL_BOOT_PHASE_OS_INIT      0x01
+#define NANOHUB_HAL_BOOT_PHASE_SERVICES     0x02
+#define NANOHUB_HAL_BOOT_PHASE_INT_APPS     0x03
+#define NANOHUB_HAL_BOOT_PHASE_EXT_APPS     0x04
+#define NANOHUB_HAL_BOOT_PHASE_READY        0x05
+#define NANOHUB_HAL_BOOT_PHASE_MAX          8
+
+SET_PACKED_STRUCT_MODE_ON
+struct NanohubHalBootStatsTx {
+    struct NanohubHalHdr hdr;
+    struct NanohubHalRet ret;
+    uint8_t flags;
+    uint8_t numPhases;
+    __le16 appsChecked;
+    __le16 appsCached;
+    __le32 phaseUs[NANOHUB_HAL_BOOT_PHASE_MAX]; /* since bootloader entry, only numPhases are sent */
+} ATTRIBUTE_PACKED;
+SET_PACKED_STRUCT_MODE_OFF
+
+#define NANOHUB_HAL_LOAD_STATS          0x1B /* also sent unsolicited (transactionId 0) on entering or leaving overload */
+
+#define NANOHUB_HAL_LOAD_LEVEL_NORMAL       0x00
+#define NANOHUB_HAL_LOAD_LEVEL_THROTTLE     0x01 /* optional sensors run slower */
+#define NANOHUB_HAL_LOAD_LEVEL_DEFER_CAL    0x02 /* and calibration is deferred */
+#define NANOHUB_HAL_LOAD_LEVEL_OVERLOAD     0x03 /* and the host has been told */
+#define NANOHUB_HAL_LOAD_LEVEL_MAX          4
+
+SET_PACKED_STRUCT_MODE_ON
+struct NanohubHalLoadStatsTx {
+    struct NanohubHalHdr hdr;
+    struct NanohubHalRet ret;
+    uint8_t level;
+    uint8_t busy;       /* % of the last window the CPU was awake */
+    __le16 pending;     /* events queued at the end of the last window */
+    __le32 drops;       /* events or host data lost since boot */
+    __le32 changes;     /* level changes since boot */
+    uint8_t numLevels;
+    __le64 levelTime[NANOHUB_HAL_LOAD_LEVEL_MAX]; /* ns at each level, only numLevels are sent */
+} ATTRIBUTE_PACKED;
+SET_PACKED_STRUCT_MODE_OFF
+
+#define NANOHUB_HAL_POOL_STATS          0x1C
+
+#define NANOHUB_HAL_POOL_STATS_RESET        0x01 /* restart peaks and clear counters once this response is built */
+
+SET_PACKED_STRUCT_MODE_ON
+struct NanohubHalPoolStatsRx {
+    uint8_t flags;
+} ATTRIBUTE_PACKED;
+SET_PACKED_STRUCT_MODE_OFF
+
+#define NANOHUB_HAL_POOL_OS_EVENTS          0x00
+#define NANOHUB_HAL_POOL_OS_MISC            0x01
+#define NANOHUB_HAL_POOL_TIMER_EVENTS       0x02
+#define NANOHUB_HAL_POOL_SENSOR_EVENTS      0x03
+#define NANOHUB_HAL_POOL_SENSOR_REQUESTS    0x04
+#define NANOHUB_HAL_POOL_HOST_OUTPUT        0x05
+
+SET_PACKED_STRUCT_MODE_ON
+struct NanohubHalPoolStat {
+    uint8_t id;
+    __le16 size;
+    __le16 used;
+    __le16 peak;
+    __le32 fails;
+    __le32 discards;
+} ATTRIBUTE_PACKED;
+SET_PACKED_STRUCT_MODE_OFF
+
+#define NANOHUB_HAL_POOL_STATS_MAX          8
+
+SET_PACKED_STRUCT_MODE_ON
+struct NanohubHalPoolStatsTx {
+    struct NanohubHalHdr hdr;
+    struct NanohubHalRet ret;
+    uint8_t count;
+    struct NanohubHalPoolStat stats[NANOHUB_HAL_POOL_STATS_MAX];
+} ATTRIBUTE_PACKED;
+SET_PACKED_STRUCT_MODE_OFF
+
 #endif /* __NANOHUBPACKET_H */
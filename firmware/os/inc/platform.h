@@ -41,6 +41,9 @@ void platPeriodic(void);
 // free all platform-specific resources for TID, and return non-zero status if some cleanup was done
 uint32_t platFreeResources(uint32_t tid);
 
+// true if RAM kept its contents across the last reset (not a power on or brown out)
+bool platIsWarmReset(void);
+
 /* Logging */
 void *platLogAllocUserData();
 void platLogFlush(void *userData);
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _POOL_STATS_H_
+#define _POOL_STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Occupancy of the OS's fixed size pools.
+ *
+ * Slab allocators, event queues and simple queues count how many entries
+ * are in use, the most that ever were (since the last reset), how many
+ * allocations failed and how many queued entries were thrown away to make
+ * room. The OS registers the pools it owns under a fixed id, and the host
+ * reads them all back at once (NANOHUB_HAL_POOL_STATS, "nanotool -x
+ * pool_stats").
+ */
+
+//values are part of the host protocol, see NANOHUB_HAL_POOL_*
+enum PoolId {
+    POOL_OS_EVENTS,             //seos event queue
+    POOL_OS_MISC,               //seos deferred calls, subscriptions, private events
+    POOL_TIMER_EVENTS,          //timer events for apps
+    POOL_SENSOR_EVENTS,         //sensors internal events and app setRate() calls
+    POOL_SENSOR_REQUESTS,       //sensors client requests
+    POOL_HOST_OUTPUT,           //hostIntf data blocks waiting for the host
+
+    POOL_NUM
+};
+
+struct PoolStats {
+    uint32_t size;              //entries the pool can hold
+    uint32_t used;
+    uint32_t peak;              //most entries used at once since the last reset
+    uint32_t fails;             //allocations or enqueues refused
+    uint32_t discards;          //queued entries dropped to make room for new ones
+};
+
+struct SlabAllocator;
+struct EvtQueue;
+struct SimpleQueue;
+
+void poolStatsAddSlab(enum PoolId id, struct SlabAllocator *slab);
+void poolStatsAddEvtQueue(enum PoolId id, struct EvtQueue *q);
+void poolStatsAddSimpleQueue(enum PoolId id, struct SimpleQueue *sq);
+
+//false for a pool that was never registered; reset restarts peak from current use and clears the counters
+bool poolStatsGet(enum PoolId id, struct PoolStats *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -190,6 +190,10 @@ enum SensorInfoFlags1 {
     // Indicates that this sensor's events are for local consumption within the
     // hub only, i.e. they should not be transmitted to the host
     SENSOR_INFO_FLAGS1_LOCAL_ONLY = (1 << 2),
+
+    // Indicates that this sensor may run slower than its clients asked for
+    // while the hub is overloaded (see loadGovernor.h)
+    SENSOR_INFO_FLAGS1_THROTTLE = (1 << 3),
 };
 
 struct SensorInfo {
@@ -202,6 +206,9 @@ struct SensorInfo {
        should only be sent on data changes, regardless of any underlying
        sampling rate. In this case, the sensorSendOneDirectEvt callback will be
        invoked on each call to sensorRequest() to send new clients initial data.
+       For NUM_AXIS_EMBEDDED sensors the core remembers the last broadcast
+       event (if it carried no free callback) and sends that instead; the
+       callback is then only used until the sensor reports after powering on.
 
        If SENSOR_RATE_ONDEMAND is included in this list, then the
        sensorTriggerOndemand callback must be implemented.
@@ -248,6 +255,8 @@ struct SensorInfo {
  * sensors module api
  */
 bool sensorsInit(void);
+void sensorsSetThrottle(bool throttle);
+void sensorsSetCalDeferred(bool defer);
 
 /*
  * Api for sensor drivers
@@ -261,6 +270,7 @@ uint32_t sensorRegisterAsApp(const struct SensorInfo *si, uint32_t tid, void *ca
 bool sensorRegisterInitComplete(uint32_t handle);
 bool sensorUnregister(uint32_t handle); /* your job to be sure it is off already */
 bool sensorSignalInternalEvt(uint32_t handle, uint32_t intEvtNum, uint32_t value1, uint64_t value2);
+bool sensorCalDeferred(void); /* hub is overloaded: skip optional runtime calibration work */
 
 #define sensorGetMyEventType(_sensorType) (EVT_NO_FIRST_SENSOR_EVENT + (_sensorType))
 #define sensorGetMyCfgEventType(_sensorType) (EVT_NO_SENSOR_CONFIG_EVENT + (_sensorType))
@@ -28,9 +28,14 @@ struct Sensor {
     uint32_t currentRate;    /* here 0 means off */
     TaggedPtr callInfo;      /* pointer to ops struct or app tid */
     void *callData;
+    uint32_t cfgSeq;         /* bumped on every client request change; lets callers cache derived state */
     uint32_t initComplete:1; /* sensor finished initializing */
     uint32_t hasOnchange :1; /* sensor supports onchange and wants to be notified to send new clients current state */
     uint32_t hasOndemand :1; /* sensor supports ondemand and wants to get triggers */
+    uint32_t cachesOnchange :1; /* onchange with embedded data: new clients are answered from lastOnchange */
+    uint32_t calPending :1;  /* calibration asked for while deferred */
+    void *lastOnchange;      /* last onchange event data broadcast by the sensor */
+    bool lastOnchangeValid;  /* not a bitfield: written from whatever context the sensor broadcasts in */
 };
 
 struct SensorsInternalEvent {
@@ -73,4 +78,7 @@ struct SensorsClientRequest {
 
 struct Sensor* sensorFindByHandle(uint32_t handle);
 
+// called by the OS for every broadcast sensor event that carries no data to free
+void sensorCacheOnchangeEvt(uint32_t originTid, uint32_t evtType, void *evtData);
+
 #endif // __SENSORS_PRIV_H__
@@ -72,6 +72,15 @@ struct Task {
     uint8_t  flags;
     uint8_t  ioCount;
 
+    /* cpu accounting, in cpuGetCycles() units; time spent in nested calls into other tasks is excluded */
+    uint64_t cpuCycles;
+    uint32_t cpuCyclesMax; /* longest single entry into the task */
+    uint32_t evtCount;     /* events handled */
+};
+
+struct TaskCpuMark {
+    uint32_t start;
+    uint32_t nested;
 };
 
 struct I2cEventData {
@@ -107,6 +116,12 @@ union SeosInternalSlabData {
         uint16_t fromTid;
         uint16_t toTid;
     } privateEvt;
+    struct {
+        uintptr_t method;   /* 0: EVT_APP_FREE_EVT_DATA */
+        uintptr_t arg1;
+        uintptr_t arg2;
+        uint16_t tid;
+    } appCall;
     union OsApiSlabItem osApiItem;
 };
 
@@ -120,6 +135,9 @@ void osTaskAbort(struct Task *task);
 void osTaskInvokeMessageFreeCallback(struct Task *task, void (*freeCallback)(void *, size_t), void *message, uint32_t messageSize);
 void osTaskInvokeEventFreeCallback(struct Task *task, void (*freeCallback)(uint16_t, void *), uint16_t event, void *data);
 void osChreTaskHandle(struct Task *task, uint32_t evtType, const void *evtData);
+void osTaskCpuBegin(struct TaskCpuMark *mark);
+void osTaskCpuEnd(struct Task *task, struct TaskCpuMark *mark);
+uint32_t osGetPendingEvents(void);
 
 static inline bool osTaskIsChre(const struct Task *task)
 {
@@ -24,6 +24,8 @@
 
 #define SIMPLE_QUEUE_MAX_ELEMENTS 0x0FFFFFFE
 
+struct PoolStats;
+
 typedef bool (*SimpleQueueForciblyDiscardCbkF)(void *data, bool onDelete); //return false to reject
 
 //SINGLE producer, SINGLE consumer queue. data is copied INTO/OUT of the queue by simpleQueueEnqueue/simpleQueueDequeue
@@ -32,6 +34,7 @@ struct SimpleQueue* simpleQueueAlloc(uint32_t numEntries, uint32_t entrySz, Simp
 void simpleQueueDestroy(struct SimpleQueue* sq); //will call discard, but in no particular order!
 bool simpleQueueEnqueue(struct SimpleQueue* sq, const void *data, int length, bool possiblyDiscardable);
 bool simpleQueueDequeue(struct SimpleQueue* sq, void *dataVal);
+void simpleQueueGetStats(struct SimpleQueue* sq, struct PoolStats *stats, bool reset); //see poolStats.h
 
 
 #endif
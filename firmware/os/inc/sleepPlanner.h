@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _SLEEP_PLANNER_H_
+#define _SLEEP_PLANNER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Picks the sleep state for an idle period.
+ *
+ * The platform describes its sleep states with a SleepPlannerOption each
+ * (usually embedded in its own table, hence the stride) and keeps doing the
+ * register work itself. Among the states that meet the timer, jitter, drift
+ * and device wakeup constraints, the planner takes the one with the lowest
+ * expected energy for the predicted idle length: the cost of entering and
+ * leaving the state plus its draw for the time spent in it. The predictor
+ * scales the time to the next timer by how much of it recent timed idle
+ * periods actually lasted, and keeps a running average for untimed ones.
+ *
+ * None of this touches hardware, so it also builds on the host, where
+ * os/core/host/sleep_planner_sim.c replays recorded idle traces against a
+ * power model.
+ */
+
+#define SLEEP_PLANNER_MAX_IDLE      (1ULL << 40) //ns, ~18 minutes; longer is all the same
+
+struct SleepPlannerOption {
+    uint64_t resolution;        //ns per tick of the clock that wakes us
+    uint32_t maxCounter;        //ticks that clock can count
+    uint32_t jitterPpm;
+    uint32_t driftPpm;
+    uint32_t maxWakeupTime;     //ns from wakeup event to running code
+    uint32_t devsAvail;         //devices that keep working in this state
+    uint32_t powerUw;           //draw while in the state
+    uint32_t transitionNj;      //energy to enter and leave the state
+};
+
+struct SleepPlannerRequest {
+    uint64_t timerLength;       //ns until the next timer, 0 if none is set
+    uint64_t predictedIdle;     //ns, from sleepPlannerPredict()
+    uint32_t maxJitterPpm;
+    uint32_t maxDriftPpm;
+    uint32_t devsToKeepAlive;
+    uint32_t numDevs;
+    const uint32_t *devsMaxWakeTime; //per device: the wakeup time it tolerates, ns
+};
+
+struct SleepPlannerHistory {
+    uint64_t untimedIdle;       //ns, running average; 0 if none seen yet
+    uint32_t timedRatio;        //Q10 running average of slept / timer length
+};
+
+void sleepPlannerInit(struct SleepPlannerHistory *hist);
+uint64_t sleepPlannerPredict(const struct SleepPlannerHistory *hist, uint64_t timerLength);
+void sleepPlannerRecord(struct SleepPlannerHistory *hist, uint64_t timerLength, uint64_t slept);
+
+//*tooShort is set if the state cannot sleep for the whole timer length
+bool sleepPlannerUsable(const struct SleepPlannerOption *opt, const struct SleepPlannerRequest *req, bool *tooShort);
+
+//in uW * ns (fJ); idle is clamped to SLEEP_PLANNER_MAX_IDLE
+uint64_t sleepPlannerEnergy(const struct SleepPlannerOption *opt, uint64_t idle);
+
+//index of the state to use, or -1 if none is usable
+int32_t sleepPlannerPick(const struct SleepPlannerOption *opts, uint32_t numOpts, size_t stride, const struct SleepPlannerRequest *req);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _SLEEP_STATS_H_
+#define _SLEEP_STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Sleep residency and wakeup accounting.
+ *
+ * The platform reports every sleep with the state it used, what woke it up
+ * and how long it lasted; the host reads the totals back as a flat list of
+ * SleepStat records (NANOHUB_HAL_SLEEP_STATS, "nanotool -x sleep_stats").
+ */
+
+#define SLEEP_STATS_MAX_STATES      8
+#define SLEEP_STATS_MAX_LINES       16
+
+enum SleepWakeReason {
+    SLEEP_WAKE_OTHER,
+    SLEEP_WAKE_TIMER,
+    SLEEP_WAKE_HOST,
+    SLEEP_WAKE_DMA,
+    SLEEP_WAKE_LINE,            //external interrupt line, also counted per line
+
+    SLEEP_WAKE_NUM
+};
+
+//values are part of the host protocol, see NANOHUB_HAL_SLEEP_STAT_*
+enum SleepStatType {
+    SLEEP_STAT_ELAPSED,         //count: sleeps, time: since the last reset
+    SLEEP_STAT_STATE,           //index: platform sleep state, time: residency
+    SLEEP_STAT_WAKE,            //index: enum SleepWakeReason, time: sleep ended by it
+    SLEEP_STAT_WAKE_LINE,       //index: external interrupt line, time: sleep ended by it
+    SLEEP_STAT_PREDICT,         //index: 0 with a timer set, 1 without; time: sum of |predicted - slept|
+};
+
+struct SleepStat {
+    uint8_t type;
+    uint8_t index;
+    uint32_t count;
+    uint64_t time;              //ns
+};
+
+void sleepStatsReset(void);
+void sleepStatsRecord(uint32_t state, enum SleepWakeReason reason, uint32_t line,
+                      uint64_t timerLength, uint64_t predicted, uint64_t slept);
+uint64_t sleepStatsGetSlept(uint32_t *sleepsP); //ns and sleeps since boot, for rates
+
+uint32_t sleepStatsCount(void);
+bool sleepStatsGet(uint32_t idx, struct SleepStat *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -21,9 +21,9 @@
 extern "C" {
 #endif
 
-void wdtInit(){}
-void wdtEnableClk(){}
-void wdtDisableClk(){}
+static inline void wdtInit(void) {}
+static inline void wdtEnableClk(void) {}
+static inline void wdtDisableClk(void) {}
 
 #ifdef __cplusplus
 }
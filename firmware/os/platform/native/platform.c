@@ -60,6 +60,11 @@ uint64_t platGetTicks(void)
     return 0;
 }
 
+bool platIsWarmReset(void)
+{
+    return false;
+}
+
 uint32_t platFreeResources(uint32_t tid)
 {
     return 0;
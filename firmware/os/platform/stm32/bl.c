@@ -486,6 +486,11 @@ void __attribute__((noreturn)) __blEntry(void)
     blDisableInts();
     SCB->VTOR = (uint32_t)&BL;
 
+    //count cycles from here, so the OS can tell how long we took; it keeps the counter running
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
     //init things a little for the higher levels
     memset(__bss_start, 0, __bss_end - __bss_start);
     memcpy(__data_start, __data_data, __data_end - __data_start);
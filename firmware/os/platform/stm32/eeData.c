@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include <bl.h>
+#include <bootCache.h>
 #include <eeData.h>
 
 extern uint32_t __eedata_start[], __eedata_end[];
@@ -135,7 +136,11 @@ void *eeDataGetAllVersions(uint32_t name, void *buf, uint32_t *szP, void **state
 
 static bool eeWrite(void *dst, const void *src, uint32_t len)
 {
-    return BL.blProgramEe(dst, src, len, BL_FLASH_KEY1, BL_FLASH_KEY2);
+    bool ret = BL.blProgramEe(dst, src, len, BL_FLASH_KEY1, BL_FLASH_KEY2);
+
+    //no app segment lives here, so nothing the boot cache holds has changed
+    bootCacheFlashWritten();
+    return ret;
 }
 
 bool eeDataSet(uint32_t name, const void *buf, uint32_t len)
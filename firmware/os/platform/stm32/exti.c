@@ -69,10 +69,16 @@ bool extiIsPendingLine(const enum ExtiLine line)
     return (EXTI->PR & (1UL << line)) ? true : false;
 }
 
+uint32_t extiGetPendingLines(void)
+{
+    return EXTI->PR & EXTI->IMR;
+}
+
 struct ExtiInterrupt
 {
     struct ChainedInterrupt base;
     IRQn_Type irq;
+    uint16_t lines;
 };
 
 static void extiInterruptEnable(struct ChainedInterrupt *irq)
@@ -87,7 +93,16 @@ static void extiInterruptDisable(struct ChainedInterrupt *irq)
     NVIC_DisableIRQ(exti->irq);
 }
 
-#define DECLARE_SHARED_EXTI(i) {            \
+#define DECLARE_SHARED_EXTI(i, first, last) {                   \
+    .base = {                                                   \
+        .enable = extiInterruptEnable,                          \
+        .disable = extiInterruptDisable,                        \
+    },                                                          \
+    .irq = i,                                                   \
+    .lines = ((2UL << (last)) - 1) & ~((1UL << (first)) - 1),   \
+}
+
+#define DECLARE_LINE_EXTI(i) {             \
     .base = {                               \
         .enable = extiInterruptEnable,      \
         .disable = extiInterruptDisable,    \
@@ -97,14 +112,35 @@ static void extiInterruptDisable(struct ChainedInterrupt *irq)
 
 uint32_t mMaxLatency = 0;
 
+/* isrs registered per irq, without saying which line they serve */
 static struct ExtiInterrupt mInterrupts[] = {
-    DECLARE_SHARED_EXTI(EXTI0_IRQn),
-    DECLARE_SHARED_EXTI(EXTI1_IRQn),
-    DECLARE_SHARED_EXTI(EXTI2_IRQn),
-    DECLARE_SHARED_EXTI(EXTI3_IRQn),
-    DECLARE_SHARED_EXTI(EXTI4_IRQn),
-    DECLARE_SHARED_EXTI(EXTI9_5_IRQn),
-    DECLARE_SHARED_EXTI(EXTI15_10_IRQn),
+    DECLARE_SHARED_EXTI(EXTI0_IRQn, 0, 0),
+    DECLARE_SHARED_EXTI(EXTI1_IRQn, 1, 1),
+    DECLARE_SHARED_EXTI(EXTI2_IRQn, 2, 2),
+    DECLARE_SHARED_EXTI(EXTI3_IRQn, 3, 3),
+    DECLARE_SHARED_EXTI(EXTI4_IRQn, 4, 4),
+    DECLARE_SHARED_EXTI(EXTI9_5_IRQn, 5, 9),
+    DECLARE_SHARED_EXTI(EXTI15_10_IRQn, 10, 15),
+};
+
+/* isrs registered for a gpio line; only a line that really is shared has more than one */
+static struct ExtiInterrupt mLines[] = {
+    DECLARE_LINE_EXTI(EXTI0_IRQn),
+    DECLARE_LINE_EXTI(EXTI1_IRQn),
+    DECLARE_LINE_EXTI(EXTI2_IRQn),
+    DECLARE_LINE_EXTI(EXTI3_IRQn),
+    DECLARE_LINE_EXTI(EXTI4_IRQn),
+    DECLARE_LINE_EXTI(EXTI9_5_IRQn),
+    DECLARE_LINE_EXTI(EXTI9_5_IRQn),
+    DECLARE_LINE_EXTI(EXTI9_5_IRQn),
+    DECLARE_LINE_EXTI(EXTI9_5_IRQn),
+    DECLARE_LINE_EXTI(EXTI9_5_IRQn),
+    DECLARE_LINE_EXTI(EXTI15_10_IRQn),
+    DECLARE_LINE_EXTI(EXTI15_10_IRQn),
+    DECLARE_LINE_EXTI(EXTI15_10_IRQn),
+    DECLARE_LINE_EXTI(EXTI15_10_IRQn),
+    DECLARE_LINE_EXTI(EXTI15_10_IRQn),
+    DECLARE_LINE_EXTI(EXTI15_10_IRQn),
 };
 
 static void extiUpdateMaxLatency(uint32_t maxLatencyNs)
@@ -118,17 +154,26 @@ static void extiUpdateMaxLatency(uint32_t maxLatencyNs)
     mMaxLatency = maxLatencyNs;
 }
 
-static void extiCalcMaxLatency()
+static uint32_t extiCalcMaxLatencyOf(struct ExtiInterrupt *exti, int count, uint32_t newMaxLatency)
 {
     int i;
-    uint32_t maxLatency, newMaxLatency = 0;
-    struct ExtiInterrupt *exti = mInterrupts;
+    uint32_t maxLatency;
 
-    for (i = 0; i < ARRAY_SIZE(mInterrupts); ++i, ++exti) {
+    for (i = 0; i < count; ++i, ++exti) {
         maxLatency = maxLatencyIsr(&exti->base);
         if (!newMaxLatency || (maxLatency && maxLatency < newMaxLatency))
             newMaxLatency = maxLatency;
     }
+
+    return newMaxLatency;
+}
+
+static void extiCalcMaxLatency()
+{
+    uint32_t newMaxLatency;
+
+    newMaxLatency = extiCalcMaxLatencyOf(mInterrupts, ARRAY_SIZE(mInterrupts), 0);
+    newMaxLatency = extiCalcMaxLatencyOf(mLines, ARRAY_SIZE(mLines), newMaxLatency);
     extiUpdateMaxLatency(newMaxLatency);
 }
 
@@ -143,10 +188,52 @@ static inline struct ExtiInterrupt *extiForIrq(IRQn_Type n)
     return NULL;
 }
 
+static inline struct ExtiInterrupt *extiForLine(enum ExtiLine line)
+{
+    if (line < ARRAY_SIZE(mLines))
+        return &mLines[line];
+    return NULL;
+}
+
+/* the irq stays enabled while any isr, per irq or per line, is chained on it */
+static void extiUpdateIrq(struct ExtiInterrupt *exti)
+{
+    uint32_t lines = exti->lines;
+    int line;
+
+    if (!list_is_empty(&exti->base.isrs)) {
+        NVIC_EnableIRQ(exti->irq);
+        return;
+    }
+
+    for (line = 0; lines; ++line, lines >>= 1) {
+        if ((lines & 1) && !list_is_empty(&mLines[line].base.isrs)) {
+            NVIC_EnableIRQ(exti->irq);
+            return;
+        }
+    }
+}
+
 static void extiIrqHandler(IRQn_Type n)
 {
     struct ExtiInterrupt *exti = extiForIrq(n);
-    dispatchIsr(&exti->base);
+    struct ExtiInterrupt *lineExti;
+    uint32_t pending = EXTI->PR & EXTI->IMR & exti->lines;
+    bool unclaimed = !pending;
+    int line;
+
+    /* straight to the isr of each pending line, lowest line first */
+    while (pending) {
+        line = __builtin_ctz(pending);
+        pending &= pending - 1;
+        lineExti = &mLines[line];
+        if (list_is_empty(&lineExti->base.isrs) || !dispatchIsr(&lineExti->base))
+            unclaimed = true;
+    }
+
+    /* per irq isrs have to check for themselves which line is theirs */
+    if (unclaimed)
+        dispatchIsr(&exti->base);
 }
 
 #define DEFINE_SHARED_EXTI_ISR(i)           \
@@ -181,9 +268,8 @@ int extiSetMaxLatency(struct ChainedIsr *isr, uint32_t maxLatencyNs)
     return 0;
 }
 
-int extiChainIsr(IRQn_Type n, struct ChainedIsr *isr)
+static int extiChainIsrTo(struct ExtiInterrupt *exti, struct ChainedIsr *isr)
 {
-    struct ExtiInterrupt *exti = extiForIrq(n);
     if (!exti)
         return -EINVAL;
     else if (!list_is_empty(&isr->node))
@@ -196,27 +282,55 @@ int extiChainIsr(IRQn_Type n, struct ChainedIsr *isr)
     return 0;
 }
 
-int extiUnchainIsr(IRQn_Type n, struct ChainedIsr *isr)
+static int extiUnchainIsrFrom(struct ExtiInterrupt *exti, struct ChainedIsr *isr)
 {
-    struct ExtiInterrupt *exti = extiForIrq(n);
     if (!exti)
         return -EINVAL;
     else if (list_is_empty(&isr->node))
         return -EINVAL;
 
     unchainIsr(&exti->base, isr);
+    extiUpdateIrq(exti);
     if (isr->maxLatencyNs && isr->maxLatencyNs == mMaxLatency)
         extiCalcMaxLatency();
     return 0;
 }
 
+int extiChainIsr(IRQn_Type n, struct ChainedIsr *isr)
+{
+    return extiChainIsrTo(extiForIrq(n), isr);
+}
+
+int extiUnchainIsr(IRQn_Type n, struct ChainedIsr *isr)
+{
+    return extiUnchainIsrFrom(extiForIrq(n), isr);
+}
+
+int extiChainIsrLine(const enum ExtiLine line, struct ChainedIsr *isr)
+{
+    return extiChainIsrTo(extiForLine(line), isr);
+}
+
+int extiUnchainIsrLine(const enum ExtiLine line, struct ChainedIsr *isr)
+{
+    struct ExtiInterrupt *exti = extiForLine(line);
+
+    return extiUnchainIsrFrom(exti ? extiForIrq(exti->irq) : NULL, isr);
+}
+
 int extiUnchainAll(uint32_t tid)
 {
     int i, count = 0;
-    struct ExtiInterrupt *exti = mInterrupts;
+    struct ExtiInterrupt *exti = mLines;
+
+    for (i = 0; i < ARRAY_SIZE(mLines); ++i, ++exti)
+        count += unchainIsrAll(&exti->base, tid);
 
-    for (i = 0; i < ARRAY_SIZE(mInterrupts); ++i, ++exti)
+    exti = mInterrupts;
+    for (i = 0; i < ARRAY_SIZE(mInterrupts); ++i, ++exti) {
         count += unchainIsrAll(&exti->base, tid);
+        extiUpdateIrq(exti);
+    }
     extiCalcMaxLatency();
 
     return count;
@@ -78,7 +78,7 @@ const struct HostIntfComm *platHostIntfInit()
     syscfgSetExtiPort(mShWakeupGpio);
     extiEnableIntGpio(mShWakeupGpio, EXTI_TRIGGER_BOTH);
     mShWakeupIsr.func = platWakeupIsr;
-    extiChainIsr(SH_EXTI_WAKEUP_IRQ, &mShWakeupIsr);
+    extiChainIsrGpio(mShWakeupGpio, &mShWakeupIsr);
 #else
 #error "No host interface bus specified"
 #endif
@@ -17,6 +17,7 @@
 #ifndef _EXTI_H_
 #define _EXTI_H_
 
+#include <errno.h>
 #include <isr.h>
 #include <stdbool.h>
 #include <plat/cmsis.h>
@@ -63,11 +64,21 @@ void extiEnableIntLine(const enum ExtiLine line, enum ExtiTrigger trigger);
 void extiDisableIntLine(const enum ExtiLine line);
 bool extiIsPendingLine(const enum ExtiLine line);
 void extiClearPendingLine(const enum ExtiLine line);
+uint32_t extiGetPendingLines(void); //pending and unmasked, one bit per line
 
 int extiChainIsr(IRQn_Type n, struct ChainedIsr *isr);
 int extiUnchainIsr(IRQn_Type n, struct ChainedIsr *isr);
 int extiUnchainAll(uint32_t tid);
 
+/*
+ * The irq handler reads the pending lines once and calls the isrs chained on
+ * each pending line directly; isrs chained per irq are only called for
+ * pending lines no per line isr claimed. Either kind may be unchained with
+ * extiUnchainIsr() on its irq.
+ */
+int extiChainIsrLine(const enum ExtiLine line, struct ChainedIsr *isr);
+int extiUnchainIsrLine(const enum ExtiLine line, struct ChainedIsr *isr);
+
 int extiSetMaxLatency(struct ChainedIsr *isr, uint32_t maxLatencyNs);
 
 static inline void extiEnableIntGpio(const struct Gpio *__restrict gpioHandle, enum ExtiTrigger trigger)
@@ -92,6 +103,22 @@ static inline bool extiIsPendingGpio(const struct Gpio *__restrict gpioHandle)
     }
     return false;
 }
+static inline int extiChainIsrGpio(const struct Gpio *__restrict gpioHandle, struct ChainedIsr *isr)
+{
+    if (gpioHandle) {
+        uint32_t gpioNum = (uint32_t)gpioHandle - GPIO_HANDLE_OFFSET;
+        return extiChainIsrLine(gpioNum & GPIO_PIN_MASK, isr);
+    }
+    return -EINVAL;
+}
+static inline int extiUnchainIsrGpio(const struct Gpio *__restrict gpioHandle, struct ChainedIsr *isr)
+{
+    if (gpioHandle) {
+        uint32_t gpioNum = (uint32_t)gpioHandle - GPIO_HANDLE_OFFSET;
+        return extiUnchainIsrLine(gpioNum & GPIO_PIN_MASK, isr);
+    }
+    return -EINVAL;
+}
 static inline void extiClearPendingGpio(const struct Gpio *__restrict gpioHandle)
 {
     if (gpioHandle) {
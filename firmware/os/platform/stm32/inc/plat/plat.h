@@ -24,23 +24,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include <seos.h>
-
-enum PlatSleepDevID
-{
-    Stm32sleepDevTim2, /* we use this for short sleeps in WFI mode */
-    Stm32sleepDevTim4, /* input capture uses this, potentially */
-    Stm32sleepDevTim5, /* input capture uses this, potentially */
-    Stm32sleepDevTim9, /* input capture uses this, potentially */
-    Stm32sleepWakeup,  /* we use this to wakeup from AP */
-    Stm32sleepDevSpi2, /* we use this to prevent stop mode during spi2 xfers */
-    Stm32sleepDevSpi3, /* we use this to prevent stop mode during spi3 xfers */
-    Stm32sleepDevI2c1, /* we use this to prevent stop mode during i2c1 xfers */
-    Stm32sleepDevI2c2, /* we use this to prevent stop mode during i2c2 xfers */
-    Stm32sleepDevI2c3, /* we use this to prevent stop mode during i2c3 xfers */
-    Stm32sleepDevExti, /* we use this for max external interrupt latency */
-
-    Stm32sleepDevNum,  //must be last always, and must be <= PLAT_MAX_SLEEP_DEVS
-};
+#include <plat/sleepStates.h>
 
 static inline const struct AppHdr* platGetInternalAppList(uint32_t *numAppsP)
 {
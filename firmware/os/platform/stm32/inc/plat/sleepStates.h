@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _STM32_SLEEP_STATES_H_
+#define _STM32_SLEEP_STATES_H_
+
+/*
+ * The stm32f411 sleep states as the sleep planner sees them, for platSleep()
+ * and the host sleep planner simulator (os/core/host/sleep_planner_sim.c).
+ * Only needs <sleepPlanner.h>.
+ *
+ * Power figures are STM32F411 datasheet typicals at 1.8V; transition energy is
+ * the wakeup time at run-mode draw (~5mW on HSI) plus regulator restart.
+ * They only need to be right relative to each other: the planner trades the
+ * deep stop modes' wakeup cost against their lower draw for the idle period
+ * it expects.
+ */
+
+#include <sleepPlanner.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum PlatSleepDevID
+{
+    Stm32sleepDevTim2, /* we use this for short sleeps in WFI mode */
+    Stm32sleepDevTim4, /* input capture uses this, potentially */
+    Stm32sleepDevTim5, /* input capture uses this, potentially */
+    Stm32sleepDevTim9, /* input capture uses this, potentially */
+    Stm32sleepWakeup,  /* we use this to wakeup from AP */
+    Stm32sleepDevSpi2, /* we use this to prevent stop mode during spi2 xfers */
+    Stm32sleepDevSpi3, /* we use this to prevent stop mode during spi3 xfers */
+    Stm32sleepDevI2c1, /* we use this to prevent stop mode during i2c1 xfers */
+    Stm32sleepDevI2c2, /* we use this to prevent stop mode during i2c2 xfers */
+    Stm32sleepDevI2c3, /* we use this to prevent stop mode during i2c3 xfers */
+    Stm32sleepDevExti, /* we use this for max external interrupt latency */
+
+    Stm32sleepDevNum,  //must be last always, and must be <= PLAT_MAX_SLEEP_DEVS
+};
+
+#define STM32_SLEEP_DEVS_ALL    ((1UL << Stm32sleepDevNum) - 1)
+
+#define STM32_SLEEP_PLAN_RTC(wakeupNs, uW, nJ)                  \
+    {                                                           \
+        .resolution = 1000000000ull/32768,                      \
+        .maxCounter = 0xffffffff,                               \
+        .jitterPpm = 0,                                         \
+        .driftPpm = 50,                                         \
+        .maxWakeupTime = (wakeupNs),                            \
+        .devsAvail = (1 << Stm32sleepDevExti),                  \
+        .powerUw = (uW),                                        \
+        .transitionNj = (nJ),                                   \
+    }
+
+/* RTC + STOP MODE, deepest first */
+#define STM32_SLEEP_PLAN_LPLV   STM32_SLEEP_PLAN_RTC(407000ull, 20, 2100)
+#define STM32_SLEEP_PLAN_LPFD   STM32_SLEEP_PLAN_RTC(130000ull, 25, 700)
+#define STM32_SLEEP_PLAN_MRFPD  STM32_SLEEP_PLAN_RTC(111000ull, 80, 600)
+#define STM32_SLEEP_PLAN_MR     STM32_SLEEP_PLAN_RTC(14500ull, 200, 80)
+
+/* TIM2 + SLEEP MODE */
+#define STM32_SLEEP_PLAN_TIM2                                   \
+    {                                                           \
+        .resolution = 1000000000ull/1000000,                    \
+        .maxCounter = 0xffffffff,                               \
+        .jitterPpm = 0,                                         \
+        .driftPpm = 30,                                         \
+        .maxWakeupTime = 12ull,                                 \
+        .devsAvail = STM32_SLEEP_DEVS_ALL,                      \
+        .powerUw = 2700,                                        \
+        .transitionNj = 0,                                      \
+    }
+
+/* just WFI */
+#define STM32_SLEEP_PLAN_WFI                                    \
+    {                                                           \
+        .resolution = 16000000000ull/1000000,                   \
+        .maxCounter = 0xffffffff,                               \
+        .jitterPpm = 0,                                         \
+        .driftPpm = 0,                                          \
+        .maxWakeupTime = 0,                                     \
+        .devsAvail = STM32_SLEEP_DEVS_ALL,                      \
+        .powerUw = 2700,                                        \
+        .transitionNj = 0,                                      \
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
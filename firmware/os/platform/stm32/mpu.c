@@ -29,6 +29,18 @@
 #define MPU_REG_RAM         2
 #define MPU_REG_PERIPH      3
 #define MPU_REG_PRIV_PERIPH 4
+#define MPU_REG_APP_RAM     5
+#define MPU_REG_GUARD       6   /* above MPU_REG_APP_RAM, so it wins where they overlap */
+
+/*
+ * RAM isolated apps may write, shared by all of them: the top of RAM, so that
+ * it is aligned to its size as a region must be. Everything else in RAM is
+ * read only to them (and so to anything running unprivileged). 0 leaves apps
+ * unisolated.
+ */
+#ifndef MPU_APP_RAM_SIZE
+#define MPU_APP_RAM_SIZE    0x8000
+#endif
 
 #define MPU_RASR_S          0x00040000
 #define MPU_RASR_C          0x00020000
@@ -113,12 +125,39 @@ static void mpuCfgRom(bool allowSvcWrite)
 
 static void mpuCfgRam(bool allowSvcExecute)
 {
-    mpuRegionCfg(MPU_REG_RAM, (uint32_t)&__ram_start, (uint32_t)&__ram_end - 1, MPU_TYPE_SRAM | MPU_RW | (allowSvcExecute ? 0 : MPU_BIT_XN));
+    mpuRegionCfg(MPU_REG_RAM, (uint32_t)&__ram_start, (uint32_t)&__ram_end - 1, MPU_TYPE_SRAM | MPU_U_RO_S_RW | (allowSvcExecute ? 0 : MPU_BIT_XN));
+}
+
+void *mpuGetAppRam(uint32_t *sizeP)
+{
+    uint32_t size = MPU_APP_RAM_SIZE;
+    uint32_t start = (uint32_t)&__ram_end - size;
+
+    /* a region that does not fit exactly would grow over the OS */
+    if (size < 32 || (size & (size - 1)) || (start & (size - 1)) || start < (uint32_t)&__ram_start)
+        return NULL;
+
+    *sizeP = size;
+    return (void *)(uintptr_t)start;
+}
+
+bool mpuSetGuard(void *start, uint32_t size)
+{
+    uint32_t addr = (uint32_t)start;
+
+    if (size < 32 || (size & (size - 1)) || (addr & (size - 1)) ||
+        ((MPU->TYPE & MPU_TYPE_DREGION_Msk) >> MPU_TYPE_DREGION_Pos) <= MPU_REG_GUARD)
+        return false;
+
+    return mpuRegionCfg(MPU_REG_GUARD, addr, addr + size - 1, MPU_TYPE_SRAM | MPU_NA | MPU_BIT_XN);
 }
 
 
 void mpuStart(void)
 {
+    uint32_t appRamSize;
+    void *appRam;
+
     MPU->CTRL = 0x00; // disable MPU
 
     /* 0x00000000 - 0xFFFFFFFF */
@@ -127,6 +166,10 @@ void mpuStart(void)
     mpuCfgRom(false);
     mpuCfgRam(false);
 
+    appRam = mpuGetAppRam(&appRamSize);
+    if (appRam)
+        mpuRegionCfg(MPU_REG_APP_RAM, (uint32_t)appRam, (uint32_t)appRam + appRamSize - 1, MPU_TYPE_SRAM | MPU_RW | MPU_BIT_XN);
+
     /* 0x40000000 - 0x4003FFFF */
     mpuRegionCfg(MPU_REG_PERIPH, 0x40000000, 0x4003FFFF, MPU_TYPE_PERIPH | MPU_U_NA_S_RW | MPU_BIT_XN);
 
@@ -36,12 +36,15 @@
 #include <usart.h>
 #include <gpio.h>
 #include <mpu.h>
+#include <reset.h>
 #include <cpu.h>
 #include <hostIntf.h>
 #include <atomic.h>
 #include <hostIntf.h>
 #include <nanohubPacket.h>
 #include <sensType.h>
+#include <sleepPlanner.h>
+#include <sleepStats.h>
 #include <variant/variant.h>
 
 
@@ -124,6 +127,7 @@ static uint32_t mMaxJitterPpm = 0, mMaxDriftPpm = 0, mMaxErrTotalPpm = 0;
 static uint32_t mSleepDevsToKeepAlive = 0;
 static uint64_t mWakeupTime = 0;
 static uint32_t mDevsMaxWakeTime[PLAT_MAX_SLEEP_DEVS] = {0,};
+static struct SleepPlannerHistory mSleepHistory;
 
 void platUninitialize(void)
 {
@@ -238,6 +242,7 @@ void platInitialize(void)
 
     //prepare for sleep mode(s)
     SCB->SCR &=~ SCB_SCR_SLEEPONEXIT_Msk;
+    sleepPlannerInit(&mSleepHistory);
 
     //set ints up for a sane state
     //3 bits preemptPriority, 1 bit subPriority
@@ -502,26 +507,14 @@ static bool sleepClockJustWfiPrepare(uint64_t delay, uint32_t acceptableJitter,
 }
 
 struct PlatSleepAndClockInfo {
-    uint64_t resolution;
-    uint64_t resolutionReciprocal; // speed up runtime by using 48 more code bytes? yes please!
-    uint32_t maxCounter;
-    uint32_t jitterPpm;
-    uint32_t driftPpm;
-    uint32_t maxWakeupTime;
-    uint32_t devsAvail; //what is available in sleep mode?
+    struct SleepPlannerOption plan; //must be first, see sleepPlannerPick()
     bool (*prepare)(uint64_t delay, uint32_t acceptableJitter, uint32_t acceptableDrift, uint32_t maxAcceptableError, void *userData, uint64_t *savedData);
     void (*wake)(void *userData, uint64_t *savedData);
     void *userData;
 } static const platSleepClocks[] = {
 #ifndef STM32F4xx_DISABLE_LPLV_SLEEP
     { /* RTC + LPLV STOP MODE */
-        .resolution = 1000000000ull/32768,
-        .resolutionReciprocal = U64_RECIPROCAL_CALCULATE(1000000000ull/32768),
-        .maxCounter = 0xffffffff,
-        .jitterPpm = 0,
-        .driftPpm = 50,
-        .maxWakeupTime = 407000ull,
-        .devsAvail = (1 << Stm32sleepDevExti),
+        .plan = STM32_SLEEP_PLAN_LPLV,
         .prepare = sleepClockRtcPrepare,
         .wake = sleepClockRtcWake,
         .userData = (void*)stm32f411SleepModeStopLPLV,
@@ -529,13 +522,7 @@ struct PlatSleepAndClockInfo {
 #endif
 #ifndef STM32F4xx_DISABLE_LPFD_SLEEP
     { /* RTC + LPFD STOP MODE */
-        .resolution = 1000000000ull/32768,
-        .resolutionReciprocal = U64_RECIPROCAL_CALCULATE(1000000000ull/32768),
-        .maxCounter = 0xffffffff,
-        .jitterPpm = 0,
-        .driftPpm = 50,
-        .maxWakeupTime = 130000ull,
-        .devsAvail = (1 << Stm32sleepDevExti),
+        .plan = STM32_SLEEP_PLAN_LPFD,
         .prepare = sleepClockRtcPrepare,
         .wake = sleepClockRtcWake,
         .userData = (void*)stm32f411SleepModeStopLPFD,
@@ -543,13 +530,7 @@ struct PlatSleepAndClockInfo {
 #endif
 #ifndef STM32F4xx_DISABLE_MRFPD_SLEEP
     { /* RTC + MRFPD STOP MODE */
-        .resolution = 1000000000ull/32768,
-        .resolutionReciprocal = U64_RECIPROCAL_CALCULATE(1000000000ull/32768),
-        .maxCounter = 0xffffffff,
-        .jitterPpm = 0,
-        .driftPpm = 50,
-        .maxWakeupTime = 111000ull,
-        .devsAvail = (1 << Stm32sleepDevExti),
+        .plan = STM32_SLEEP_PLAN_MRFPD,
         .prepare = sleepClockRtcPrepare,
         .wake = sleepClockRtcWake,
         .userData = (void*)stm32f411SleepModeStopMRFPD,
@@ -557,13 +538,7 @@ struct PlatSleepAndClockInfo {
 #endif
 #ifndef STM32F4xx_DISABLE_MR_SLEEP
     { /* RTC + MR STOP MODE */
-        .resolution = 1000000000ull/32768,
-        .resolutionReciprocal = U64_RECIPROCAL_CALCULATE(1000000000ull/32768),
-        .maxCounter = 0xffffffff,
-        .jitterPpm = 0,
-        .driftPpm = 50,
-        .maxWakeupTime = 14500ull,
-        .devsAvail = (1 << Stm32sleepDevExti),
+        .plan = STM32_SLEEP_PLAN_MR,
         .prepare = sleepClockRtcPrepare,
         .wake = sleepClockRtcWake,
         .userData = (void*)stm32f411SleepModeStopMR,
@@ -571,97 +546,77 @@ struct PlatSleepAndClockInfo {
 #endif
 #ifndef STM32F4xx_DISABLE_TIM2_SLEEP
     { /* TIM2 + SLEEP MODE */
-        .resolution = 1000000000ull/1000000,
-        .resolutionReciprocal = U64_RECIPROCAL_CALCULATE(1000000000ull/1000000),
-        .maxCounter = 0xffffffff,
-        .jitterPpm = 0,
-        .driftPpm = 30,
-        .maxWakeupTime = 12ull,
-        .devsAvail = (1 << Stm32sleepDevTim2) | (1 << Stm32sleepDevTim4) | (1 << Stm32sleepDevTim5) | (1 << Stm32sleepDevTim9) | (1 << Stm32sleepWakeup) | (1 << Stm32sleepDevSpi2) | (1 << Stm32sleepDevSpi3) | (1 << Stm32sleepDevI2c1) | (1 << Stm32sleepDevI2c2) | (1 << Stm32sleepDevI2c3) | (1 << Stm32sleepDevExti),
+        .plan = STM32_SLEEP_PLAN_TIM2,
         .prepare = sleepClockTmrPrepare,
         .wake = sleepClockTmrWake,
     },
 #endif
     { /* just WFI */
-        .resolution = 16000000000ull/1000000,
-        .resolutionReciprocal = U64_RECIPROCAL_CALCULATE(16000000000ull/1000000),
-        .maxCounter = 0xffffffff,
-        .jitterPpm = 0,
-        .driftPpm = 0,
-        .maxWakeupTime = 0,
-        .devsAvail = (1 << Stm32sleepDevTim2) | (1 << Stm32sleepDevTim4) | (1 << Stm32sleepDevTim5) | (1 << Stm32sleepDevTim9) | (1 << Stm32sleepWakeup) | (1 << Stm32sleepDevSpi2) | (1 << Stm32sleepDevSpi3) | (1 << Stm32sleepDevI2c1) | (1 << Stm32sleepDevI2c2) | (1 << Stm32sleepDevI2c3) | (1 << Stm32sleepDevExti),
+        .plan = STM32_SLEEP_PLAN_WFI,
         .prepare = sleepClockJustWfiPrepare,
     },
-
-    /* terminator */
-    {0},
 };
 
-void platSleep(void)
+//called with interrupts off right after wakeup: whatever is pending is what woke us up
+static enum SleepWakeReason platSleepWakeReason(uint32_t *line)
 {
-    uint64_t predecrement = 0, curTime = timGetTime(), length = mWakeupTime - curTime, intState;
-    const struct PlatSleepAndClockInfo *sleepClock, *leastBadOption = NULL;
-    uint64_t savedData;
-    uint32_t i;
-
-    //shortcut the sleep if it is time to wake up already
-    if (mWakeupTime && mWakeupTime < curTime)
-        return;
+    uint32_t lines = extiGetPendingLines();
+    uint32_t bus, stream;
 
-    for (sleepClock = platSleepClocks; sleepClock->maxCounter; sleepClock++) {
-
-        bool potentialLeastBadOption = false;
-
-        //if we have timers, consider them
-        if (mWakeupTime) {
-
-            //calculate how much we WOULD predecerement by
-            predecrement = sleepClock->resolution + sleepClock->maxWakeupTime;
-
-            //skip options with too much jitter (after accounting for error
-            if (sleepClock->jitterPpm > mMaxJitterPpm)
-                continue;
+#ifdef SH_INT_WAKEUP
+    if (lines & (1UL << (SH_INT_WAKEUP & GPIO_PIN_MASK)))
+        return SLEEP_WAKE_HOST;
+#endif
 
-            //skip options that will take too long to wake up to be of use
-            if (predecrement > length)
-                continue;
+    if (lines & 0xFFFF) {
+        *line = __builtin_ctz(lines & 0xFFFF);
+        return SLEEP_WAKE_LINE;
+    }
 
-            //skip options with too much drift
-            if (sleepClock->driftPpm > mMaxDriftPpm)
-                continue;
+    if ((lines & (1UL << EXTI_LINE_RTC_WKUP)) || NVIC_GetPendingIRQ(RTC_WKUP_IRQn) ||
+        NVIC_GetPendingIRQ(TIM2_IRQn) || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+        return SLEEP_WAKE_TIMER;
 
-            //skip options that do not let us sleep enough, but save them for later if we simply must pick something
-            if (cpuMathRecipAssistedUdiv64by64(length, sleepClock->resolution, sleepClock->resolutionReciprocal) > sleepClock->maxCounter && !leastBadOption)
-                potentialLeastBadOption = true;
+    for (bus = 0; bus < 2; bus++) {
+        for (stream = 0; stream < 8; stream++) {
+            if (NVIC_GetPendingIRQ(dmaIrq(bus, stream)))
+                return SLEEP_WAKE_DMA;
         }
+    }
 
-        //skip all options that do not keep enough deviceas awake
-        if ((sleepClock->devsAvail & mSleepDevsToKeepAlive) != mSleepDevsToKeepAlive)
-            continue;
+    return SLEEP_WAKE_OTHER;
+}
 
-        //skip all options that wake up too slowly
-        for (i = 0; i < Stm32sleepDevNum; i++) {
-            if (!(mSleepDevsToKeepAlive & (1 << i)))
-                continue;
-            if (mDevsMaxWakeTime[i] < sleepClock->maxWakeupTime)
-                break;
-        }
-        if (i != Stm32sleepDevNum)
-            continue;
-
-        //if it will not let us sleep long enough save it as a possibility and go on
-        if (potentialLeastBadOption && !leastBadOption)
-            leastBadOption = sleepClock;
-        else //if it fits us perfectly, pick it
-            break;
-    }
-    if (!sleepClock->maxCounter)
-        sleepClock = leastBadOption;
+void platSleep(void)
+{
+    uint64_t curTime = timGetTime(), intState;
+    const struct PlatSleepAndClockInfo *sleepClock;
+    struct SleepPlannerRequest req;
+    enum SleepWakeReason reason = SLEEP_WAKE_OTHER;
+    uint32_t line = 0;
+    uint64_t savedData, slept;
+    bool didSleep = false;
+    int32_t idx;
+
+    //shortcut the sleep if it is time to wake up already
+    if (mWakeupTime && mWakeupTime < curTime)
+        return;
 
-    if (!sleepClock) {
+    req.timerLength = mWakeupTime ? mWakeupTime - curTime : 0;
+    req.predictedIdle = sleepPlannerPredict(&mSleepHistory, req.timerLength);
+    req.maxJitterPpm = mMaxJitterPpm;
+    req.maxDriftPpm = mMaxDriftPpm;
+    req.devsToKeepAlive = mSleepDevsToKeepAlive;
+    req.numDevs = Stm32sleepDevNum;
+    req.devsMaxWakeTime = mDevsMaxWakeTime;
+
+    idx = sleepPlannerPick(&platSleepClocks[0].plan, ARRAY_SIZE(platSleepClocks),
+                           sizeof(platSleepClocks[0]), &req);
+    if (idx < 0) {
         //should never happen - this will spin the CPU and be bad, but it WILL work in all cases
         return;
     }
+    sleepClock = &platSleepClocks[idx];
 
     //turn ints off in prep for sleep
     wdtDisableClk();
@@ -669,13 +624,16 @@ void platSleep(void)
 
     //options? config it
     if (sleepClock->prepare &&
-        sleepClock->prepare(mWakeupTime ? length - sleepClock->maxWakeupTime : 0,
+        sleepClock->prepare(req.timerLength ? req.timerLength - sleepClock->plan.maxWakeupTime : 0,
                             mMaxJitterPpm, mMaxDriftPpm, mMaxErrTotalPpm,
                             sleepClock->userData, &savedData)) {
 
         asm volatile ("wfi\n"
             "nop" :::"memory");
 
+        didSleep = true;
+        reason = platSleepWakeReason(&line);
+
         //wakeup
         if (sleepClock->wake)
             sleepClock->wake(sleepClock->userData, &savedData);
@@ -683,6 +641,11 @@ void platSleep(void)
     //re-enable interrupts and let the handlers run
     cpuIntsRestore(intState);
     wdtEnableClk();
+
+    slept = timGetTime() - curTime;
+    sleepPlannerRecord(&mSleepHistory, req.timerLength, slept);
+    if (didSleep)
+        sleepStatsRecord(idx, reason, line, req.timerLength, req.predictedIdle, slept);
 }
 
 void* platGetPersistentRamStore(uint32_t *bytes)
@@ -691,6 +654,11 @@ void* platGetPersistentRamStore(uint32_t *bytes)
     return rtcGetBackupStorage();
 }
 
+bool platIsWarmReset(void)
+{
+    return !(pwrResetReason() & (RESET_POWER_ON | RESET_BROWN_OUT));
+}
+
 uint32_t platFreeResources(uint32_t tid)
 {
     uint32_t dmaCount = dmaStopAll(tid);
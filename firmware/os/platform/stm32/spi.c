@@ -480,8 +480,10 @@ static void stmSpiSlaveSetCsInterrupt(struct SpiDevice *dev, bool enabled)
         if (pdev->nss) {
             syscfgSetExtiPort(pdev->nss);
             extiEnableIntGpio(pdev->nss, EXTI_TRIGGER_RISING);
+            extiChainIsrGpio(pdev->nss, isr);
+        } else {
+            extiChainIsr(pdev->board->irqNss, isr);
         }
-        extiChainIsr(pdev->board->irqNss, isr);
     } else {
         extiUnchainIsr(pdev->board->irqNss, isr);
         if (pdev->nss)
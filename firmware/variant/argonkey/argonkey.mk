@@ -42,6 +42,7 @@ SRCS_os += \
     os/algos/common/math/mat.c \
     os/algos/common/math/quat.c \
     os/algos/common/math/vec.c \
+    os/algos/accel_features.c \
     os/algos/fusion.c \
     os/algos/time_sync.c
 
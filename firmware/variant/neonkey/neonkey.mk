@@ -39,6 +39,8 @@ SRCS_os += \
     os/algos/common/math/mat.c \
     os/algos/common/math/quat.c \
     os/algos/common/math/vec.c \
+    os/algos/accel_features.c \
+    os/algos/als_prox_onchange.c \
     os/algos/fusion.c \
     os/algos/time_sync.c
 
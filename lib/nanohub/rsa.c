@@ -274,6 +274,247 @@ const uint32_t* rsaPrivOp(struct RsaState* state, const uint32_t *a, const uint3
 
     return state->tmpA;
 }
+
+/*
+ * Constant time private ops.
+ *
+ * Numbers are kept as Montgomery residues (x * R mod m, R = 2 ^ (32 * n)) so a modular multiplication is one
+ * interleaved multiply-and-reduce pass (CIOS) instead of a multiplication and a bit-serial division. Exponents
+ * are consumed RSA_WINDOW_BITS bits at a time from a table of the first powers of the base. Nothing branches on
+ * or indexes memory by secret data: every exponent bit is processed (leading zeroes too), table entries are
+ * picked by masking all of them and final subtractions are done unconditionally and masked in.
+ */
+
+static uint32_t ctMask(uint32_t v) //0xffffffff if v is zero, 0 otherwise
+{
+    return ((v | (0 - v)) >> 31) - 1;
+}
+
+static uint32_t montInv(uint32_t m0) //-(m0 ^ -1) mod 2 ^ 32, m0 odd
+{
+    uint32_t inv = m0, i;
+
+    for (i = 0; i < 4; i++) //newton, each iteration doubles the correct bits (3 to start with)
+        inv *= 2 - m0 * inv;
+
+    return 0 - inv;
+}
+
+static void ctSelect(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t mask, uint32_t n) //r = mask ? a : b
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++)
+        r[i] = (a[i] & mask) | (b[i] & ~mask);
+}
+
+static uint32_t biSub(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t n) //r = a - b, returns borrow
+{
+    uint64_t t = 0;
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        t = (uint64_t)a[i] - b[i] - t;
+        r[i] = t;
+        t = (t >> 32) & 1;
+    }
+
+    return t;
+}
+
+static uint32_t biAdd(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t n) //r = a + b, returns carry
+{
+    uint64_t t = 0;
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        t += (uint64_t)a[i] + b[i];
+        r[i] = t;
+        t >>= 32;
+    }
+
+    return t;
+}
+
+static void montSubMod(uint32_t *r, const uint32_t *a, const uint32_t *b, const uint32_t *m, uint32_t *tmp, uint32_t n) //r = (a - b) mod m, a, b < m
+{
+    uint32_t borrow = biSub(r, a, b, n);
+
+    biAdd(tmp, r, m, n);
+    ctSelect(r, tmp, r, 0 - borrow, n);
+}
+
+static void montAddMod(uint32_t *r, const uint32_t *a, const uint32_t *b, const uint32_t *m, uint32_t *tmp, uint32_t n) //r = (a + b) mod m, a, b < m
+{
+    uint32_t carry = biAdd(r, a, b, n);
+    uint32_t borrow = biSub(tmp, r, m, n);
+
+    //r - m is right unless the sum fit in n limbs and was less than m
+    ctSelect(r, r, tmp, ctMask(carry) & (0 - borrow), n);
+}
+
+//r = a * b / R mod m, needs a < R, b < m; tmp is n + 2 limbs; r may alias a or b
+static void montMul(uint32_t *r, const uint32_t *a, const uint32_t *b, const uint32_t *m, uint32_t mInv, uint32_t *tmp, uint32_t n)
+{
+    uint32_t i, j, u;
+    uint64_t t, borrow;
+
+    memset(tmp, 0, sizeof(uint32_t[n + 2]));
+
+    for (i = 0; i < n; i++) {
+        t = 0;
+        for (j = 0; j < n; j++) {
+            t += (uint64_t)a[j] * b[i] + tmp[j];
+            tmp[j] = t;
+            t >>= 32;
+        }
+        t += tmp[n];
+        tmp[n] = t;
+        tmp[n + 1] = t >> 32;
+
+        u = tmp[0] * mInv;
+        t = ((uint64_t)u * m[0] + tmp[0]) >> 32;
+        for (j = 1; j < n; j++) {
+            t += (uint64_t)u * m[j] + tmp[j];
+            tmp[j - 1] = t;
+            t >>= 32;
+        }
+        t += tmp[n];
+        tmp[n - 1] = t;
+        tmp[n] = tmp[n + 1] + (t >> 32);
+    }
+
+    //tmp < 2m: subtract m unless that borrows out of the top limb too
+    borrow = tmp[n] - (uint64_t)biSub(r, tmp, m, n);
+    ctSelect(r, tmp, r, borrow >> 32, n);
+}
+
+//r = R ^ 2 mod m, by doubling 1 2 * 32 * n times
+static void montR2(uint32_t *r, const uint32_t *m, uint32_t *tmp, uint32_t n)
+{
+    uint32_t i;
+
+    memset(r, 0, sizeof(uint32_t[n]));
+    r[0] = 1;
+
+    for (i = 0; i < 64 * n; i++)
+        montAddMod(r, r, r, m, tmp, n);
+}
+
+//r = a ^ e mod m, a is n or 2 * n limbs, e is eLimbs limbs, m is n limbs and odd; leaves R ^ 2 mod m in state->rr, returns -(m ^ -1) mod 2 ^ 32
+static uint32_t montExp(struct RsaPrivState* state, uint32_t *r, const uint32_t *a, uint32_t aLimbs, const uint32_t *e, uint32_t eLimbs, const uint32_t *m, uint32_t n)
+{
+    uint32_t mInv = montInv(m[0]);
+    uint32_t *x = state->x, *y = state->y, *acc = state->acc, *tmp = state->tmp;
+    uint32_t i, j, bit, idx, mask;
+    uint32_t nBits = 32 * eLimbs;
+
+    montR2(state->rr, m, tmp, n);
+
+    //x = a * R mod m: the low half times R, plus the high half times R ^ 2
+    montMul(x, a, state->rr, m, mInv, tmp, n);
+    if (aLimbs > n) {
+        montMul(y, a + n, state->rr, m, mInv, tmp, n);
+        montMul(y, y, state->rr, m, mInv, tmp, n);
+        montAddMod(x, x, y, m, tmp, n);
+    }
+
+    //table[i] = a ^ i * R mod m
+    memset(y, 0, sizeof(uint32_t[n]));
+    y[0] = 1;
+    montMul(state->table[0], y, state->rr, m, mInv, tmp, n);
+    for (i = 1; i < (1 << RSA_WINDOW_BITS); i++)
+        montMul(state->table[i], state->table[i - 1], x, m, mInv, tmp, n);
+
+    memcpy(acc, state->table[0], sizeof(uint32_t[n]));
+
+    //the first window is shorter if the bit count is not a multiple of the window
+    bit = nBits;
+    while (bit) {
+        j = bit % RSA_WINDOW_BITS ? bit % RSA_WINDOW_BITS : RSA_WINDOW_BITS;
+        for (idx = 0; j; j--) {
+            bit--;
+            idx = (idx << 1) | ((e[bit / 32] >> (bit % 32)) & 1);
+            montMul(acc, acc, acc, m, mInv, tmp, n);
+        }
+
+        memset(y, 0, sizeof(uint32_t[n]));
+        for (i = 0; i < (1 << RSA_WINDOW_BITS); i++) {
+            mask = ctMask(i ^ idx);
+            for (j = 0; j < n; j++)
+                y[j] |= state->table[i][j] & mask;
+        }
+        montMul(acc, acc, y, m, mInv, tmp, n);
+    }
+
+    //back from Montgomery form
+    memset(y, 0, sizeof(uint32_t[n]));
+    y[0] = 1;
+    montMul(r, acc, y, m, mInv, tmp, n);
+
+    return mInv;
+}
+
+static void biMulFull(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t n) //r = a * b, r is 2 * n limbs
+{
+    uint32_t i, j;
+    uint64_t t;
+
+    memset(r, 0, sizeof(uint32_t[2 * n]));
+    for (i = 0; i < n; i++) {
+        t = 0;
+        for (j = 0; j < n; j++) {
+            t += (uint64_t)a[j] * b[i] + r[i + j];
+            r[i + j] = t;
+            t >>= 32;
+        }
+        r[i + n] = t;
+    }
+}
+
+const uint32_t* rsaPrivOpMont(struct RsaPrivState* state, const uint32_t *a, const uint32_t *b, const uint32_t *c)
+{
+    montExp(state, state->res, a, RSA_LIMBS, b, RSA_LIMBS, c, RSA_LIMBS);
+
+    return state->res;
+}
+
+/*
+ * Garner's recombination: m1 = a ^ dP mod p, m2 = a ^ dQ mod q, h = qInv * (m1 - m2) mod p, result = m2 + h * q.
+ * m2 may be larger than p, so both go through the Montgomery form of p, where one montMul by qInv also takes
+ * the difference back out of it.
+ */
+const uint32_t* rsaPrivOpCrt(struct RsaPrivState* state, const uint32_t *a, const struct RsaCrtKey *key)
+{
+    uint32_t m1[RSA_HALF_LIMBS], m2[RSA_HALF_LIMBS], h[RSA_HALF_LIMBS];
+    uint32_t mInv;
+
+    montExp(state, m2, a, RSA_LIMBS, key->dQ, RSA_HALF_LIMBS, key->q, RSA_HALF_LIMBS);
+    mInv = montExp(state, m1, a, RSA_LIMBS, key->dP, RSA_HALF_LIMBS, key->p, RSA_HALF_LIMBS);
+
+    montMul(m1, m1, state->rr, key->p, mInv, state->tmp, RSA_HALF_LIMBS);
+    montMul(h, m2, state->rr, key->p, mInv, state->tmp, RSA_HALF_LIMBS);
+    montSubMod(h, m1, h, key->p, state->tmp, RSA_HALF_LIMBS);
+    montMul(h, h, key->qInv, key->p, mInv, state->tmp, RSA_HALF_LIMBS);
+
+    //h * q + m2 < p * q, so the carry out of the low half never runs past the top
+    biMulFull(state->res, h, key->q, RSA_HALF_LIMBS);
+    memset(h, 0, sizeof(h));
+    h[0] = biAdd(state->res, state->res, m2, RSA_HALF_LIMBS);
+    biAdd(state->res + RSA_HALF_LIMBS, state->res + RSA_HALF_LIMBS, h, RSA_HALF_LIMBS);
+
+    memset(m1, 0, sizeof(m1));
+    memset(m2, 0, sizeof(m2));
+
+    return state->res;
+}
+
+bool rsaCrtKeyMatches(struct RsaPrivState* state, const struct RsaCrtKey *key, const uint32_t *c)
+{
+    biMulFull(state->res, key->p, key->q, RSA_HALF_LIMBS);
+
+    return (key->p[0] & 1) && (key->q[0] & 1) && !memcmp(state->res, c, RSA_BYTES);
+}
 #endif
 
 
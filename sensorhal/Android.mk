@@ -139,6 +139,7 @@ LOCAL_C_INCLUDES += \
     device/google/contexthub/firmware/os/inc
 
 LOCAL_SRC_FILES := \
+    calstore.cpp \
     hubconnection.cpp \
     directchannel.cpp
 
@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "calstore"
+#include "calstore.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <utils/Log.h>
+
+namespace android {
+
+#define CAL_STORE_MAGIC     0x4c41434e // "NCAL"
+#define CAL_STORE_VERSION   1
+
+struct CalFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t numRecords;
+    uint32_t slotSize;
+    uint32_t crc;
+};
+
+struct CalSlot {
+    uint16_t id;
+    uint16_t len;
+    uint32_t seq;
+    uint8_t data[CAL_STORE_MAX_RECORD];
+    uint32_t crc;
+};
+
+static uint32_t calCrc32(const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++)
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+
+    return ~crc;
+}
+
+static off_t slotOffset(uint32_t id, uint32_t slot)
+{
+    return sizeof(struct CalFileHeader) + (2 * id + slot) * sizeof(struct CalSlot);
+}
+
+CalStore::Flusher::Flusher(CalStore *store)
+    : Thread(false /* canCallJava */),
+      mStore(store) {
+}
+
+bool CalStore::Flusher::threadLoop() {
+    {
+        Mutex::Autolock autoLock(mStore->mLock);
+
+        while (!mStore->mPending && !exitPending())
+            mStore->mDirtyCond.wait(mStore->mLock);
+
+        if (exitPending())
+            return false;
+
+        // records that fail to write stay dirty and go out with the next put()
+        mStore->mPending = false;
+    }
+
+    mStore->flush();
+    return true;
+}
+
+CalStore::CalStore(const char *path)
+    : mPath(path),
+      mFd(-1),
+      mPending(false) {
+    memset(mRecords, 0x00, sizeof(mRecords));
+}
+
+CalStore::~CalStore() {
+    if (mFlusher != NULL) {
+        mFlusher->requestExit();
+        {
+            Mutex::Autolock autoLock(mLock);
+            mDirtyCond.signal();
+        }
+        mFlusher->join();
+    }
+
+    if (mFd >= 0) {
+        flush();
+        close(mFd);
+    }
+}
+
+bool CalStore::reset() {
+    struct CalFileHeader header = {
+        .magic = CAL_STORE_MAGIC,
+        .version = CAL_STORE_VERSION,
+        .numRecords = NUM_CAL_RECORDS,
+        .slotSize = sizeof(struct CalSlot),
+        .crc = 0,
+    };
+
+    header.crc = calCrc32(&header, offsetof(struct CalFileHeader, crc));
+    memset(mRecords, 0x00, sizeof(mRecords));
+
+    if (ftruncate(mFd, 0) < 0 ||
+        pwrite(mFd, &header, sizeof(header), 0) != sizeof(header) ||
+        fdatasync(mFd) < 0) {
+        ALOGW("failed to initialize %s: %s", mPath, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool CalStore::open() {
+    uint8_t buf[sizeof(struct CalFileHeader) + 2 * NUM_CAL_RECORDS * sizeof(struct CalSlot)];
+    const struct CalFileHeader *header = (const struct CalFileHeader *)buf;
+    ssize_t len;
+
+    if (mFd >= 0)
+        return true;
+
+    mFd = ::open(mPath, O_RDWR | O_CREAT | O_CLOEXEC, 0660);
+    if (mFd < 0) {
+        ALOGW("failed to open %s: %s", mPath, strerror(errno));
+        return false;
+    }
+
+    // the whole store is read with one call
+    len = TEMP_FAILURE_RETRY(pread(mFd, buf, sizeof(buf), 0));
+    if (len < (ssize_t)sizeof(*header) ||
+        header->magic != CAL_STORE_MAGIC ||
+        header->version != CAL_STORE_VERSION ||
+        header->slotSize != sizeof(struct CalSlot) ||
+        header->crc != calCrc32(header, offsetof(struct CalFileHeader, crc))) {
+        if (len > 0)
+            ALOGW("%s is not a valid calibration store, resetting it", mPath);
+        if (!reset()) {
+            close(mFd);
+            mFd = -1;
+            return false;
+        }
+        startFlusher();
+        return true;
+    }
+
+    for (uint32_t id = 0; id < NUM_CAL_RECORDS; id++) {
+        Record &rec = mRecords[id];
+
+        for (uint32_t slot = 0; slot < 2; slot++) {
+            struct CalSlot s;
+
+            if (slotOffset(id, slot) + (ssize_t)sizeof(s) > len)
+                break;
+            memcpy(&s, buf + slotOffset(id, slot), sizeof(s));
+
+            // a torn or never written slot fails here and the other is used
+            if (s.id != id || s.len > sizeof(s.data) ||
+                s.crc != calCrc32(&s, offsetof(struct CalSlot, crc)))
+                continue;
+
+            if (!rec.valid || (int32_t)(s.seq - rec.seq) > 0) {
+                rec.valid = true;
+                rec.stored = true;
+                rec.slot = slot;
+                rec.seq = s.seq;
+                rec.len = s.len;
+                memcpy(rec.data, s.data, s.len);
+            }
+        }
+    }
+
+    startFlusher();
+    return true;
+}
+
+void CalStore::startFlusher() {
+    mFlusher = new Flusher(this);
+    if (mFlusher->run("calstore", PRIORITY_BACKGROUND) != OK) {
+        // put() still works, the records just wait for flush()
+        ALOGW("failed to start the flusher for %s", mPath);
+        mFlusher.clear();
+    }
+}
+
+bool CalStore::isEmpty() const {
+    Mutex::Autolock autoLock(mLock);
+
+    for (uint32_t id = 0; id < NUM_CAL_RECORDS; id++) {
+        if (mRecords[id].valid)
+            return false;
+    }
+
+    return true;
+}
+
+bool CalStore::get(CalRecordId id, void *data, size_t len) const {
+    Mutex::Autolock autoLock(mLock);
+    const Record &rec = mRecords[id];
+
+    if (!rec.valid || rec.len != len)
+        return false;
+
+    memcpy(data, rec.data, len);
+    return true;
+}
+
+bool CalStore::put(CalRecordId id, const void *data, size_t len) {
+    Mutex::Autolock autoLock(mLock);
+    Record &rec = mRecords[id];
+
+    if (mFd < 0 || len > sizeof(rec.data))
+        return false;
+
+    if (rec.valid && rec.len == len && memcmp(rec.data, data, len) == 0)
+        return true;
+
+    rec.valid = true;
+    rec.dirty = true;
+    rec.len = len;
+    memcpy(rec.data, data, len);
+
+    mPending = true;
+    mDirtyCond.signal();
+
+    return true;
+}
+
+bool CalStore::flush() {
+    Mutex::Autolock flushLock(mFlushLock);
+    struct CalSlot slots[NUM_CAL_RECORDS];
+    uint8_t slotIdx[NUM_CAL_RECORDS];
+    size_t count = 0;
+    bool ok = true;
+
+    if (mFd < 0)
+        return false;
+
+    {
+        Mutex::Autolock autoLock(mLock);
+
+        for (uint32_t id = 0; id < NUM_CAL_RECORDS; id++) {
+            Record &rec = mRecords[id];
+            struct CalSlot &s = slots[count];
+
+            if (!rec.dirty)
+                continue;
+
+            memset(&s, 0x00, sizeof(s));
+            s.id = id;
+            s.len = rec.len;
+            s.seq = rec.stored ? rec.seq + 1 : 0;
+            memcpy(s.data, rec.data, rec.len);
+            s.crc = calCrc32(&s, offsetof(struct CalSlot, crc));
+
+            // overwrite the stale copy; the current one stays valid until
+            // this is on disk
+            slotIdx[count++] = rec.stored ? !rec.slot : 0;
+            rec.dirty = false;
+        }
+    }
+
+    if (!count)
+        return true;
+
+    for (size_t i = 0; ok && i < count; i++) {
+        if (TEMP_FAILURE_RETRY(pwrite(mFd, &slots[i], sizeof(slots[i]),
+                                      slotOffset(slots[i].id, slotIdx[i]))) != sizeof(slots[i]))
+            ok = false;
+    }
+    // one sync covers every record written in this pass
+    if (ok && fdatasync(mFd) < 0)
+        ok = false;
+
+    if (!ok)
+        ALOGW("failed to update %s: %s", mPath, strerror(errno));
+
+    Mutex::Autolock autoLock(mLock);
+    for (size_t i = 0; i < count; i++) {
+        Record &rec = mRecords[slots[i].id];
+
+        if (ok) {
+            rec.stored = true;
+            rec.slot = slotIdx[i];
+            rec.seq = slots[i].seq;
+        } else {
+            rec.dirty = true;
+        }
+    }
+
+    return ok;
+}
+
+}  // namespace android
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CAL_STORE_H_
+
+#define CAL_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <media/stagefright/foundation/ABase.h>
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/Thread.h>
+
+namespace android {
+
+// Record ids are part of the file format: only ever append
+enum CalRecordId {
+    CAL_RECORD_MAG_BIAS,
+    CAL_RECORD_GYRO_SW_BIAS,
+    CAL_RECORD_ACCEL_SW_BIAS,
+    CAL_RECORD_GYRO_OTC_DATA,
+
+    NUM_CAL_RECORDS
+};
+
+#define CAL_STORE_MAX_RECORD    64
+
+/*
+ * Binary store for the calibration the HAL saves across boots.
+ *
+ * The file is a header followed by two fixed slots per record id, each with
+ * its own sequence number and CRC. An update rewrites only the older slot of
+ * one record and syncs it, so a crash or power loss during an update leaves
+ * the previous value readable, and updating one record costs a single small
+ * write instead of rewriting everything.
+ *
+ * put() only updates the cached copy; the writes and the fdatasync run on a
+ * flusher thread so the caller (the HAL event thread) never waits on storage.
+ * Updates that arrive while a flush is running are coalesced into the next
+ * one, and a slot is only rewritten after the previous write of that record
+ * has been synced.
+ */
+struct CalStore {
+    explicit CalStore(const char *path);
+    ~CalStore();
+
+    // Reads the file, creating or resetting it if it is missing or invalid
+    bool open();
+    bool isOpen() const { return mFd >= 0; }
+
+    // True if no record has been stored yet
+    bool isEmpty() const;
+
+    // Copies the record out if it is stored with exactly len bytes
+    bool get(CalRecordId id, void *data, size_t len) const;
+
+    // Queues the record for writing unless it is unchanged
+    bool put(CalRecordId id, const void *data, size_t len);
+
+    // Writes and syncs all queued records on the calling thread
+    bool flush();
+
+private:
+    struct Record {
+        bool valid;
+        bool dirty;
+        uint16_t len;
+        uint8_t data[CAL_STORE_MAX_RECORD];
+
+        // what is on disk; only changed by flush()
+        bool stored;
+        uint8_t slot;
+        uint32_t seq;
+    };
+
+    struct Flusher : public Thread {
+        explicit Flusher(CalStore *store);
+        virtual bool threadLoop();
+
+    private:
+        CalStore *mStore;
+    };
+
+    const char *mPath;
+    int mFd;
+    Record mRecords[NUM_CAL_RECORDS];
+
+    // mLock guards mRecords, mFlushLock serializes the writes
+    mutable Mutex mLock;
+    Mutex mFlushLock;
+    Condition mDirtyCond;
+    bool mPending;
+    sp<Flusher> mFlusher;
+
+    bool reset();
+    void startFlusher();
+
+    DISALLOW_EVIL_CONSTRUCTORS(CalStore);
+};
+
+}  // namespace android
+
+#endif  // CAL_STORE_H_
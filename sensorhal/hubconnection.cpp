@@ -22,6 +22,7 @@
 #include "JSONObject.h"
 
 #include <errno.h>
+#include <stdio.h>
 #include <unistd.h>
 #include <math.h>
 #include <inttypes.h>
@@ -34,6 +35,7 @@
 #include <cutils/ashmem.h>
 #include <cutils/properties.h>
 #include <hardware_legacy/power.h>
+#include <utils/SystemClock.h>
 #include <media/stagefright/foundation/ADebug.h>
 
 #include <algorithm>
@@ -116,6 +118,7 @@ static bool isWakeEvent(int32_t sensor)
 HubConnection::HubConnection()
     : Thread(false /* canCallJava */),
       mRing(10 *1024),
+      mCalStore(CONTEXTHUB_SAVED_CAL_PATH),
       mScaleAccel(1.0f),
       mScaleMag(1.0f),
       mStepCounterOffset(0ull),
@@ -135,7 +138,11 @@ HubConnection::HubConnection()
     mLefty.hub = false;
 
     memset(&mSensorState, 0x00, sizeof(mSensorState));
+    memset(&mFlushesPending, 0x00, sizeof(mFlushesPending));
     mFd = open(NANOHUB_FILE_PATH, O_RDWR);
+    if (mFd >= 0 && mHubRing.map(mFd))
+        ALOGI("Reading nanohub packets from the shared ring");
+    mHubRingDropped = mHubRing.isMapped() ? mHubRing.dropped() : 0;
     mPollFds[0].fd = mFd;
     mPollFds[0].events = POLLIN;
     mPollFds[0].revents = 0;
@@ -143,6 +150,8 @@ HubConnection::HubConnection()
 
     mWakelockHeld = false;
     mWakeEventCount = 0;
+    mWakeLockHoldNs = property_get_int32(WAKELOCK_HOLD_PROPERTY, 0) * 1000000LL;
+    mWakeLockIdleTime = 0;
     mWriteFailures = 0;
 
     initNanohubLock();
@@ -393,87 +402,58 @@ static std::vector<float> getFloatSetting(const sp<JSONObject> &settings, const
     return ret;
 }
 
-static void loadSensorSettings(sp<JSONObject>* settings,
-                               sp<JSONObject>* saved_settings) {
-    File settings_file(CONTEXTHUB_SETTINGS_PATH, "r");
-    File saved_settings_file(CONTEXTHUB_SAVED_SETTINGS_PATH, "r");
+static sp<JSONObject> loadSettings(const char *path) {
+    File settings_file(path, "r");
 
     status_t err;
     if ((err = settings_file.initCheck()) != OK) {
-        ALOGW("settings file open failed: %d (%s)",
+        ALOGW("settings file %s open failed: %d (%s)",
+              path,
               err,
               strerror(-err));
 
-        *settings = new JSONObject;
-    } else {
-        *settings = readSettings(&settings_file);
+        return new JSONObject;
     }
 
-    if ((err = saved_settings_file.initCheck()) != OK) {
-        ALOGW("saved settings file open failed: %d (%s)",
-              err,
-              strerror(-err));
-        *saved_settings = new JSONObject;
-    } else {
-        *saved_settings = readSettings(&saved_settings_file);
-    }
+    return readSettings(&settings_file);
 }
 
-void HubConnection::saveSensorSettings() const {
-    File saved_settings_file(CONTEXTHUB_SAVED_SETTINGS_PATH, "w");
-    sp<JSONObject> settingsObject = new JSONObject;
-
-    status_t err;
-    if ((err = saved_settings_file.initCheck()) != OK) {
-        ALOGW("saved settings file open failed %d (%s)",
-              err,
-              strerror(-err));
+void HubConnection::loadSavedCalibration() {
+    if (mCalStore.isOpen() || !mCalStore.open() || !mCalStore.isEmpty())
         return;
+
+    // First boot with the binary store: carry over what the JSON file that
+    // used to hold the saved calibration has
+    sp<JSONObject> saved_settings = loadSettings(CONTEXTHUB_SAVED_SETTINGS_PATH);
+    float bias[3];
+
+    if (getCalibrationFloat(saved_settings, MAG_BIAS_TAG, bias))
+        mCalStore.put(CAL_RECORD_MAG_BIAS, bias, sizeof(bias));
+    if (getCalibrationFloat(saved_settings, GYRO_SW_BIAS_TAG, bias))
+        mCalStore.put(CAL_RECORD_GYRO_SW_BIAS, bias, sizeof(bias));
+    if (getCalibrationFloat(saved_settings, ACCEL_SW_BIAS_TAG, bias))
+        mCalStore.put(CAL_RECORD_ACCEL_SW_BIAS, bias, sizeof(bias));
+
+    std::vector<float> gyroOtcData = getFloatSetting(saved_settings, GYRO_OTC_DATA_TAG);
+    if (gyroOtcData.size() == sizeof(GyroOtcData) / sizeof(float))
+        mCalStore.put(CAL_RECORD_GYRO_OTC_DATA, gyroOtcData.data(), sizeof(GyroOtcData));
+
+    // Retire the JSON once its values are on disk, so a store that is later
+    // reset (e.g. after a corrupt header) is not refilled with stale values
+    if (mCalStore.flush() &&
+        rename(CONTEXTHUB_SAVED_SETTINGS_PATH, CONTEXTHUB_SAVED_SETTINGS_PATH ".migrated") < 0 &&
+        errno != ENOENT) {
+        ALOGW("failed to retire %s: %s", CONTEXTHUB_SAVED_SETTINGS_PATH, strerror(errno));
     }
+}
+
+void HubConnection::saveMagBias() {
+    float bias[3] = { mMagBias[0], mMagBias[1], mMagBias[2] };
 
-    // Build a settings object.
-    sp<JSONArray> magArray = new JSONArray;
 #ifdef USB_MAG_BIAS_REPORTING_ENABLED
-    magArray->addFloat(mMagBias[0] + mUsbMagBias);
-#else
-    magArray->addFloat(mMagBias[0]);
+    bias[0] += mUsbMagBias;
 #endif  // USB_MAG_BIAS_REPORTING_ENABLED
-    magArray->addFloat(mMagBias[1]);
-    magArray->addFloat(mMagBias[2]);
-    settingsObject->setArray(MAG_BIAS_TAG, magArray);
-
-    // Add gyro settings
-    sp<JSONArray> gyroArray = new JSONArray;
-    gyroArray->addFloat(mGyroBias[0]);
-    gyroArray->addFloat(mGyroBias[1]);
-    gyroArray->addFloat(mGyroBias[2]);
-    settingsObject->setArray(GYRO_SW_BIAS_TAG, gyroArray);
-
-    // Add accel settings
-    sp<JSONArray> accelArray = new JSONArray;
-    accelArray->addFloat(mAccelBias[0]);
-    accelArray->addFloat(mAccelBias[1]);
-    accelArray->addFloat(mAccelBias[2]);
-    settingsObject->setArray(ACCEL_SW_BIAS_TAG, accelArray);
-
-    // Add overtemp calibration values for gyro
-    sp<JSONArray> gyroOtcDataArray = new JSONArray;
-    const float *f;
-    size_t i;
-    for (f = reinterpret_cast<const float *>(&mGyroOtcData), i = 0;
-            i < sizeof(mGyroOtcData)/sizeof(float); ++i, ++f) {
-        gyroOtcDataArray->addFloat(*f);
-    }
-    settingsObject->setArray(GYRO_OTC_DATA_TAG, gyroOtcDataArray);
-
-    // Write the JSON string to disk.
-    AString serializedSettings = settingsObject->toString();
-    size_t size = serializedSettings.size();
-    if ((err = saved_settings_file.write(serializedSettings.c_str(), size)) != (ssize_t)size) {
-        ALOGW("saved settings file write failed %d (%s)",
-              err,
-              strerror(-err));
-    }
+    mCalStore.put(CAL_RECORD_MAG_BIAS, bias, sizeof(bias));
 }
 
 ssize_t HubConnection::sendCmd(const void *buf, size_t count)
@@ -562,38 +542,49 @@ sensors_event_t *HubConnection::initEv(sensors_event_t *ev, uint64_t timestamp,
     return ev;
 }
 
-ssize_t HubConnection::decrementIfWakeEventLocked(int32_t sensor)
+void HubConnection::decrementWakeEventsLocked(size_t count)
 {
-    if (isWakeEvent(sensor)) {
-        if (mWakeEventCount > 0)
-            mWakeEventCount--;
-        else
-            ALOGW("%s: sensor=%d, unexpected count=%d, no-op",
-                  __FUNCTION__, sensor, mWakeEventCount);
+    if (count == 0)
+        return;
+
+    if (count > (size_t)mWakeEventCount) {
+        ALOGW("%s: %zu wake events read, unexpected count=%d",
+              __FUNCTION__, count, mWakeEventCount);
+        count = mWakeEventCount;
     }
 
-    return mWakeEventCount;
+    mWakeEventCount -= count;
+    if (mWakeEventCount == 0)
+        mWakeLockIdleTime = elapsedRealtimeNano();
 }
 
-void HubConnection::protectIfWakeEventLocked(int32_t sensor)
+void HubConnection::protectWakeEventsLocked(size_t count)
 {
-    if (isWakeEvent(sensor)) {
-        if (mWakelockHeld == false) {
-            acquire_wake_lock(PARTIAL_WAKE_LOCK, WAKELOCK_NAME);
-            mWakelockHeld = true;
-        }
-        mWakeEventCount++;
+    if (count == 0)
+        return;
+
+    if (mWakelockHeld == false) {
+        acquire_wake_lock(PARTIAL_WAKE_LOCK, WAKELOCK_NAME);
+        mWakelockHeld = true;
     }
+    mWakeEventCount += count;
 }
 
-void HubConnection::releaseWakeLockIfAppropriate()
+nsecs_t HubConnection::releaseWakeLockIfAppropriate()
 {
     Mutex::Autolock autoLock(mLock);
 
-    if (mWakelockHeld && (mWakeEventCount == 0)) {
-        mWakelockHeld = false;
-        release_wake_lock(WAKELOCK_NAME);
-    }
+    if (!mWakelockHeld || mWakeEventCount > 0)
+        return 0;
+
+    nsecs_t idle = elapsedRealtimeNano() - mWakeLockIdleTime;
+    if (idle < mWakeLockHoldNs)
+        return mWakeLockHoldNs - idle;
+
+    mWakelockHeld = false;
+    release_wake_lock(WAKELOCK_NAME);
+
+    return 0;
 }
 
 void HubConnection::processSample(uint64_t timestamp, uint32_t type, uint32_t sensor, struct OneAxisSample *sample, __attribute__((unused)) bool highAccuracy)
@@ -875,13 +866,13 @@ void HubConnection::processSample(uint64_t timestamp, uint32_t type, uint32_t se
         mAccelBias[0] = sample->x;
         mAccelBias[1] = sample->y;
         mAccelBias[2] = sample->z;
-        saveSensorSettings();
+        mCalStore.put(CAL_RECORD_ACCEL_SW_BIAS, mAccelBias, sizeof(mAccelBias));
         break;
     case COMMS_SENSOR_GYRO_BIAS:
         mGyroBias[0] = sample->x;
         mGyroBias[1] = sample->y;
         mGyroBias[2] = sample->z;
-        saveSensorSettings();
+        mCalStore.put(CAL_RECORD_GYRO_SW_BIAS, mGyroBias, sizeof(mGyroBias));
         break;
     case COMMS_SENSOR_MAG:
         sv = &initEv(&nev[cnt], timestamp, type, sensor)->magnetic;
@@ -917,7 +908,7 @@ void HubConnection::processSample(uint64_t timestamp, uint32_t type, uint32_t se
         mMagBias[1] = sample->y;
         mMagBias[2] = sample->z;
 
-        saveSensorSettings();
+        saveMagBias();
         break;
     case COMMS_SENSOR_ORIENTATION:
     case COMMS_SENSOR_LINEAR_ACCEL:
@@ -1017,12 +1008,10 @@ void HubConnection::restoreSensorState()
 
             cmd.cmd = CONFIG_CMD_FLUSH;
 
-            for (auto iter = mFlushesPending[i].cbegin(); iter != mFlushesPending[i].cend(); ++iter) {
-                for (int j = 0; j < iter->count; j++) {
-                    int ret = sendCmd(&cmd, sizeof(cmd));
-                    if (ret != sizeof(cmd)) {
-                        ALOGW("failed to send flush command to sensor %d\n", cmd.sensorType);
-                    }
+            for (uint32_t j = 0; j < mFlushesPending[i].pending; j++) {
+                int ret = sendCmd(&cmd, sizeof(cmd));
+                if (ret != sizeof(cmd)) {
+                    ALOGW("failed to send flush command to sensor %d\n", cmd.sensorType);
                 }
             }
         }
@@ -1037,22 +1026,25 @@ void HubConnection::postOsLog(uint8_t *buf, ssize_t len)
     if (len < 6)
         return;
 
-    buf[len] = 0x00;
+    // buf may be a packet in the shared ring, so don't terminate it in place
+    int msgLen = len - 5;
+    const char *msg = (const char *)&buf[5];
+
     switch (buf[4]) {
     case 'E':
-        ALOGE("osLog: %s", &buf[5]);
+        ALOGE("osLog: %.*s", msgLen, msg);
         break;
     case 'W':
-        ALOGW("osLog: %s", &buf[5]);
+        ALOGW("osLog: %.*s", msgLen, msg);
         break;
     case 'I':
-        ALOGI("osLog: %s", &buf[5]);
+        ALOGI("osLog: %.*s", msgLen, msg);
         break;
     case 'D':
-        ALOGD("osLog: %s", &buf[5]);
+        ALOGD("osLog: %.*s", msgLen, msg);
         break;
     case 'V':
-        ALOGV("osLog: %s", &buf[5]);
+        ALOGV("osLog: %.*s", msgLen, msg);
         break;
     default:
         break;
@@ -1077,7 +1069,7 @@ void HubConnection::processAppData(uint8_t *buf, ssize_t len) {
             return;
         }
         mGyroOtcData = data->gyroOtcData[0];
-        saveSensorSettings();
+        mCalStore.put(CAL_RECORD_GYRO_OTC_DATA, &mGyroOtcData, sizeof(mGyroOtcData));
         break;
     default:
         ALOGW("Unknown app to hal data type 0x%04x", data->type);
@@ -1334,11 +1326,15 @@ ssize_t HubConnection::processBuf(uint8_t *buf, size_t len)
         primary = (primary ? primary : sensor);
 
         for (i=0; i<data->firstSample.numFlushes; i++) {
+            struct Flush flush;
             bool internal = false;
 
             {
                 Mutex::Autolock autoLock(mLock);
-                struct Flush& flush = mFlushesPending[primary].front();
+                if (!popFlush(primary, &flush)) {
+                    ALOGW("flush complete for sensor %d with no flush pending\n", primary);
+                    break;
+                }
                 memset(&ev, 0x00, sizeof(sensors_event_t));
                 ev.version = META_DATA_VERSION;
                 ev.timestamp = 0;
@@ -1354,9 +1350,6 @@ ssize_t HubConnection::processBuf(uint8_t *buf, size_t len)
                     else if (flush.handle == COMMS_SENSOR_GYRO_WRIST_AWARE)
                         mLefty.gyro = !mLefty.gyro;
                 }
-
-                if (--flush.count == 0)
-                    mFlushesPending[primary].pop_front();
             }
 
             if (!internal)
@@ -1375,7 +1368,6 @@ ssize_t HubConnection::processBuf(uint8_t *buf, size_t len)
 void HubConnection::sendCalibrationOffsets()
 {
     sp<JSONObject> settings;
-    sp<JSONObject> saved_settings;
     struct {
         int32_t hw[3];
         float sw[3];
@@ -1383,12 +1375,16 @@ void HubConnection::sendCalibrationOffsets()
 
     int32_t proximity, proximity_array[4];
     float barometer, humidity, light;
-    bool accel_hw_cal_exists, accel_sw_cal_exists;
+    float softwareGyroBias[3], magBiasData[3];
+    bool accel_hw_cal_exists, accel_sw_cal_exists, gyro_sw_cal_exists;
 
-    loadSensorSettings(&settings, &saved_settings);
+    settings = loadSettings(CONTEXTHUB_SETTINGS_PATH);
+    loadSavedCalibration();
 
     accel_hw_cal_exists = getCalibrationInt32(settings, ACCEL_BIAS_TAG, accel.hw, 3);
-    accel_sw_cal_exists = getCalibrationFloat(saved_settings, ACCEL_SW_BIAS_TAG, accel.sw);
+    accel_sw_cal_exists = mCalStore.get(CAL_RECORD_ACCEL_SW_BIAS, accel.sw, sizeof(accel.sw));
+    if (!accel_sw_cal_exists)
+        memset(accel.sw, 0x00, sizeof(accel.sw));
     if (accel_hw_cal_exists || accel_sw_cal_exists) {
         // Store SW bias so we can remove bias for uncal data
         mAccelBias[0] = accel.sw[0];
@@ -1400,8 +1396,9 @@ void HubConnection::sendCalibrationOffsets()
 
     ALOGV("Use new configuration format");
     std::vector<int32_t> hardwareGyroBias = getInt32Setting(settings, GYRO_BIAS_TAG);
-    std::vector<float> softwareGyroBias = getFloatSetting(saved_settings, GYRO_SW_BIAS_TAG);
-    if (hardwareGyroBias.size() == 3 || softwareGyroBias.size() == 3) {
+    gyro_sw_cal_exists = mCalStore.get(CAL_RECORD_GYRO_SW_BIAS, softwareGyroBias,
+                                       sizeof(softwareGyroBias));
+    if (hardwareGyroBias.size() == 3 || gyro_sw_cal_exists) {
         struct {
             AppToSensorHalDataPayload header;
             GyroCalBias data;
@@ -1414,12 +1411,11 @@ void HubConnection::sendCalibrationOffsets()
             std::copy(hardwareGyroBias.begin(), hardwareGyroBias.end(),
                       packet.data.hardwareBias);
         }
-        if (softwareGyroBias.size() == 3) {
+        if (gyro_sw_cal_exists) {
             // Store SW bias so we can remove bias for uncal data
-            std::copy(softwareGyroBias.begin(), softwareGyroBias.end(),
-                      mGyroBias);
+            std::copy(softwareGyroBias, softwareGyroBias + 3, mGyroBias);
 
-            std::copy(softwareGyroBias.begin(), softwareGyroBias.end(),
+            std::copy(softwareGyroBias, softwareGyroBias + 3,
                       packet.data.softwareBias);
         }
         // send packet to hub
@@ -1427,10 +1423,7 @@ void HubConnection::sendCalibrationOffsets()
     }
 
     // over temp cal
-    std::vector<float> gyroOtcData = getFloatSetting(saved_settings, GYRO_OTC_DATA_TAG);
-    if (gyroOtcData.size() == sizeof(GyroOtcData) / sizeof(float)) {
-        std::copy(gyroOtcData.begin(), gyroOtcData.end(),
-                  reinterpret_cast<float*>(&mGyroOtcData));
+    if (mCalStore.get(CAL_RECORD_GYRO_OTC_DATA, &mGyroOtcData, sizeof(mGyroOtcData))) {
         struct {
             AppToSensorHalDataPayload header;
             GyroOtcData data;
@@ -1444,13 +1437,12 @@ void HubConnection::sendCalibrationOffsets()
         // send it to hub
         queueDataInternal(COMMS_SENSOR_GYRO, &packet, sizeof(packet));
     } else {
-        ALOGW("Illegal otc_gyro data size = %zu", gyroOtcData.size());
+        ALOGW("No saved otc_gyro data");
     }
 
-    std::vector<float> magBiasData = getFloatSetting(saved_settings, MAG_BIAS_TAG);
-    if (magBiasData.size() == 3) {
+    if (mCalStore.get(CAL_RECORD_MAG_BIAS, magBiasData, sizeof(magBiasData))) {
         // Store SW bias so we can remove bias for uncal data
-        std::copy(magBiasData.begin(), magBiasData.end(), mMagBias);
+        std::copy(magBiasData, magBiasData + 3, mMagBias);
 
         struct {
             AppToSensorHalDataPayload header;
@@ -1460,7 +1452,7 @@ void HubConnection::sendCalibrationOffsets()
                 .size = sizeof(MagCalBias),
                 .type = HALINTF_TYPE_MAG_CAL_BIAS }
         };
-        std::copy(magBiasData.begin(), magBiasData.end(), packet.mag.bias);
+        std::copy(magBiasData, magBiasData + 3, packet.mag.bias);
         queueDataInternal(COMMS_SENSOR_MAG, &packet, sizeof(packet));
     }
 
@@ -1528,20 +1520,16 @@ bool HubConnection::threadLoop() {
 #endif // DOUBLE_TOUCH_ENABLED
 
         if (mPollFds[0].revents & POLLIN) {
-            uint8_t recv[256];
-            ssize_t len = ::read(mFd, recv, sizeof(recv));
-
-            if (len >= 0) {
-                for (ssize_t offset = 0; offset < len;) {
-                    ret = processBuf(recv + offset, len - offset);
-
-                    if (ret > 0)
-                        offset += ret;
-                    else
-                        break;
-                }
+            if (mHubRing.isMapped()) {
+                processHubRing();
             } else {
-                ALOGW("read -1: errno=%d\n", errno);
+                uint8_t recv[256];
+                ssize_t len = ::read(mFd, recv, sizeof(recv));
+
+                if (len >= 0)
+                    processPackets(recv, len);
+                else
+                    ALOGW("read -1: errno=%d\n", errno);
             }
         }
     }
@@ -1549,6 +1537,38 @@ bool HubConnection::threadLoop() {
     return false;
 }
 
+void HubConnection::processPackets(uint8_t *buf, size_t len)
+{
+    for (size_t offset = 0; offset < len;) {
+        ssize_t ret = processBuf(buf + offset, len - offset);
+
+        if (ret > 0)
+            offset += ret;
+        else
+            break;
+    }
+}
+
+// Handles everything the driver has put in the shared ring, in place. The
+// device stays readable for as long as the ring is not empty, so poll() is
+// only needed again to sleep.
+void HubConnection::processHubRing()
+{
+    uint32_t dropped = mHubRing.dropped();
+    uint8_t *buf;
+    size_t len;
+
+    while ((buf = mHubRing.peek(&len)) != NULL) {
+        processPackets(buf, len);
+        mHubRing.consume();
+    }
+
+    if (dropped != mHubRingDropped) {
+        ALOGW("nanohub ring full: %" PRIu32 " packets dropped", dropped - mHubRingDropped);
+        mHubRingDropped = dropped;
+    }
+}
+
 void HubConnection::initConfigCmd(struct ConfigCmd *cmd, int handle)
 {
     memset(cmd, 0x00, sizeof(*cmd));
@@ -1682,13 +1702,32 @@ void HubConnection::queueBatch(
     }
 }
 
-void HubConnection::queueFlush(int handle)
+int HubConnection::queueFlush(int handle)
 {
     Mutex::Autolock autoLock(mLock);
-    queueFlushInternal(handle, false);
+    return queueFlushInternal(handle, false);
 }
 
-void HubConnection::queueFlushInternal(int handle, bool internal)
+// Takes the oldest pending flush of 'primary'. Called with mLock held.
+bool HubConnection::popFlush(uint32_t primary, struct Flush *flush)
+{
+    struct FlushQueue& queue = mFlushesPending[primary];
+    struct Flush& front = queue.entries[queue.head];
+
+    if (queue.len == 0)
+        return false;
+
+    *flush = front;
+    queue.pending--;
+    if (--front.count == 0) {
+        queue.head = (queue.head + 1) % MAX_FLUSH_ENTRIES;
+        queue.len--;
+    }
+
+    return true;
+}
+
+int HubConnection::queueFlushInternal(int handle, bool internal)
 {
     struct ConfigCmd cmd;
     uint32_t primary;
@@ -1700,15 +1739,25 @@ void HubConnection::queueFlushInternal(int handle, bool internal)
         primary = mSensorState[handle].primary;
         primary = (primary ? primary : handle);
 
-        std::list<Flush>& flushList = mFlushesPending[primary];
+        struct FlushQueue& queue = mFlushesPending[primary];
+        struct Flush *back = NULL;
 
-        if (!flushList.empty() &&
-            flushList.back().internal == internal &&
-            flushList.back().handle == handle) {
-            ++flushList.back().count;
+        if (queue.len > 0)
+            back = &queue.entries[(queue.head + queue.len - 1) % MAX_FLUSH_ENTRIES];
+
+        if (back && back->internal == internal && back->handle == handle &&
+            back->count < UINT16_MAX) {
+            ++back->count;
+        } else if (queue.len < MAX_FLUSH_ENTRIES) {
+            queue.entries[(queue.head + queue.len) % MAX_FLUSH_ENTRIES] =
+                    (struct Flush){handle, 1, internal};
+            queue.len++;
         } else {
-            flushList.push_back((struct Flush){handle, 1, internal});
+            ALOGW("queueFlush: too many flushes pending on sensor %d, dropping flush for handle=%d",
+                  primary, handle);
+            return -EBUSY;
         }
+        queue.pending++;
 
         initConfigCmd(&cmd, handle);
         cmd.cmd = CONFIG_CMD_FLUSH;
@@ -1724,6 +1773,8 @@ void HubConnection::queueFlushInternal(int handle, bool internal)
     } else {
         ALOGV("queueFlush: unhandled handle=%d", handle);
     }
+
+    return 0;
 }
 
 void HubConnection::queueDataInternal(int handle, void *data, size_t length)
@@ -1807,7 +1858,17 @@ void HubConnection::initNanohubLock() {
 }
 
 ssize_t HubConnection::read(sensors_event_t *ev, size_t size) {
-    ssize_t n = mRing.read(ev, size);
+    size_t numWakeEvents = 0;
+    nsecs_t holdNs;
+    ssize_t n;
+
+    // Release the wake lock if held and no more events in ring buffer. While
+    // the release hysteresis keeps it, only wait for new events until that
+    // runs out so the lock is not kept across an idle ring.
+    do {
+        holdNs = releaseWakeLockIfAppropriate();
+        n = mRing.read(ev, size, holdNs > 0 ? holdNs : -1);
+    } while (n == 0);
 
     Mutex::Autolock autoLock(mLock);
 
@@ -1818,14 +1879,18 @@ ssize_t HubConnection::read(sensors_event_t *ev, size_t size) {
         mWriteFailures = 0;
     }
 
-    for (ssize_t i = 0; i < n; i++)
-        decrementIfWakeEventLocked(ev[i].sensor);
+    for (ssize_t i = 0; i < n; i++) {
+        if (isWakeEvent(ev[i].sensor))
+            numWakeEvents++;
+    }
+    decrementWakeEventsLocked(numWakeEvents);
 
     return n;
 }
 
 
 ssize_t HubConnection::write(const sensors_event_t *ev, size_t n) {
+    size_t numWakeEvents = 0;
     ssize_t ret = 0;
 
     Mutex::Autolock autoLock(mLock);
@@ -1833,8 +1898,8 @@ ssize_t HubConnection::write(const sensors_event_t *ev, size_t n) {
     for (size_t i=0; i<n; i++) {
         if (mRing.write(&ev[i], 1) == 1) {
             ret++;
-            // If event is a wake event, protect it with a wakelock
-            protectIfWakeEventLocked(ev[i].sensor);
+            if (isWakeEvent(ev[i].sensor))
+                numWakeEvents++;
         } else {
             if (mWriteFailures++ == 0)
                 ALOGW("%s: mRing.write failed @ %zu/%zu",
@@ -1843,6 +1908,9 @@ ssize_t HubConnection::write(const sensors_event_t *ev, size_t n) {
         }
     }
 
+    // Protect the wake events of the whole batch with one wakelock
+    protectWakeEventsLocked(numWakeEvents);
+
     return ret;
 }
 
@@ -27,17 +27,20 @@
 #include <utils/Mutex.h>
 #include <utils/Thread.h>
 
-#include <list>
+#include <vector>
 
+#include "calstore.h"
 #include "directchannel.h"
 #include "eventnums.h"
 #include "halIntf.h"
 #include "hubdefs.h"
+#include "hubring.h"
 #include "ring.h"
 
 #include <unordered_map>
 
 #define WAKELOCK_NAME "sensorHal"
+#define WAKELOCK_HOLD_PROPERTY "persist.nanohub.wakelock_hold_ms"
 
 #define ACCEL_BIAS_TAG     "accel"
 #define ACCEL_SW_BIAS_TAG  "accel_sw"
@@ -47,6 +50,7 @@
 #define MAG_BIAS_TAG       "mag"
 
 #define MAX_ALTERNATES     2
+#define MAX_FLUSH_ENTRIES  16
 
 namespace android {
 
@@ -70,19 +74,19 @@ struct HubConnection : public Thread {
     void queueSetDelay(int handle, nsecs_t delayNs);
     void queueBatch(int handle, nsecs_t sampling_period_ns,
             nsecs_t max_report_latency_ns);
-    void queueFlush(int handle);
+    int queueFlush(int handle);
     void queueData(int handle, void *data, size_t length);
 
     void setOperationParameter(const additional_info_event_t &info);
 
-    void releaseWakeLockIfAppropriate();
+    // Returns how much longer the release hysteresis keeps an idle wake
+    // lock held, or 0 if it is not held or was just released
+    nsecs_t releaseWakeLockIfAppropriate();
 
     //TODO: factor out event ring buffer functionality into a separate class
     ssize_t read(sensors_event_t *ev, size_t size);
     ssize_t write(const sensors_event_t *ev, size_t n);
 
-    void saveSensorSettings() const;
-
     void setRawScale(float scaleAccel, float scaleMag) {
         mScaleAccel = scaleAccel;
         mScaleMag = scaleMag;
@@ -102,8 +106,15 @@ private:
     bool mWakelockHeld;
     int32_t mWakeEventCount;
 
-    void protectIfWakeEventLocked(int32_t sensor);
-    ssize_t decrementIfWakeEventLocked(int32_t sensor);
+    // The wake lock is taken when a write() brings the number of unread wake
+    // events up from 0 and dropped once read() has taken them all, but only
+    // after mWakeLockHoldNs more without a new wake event, so that bursts
+    // share one acquire/release pair.
+    nsecs_t mWakeLockHoldNs;
+    nsecs_t mWakeLockIdleTime;
+
+    void protectWakeEventsLocked(size_t count);
+    void decrementWakeEventsLocked(size_t count);
 
     static inline uint64_t period_ns_to_frequency_q10(nsecs_t period_ns) {
         return 1024000000000ULL / period_ns;
@@ -156,13 +167,24 @@ private:
     struct Flush
     {
         int handle;
-        uint8_t count;
+        uint16_t count;
 
         // Used to synchronize the transition in and out of
         // lefty mode between nanohub and the AP.
         bool internal;
     };
 
+    // Flushes sent to nanohub for one primary sensor, oldest first. Back to
+    // back flushes for the same handle share an entry, so the ring only runs
+    // out when callers keep alternating between the handles of a primary.
+    struct FlushQueue
+    {
+        struct Flush entries[MAX_FLUSH_ENTRIES];
+        uint8_t head;
+        uint8_t len;
+        uint32_t pending; // sum of entries[].count
+    };
+
     struct SensorState {
         uint64_t latency;
         uint64_t lastTimestamp;
@@ -236,6 +258,10 @@ private:
     Mutex mLock;
 
     RingBuffer mRing;
+
+    // Packets from nanohub when its driver shares them through mmap()
+    HubRingReader mHubRing;
+    uint32_t mHubRingDropped;
     int32_t mWriteFailures;
 
     float mMagBias[3];
@@ -246,12 +272,14 @@ private:
     bool mAccelEnabledBiasStored;
     GyroOtcData mGyroOtcData;
 
+    CalStore mCalStore;
+
     float mScaleAccel, mScaleMag;
 
     LeftyState mLefty;
 
     SensorState mSensorState[NUM_COMMS_SENSORS_PLUS_1];
-    std::list<struct Flush> mFlushesPending[NUM_COMMS_SENSORS_PLUS_1];
+    struct FlushQueue mFlushesPending[NUM_COMMS_SENSORS_PLUS_1];
 
     uint64_t mStepCounterOffset;
     uint64_t mLastStepCount;
@@ -269,6 +297,8 @@ private:
     void postOsLog(uint8_t *buf, ssize_t len);
     void processAppData(uint8_t *buf, ssize_t len);
     ssize_t processBuf(uint8_t *buf, size_t len);
+    void processPackets(uint8_t *buf, size_t len);
+    void processHubRing();
 
     inline bool isValidHandle(int handle) {
         return handle >= 0
@@ -279,7 +309,8 @@ private:
     ssize_t sendCmd(const void *buf, size_t count);
     void initConfigCmd(struct ConfigCmd *cmd, int handle);
 
-    void queueFlushInternal(int handle, bool internal);
+    int queueFlushInternal(int handle, bool internal);
+    bool popFlush(uint32_t primary, struct Flush *flush);
 
     void queueDataInternal(int handle, void *data, size_t length);
 
@@ -290,6 +321,8 @@ private:
 
     void restoreSensorState();
     void sendCalibrationOffsets();
+    void loadSavedCalibration();
+    void saveMagBias();
 
     // Enable SCHED_FIFO priority for main thread
     void enableSchedFifoMode();
@@ -102,9 +102,6 @@ int SensorContext::setDelay(int handle, int64_t delayNs) {
 int SensorContext::poll(sensors_event_t *data, int count) {
     ALOGV("poll");
 
-    // Release wakelock if held and no more events in ring buffer
-    mHubConnection->releaseWakeLockIfAppropriate();
-
     return mHubConnection->read(data, count);
 }
 
@@ -311,8 +308,7 @@ int SensorContext::HubConnectionOperation::batch(
 }
 
 int SensorContext::HubConnectionOperation::flush(int handle) {
-    mHubConnection->queueFlush(handle);
-    return 0;
+    return mHubConnection->queueFlush(handle);
 }
 
 #ifdef DYNAMIC_SENSOR_EXT_ENABLED
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hubring.h"
+
+#include <string.h>
+#include <sys/mman.h>
+
+namespace android {
+
+static inline uint32_t recordSize(size_t len) {
+    return (sizeof(struct HubRingRecord) + len + HUB_RING_ALIGN - 1) & ~(HUB_RING_ALIGN - 1);
+}
+
+HubRingReader::HubRingReader()
+    : mHeader(NULL),
+      mData(NULL),
+      mMapSize(0),
+      mNext(0),
+      mResyncs(0) {
+}
+
+HubRingReader::~HubRingReader() {
+    unmap();
+}
+
+bool HubRingReader::map(int fd) {
+    struct HubRingHeader *header;
+    size_t size;
+    void *mem;
+
+    unmap();
+
+    mem = mmap(NULL, sizeof(*header), PROT_READ, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED)
+        return false;
+
+    header = (struct HubRingHeader *)mem;
+    size = header->dataOffset + header->size;
+    bool valid = header->magic == HUB_RING_MAGIC &&
+                 header->version == HUB_RING_VERSION &&
+                 header->size >= 2 * sizeof(struct HubRingRecord) &&
+                 (header->size & (header->size - 1)) == 0 &&
+                 header->dataOffset >= sizeof(*header) &&
+                 (header->dataOffset & (HUB_RING_ALIGN - 1)) == 0;
+    munmap(mem, sizeof(*header));
+
+    if (!valid)
+        return false;
+
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED)
+        return false;
+
+    mHeader = (struct HubRingHeader *)mem;
+    mData = (uint8_t *)mem + mHeader->dataOffset;
+    mMapSize = size;
+    mNext = __atomic_load_n(&mHeader->tail, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+void HubRingReader::unmap() {
+    if (mHeader != NULL) {
+        munmap(mHeader, mMapSize);
+        mHeader = NULL;
+        mData = NULL;
+        mMapSize = 0;
+    }
+}
+
+uint8_t *HubRingReader::peek(size_t *len) {
+    uint32_t size = mHeader->size;
+    uint32_t tail = __atomic_load_n(&mHeader->tail, __ATOMIC_RELAXED);
+
+    for (;;) {
+        // pairs with the fence in HubRingWriter::write() so that either we
+        // see the new head here or the writer sees our tail and wakes us
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        uint32_t head = __atomic_load_n(&mHeader->head, __ATOMIC_ACQUIRE);
+        uint32_t avail = head - tail;
+        uint32_t pos = tail & (size - 1);
+        struct HubRingRecord *rec = (struct HubRingRecord *)(mData + pos);
+
+        if (avail == 0)
+            return NULL;
+
+        if (avail < sizeof(*rec) || avail > size || (pos & (HUB_RING_ALIGN - 1)))
+            goto resync;
+
+        if (rec->flags & HUB_RING_FLAG_WRAP) {
+            if (avail < size - pos)
+                goto resync;
+            tail += size - pos;
+            __atomic_store_n(&mHeader->tail, tail, __ATOMIC_RELEASE);
+            continue;
+        }
+
+        if (recordSize(rec->len) > avail || pos + recordSize(rec->len) > size)
+            goto resync;
+
+        *len = rec->len;
+        mNext = tail + recordSize(rec->len);
+        return (uint8_t *)(rec + 1);
+
+resync:
+        // the producer broke the format; drop what it wrote so far
+        mResyncs++;
+        __atomic_store_n(&mHeader->tail, head, __ATOMIC_RELEASE);
+        return NULL;
+    }
+}
+
+void HubRingReader::consume() {
+    __atomic_store_n(&mHeader->tail, mNext, __ATOMIC_RELEASE);
+}
+
+uint32_t HubRingReader::dropped() const {
+    return __atomic_load_n(&mHeader->dropped, __ATOMIC_RELAXED);
+}
+
+bool HubRingWriter::init(void *mem, size_t memSize, uint32_t dataOffset) {
+    struct HubRingHeader *header = (struct HubRingHeader *)mem;
+    uint32_t size;
+
+    if (dataOffset < sizeof(*header) || (dataOffset & (HUB_RING_ALIGN - 1)) ||
+        memSize < dataOffset + 2 * sizeof(struct HubRingRecord))
+        return false;
+
+    for (size = 1; size <= (memSize - dataOffset) / 2; size <<= 1)
+        ;
+
+    memset(header, 0x00, sizeof(*header));
+    header->size = size;
+    header->dataOffset = dataOffset;
+    header->version = HUB_RING_VERSION;
+    __atomic_store_n(&header->magic, HUB_RING_MAGIC, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+HubRingWriter::HubRingWriter(void *mem)
+    : mHeader((struct HubRingHeader *)mem),
+      mData((uint8_t *)mem + mHeader->dataOffset) {
+}
+
+bool HubRingWriter::write(const void *data, size_t len, bool *wake) {
+    uint32_t size = mHeader->size;
+    uint32_t head = __atomic_load_n(&mHeader->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&mHeader->tail, __ATOMIC_ACQUIRE);
+    uint32_t need = recordSize(len);
+    uint32_t pos = head & (size - 1);
+    uint32_t pad = size - pos < need ? size - pos : 0;
+    struct HubRingRecord *rec;
+
+    *wake = false;
+
+    if (len > UINT16_MAX || size - (head - tail) < pad + need) {
+        mHeader->dropped++;
+        return false;
+    }
+
+    if (pad) {
+        rec = (struct HubRingRecord *)(mData + pos);
+        rec->len = 0;
+        rec->flags = HUB_RING_FLAG_WRAP;
+        pos = 0;
+    }
+
+    rec = (struct HubRingRecord *)(mData + pos);
+    rec->len = len;
+    rec->flags = 0;
+    memcpy(rec + 1, data, len);
+
+    __atomic_store_n(&mHeader->head, head + pad + need, __ATOMIC_RELEASE);
+
+    // the reader only sleeps after finding head == tail; if it had caught
+    // up with the old head it may have done so before our store
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    *wake = __atomic_load_n(&mHeader->tail, __ATOMIC_RELAXED) == head;
+
+    return true;
+}
+
+}  // namespace android
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HUB_RING_H_
+
+#define HUB_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Packet ring shared by the nanohub driver and its reader through mmap() of
+ * the device node, so that a streaming reader needs poll() only to sleep
+ * when the ring is empty instead of a read() per packet.
+ *
+ * The mapping starts with struct HubRingHeader; the data area follows at
+ * dataOffset. head is only written by the producer, tail only by the
+ * reader. Both are free-running byte counts and the data area, whose size
+ * is a power of two, is indexed modulo its size. Every packet is stored as
+ * a struct HubRingRecord followed by the payload, padded to HUB_RING_ALIGN,
+ * and never wraps: when it does not fit before the end of the data area the
+ * producer writes a HUB_RING_FLAG_WRAP record and starts over at offset 0.
+ * The device reports POLLIN for as long as head != tail.
+ */
+
+#define HUB_RING_MAGIC          0x474e5248 // "HRNG"
+#define HUB_RING_VERSION        1
+#define HUB_RING_ALIGN          4
+#define HUB_RING_FLAG_WRAP      0x0001
+
+struct HubRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;          // bytes in the data area
+    uint32_t dataOffset;    // of the data area, from the start of the mapping
+
+    // producer side
+    uint32_t head __attribute__((aligned(64)));
+    uint32_t dropped;       // packets that did not fit
+
+    // reader side
+    uint32_t tail __attribute__((aligned(64)));
+} __attribute__((aligned(64)));
+
+struct HubRingRecord {
+    uint16_t len;           // payload bytes
+    uint16_t flags;
+};
+
+#ifdef __cplusplus
+
+namespace android {
+
+struct HubRingReader {
+    HubRingReader();
+    ~HubRingReader();
+
+    // Maps the ring exported by fd; fails if fd has none
+    bool map(int fd);
+    void unmap();
+    bool isMapped() const { return mHeader != NULL; }
+
+    // Returns the next packet in place, or NULL if the ring is empty. The
+    // packet stays valid until consume().
+    uint8_t *peek(size_t *len);
+    void consume();
+
+    uint32_t dropped() const;
+    uint32_t resyncs() const { return mResyncs; }
+
+private:
+    struct HubRingHeader *mHeader;
+    uint8_t *mData;
+    size_t mMapSize;
+    uint32_t mNext;
+    uint32_t mResyncs;
+
+    HubRingReader(const HubRingReader &);
+    HubRingReader &operator=(const HubRingReader &);
+};
+
+// Userspace producer with the same behaviour as the driver, for bringing up
+// and testing readers without one (see util/hubring_producer).
+struct HubRingWriter {
+    // Lays out an empty ring over mem; memSize - dataOffset is rounded down
+    // to a power of two
+    static bool init(void *mem, size_t memSize, uint32_t dataOffset);
+
+    explicit HubRingWriter(void *mem);
+
+    // Returns false if the packet did not fit. Sets *wake if the reader may
+    // have seen the ring empty and has to be woken up.
+    bool write(const void *data, size_t len, bool *wake);
+
+private:
+    struct HubRingHeader *mHeader;
+    uint8_t *mData;
+
+    HubRingWriter(const HubRingWriter &);
+    HubRingWriter &operator=(const HubRingWriter &);
+};
+
+}  // namespace android
+
+#endif // __cplusplus
+
+#endif  // HUB_RING_H_
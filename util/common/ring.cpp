@@ -66,9 +66,11 @@ ssize_t RingBuffer::write(const sensors_event_t *ev, size_t size) {
     return size;
 }
 
-ssize_t RingBuffer::read(sensors_event_t *ev, size_t size) {
+ssize_t RingBuffer::read(sensors_event_t *ev, size_t size, nsecs_t timeoutNs) {
     Mutex::Autolock autoLock(mLock);
 
+    // spurious wakeups must not restart the timeout
+    nsecs_t deadline = timeoutNs < 0 ? 0 : systemTime(SYSTEM_TIME_MONOTONIC) + timeoutNs;
     size_t numAvailableToRead;
     for (;;) {
         numAvailableToRead = mWritePos - mReadPos;
@@ -76,7 +78,15 @@ ssize_t RingBuffer::read(sensors_event_t *ev, size_t size) {
             break;
         }
 
-        mNotEmptyCondition.wait(mLock);
+        if (timeoutNs < 0) {
+            mNotEmptyCondition.wait(mLock);
+        } else {
+            nsecs_t remaining = deadline - systemTime(SYSTEM_TIME_MONOTONIC);
+            if (remaining <= 0) {
+                return 0;
+            }
+            mNotEmptyCondition.waitRelative(mLock, remaining);
+        }
     }
 
     if (size > numAvailableToRead) {
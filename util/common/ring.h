@@ -30,7 +30,9 @@ struct RingBuffer {
     ~RingBuffer();
 
     ssize_t write(const sensors_event_t *ev, size_t size);
-    ssize_t read(sensors_event_t *ev, size_t size);
+    // Blocks until at least one event is available, or for at most
+    // timeoutNs if that is not negative; returns 0 on timeout.
+    ssize_t read(sensors_event_t *ev, size_t size, nsecs_t timeoutNs = -1);
 
 private:
     Mutex mLock;
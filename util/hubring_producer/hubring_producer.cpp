@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Reference producer for the shared packet ring in util/common/hubring.h.
+//
+// Streams sensor-sized packets through a ring in a temporary file, the way
+// the nanohub driver does through the device mapping, to a forked reader
+// built on HubRingReader. An eventfd stands in for the device's POLLIN. The
+// reader checks the packet sequence and reports how many syscalls it needed
+// per packet.
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hubring.h"
+
+using android::HubRingReader;
+using android::HubRingWriter;
+
+#define DATA_OFFSET     4096
+#define SEQ_END         UINT32_MAX
+
+static void showHelp()
+{
+    printf("Usage: hubring_producer [-h] [-n <packets>] [-l <packet_bytes>] [-r <packets_per_sec>]\n"
+           "                        [-b <burst>] [-s <ring_bytes>]\n");
+}
+
+static void sleepNs(uint64_t ns)
+{
+    struct timespec ts = { (time_t)(ns / 1000000000), (long)(ns % 1000000000) };
+
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR)
+        ;
+}
+
+static void signalReader(int efd)
+{
+    uint64_t one = 1;
+
+    if (write(efd, &one, sizeof(one)) != sizeof(one))
+        perror("eventfd write");
+}
+
+static int runReader(int fd, int efd)
+{
+    HubRingReader ring;
+    struct pollfd pfd = { efd, POLLIN, 0 };
+    uint32_t expected = 0;
+    uint64_t packets = 0, bytes = 0, syscalls = 0, errors = 0;
+    uint64_t value;
+
+    if (!ring.map(fd)) {
+        fprintf(stderr, "reader: no ring to map\n");
+        return 1;
+    }
+
+    for (;;) {
+        size_t len;
+        uint8_t *pkt = ring.peek(&len);
+
+        if (pkt == NULL) {
+            // the device node would be polled here, and would not need
+            // clearing with a read
+            syscalls += 2;
+            if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+                break;
+            if (read(efd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+                break;
+            continue;
+        }
+
+        uint32_t seq;
+        if (len < sizeof(seq)) {
+            errors++;
+            ring.consume();
+            continue;
+        }
+        memcpy(&seq, pkt, sizeof(seq));
+        ring.consume();
+
+        if (seq == SEQ_END)
+            break;
+        if (seq != expected)
+            errors++;
+        expected = seq + 1;
+        packets++;
+        bytes += len;
+    }
+
+    printf("reader: %" PRIu64 " packets, %" PRIu64 " bytes, %" PRIu64 " sequence errors\n",
+           packets, bytes, errors);
+    printf("reader: %" PRIu64 " syscalls (%.4f per packet; read() would need at least 1)\n",
+           syscalls, packets ? (double)syscalls / packets : 0.0);
+    printf("reader: %" PRIu32 " dropped by producer, %" PRIu32 " resyncs\n",
+           ring.dropped(), ring.resyncs());
+
+    return errors ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t numPackets = 100000, packetLen = 60, rate = 0, burst = 16;
+    size_t ringBytes = 64 * 1024;
+    uint8_t pkt[UINT16_MAX];
+    uint32_t seq, dropped = 0, wakes = 0;
+    bool wake;
+    int opt, status;
+
+    while ((opt = getopt(argc, argv, "hn:l:r:b:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            numPackets = strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            packetLen = strtoul(optarg, NULL, 0);
+            break;
+        case 'r':
+            rate = strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            burst = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            ringBytes = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            showHelp();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (packetLen < sizeof(seq) || packetLen > sizeof(pkt) || burst == 0) {
+        showHelp();
+        return 1;
+    }
+
+    FILE *file = tmpfile();
+    int efd = eventfd(0, EFD_NONBLOCK);
+    if (file == NULL || efd < 0) {
+        perror("setup");
+        return 1;
+    }
+
+    int fd = fileno(file);
+    size_t mapSize = DATA_OFFSET + ringBytes;
+    void *mem;
+    if (ftruncate(fd, mapSize) < 0 ||
+        (mem = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        perror("ring");
+        return 1;
+    }
+
+    if (!HubRingWriter::init(mem, mapSize, DATA_OFFSET)) {
+        fprintf(stderr, "ring too small\n");
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    } else if (pid == 0) {
+        return runReader(fd, efd);
+    }
+
+    HubRingWriter ring(mem);
+    memset(pkt, 0xa5, sizeof(pkt));
+
+    // like the driver, drop packets while the ring is full; a burst is what
+    // one hub interrupt delivers
+    for (seq = 0; seq < numPackets; seq++) {
+        memcpy(pkt, &seq, sizeof(seq));
+        if (!ring.write(pkt, packetLen, &wake)) {
+            dropped++;
+            // keep the sequence check meaningful
+            seq--;
+            sleepNs(100000);
+            continue;
+        }
+        if (wake) {
+            signalReader(efd);
+            wakes++;
+        }
+        if (rate && (seq + 1) % burst == 0)
+            sleepNs(1000000000ull * burst / rate);
+    }
+
+    seq = SEQ_END;
+    memcpy(pkt, &seq, sizeof(seq));
+    while (!ring.write(pkt, sizeof(seq), &wake))
+        sleepNs(100000);
+    signalReader(efd);
+
+    waitpid(pid, &status, 0);
+    printf("producer: %" PRIu32 " packets, %" PRIu32 " wakeups, %" PRIu32 " retries on full ring\n",
+           numPackets, wakes, dropped);
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
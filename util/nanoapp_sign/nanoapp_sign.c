@@ -19,6 +19,11 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include <nanohub/nanohub.h>
 #include <nanohub/nanoapp.h>
@@ -118,7 +123,10 @@ struct RsaData {
     uint32_t num[RSA_LIMBS];
     uint32_t exponent[RSA_LIMBS];
     uint32_t modulus[RSA_LIMBS];
+    struct RsaCrtKey crt;
+    bool haveCrt;
     struct RsaState state;
+    struct RsaPrivState privState;
 };
 
 static bool validateSignature(uint8_t *sigPack, struct RsaData *rsa, bool verbose, uint32_t *refHash, bool preset)
@@ -188,36 +196,42 @@ static bool validateSignature(uint8_t *sigPack, struct RsaData *rsa, bool verbos
 
 #define SIGNATURE_BLOCK_SIZE    (2 * RSA_BYTES)
 
+//modulus and private exponent convert to RSA_BYTES; CRT values (primes, their exponents and qInv) to RSA_HALF_BYTES
 static int handleConvertKey(uint8_t **pbuf, uint32_t bufUsed, FILE *out, struct RsaData *rsa)
 {
     bool  haveNonzero = false;
     uint8_t *buf = *pbuf;
+    uint8_t be[RSA_BYTES];
+    uint32_t len = 0, outLen;
     int i, c;
     uint32_t pos = 0;
     int ret;
 
-    for (i = 0; i < (int)RSA_BYTES; i++) {
+    while (1) {
 
         //get a byte, skipping all zeroes (openssl likes to prepend one at times)
         do {
             c = getHexEncodedByte(buf, &pos, bufUsed);
         } while (c == 0 && !haveNonzero);
         haveNonzero = true;
-        if (c < 0) {
+        if (c < 0 && pos == bufUsed && len)
+            break;
+        if (c < 0 || len == RSA_BYTES) {
             fprintf(stderr, "Invalid text RSA input data\n");
             return 2;
         }
 
-        buf[i] = c;
+        be[len++] = c;
     }
 
-    // change form BE to native; ignore alignment
-    uint32_t *be32Buf = (uint32_t*)buf;
-    for (i = 0; i < RSA_LIMBS; i++)
-        rsa->num[RSA_LIMBS - i - 1] = be32toh(be32Buf[i]);
+    // change form BE to native
+    memset(rsa->num, 0, sizeof(rsa->num));
+    for (i = 0; i < (int)len; i++)
+        rsa->num[i / 4] |= (uint32_t)be[len - i - 1] << (8 * (i % 4));
 
     //output in our binary format (little-endian)
-    ret = fwrite(rsa->num, 1, RSA_BYTES, out) == RSA_BYTES ? 0 : 2;
+    outLen = len <= RSA_HALF_BYTES ? RSA_HALF_BYTES : RSA_BYTES;
+    ret = fwrite(rsa->num, 1, outLen, out) == outLen ? 0 : 2;
     fprintf(stderr, "Conversion status: %d\n", ret);
 
     return ret;
@@ -381,9 +395,18 @@ static int handleSign(uint8_t **pbuf, uint32_t bufUsed, FILE *out, struct RsaDat
 
     //do the RSA thing
     fprintf(stderr, "Retriculating splines...");
-    rsaResult = rsaPrivOp(&rsa->state, rsa->num, rsa->exponent, rsa->modulus);
+    if (rsa->haveCrt)
+        rsaResult = rsaPrivOpCrt(&rsa->privState, rsa->num, &rsa->crt);
+    else
+        rsaResult = rsaPrivOpMont(&rsa->privState, rsa->num, rsa->exponent, rsa->modulus);
     fprintf(stderr, "DONE\n");
 
+    //a private key that matches the modulus can still have a bad exponent or CRT values; do not let it produce garbage silently
+    if (memcmp(rsaPubOp(&rsa->state, rsaResult, rsa->modulus), rsa->num, RSA_BYTES)) {
+        fprintf(stderr, "Signature does not verify; bad private key?\n");
+        return 2;
+    }
+
     //update the user
     if (verbose)
         printHashRev(stderr, "RSA cyphertext", rsaResult, RSA_LIMBS);
@@ -407,27 +430,135 @@ static void fatalUsage(const char *name, const char *msg, const char *arg)
         fprintf(stderr, "Error: %s\n\n", msg);
 
     fprintf(stderr, "USAGE: %s [-v] [-e <pvt key>] [-m <pub key>] [-t] [-s] [-b] <input file> [<output file>]\n"
+                    "       %s -s -j <jobs> -e <pvt key> -m <pub key> [-r] <input file> <output file> [<input file> <output file> ...]\n"
                     "       -v : be verbose\n"
                     "       -b : generate binary key from text file created by OpenSSL\n"
+                    "            (modulus and exponent give %u bytes; primes, their exponents and qInv give %u)\n"
                     "       -s : sign post-processed file\n"
                     "       -t : verify signature of signed post-processed file\n"
-                    "       -e : RSA binary private key\n"
+                    "       -e : RSA binary private key: the exponent, optionally followed by\n"
+                    "            p, q, dP, dQ and qInv (faster signing)\n"
                     "       -m : RSA binary public key\n"
                     "       -r : do not parse headers, do not generate headers (with -t, -s)\n"
-                    , name);
+                    "       -j : sign input/output file pairs, up to <jobs> at a time\n"
+                    , name, name, (unsigned)RSA_BYTES, (unsigned)RSA_HALF_BYTES);
     exit(1);
 }
 
-int main(int argc, char **argv)
+static int handleFile(const char *inFile, const char *outFile, struct RsaData *rsa,
+                      bool verbose, bool sign, bool verify, bool txt2bin, bool bareData)
 {
     uint32_t bufUsed = 0;
     uint8_t *buf = NULL;
+    FILE *out = NULL;
     int ret = -1;
+    struct ImageHeader *image;
+
+    buf = loadFile(inFile, &bufUsed);
+    fprintf(stderr, "Read %" PRIu32 " bytes\n", bufUsed);
+
+    image = (struct ImageHeader *)buf;
+    if (!bareData && !txt2bin) {
+        if (bufUsed >= sizeof(*image) &&
+            image->aosp.header_version == 1 &&
+            image->aosp.magic == NANOAPP_AOSP_MAGIC &&
+            image->layout.magic == GOOGLE_LAYOUT_MAGIC) {
+            fprintf(stderr, "Found AOSP header\n");
+        } else {
+            fprintf(stderr, "Unknown binary format\n");
+            free(buf);
+            return 2;
+        }
+    }
+
+    if (!outFile)
+        out = stdout;
+    else
+        out = fopen(outFile, "w");
+    if (!out) {
+        fprintf(stderr, "failed to create/open output file: %s\n", outFile);
+        free(buf);
+        return 2;
+    }
+
+    if (sign)
+        ret = handleSign(&buf, bufUsed, out, rsa, verbose, bareData);
+    else if (verify)
+        ret = handleVerify(&buf, bufUsed, rsa, verbose, bareData);
+    else if (txt2bin)
+        ret = handleConvertKey(&buf, bufUsed, out, rsa);
+
+    free(buf);
+    if (fclose(out) && !ret)
+        ret = 2;
+
+    //do not leave a truncated or empty output behind for the next build step to pick up
+    if (ret && outFile)
+        remove(outFile);
+
+    return ret;
+}
+
+//sign each input/output pair in its own process, keeping up to 'jobs' of them going
+static int handleBatch(const char **files, uint32_t numFiles, uint32_t jobs, struct RsaData *rsa, bool verbose, bool bareData)
+{
+    uint32_t i;
+    int ret = 0;
+
+#ifdef _WIN32
+    (void)jobs;
+    for (i = 0; i < numFiles; i += 2) {
+        if (handleFile(files[i], files[i + 1], rsa, verbose, true, false, false, bareData)) {
+            fprintf(stderr, "Failed to sign %s\n", files[i]);
+            ret = 2;
+        }
+    }
+#else
+    uint32_t running = 0;
+    pid_t pid;
+    int status;
+
+    for (i = 0; i < numFiles || running; ) {
+        if (i < numFiles && running < jobs) {
+            //children must not inherit unflushed output; each opens its own /dev/urandom
+            fflush(NULL);
+            pid = fork();
+            if (!pid)
+                exit(handleFile(files[i], files[i + 1], rsa, verbose, true, false, false, bareData));
+            if (pid < 0) {
+                perror("fork");
+                ret = 2;
+                numFiles = i;
+                continue;
+            }
+            running++;
+            i += 2;
+            continue;
+        }
+
+        pid = wait(&status);
+        if (pid < 0) {
+            perror("wait");
+            return 2;
+        }
+        running--;
+        if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+            fprintf(stderr, "Signing job %d failed\n", (int)pid);
+            ret = 2;
+        }
+    }
+#endif
+
+    fprintf(stderr, "Batch status: %s (%d)\n", ret == 0 ? "success" : "failed", ret);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
     const char **strArg = NULL;
     const char *appName = argv[0];
-    const char *posArg[2] = { NULL };
+    const char **posArg;
     uint32_t posArgCnt = 0;
-    FILE *out = NULL;
     const char *prev = NULL;
     bool verbose = false;
     bool sign = false;
@@ -436,13 +567,18 @@ int main(int argc, char **argv)
     bool bareData = false;
     const char *keyPvtFile = NULL;
     const char *keyPubFile = NULL;
+    const char *jobsArg = NULL;
+    uint32_t jobs = 0;
     int multi = 0;
+    int ret;
     struct RsaData rsa;
-    struct ImageHeader *image;
 
     //it might not matter, but we still like to try to cleanup after ourselves
     (void)atexit(cleanup);
 
+    posArg = reallocOrDie(NULL, sizeof(*posArg) * argc);
+    memset(posArg, 0, sizeof(*posArg) * argc);
+
     for (int i = 1; i < argc; i++) {
         if (argv[i][0] == '-') {
             prev = argv[i];
@@ -460,6 +596,8 @@ int main(int argc, char **argv)
                 strArg = &keyPubFile;
             else if (!strcmp(argv[i], "-r"))
                 bareData = true;
+            else if (!strcmp(argv[i], "-j"))
+                strArg = &jobsArg;
             else
                 fatalUsage(appName, "unknown argument", argv[i]);
         } else {
@@ -467,10 +605,8 @@ int main(int argc, char **argv)
                     *strArg = argv[i];
                 strArg = NULL;
             } else {
-                if (posArgCnt < 2)
-                    posArg[posArgCnt++] = argv[i];
-                else
-                    fatalUsage(appName, "too many positional arguments", argv[i]);
+                //-j may come after the files, so count them only once parsing is done
+                posArg[posArgCnt++] = argv[i];
             }
             prev = 0;
         }
@@ -493,21 +629,26 @@ int main(int argc, char **argv)
 
     memset(&rsa, 0, sizeof(rsa));
 
+    if (jobsArg) {
+        char *end;
+
+        jobs = strtoul(jobsArg, &end, 0);
+        if (*end || !jobs)
+            fatalUsage(appName, "invalid job count", jobsArg);
+        if (!sign)
+            fatalUsage(appName, "-j only works with -s", NULL);
+        if (posArgCnt % 2)
+            fatalUsage(appName, "missing output file name for", posArg[posArgCnt - 1]);
+    } else if (posArgCnt > 2) {
+        fatalUsage(appName, "too many positional arguments", posArg[2]);
+    }
+
     if (sign && !(keyPvtFile && keyPubFile))
         fatalUsage(appName, "We need both PUB (-m) and PVT (-e) keys for signing", NULL);
 
     if (verify && (!keyPubFile || keyPvtFile))
         fatalUsage(appName, "We only need PUB (-m)  key for signature checking", NULL);
 
-    if (keyPvtFile) {
-        if (!readFile(rsa.exponent, sizeof(rsa.exponent), keyPvtFile))
-            fatalUsage(appName, "Can't read PVT key from", keyPvtFile);
-#ifdef DEBUG_KEYS
-        else if (verbose)
-            printHashRev(stderr, "RSA exponent", rsa.exponent, RSA_LIMBS);
-#endif
-    }
-
     if (keyPubFile) {
         if (!readFile(rsa.modulus, sizeof(rsa.modulus), keyPubFile))
             fatalUsage(appName, "Can't read PUB key from", keyPubFile);
@@ -515,37 +656,34 @@ int main(int argc, char **argv)
             printHashRev(stderr, "RSA modulus", rsa.modulus, RSA_LIMBS);
     }
 
-    buf = loadFile(posArg[0], &bufUsed);
-    fprintf(stderr, "Read %" PRIu32 " bytes\n", bufUsed);
+    if (keyPvtFile) {
+        uint32_t keySize;
+        uint8_t *key = loadFile(keyPvtFile, &keySize);
 
-    image = (struct ImageHeader *)buf;
-    if (!bareData && !txt2bin) {
-        if (bufUsed >= sizeof(*image) &&
-            image->aosp.header_version == 1 &&
-            image->aosp.magic == NANOAPP_AOSP_MAGIC &&
-            image->layout.magic == GOOGLE_LAYOUT_MAGIC) {
-            fprintf(stderr, "Found AOSP header\n");
-        } else {
-            fprintf(stderr, "Unknown binary format\n");
-            return 2;
+        if (keySize != RSA_BYTES && keySize != RSA_BYTES + sizeof(rsa.crt))
+            fatalUsage(appName, "Can't read PVT key from", keyPvtFile);
+        memcpy(rsa.exponent, key, RSA_BYTES);
+        if (keySize > RSA_BYTES) {
+            memcpy(&rsa.crt, key + RSA_BYTES, sizeof(rsa.crt));
+            if (!rsaCrtKeyMatches(&rsa.privState, &rsa.crt, rsa.modulus))
+                fatalUsage(appName, "PVT key primes do not match PUB key", keyPvtFile);
+            rsa.haveCrt = true;
+        } else if (!(rsa.modulus[0] & 1)) {
+            fatalUsage(appName, "PUB key is not a valid modulus", keyPubFile);
         }
+        memset(key, 0, keySize);
+        free(key);
+#ifdef DEBUG_KEYS
+        if (verbose)
+            printHashRev(stderr, "RSA exponent", rsa.exponent, RSA_LIMBS);
+#endif
     }
 
-    if (!posArg[1])
-        out = stdout;
+    if (jobsArg)
+        ret = handleBatch(posArg, posArgCnt, jobs, &rsa, verbose, bareData);
     else
-        out = fopen(posArg[1], "w");
-    if (!out)
-        fatalUsage(appName, "failed to create/open output file", posArg[1]);
-
-    if (sign)
-        ret = handleSign(&buf, bufUsed, out, &rsa, verbose, bareData);
-    else if (verify)
-        ret = handleVerify(&buf, bufUsed, &rsa, verbose, bareData);
-    else if (txt2bin)
-        ret = handleConvertKey(&buf, bufUsed, out, &rsa);
+        ret = handleFile(posArg[0], posArgCnt > 1 ? posArg[1] : NULL, &rsa, verbose, sign, verify, txt2bin, bareData);
 
-    free(buf);
-    fclose(out);
+    free(posArg);
     return ret;
 }
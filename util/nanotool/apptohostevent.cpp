@@ -153,4 +153,58 @@ const HostHubRawPacket *AppToHostEvent::GetTypedData() const {
         event_data.data() + sizeof(uint32_t));
 }
 
+/* AppToHostChreEvent *********************************************************/
+
+std::unique_ptr<AppToHostChreEvent> AppToHostChreEvent::FromBytes(
+        const std::vector<uint8_t>& buffer) {
+    auto event = std::unique_ptr<AppToHostChreEvent>(new AppToHostChreEvent());
+    event->Populate(buffer);
+    if (!event->IsValid()) {
+        return nullptr;
+    }
+
+    return event;
+}
+
+uint64_t AppToHostChreEvent::GetAppId() const {
+    return GetTypedData()->appId;
+}
+
+uint32_t AppToHostChreEvent::GetMessageType() const {
+    return GetTypedData()->messageType;
+}
+
+uint8_t AppToHostChreEvent::GetDataLen() const {
+    return GetTypedData()->messageSize;
+}
+
+const uint8_t *AppToHostChreEvent::GetDataPtr() const {
+    return (reinterpret_cast<const uint8_t*>(GetTypedData())
+              + sizeof(struct HostHubChrePacket));
+}
+
+bool AppToHostChreEvent::IsValid() const {
+    const HostHubChrePacket *packet = GetTypedData();
+    if (!packet) {
+        return false;
+    }
+
+    if (event_data.size() < (sizeof(uint32_t) + sizeof(struct HostHubChrePacket)
+                               + packet->messageSize)) {
+        LOGW("Invalid/short AppToHostChre event of size %zu", event_data.size());
+        return false;
+    }
+
+    return true;
+}
+
+const HostHubChrePacket *AppToHostChreEvent::GetTypedData() const {
+    if (event_data.size() < sizeof(uint32_t) + sizeof(struct HostHubChrePacket)) {
+        LOGW("Invalid/short AppToHostChre event of size %zu", event_data.size());
+        return nullptr;
+    }
+    return reinterpret_cast<const HostHubChrePacket *>(
+        event_data.data() + sizeof(uint32_t));
+}
+
 }  // namespace android
@@ -29,6 +29,110 @@ struct HostHubRawPacket {
     //raw data in unspecified format here
 } __attribute((packed));
 
+struct HostHubChrePacket {
+    uint64_t appId;
+    uint8_t messageSize; //not incl this header, 128 bytes max
+    uint32_t messageType;
+    uint16_t hostEndpoint;
+    //raw data in unspecified format here
+} __attribute((packed));
+
+// From nanohub.h
+struct HostMsgHdrChre {
+    uint32_t eventId;
+    uint64_t appId;
+    uint8_t len;
+    uint32_t appEventId;
+    uint16_t endpoint;
+} __attribute__((packed));
+
+// From nanohubPacket.h: messages to the OS use the transaction ID as the
+// message type and answer with a struct HalRet
+struct HalRet {
+    uint8_t msg;
+    uint32_t status;
+} __attribute__((packed));
+
+#define NANOHUB_HAL_SLEEP_STATS             0x19
+#define NANOHUB_HAL_SLEEP_STATS_RESET       0x01
+
+#define NANOHUB_HAL_SLEEP_STAT_ELAPSED      0x00
+#define NANOHUB_HAL_SLEEP_STAT_STATE        0x01
+#define NANOHUB_HAL_SLEEP_STAT_WAKE         0x02
+#define NANOHUB_HAL_SLEEP_STAT_WAKE_LINE    0x03
+#define NANOHUB_HAL_SLEEP_STAT_PREDICT      0x04
+
+struct HalSleepStatsRx {
+    uint8_t offset;
+    uint8_t flags;
+} __attribute__((packed));
+
+struct HalSleepStat {
+    uint8_t type;
+    uint8_t index;
+    uint32_t count;
+    uint64_t time; // ns
+} __attribute__((packed));
+
+struct HalSleepStatsTx {
+    struct HalRet ret;
+    uint8_t total;
+    uint8_t offset;
+    uint8_t count;
+    struct HalSleepStat stats[];
+} __attribute__((packed));
+
+#define NANOHUB_HAL_BOOT_STATS              0x1A
+#define NANOHUB_HAL_BOOT_STATS_WARM         0x01
+
+#define NANOHUB_HAL_BOOT_PHASE_MAX          8
+
+struct HalBootStatsTx {
+    struct HalRet ret;
+    uint8_t flags;
+    uint8_t numPhases;
+    uint16_t appsChecked;
+    uint16_t appsCached;
+    uint32_t phaseUs[]; // since OS entry, 0 if not reached
+} __attribute__((packed));
+
+#define NANOHUB_HAL_LOAD_STATS              0x1B
+
+#define NANOHUB_HAL_LOAD_LEVEL_MAX          4
+
+struct HalLoadStatsTx {
+    struct HalRet ret;
+    uint8_t level;
+    uint8_t busy;       // % of the last window the CPU was awake
+    uint16_t pending;   // events queued at the end of the last window
+    uint32_t drops;     // since boot
+    uint32_t changes;   // level changes since boot
+    uint8_t numLevels;
+    uint64_t levelTime[]; // ns at each level
+} __attribute__((packed));
+
+#define NANOHUB_HAL_POOL_STATS              0x1C
+#define NANOHUB_HAL_POOL_STATS_RESET        0x01
+
+struct HalPoolStatsRx {
+    uint8_t flags;
+} __attribute__((packed));
+
+struct HalPoolStat {
+    uint8_t id;
+    uint16_t size;
+    uint16_t used;
+    uint16_t peak;      // since the last reset
+    uint32_t fails;
+    uint32_t discards;
+} __attribute__((packed));
+
+struct HalPoolStatsTx {
+    struct HalRet ret;
+    uint8_t count;
+    struct HalPoolStat stats[];
+} __attribute__((packed));
+
 // From brHostEvent.h
 #define BRIDGE_HOST_EVENT_MSG_VERSION_INFO (0)
 
@@ -61,6 +165,7 @@ constexpr uint64_t kAppIdVendorGoogle = 0x476f6f676cULL; // "Googl"
 constexpr uint64_t kAppIdVendorSTMicro = 0x53544d6963ULL; // "STMic"
 constexpr uint64_t kAppIdVendorInvn = 0x496E76656EULL; // "Inven"
 
+constexpr uint64_t kAppIdOs                = MakeAppId(kAppIdVendorGoogle, 0);
 constexpr uint64_t kAppIdBoschBmi160Bmm150 = MakeAppId(kAppIdVendorGoogle, 2);
 constexpr uint64_t kAppIdBoschBmp280       = MakeAppId(kAppIdVendorGoogle, 5);
 constexpr uint64_t kAppIdAmsTmd2772        = MakeAppId(kAppIdVendorGoogle, 9);
@@ -107,6 +212,27 @@ class AppToHostEvent : public ReadEventResponse {
     bool CheckEventHeader(SensorType sensor_type) const;
 };
 
+/*
+ * Events sent with event type EVT_APP_TO_HOST_CHRE, which also carry a message
+ * type. The OS uses these to answer host requests, with the request's
+ * transaction ID as the message type.
+ */
+class AppToHostChreEvent : public ReadEventResponse {
+  public:
+    static std::unique_ptr<AppToHostChreEvent> FromBytes(
+        const std::vector<uint8_t>& buffer);
+
+    uint64_t GetAppId() const;
+    uint32_t GetMessageType() const;
+    uint8_t GetDataLen() const;
+    const uint8_t *GetDataPtr() const;
+
+    virtual bool IsValid() const;
+
+  protected:
+    const HostHubChrePacket *GetTypedData() const;
+};
+
 #define SENSOR_APP_MSG_CALIBRATION_RESULT (0)
 #define SENSOR_APP_MSG_TEST_RESULT        (1)
 
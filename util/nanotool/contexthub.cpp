@@ -16,8 +16,10 @@
 
 #include "contexthub.h"
 
+#include <cinttypes>
 #include <cstring>
 #include <errno.h>
+#include <map>
 #include <vector>
 
 #include "apptohostevent.h"
@@ -33,6 +35,7 @@ namespace android {
 constexpr int kCalibrationTimeoutMs(10000);
 constexpr int kTestTimeoutMs(10000);
 constexpr int kBridgeVersionTimeoutMs(500);
+constexpr int kHalCommandTimeoutMs(500);
 
 struct SensorTypeNames {
     SensorType sensor_type;
@@ -327,6 +330,266 @@ bool ContextHub::PrintBridgeVersion() {
     return success;
 }
 
+static const char *SleepWakeReasonName(uint8_t reason) {
+    static const char * const names[] = { "other", "timer", "host", "dma", "interrupt line" };
+    return reason < sizeof(names) / sizeof(names[0]) ? names[reason] : "?";
+}
+
+static void PrintSleepStat(const char *name, const HalSleepStat& stat,
+        uint64_t elapsed) {
+    printf("  %-16s %10" PRIu32 " %12.3f ms %6.2f%%\n", name, stat.count,
+           stat.time / 1e6, elapsed ? 100.0 * stat.time / elapsed : 0.0);
+}
+
+template<typename T>
+bool ContextHub::SendHalCommand(const WriteEventRequest& request,
+        uint32_t transaction_id, uint8_t msg, const char *name,
+        std::function<bool(const T&, size_t)> handler) {
+    TransportResult result = WriteEvent(request);
+    if (result != TransportResult::Success) {
+        LOGE("Failed to send %s request: %d", name, static_cast<int>(result));
+        return false;
+    }
+
+    bool got_response = false;
+    bool success = false;
+    auto event_handler = [&](const AppToHostChreEvent &event) -> bool {
+        auto rsp = reinterpret_cast<const T *>(event.GetDataPtr());
+        if (event.GetAppId() != kAppIdOs ||
+                event.GetMessageType() != transaction_id) {
+            LOGD("Ignored unrelated app to host event");
+            return true;
+        }
+
+        got_response = true;
+        if (event.GetDataLen() < sizeof(T) || rsp->ret.msg != msg ||
+                !handler(*rsp, event.GetDataLen())) {
+            LOGE("Got malformed %s response", name);
+        } else {
+            success = true;
+        }
+        return false;
+    };
+
+    ReadAppChreEvents(event_handler, kHalCommandTimeoutMs);
+    if (!got_response) {
+        LOGE("No %s response; the hub may not support it", name);
+    }
+
+    return success;
+}
+
+bool ContextHub::PrintSleepStats(bool reset) {
+    std::vector<HalSleepStat> stats;
+    uint32_t transaction_id = 0x534c5000; // "SLP"
+    size_t total = 1;
+
+    while (stats.size() < total) {
+        SleepStatsRequest request(stats.size(), false, ++transaction_id);
+        bool changed = false;
+        auto handler = [&](const HalSleepStatsTx& rsp, size_t length) -> bool {
+            if (length < sizeof(rsp) + rsp.count * sizeof(HalSleepStat)) {
+                return false;
+            } else if (rsp.offset != stats.size() ||
+                       (!rsp.count && rsp.total > stats.size())) {
+                changed = true;
+            } else {
+                for (uint8_t i = 0; i < rsp.count; i++) {
+                    stats.push_back(rsp.stats[i]);
+                }
+                total = rsp.count ? rsp.total : stats.size();
+            }
+            return true;
+        };
+
+        if (!SendHalCommand<HalSleepStatsTx>(request, transaction_id,
+                NANOHUB_HAL_SLEEP_STATS, "sleep stats", handler)) {
+            return false;
+        } else if (changed) {
+            LOGE("Sleep stats changed while reading them");
+            return false;
+        }
+    }
+
+    if (reset) {
+        // Nothing is left to read at this offset, so this only clears
+        SleepStatsRequest request(stats.size(), true, ++transaction_id);
+        if (WriteEvent(request) != TransportResult::Success) {
+            LOGE("Failed to reset sleep stats");
+            return false;
+        }
+    }
+
+    uint64_t elapsed = 0;
+    uint32_t sleeps = 0;
+    for (const HalSleepStat& stat : stats) {
+        if (stat.type == NANOHUB_HAL_SLEEP_STAT_ELAPSED) {
+            elapsed = stat.time;
+            sleeps = stat.count;
+        }
+    }
+
+    printf("Sleep stats over %.3f s, %" PRIu32 " sleeps\n", elapsed / 1e9, sleeps);
+
+    const std::map<uint8_t, const char *> sections = {
+        { NANOHUB_HAL_SLEEP_STAT_STATE,     "Residency per sleep state (deepest first):" },
+        { NANOHUB_HAL_SLEEP_STAT_WAKE,      "Wakeup reasons (time: sleep they ended):" },
+        { NANOHUB_HAL_SLEEP_STAT_WAKE_LINE, "Wakeups per interrupt line:" },
+    };
+    char name[32];
+
+    for (const auto& section : sections) {
+        printf("%s\n", section.second);
+        for (const HalSleepStat& stat : stats) {
+            if (stat.type != section.first ||
+                    (stat.type == NANOHUB_HAL_SLEEP_STAT_WAKE_LINE && !stat.count)) {
+                continue;
+            }
+            if (stat.type == NANOHUB_HAL_SLEEP_STAT_WAKE) {
+                snprintf(name, sizeof(name), "%s", SleepWakeReasonName(stat.index));
+            } else if (stat.type == NANOHUB_HAL_SLEEP_STAT_WAKE_LINE) {
+                snprintf(name, sizeof(name), "line %u", stat.index);
+            } else {
+                snprintf(name, sizeof(name), "state %u", stat.index);
+            }
+            PrintSleepStat(name, stat, elapsed);
+        }
+    }
+
+    printf("Idle length prediction (mean error):\n");
+    for (const HalSleepStat& stat : stats) {
+        if (stat.type == NANOHUB_HAL_SLEEP_STAT_PREDICT) {
+            printf("  %-16s %10" PRIu32 " %12.3f ms\n",
+                   stat.index ? "untimed" : "timed", stat.count,
+                   stat.count ? stat.time / 1e6 / stat.count : 0.0);
+        }
+    }
+
+    return true;
+}
+
+bool ContextHub::PrintBootStats() {
+    static const char * const phases[] = {
+        "bootloader", "OS init", "services", "internal apps", "external apps", "ready",
+    };
+    uint32_t transaction_id = 0x424f5400; // "BOT"
+    std::vector<uint32_t> phase_us;
+    HalBootStatsTx stats;
+
+    BootStatsRequest request(transaction_id);
+    auto handler = [&](const HalBootStatsTx& rsp, size_t length) -> bool {
+        if (rsp.numPhases > NANOHUB_HAL_BOOT_PHASE_MAX ||
+                length < sizeof(rsp) + rsp.numPhases * sizeof(uint32_t)) {
+            return false;
+        }
+        stats = rsp;
+        for (uint8_t i = 0; i < rsp.numPhases; i++) {
+            phase_us.push_back(rsp.phaseUs[i]);
+        }
+        return true;
+    };
+
+    if (!SendHalCommand<HalBootStatsTx>(request, transaction_id,
+            NANOHUB_HAL_BOOT_STATS, "boot stats", handler)) {
+        return false;
+    }
+
+    printf("Last boot was %s: %u apps verified, %u taken as verified\n",
+           (stats.flags & NANOHUB_HAL_BOOT_STATS_WARM) ? "warm" : "cold",
+           stats.appsChecked, stats.appsCached);
+
+    uint32_t prev_us = 0;
+    for (size_t i = 0; i < phase_us.size(); i++) {
+        const char *name = i < sizeof(phases) / sizeof(phases[0]) ? phases[i] : "?";
+        if (!phase_us[i]) {
+            // older bootloaders do not time themselves
+            printf("  %-16s %s\n", name, i ? "not reached" : "not timed");
+            continue;
+        }
+        printf("  %-16s %10.3f ms (+%.3f ms)\n", name, phase_us[i] / 1e3,
+               (phase_us[i] - prev_us) / 1e3);
+        prev_us = phase_us[i];
+    }
+
+    return true;
+}
+
+bool ContextHub::PrintLoadStats() {
+    static const char * const levels[] = {
+        "normal", "throttle", "defer cal", "overload",
+    };
+    uint32_t transaction_id = 0x4c4f4400; // "LOD"
+    std::vector<uint64_t> level_time;
+    HalLoadStatsTx stats;
+
+    LoadStatsRequest request(transaction_id);
+    auto handler = [&](const HalLoadStatsTx& rsp, size_t length) -> bool {
+        if (rsp.numLevels > NANOHUB_HAL_LOAD_LEVEL_MAX ||
+                length < sizeof(rsp) + rsp.numLevels * sizeof(uint64_t)) {
+            return false;
+        }
+        stats = rsp;
+        for (uint8_t i = 0; i < rsp.numLevels; i++) {
+            level_time.push_back(rsp.levelTime[i]);
+        }
+        return true;
+    };
+
+    if (!SendHalCommand<HalLoadStatsTx>(request, transaction_id,
+            NANOHUB_HAL_LOAD_STATS, "load stats", handler)) {
+        return false;
+    }
+
+    printf("Load level: %s, CPU awake %u%%, %u events queued\n",
+           stats.level < sizeof(levels) / sizeof(levels[0]) ? levels[stats.level] : "?",
+           stats.busy, stats.pending);
+    printf("Data dropped: %" PRIu32 ", level changes: %" PRIu32 "\n",
+           stats.drops, stats.changes);
+
+    for (size_t i = 0; i < level_time.size(); i++) {
+        const char *name = i < sizeof(levels) / sizeof(levels[0]) ? levels[i] : "?";
+        printf("  %-16s %12.3f s\n", name, level_time[i] / 1e9);
+    }
+
+    return true;
+}
+
+bool ContextHub::PrintPoolStats(bool reset) {
+    static const char * const pools[] = {
+        "os events", "os misc", "timer events", "sensor events",
+        "sensor requests", "host output",
+    };
+    uint32_t transaction_id = 0x504f4c00; // "POL"
+    std::vector<HalPoolStat> stats;
+
+    PoolStatsRequest request(reset, transaction_id);
+    auto handler = [&](const HalPoolStatsTx& rsp, size_t length) -> bool {
+        if (length < sizeof(rsp) + rsp.count * sizeof(HalPoolStat)) {
+            return false;
+        }
+        for (uint8_t i = 0; i < rsp.count; i++) {
+            stats.push_back(rsp.stats[i]);
+        }
+        return true;
+    };
+
+    if (!SendHalCommand<HalPoolStatsTx>(request, transaction_id,
+            NANOHUB_HAL_POOL_STATS, "pool stats", handler)) {
+        return false;
+    }
+
+    printf("%-16s %6s %6s %6s %10s %10s\n",
+           "pool", "size", "used", "peak", "fails", "discards");
+    for (const HalPoolStat& stat : stats) {
+        const char *name = stat.id < sizeof(pools) / sizeof(pools[0]) ? pools[stat.id] : "?";
+        printf("%-16s %6u %6u %6u %10" PRIu32 " %10" PRIu32 "%s\n",
+               name, stat.size, stat.used, stat.peak, stat.fails, stat.discards,
+               stat.peak >= stat.size ? "  (full)" : "");
+    }
+
+    return true;
+}
+
 void ContextHub::PrintSensorEvents(SensorType type, int limit) {
     bool continuous = (limit == 0);
     auto event_printer = [type, &limit, continuous](const SensorEvent& event) -> bool {
@@ -554,6 +817,47 @@ ContextHub::TransportResult ContextHub::ReadAppEvents(
     return TransportResult::Success;
 }
 
+ContextHub::TransportResult ContextHub::ReadAppChreEvents(
+        std::function<bool(const AppToHostChreEvent&)> callback, int timeout_ms) {
+    using Milliseconds = std::chrono::milliseconds;
+
+    TransportResult result;
+    bool timeout_required = timeout_ms > 0;
+    bool keep_going = true;
+
+    while (keep_going) {
+        if (timeout_required && timeout_ms <= 0) {
+            return TransportResult::Timeout;
+        }
+
+        std::unique_ptr<ReadEventResponse> event;
+
+        SteadyClock start_time = std::chrono::steady_clock::now();
+        result = ReadEvent(&event, timeout_ms);
+        SteadyClock end_time = std::chrono::steady_clock::now();
+
+        auto delta = end_time - start_time;
+        timeout_ms -= std::chrono::duration_cast<Milliseconds>(delta).count();
+
+        if (result == TransportResult::Success && event->IsAppToHostChreEvent()) {
+            AppToHostChreEvent *app_event = reinterpret_cast<AppToHostChreEvent*>(
+                event.get());
+            keep_going = callback(*app_event);
+        } else {
+            if (result != TransportResult::Success) {
+                LOGE("Error %d while reading", static_cast<int>(result));
+                if (result != TransportResult::ParseFailure) {
+                    return result;
+                }
+            } else {
+                LOGD("Ignoring non-app-to-host event");
+            }
+        }
+    }
+
+    return TransportResult::Success;
+}
+
 void ContextHub::ReadSensorEvents(std::function<bool(const SensorEvent&)> callback) {
     TransportResult result;
     bool keep_going = true;
@@ -26,6 +26,7 @@
 
 namespace android {
 
+class AppToHostChreEvent;
 class AppToHostEvent;
 class SensorEvent;
 
@@ -182,6 +183,30 @@ class ContextHub : public NonCopyable {
      */
     bool PrintBridgeVersion();
 
+    /*
+     * Reads and prints the hub's sleep residency and wakeup statistics,
+     * clearing them afterwards if reset is set.
+     */
+    bool PrintSleepStats(bool reset);
+
+    /*
+     * Requests the timing of the hub's last boot and prints it. Returns true
+     * on success.
+     */
+    bool PrintBootStats();
+
+    /*
+     * Requests the hub's load level and how long it spent at each level, and
+     * prints them. Returns true on success.
+     */
+    bool PrintLoadStats();
+
+    /*
+     * Reads and prints the occupancy of the hub's OS pools and queues,
+     * restarting their peaks and counters afterwards if reset is set.
+     */
+    bool PrintPoolStats(bool reset);
+
     /*
      * Prints up to <sample_limit> incoming sensor samples corresponding to the
      * given SensorType, ignoring other events. If sample_limit is 0, then
@@ -234,6 +259,13 @@ class ContextHub : public NonCopyable {
     TransportResult ReadAppEvents(std::function<bool(const AppToHostEvent&)> callback,
         int timeout_ms = 0);
 
+    /*
+     * Same as ReadAppEvents, for AppToHostChreEvent.
+     */
+    TransportResult ReadAppChreEvents(
+        std::function<bool(const AppToHostChreEvent&)> callback,
+        int timeout_ms = 0);
+
     /*
      * Calls ReadEvent in a loop, handling errors and ignoring events that
      * didn't originate from a sensor. Valid SensorEvents are passed to the
@@ -242,6 +274,16 @@ class ContextHub : public NonCopyable {
      */
     void ReadSensorEvents(std::function<bool(const SensorEvent&)> callback);
 
+    /*
+     * Sends a HAL command to the OS and waits for the response with the same
+     * transaction id and HAL message. The handler gets the response and its
+     * length, and returns false if it is malformed.
+     */
+    template<typename T>
+    bool SendHalCommand(const WriteEventRequest& request,
+        uint32_t transaction_id, uint8_t msg, const char *name,
+        std::function<bool(const T&, size_t)> handler);
+
     /*
      * Sends the given calibration data down to the hub
      */
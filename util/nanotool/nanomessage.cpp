@@ -118,6 +118,8 @@ std::unique_ptr<ReadEventResponse> ReadEventResponse::FromBytes(
         return SensorEvent::FromBytes(buffer);
     } else if (ReadEventResponse::IsAppToHostEvent(event_type)) {
         return AppToHostEvent::FromBytes(buffer);
+    } else if (ReadEventResponse::IsAppToHostChreEvent(event_type)) {
+        return AppToHostChreEvent::FromBytes(buffer);
     } else if (ReadEventResponse::IsResetReasonEvent(event_type)) {
         return ResetReasonEvent::FromBytes(buffer);
     } else if (ReadEventResponse::IsLogEvent(event_type)) {
@@ -142,6 +144,10 @@ bool ReadEventResponse::IsAppToHostEvent() const {
     return ReadEventResponse::IsAppToHostEvent(GetEventType());
 }
 
+bool ReadEventResponse::IsAppToHostChreEvent() const {
+    return ReadEventResponse::IsAppToHostChreEvent(GetEventType());
+}
+
 bool ReadEventResponse::IsSensorEvent() const {
     return ReadEventResponse::IsSensorEvent(GetEventType());
 }
@@ -167,6 +173,10 @@ bool ReadEventResponse::IsAppToHostEvent(uint32_t event_type) {
     return (event_type == static_cast<uint32_t>(EventType::AppToHostEvent));
 }
 
+bool ReadEventResponse::IsAppToHostChreEvent(uint32_t event_type) {
+    return (event_type == static_cast<uint32_t>(EventType::AppToHostChreEvent));
+}
+
 bool ReadEventResponse::IsResetReasonEvent(uint32_t event_type) {
     return (event_type == static_cast<uint32_t>(EventType::ResetReasonEvent));
 }
@@ -262,4 +272,142 @@ std::string BridgeVersionInfoRequest::ToString() const {
     return std::string("Bridge version info request\n");
 }
 
+/* SleepStatsRequest **********************************************************/
+
+SleepStatsRequest::SleepStatsRequest(uint8_t offset, bool reset,
+        uint32_t transaction_id)
+    : offset_(offset), reset_(reset), transaction_id_(transaction_id) {}
+
+std::vector<uint8_t> SleepStatsRequest::GetBytes() const {
+    struct SleepStatsRequestEvent : public Event {
+        struct HostMsgHdrChre hdr;
+        uint8_t msg;
+        struct HalSleepStatsRx rx;
+    } __attribute__((packed));
+
+    std::vector<uint8_t> buffer(sizeof(SleepStatsRequestEvent));
+
+    std::fill(buffer.begin(), buffer.end(), 0);
+    auto event = reinterpret_cast<SleepStatsRequestEvent *>(buffer.data());
+    event->event_type   = static_cast<uint32_t>(EventType::AppFromHostChreEvent);
+    event->hdr.appId    = kAppIdOs;
+    event->hdr.len      = sizeof(event->msg) + sizeof(event->rx);
+    event->hdr.appEventId = transaction_id_;
+    event->msg          = NANOHUB_HAL_SLEEP_STATS;
+    event->rx.offset    = offset_;
+    event->rx.flags     = reset_ ? NANOHUB_HAL_SLEEP_STATS_RESET : 0;
+
+    return buffer;
+}
+
+EventType SleepStatsRequest::GetEventType() const {
+    return EventType::AppFromHostChreEvent;
+}
+
+std::string SleepStatsRequest::ToString() const {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "Sleep stats request at %u%s\n",
+             offset_, reset_ ? ", reset" : "");
+    return std::string(buffer);
+}
+
+/* BootStatsRequest ***********************************************************/
+
+BootStatsRequest::BootStatsRequest(uint32_t transaction_id)
+    : transaction_id_(transaction_id) {}
+
+std::vector<uint8_t> BootStatsRequest::GetBytes() const {
+    struct BootStatsRequestEvent : public Event {
+        struct HostMsgHdrChre hdr;
+        uint8_t msg;
+    } __attribute__((packed));
+
+    std::vector<uint8_t> buffer(sizeof(BootStatsRequestEvent));
+
+    std::fill(buffer.begin(), buffer.end(), 0);
+    auto event = reinterpret_cast<BootStatsRequestEvent *>(buffer.data());
+    event->event_type   = static_cast<uint32_t>(EventType::AppFromHostChreEvent);
+    event->hdr.appId    = kAppIdOs;
+    event->hdr.len      = sizeof(event->msg);
+    event->hdr.appEventId = transaction_id_;
+    event->msg          = NANOHUB_HAL_BOOT_STATS;
+
+    return buffer;
+}
+
+EventType BootStatsRequest::GetEventType() const {
+    return EventType::AppFromHostChreEvent;
+}
+
+std::string BootStatsRequest::ToString() const {
+    return std::string("Boot stats request\n");
+}
+
+/* LoadStatsRequest ***********************************************************/
+
+LoadStatsRequest::LoadStatsRequest(uint32_t transaction_id)
+    : transaction_id_(transaction_id) {}
+
+std::vector<uint8_t> LoadStatsRequest::GetBytes() const {
+    struct LoadStatsRequestEvent : public Event {
+        struct HostMsgHdrChre hdr;
+        uint8_t msg;
+    } __attribute__((packed));
+
+    std::vector<uint8_t> buffer(sizeof(LoadStatsRequestEvent));
+
+    std::fill(buffer.begin(), buffer.end(), 0);
+    auto event = reinterpret_cast<LoadStatsRequestEvent *>(buffer.data());
+    event->event_type   = static_cast<uint32_t>(EventType::AppFromHostChreEvent);
+    event->hdr.appId    = kAppIdOs;
+    event->hdr.len      = sizeof(event->msg);
+    event->hdr.appEventId = transaction_id_;
+    event->msg          = NANOHUB_HAL_LOAD_STATS;
+
+    return buffer;
+}
+
+EventType LoadStatsRequest::GetEventType() const {
+    return EventType::AppFromHostChreEvent;
+}
+
+std::string LoadStatsRequest::ToString() const {
+    return std::string("Load stats request\n");
+}
+
+/* PoolStatsRequest ***********************************************************/
+
+PoolStatsRequest::PoolStatsRequest(bool reset, uint32_t transaction_id)
+    : reset_(reset), transaction_id_(transaction_id) {}
+
+std::vector<uint8_t> PoolStatsRequest::GetBytes() const {
+    struct PoolStatsRequestEvent : public Event {
+        struct HostMsgHdrChre hdr;
+        uint8_t msg;
+        struct HalPoolStatsRx rx;
+    } __attribute__((packed));
+
+    std::vector<uint8_t> buffer(sizeof(PoolStatsRequestEvent));
+
+    std::fill(buffer.begin(), buffer.end(), 0);
+    auto event = reinterpret_cast<PoolStatsRequestEvent *>(buffer.data());
+    event->event_type   = static_cast<uint32_t>(EventType::AppFromHostChreEvent);
+    event->hdr.appId    = kAppIdOs;
+    event->hdr.len      = sizeof(event->msg) + sizeof(event->rx);
+    event->hdr.appEventId = transaction_id_;
+    event->msg          = NANOHUB_HAL_POOL_STATS;
+    event->rx.flags     = reset_ ? NANOHUB_HAL_POOL_STATS_RESET : 0;
+
+    return buffer;
+}
+
+EventType PoolStatsRequest::GetEventType() const {
+    return EventType::AppFromHostChreEvent;
+}
+
+std::string PoolStatsRequest::ToString() const {
+    return std::string(reset_ ? "Pool stats request, reset\n" :
+                                "Pool stats request\n");
+}
+
 }  // namespace android
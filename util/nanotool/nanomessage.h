@@ -31,11 +31,13 @@ namespace android {
  */
 enum class EventType {
     AppFromHostEvent = 0x000000F8,
+    AppFromHostChreEvent = 0x000000F9,
     FirstSensorEvent = 0x00000200,
     LastSensorEvent  = 0x000002FF,
     ConfigureSensor  = 0x00000300,
     AppToHostEvent   = 0x00000401,
     ResetReasonEvent = 0x00000403,
+    AppToHostChreEvent = 0x00000407,
     LogEvent         = 0x474F4C41,
 };
 
@@ -139,6 +141,7 @@ class ReadEventResponse : public NanoResponse {
     bool Populate(const std::vector<uint8_t>& buffer) override;
 
     bool IsAppToHostEvent() const;
+    bool IsAppToHostChreEvent() const;
     bool IsSensorEvent() const;
     bool IsResetReasonEvent() const;
     bool IsLogEvent() const;
@@ -150,6 +153,7 @@ class ReadEventResponse : public NanoResponse {
   protected:
     static uint32_t EventTypeFromBuffer(const std::vector<uint8_t>& buffer);
     static bool IsAppToHostEvent(uint32_t event_type);
+    static bool IsAppToHostChreEvent(uint32_t event_type);
     static bool IsSensorEvent(uint32_t event_type);
     static bool IsResetReasonEvent(uint32_t event_type);
     static bool IsLogEvent(uint32_t event_type);
@@ -202,6 +206,74 @@ class BridgeVersionInfoRequest : public WriteEventRequest {
     std::string ToString() const override;
 };
 
+/*
+ * Reads a page of the hub's sleep statistics, optionally clearing them
+ * afterwards. The hub answers with an AppToHostChreEvent.
+ */
+class SleepStatsRequest : public WriteEventRequest {
+  public:
+    SleepStatsRequest(uint8_t offset, bool reset, uint32_t transaction_id);
+
+    std::vector<uint8_t> GetBytes() const override;
+    EventType GetEventType() const override;
+    std::string ToString() const override;
+
+  private:
+    uint8_t offset_;
+    bool reset_;
+    uint32_t transaction_id_;
+};
+
+/*
+ * Asks the hub how its last boot went: how long each phase took and how many
+ * apps had to be verified. The hub answers with an AppToHostChreEvent.
+ */
+class BootStatsRequest : public WriteEventRequest {
+  public:
+    BootStatsRequest(uint32_t transaction_id);
+
+    std::vector<uint8_t> GetBytes() const override;
+    EventType GetEventType() const override;
+    std::string ToString() const override;
+
+  private:
+    uint32_t transaction_id_;
+};
+
+/*
+ * Asks the hub how loaded it is and how much work it is shedding. The hub
+ * answers with an AppToHostChreEvent.
+ */
+class LoadStatsRequest : public WriteEventRequest {
+  public:
+    LoadStatsRequest(uint32_t transaction_id);
+
+    std::vector<uint8_t> GetBytes() const override;
+    EventType GetEventType() const override;
+    std::string ToString() const override;
+
+  private:
+    uint32_t transaction_id_;
+};
+
+/*
+ * Reads the occupancy of the hub's OS pools and queues, optionally
+ * restarting the peaks and counters afterwards. The hub answers with an
+ * AppToHostChreEvent.
+ */
+class PoolStatsRequest : public WriteEventRequest {
+  public:
+    PoolStatsRequest(bool reset, uint32_t transaction_id);
+
+    std::vector<uint8_t> GetBytes() const override;
+    EventType GetEventType() const override;
+    std::string ToString() const override;
+
+  private:
+    bool reset_;
+    uint32_t transaction_id_;
+};
+
 }  // namespace android
 
 #endif  // NANOMESSAGE_H_
@@ -65,11 +65,14 @@ uint32_t Crc32(const uint8_t *buffer, int length) {
 }
 
 NanoPacket::NanoPacket(uint32_t sequence_number, PacketReason reason,
-        const std::vector<uint8_t> *data) {
+        const std::vector<uint8_t> *data, bool queued) {
     Reset();
     parsing_state_ = ParsingState::Complete;
     sequence_number_ = sequence_number;
     reason_ = static_cast<uint32_t>(reason);
+    if (queued) {
+        reason_ |= kPacketReasonQueueFlag;
+    }
 
     // Resize the buffer to accomodate header, footer and data content.
     size_t data_size = data ? data->size() : 0;
@@ -88,10 +91,10 @@ NanoPacket::NanoPacket(uint32_t sequence_number, PacketReason reason,
     packet_buffer_[2] = sequence_number >> 8;
     packet_buffer_[3] = sequence_number >> 16;
     packet_buffer_[4] = sequence_number >> 24;
-    packet_buffer_[5] = static_cast<uint32_t>(reason);
-    packet_buffer_[6] = static_cast<uint32_t>(reason) >> 8;
-    packet_buffer_[7] = static_cast<uint32_t>(reason) >> 16;
-    packet_buffer_[8] = static_cast<uint32_t>(reason) >> 24;
+    packet_buffer_[5] = reason_;
+    packet_buffer_[6] = reason_ >> 8;
+    packet_buffer_[7] = reason_ >> 16;
+    packet_buffer_[8] = reason_ >> 24;
     packet_buffer_[9] = data_size;
 
     // Insert the data content of the packet.
@@ -130,12 +133,20 @@ const std::vector<uint8_t>& NanoPacket::packet_buffer() const {
     return packet_buffer_;
 }
 
+uint32_t NanoPacket::sequence_number() const {
+    return sequence_number_;
+}
+
 uint32_t NanoPacket::reason() const {
     return reason_;
 }
 
 PacketReason NanoPacket::TypedReason() const {
-    return static_cast<PacketReason>(reason_);
+    return static_cast<PacketReason>(reason_ & ~kPacketReasonQueueFlag);
+}
+
+bool NanoPacket::IsQueuedAcknowledge() const {
+    return TypedReason() == PacketReason::AcknowledgeQueued;
 }
 
 const std::vector<uint8_t>& NanoPacket::packet_content() const {
@@ -29,14 +29,38 @@ namespace android {
  * The various reasons for a NanoPacket to be sent.
  */
 enum class PacketReason : uint32_t {
-    Acknowledge        = 0x00000000,
-    NAcknowledge       = 0x00000001,
-    NAcknowledgeBusy   = 0x00000002,
-    GetHardwareVersion = 0x00001000,
-    ReadEventRequest   = 0x00001090,
-    WriteEventRequest  = 0x00001091,
+    Acknowledge          = 0x00000000,
+    NAcknowledge         = 0x00000001,
+    NAcknowledgeBusy     = 0x00000002,
+    AcknowledgeQueued    = 0x00000003,
+    GetHardwareVersion   = 0x00001000,
+    GetResponse          = 0x00001010,
+    StartFirmwareUpload  = 0x00001040,
+    FirmwareChunk        = 0x00001041,
+    FinishFirmwareUpload = 0x00001042,
+    ReadEventRequest     = 0x00001090,
+    WriteEventRequest    = 0x00001091,
 };
 
+/*
+ * Set in the reason of a request to let the hub queue it: the hub answers
+ * AcknowledgeQueued right away and the actual response is collected later with
+ * a GetResponse request, matched to the request by its sequence number.
+ */
+constexpr uint32_t kPacketReasonQueueFlag(0x80000000);
+
+/*
+ * The most requests the hub keeps queued at once; beyond that it answers
+ * NAcknowledgeBusy.
+ */
+constexpr size_t kPacketQueuedMax(4);
+
+/*
+ * Computes the CRC32 used by the hub for packets and firmware images. Buffers
+ * are zero padded to a multiple of 4 bytes.
+ */
+uint32_t Crc32(const uint8_t *buffer, int length);
+
 /*
  * A NanoPacket parsing engine. Used to take a stream of bytes and convert them
  * into an object that can more easily be worked with.
@@ -52,9 +76,10 @@ class NanoPacket : public NonCopyable {
         CrcMismatch,
     };
 
-    // Formats data into NanoPacket format in the provided buffer.
+    // Formats data into NanoPacket format in the provided buffer. A queued
+    // request may be answered out of order (see kPacketReasonQueueFlag).
     NanoPacket(uint32_t sequence_number, PacketReason reason,
-        const std::vector<uint8_t> *data = nullptr);
+        const std::vector<uint8_t> *data = nullptr, bool queued = false);
 
     // Creates an empty NanoPacket for data to be parsed into.
     NanoPacket();
@@ -72,12 +97,20 @@ class NanoPacket : public NonCopyable {
     // The entire content of the message.
     const std::vector<uint8_t>& packet_buffer() const;
 
+    // Obtains the sequence number of the packet. Responses carry the sequence
+    // number of the request they answer.
+    uint32_t sequence_number() const;
+
     // Obtains the reason for the packet.
     uint32_t reason() const;
 
-    // Obtains the reason as a PacketReason.
+    // Obtains the reason as a PacketReason, without kPacketReasonQueueFlag.
     PacketReason TypedReason() const;
 
+    // Indicates that the request was queued by the hub and its response has
+    // to be fetched with a GetResponse request.
+    bool IsQueuedAcknowledge() const;
+
     // Obtains the data content of the packet.
     const std::vector<uint8_t>& packet_content() const;
 
@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "nanopacketclient.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "log.h"
+
+namespace android {
+
+// Largest packet: 10 byte header, 255 byte payload, 4 byte CRC.
+constexpr size_t kPacketSizeMax(10 + 255 + 4);
+
+// Chunk payload after the 4 byte offset. A multiple of 4, so that the CRC the
+// hub chains over the chunks matches the CRC of the whole image.
+constexpr size_t kFirmwareChunkMax(248);
+
+// Polls of a response, or replies that make no progress, before giving up.
+constexpr int kPollMax(10000);
+
+// Default wait between polls of the hub.
+constexpr useconds_t kPollIntervalUs(1000);
+
+/*
+ * NanohubFirmwareChunkReply and NanohubFirmwareUploadReply in nanohubPacket.h.
+ */
+enum class FirmwareChunkReply : uint8_t {
+    Accepted,
+    Wait,
+    Resend,
+    Restart,
+    Cancel,
+    CancelNoRetry,
+    NoSpace,
+};
+
+enum class FirmwareUploadReply : uint8_t {
+    Success,
+    Processing,
+};
+
+// Appends a little-endian word to a buffer.
+static void AppendWord(std::vector<uint8_t>& buffer, uint32_t word) {
+    buffer.push_back(word);
+    buffer.push_back(word >> 8);
+    buffer.push_back(word >> 16);
+    buffer.push_back(word >> 24);
+}
+
+NanoPacketClient::NanoPacketClient(PacketTransport *transport)
+    : transport_(transport),
+      sequence_number_(0) {
+}
+
+NanoPacketClient::Result NanoPacketClient::Request(PacketReason reason,
+        const std::vector<uint8_t>& data, PacketResponse *response) {
+    NanoPacket request(++sequence_number_, reason, &data);
+    Result result = Transact(request, response);
+
+    if (result == Result::Queued) {
+        LOGE("Hub queued unqueueable request 0x%08x",
+            static_cast<uint32_t>(reason));
+        result = Result::ProtocolError;
+    }
+
+    return result;
+}
+
+NanoPacketClient::Result NanoPacketClient::Submit(PacketReason reason,
+        const std::vector<uint8_t>& data, uint32_t *sequence_number,
+        PacketResponse *response) {
+    NanoPacket request(++sequence_number_, reason, &data, true);
+    Result result = Transact(request, response);
+
+    *sequence_number = request.sequence_number();
+    if (result == Result::Queued) {
+        queued_[*sequence_number] = reason;
+    }
+
+    return result;
+}
+
+NanoPacketClient::Result NanoPacketClient::Collect(PacketResponse *response) {
+    NanoPacket request(++sequence_number_, PacketReason::GetResponse);
+    if (!transport_->Send(request.packet_buffer())) {
+        return Result::TransportError;
+    }
+
+    Result result = ReadPacket(response);
+    if (result != Result::Success) {
+        return result;
+    }
+
+    auto it = queued_.find(response->sequence_number);
+    if (it == queued_.end() || it->second != response->reason) {
+        LOGE("Response 0x%08x to seq %u does not match a queued request",
+            static_cast<uint32_t>(response->reason),
+            response->sequence_number);
+        return Result::ProtocolError;
+    }
+    queued_.erase(it);
+
+    return Result::Success;
+}
+
+NanoPacketClient::Result NanoPacketClient::Await(uint32_t sequence_number,
+        PacketResponse *response) {
+    for (int poll = 0; poll < kPollMax; poll++) {
+        auto it = collected_.find(sequence_number);
+        if (it != collected_.end()) {
+            *response = std::move(it->second);
+            collected_.erase(it);
+            return Result::Success;
+        }
+
+        if (queued_.find(sequence_number) == queued_.end()) {
+            LOGE("Seq %u is not queued", sequence_number);
+            return Result::ProtocolError;
+        }
+
+        PacketResponse collected;
+        Result result = Collect(&collected);
+        if (result == Result::Busy) {
+            Idle();
+        } else if (result != Result::Success) {
+            return result;
+        } else if (collected.sequence_number == sequence_number) {
+            *response = std::move(collected);
+            return Result::Success;
+        } else {
+            collected_[collected.sequence_number] = std::move(collected);
+        }
+    }
+
+    LOGE("Timed out waiting for seq %u", sequence_number);
+    return Result::TransportError;
+}
+
+bool NanoPacketClient::UploadFirmware(const std::vector<uint8_t>& image,
+        uint8_t type) {
+    PacketResponse response;
+    std::vector<uint8_t> start;
+    AppendWord(start, image.size());
+    AppendWord(start, ~Crc32(image.data(), image.size()));
+    start.push_back(type);
+
+    if (Request(PacketReason::StartFirmwareUpload, start, &response)
+            != Result::Success || response.content.empty()
+            || !response.content[0]) {
+        LOGE("Hub did not accept a %zu byte upload", image.size());
+        return false;
+    }
+
+    // One chunk at a time: the hub answers Resend to a chunk that arrives
+    // while it is still writing the previous one, so queueing more buys
+    // nothing. Queueing the one chunk frees the link for the idle callback.
+    size_t offset = 0;
+    int stalled = 0;
+    while (offset < image.size()) {
+        if (stalled++ == kPollMax) {
+            LOGE("Upload stalled at offset %zu", offset);
+            return false;
+        }
+
+        size_t length = std::min(kFirmwareChunkMax, image.size() - offset);
+        std::vector<uint8_t> chunk;
+        AppendWord(chunk, offset);
+        chunk.insert(chunk.end(), image.begin() + offset,
+            image.begin() + offset + length);
+
+        uint32_t sequence_number;
+        Result result = Submit(PacketReason::FirmwareChunk, chunk,
+            &sequence_number, &response);
+        if (result == Result::Queued) {
+            result = Await(sequence_number, &response);
+        } else if (result == Result::Busy) {
+            Idle();
+            continue;
+        }
+
+        if (result != Result::Success || response.content.empty()) {
+            LOGE("Chunk at offset %zu failed", offset);
+            return false;
+        }
+
+        switch (static_cast<FirmwareChunkReply>(response.content[0])) {
+          case FirmwareChunkReply::Accepted:
+            offset += length;
+            stalled = 0;
+            break;
+          case FirmwareChunkReply::Wait:
+          case FirmwareChunkReply::Resend:
+            Idle();
+            break;
+          case FirmwareChunkReply::Restart:
+            offset = 0;
+            break;
+          default:
+            LOGE("Hub cancelled the upload at offset %zu: %u", offset,
+                response.content[0]);
+            return false;
+        }
+    }
+
+    for (int poll = 0; poll < kPollMax; poll++) {
+        uint32_t sequence_number;
+        Result result = Submit(PacketReason::FinishFirmwareUpload,
+            std::vector<uint8_t>(), &sequence_number, &response);
+        if (result == Result::Queued) {
+            result = Await(sequence_number, &response);
+        } else if (result == Result::Busy) {
+            Idle();
+            continue;
+        }
+
+        if (result != Result::Success || response.content.empty()) {
+            LOGE("Finishing the upload failed");
+            return false;
+        }
+
+        switch (static_cast<FirmwareUploadReply>(response.content[0])) {
+          case FirmwareUploadReply::Success:
+            return true;
+          case FirmwareUploadReply::Processing:
+            Idle();
+            break;
+          default:
+            LOGE("Upload rejected: %u", response.content[0]);
+            return false;
+        }
+    }
+
+    LOGE("Timed out finishing the upload");
+    return false;
+}
+
+void NanoPacketClient::SetIdleCallback(std::function<void()> idle) {
+    idle_ = idle;
+}
+
+size_t NanoPacketClient::queued_count() const {
+    return queued_.size();
+}
+
+NanoPacketClient::Result NanoPacketClient::Transact(const NanoPacket& request,
+        PacketResponse *response) {
+    if (!transport_->Send(request.packet_buffer())) {
+        return Result::TransportError;
+    }
+
+    Result result = ReadPacket(response);
+    if (result != Result::Success) {
+        return result;
+    }
+
+    if (response->sequence_number != request.sequence_number()) {
+        LOGE("Response to seq %u for request seq %u",
+            response->sequence_number, request.sequence_number());
+        return Result::ProtocolError;
+    }
+
+    return Result::Success;
+}
+
+NanoPacketClient::Result NanoPacketClient::ReadPacket(
+        PacketResponse *response) {
+    NanoPacket packet;
+    uint8_t buffer[kPacketSizeMax];
+
+    while (!packet.ParsingIsComplete()) {
+        ssize_t length = transport_->Receive(buffer, sizeof(buffer));
+        if (length <= 0) {
+            return Result::TransportError;
+        }
+
+        size_t bytes_parsed = 0;
+        if (packet.Parse(buffer, length, &bytes_parsed)
+                == NanoPacket::ParseResult::CrcMismatch) {
+            LOGE("CRC mismatch in response");
+            return Result::ProtocolError;
+        }
+    }
+
+    response->sequence_number = packet.sequence_number();
+    response->reason = packet.TypedReason();
+    response->content = packet.packet_content();
+
+    switch (response->reason) {
+      case PacketReason::AcknowledgeQueued:
+        return Result::Queued;
+      case PacketReason::NAcknowledgeBusy:
+        return Result::Busy;
+      case PacketReason::NAcknowledge:
+        return Result::Rejected;
+      default:
+        return Result::Success;
+    }
+}
+
+void NanoPacketClient::Idle() {
+    if (idle_) {
+        idle_();
+    } else {
+        usleep(kPollIntervalUs);
+    }
+}
+
+}  // namespace android
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NANOPACKETCLIENT_H_
+#define NANOPACKETCLIENT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "nanopacket.h"
+#include "noncopyable.h"
+
+namespace android {
+
+/*
+ * A byte link to the hub that carries NanoPackets, e.g. a SPI or UART device.
+ */
+class PacketTransport {
+  public:
+    virtual ~PacketTransport() {};
+
+    // Writes a whole packet. Returns false on error.
+    virtual bool Send(const std::vector<uint8_t>& bytes) = 0;
+
+    // Reads the bytes of at most one packet into the buffer. Returns the
+    // number of bytes read, or a negative value on error.
+    virtual ssize_t Receive(uint8_t *buffer, size_t length) = 0;
+};
+
+/*
+ * A response from the hub, for the request with the same sequence number.
+ */
+struct PacketResponse {
+    uint32_t sequence_number;
+    PacketReason reason;
+    std::vector<uint8_t> content;
+};
+
+/*
+ * Talks the packet protocol to the hub over a PacketTransport, including
+ * queued requests (see kPacketReasonQueueFlag): a queued request does not hold
+ * the link while the hub handles it, so other requests can be made until its
+ * response is collected with GetResponse.
+ */
+class NanoPacketClient : public NonCopyable {
+  public:
+    /*
+     * The outcome of a request.
+     */
+    enum class Result {
+        Success,
+        Queued,         // Acknowledged with AcknowledgeQueued, see Await()
+        Busy,           // NAcknowledgeBusy
+        Rejected,       // NAcknowledge
+        TransportError,
+        ProtocolError,
+    };
+
+    explicit NanoPacketClient(PacketTransport *transport);
+
+    // Sends a request and waits for its response.
+    Result Request(PacketReason reason, const std::vector<uint8_t>& data,
+        PacketResponse *response);
+
+    // Sends a request the hub may queue. Returns Success with the response if
+    // the hub answered right away, or Queued with the sequence number to pass
+    // to Await(). Busy means kPacketQueuedMax requests are already queued.
+    Result Submit(PacketReason reason, const std::vector<uint8_t>& data,
+        uint32_t *sequence_number, PacketResponse *response);
+
+    // Fetches one finished response to a queued request, in any order. Busy
+    // means none is finished yet, Rejected that nothing is queued.
+    Result Collect(PacketResponse *response);
+
+    // Waits for the response to the queued request with the given sequence
+    // number. Responses to other queued requests are kept for their own
+    // Await(). The idle callback runs between polls.
+    Result Await(uint32_t sequence_number, PacketResponse *response);
+
+    // Uploads a firmware image with queued chunks, so the idle callback can
+    // keep reading events while the hub writes each chunk to flash.
+    bool UploadFirmware(const std::vector<uint8_t>& image, uint8_t type);
+
+    // Sets what to do while waiting on the hub, e.g. reading events. Sleeps
+    // kPollIntervalUs by default.
+    void SetIdleCallback(std::function<void()> idle);
+
+    // Number of requests queued on the hub and not yet collected.
+    size_t queued_count() const;
+
+  private:
+    PacketTransport *transport_;
+    uint32_t sequence_number_;
+    std::function<void()> idle_;
+
+    // Queued requests by sequence number: their reason, and their response
+    // once collected on behalf of another Await().
+    std::map<uint32_t, PacketReason> queued_;
+    std::map<uint32_t, PacketResponse> collected_;
+
+    // Sends one packet and reads the packet that answers it.
+    Result Transact(const NanoPacket& request, PacketResponse *response);
+
+    // Reads one packet from the transport.
+    Result ReadPacket(PacketResponse *response);
+
+    // Waits for the hub while it has nothing ready.
+    void Idle();
+};
+
+}  // namespace android
+
+#endif  // NANOPACKETCLIENT_H_
@@ -49,6 +49,12 @@ enum class NanotoolCommand {
     LoadCalibration,
     Flash,
     GetBridgeVer,
+    SleepStats,
+    SleepStatsReset,
+    BootStats,
+    LoadStats,
+    PoolStats,
+    PoolStatsReset,
 };
 
 struct ParsedArgs {
@@ -72,6 +78,12 @@ static NanotoolCommand StrToCommand(const char *command_name) {
         std::make_tuple("load_cal",    NanotoolCommand::LoadCalibration),
         std::make_tuple("flash",       NanotoolCommand::Flash),
         std::make_tuple("bridge_ver",  NanotoolCommand::GetBridgeVer),
+        std::make_tuple("sleep_stats", NanotoolCommand::SleepStats),
+        std::make_tuple("sleep_stats_reset", NanotoolCommand::SleepStatsReset),
+        std::make_tuple("boot_stats", NanotoolCommand::BootStats),
+        std::make_tuple("load_stats", NanotoolCommand::LoadStats),
+        std::make_tuple("pool_stats", NanotoolCommand::PoolStats),
+        std::make_tuple("pool_stats_reset", NanotoolCommand::PoolStatsReset),
     };
 
     if (!command_name) {
@@ -110,6 +122,17 @@ static void PrintUsage(const char *name) {
         "                           events, then disable the sensor before exiting\n"
         "                        read: output events for the given sensor, or all events\n"
         "                           if no sensor specified\n"
+        "                        sleep_stats: print the hub's sleep residency, wakeup\n"
+        "                           reasons and idle prediction error\n"
+        "                        sleep_stats_reset: same as sleep_stats, then clear them\n"
+        "                        boot_stats: print how long each phase of the hub's last\n"
+        "                           boot took and how many apps it had to verify\n"
+        "                        load_stats: print the hub's load level, dropped data\n"
+        "                           and the time spent shedding work\n"
+        "                        pool_stats: print how full the hub's OS pools and queues\n"
+        "                           are and have been, and what they refused or dropped\n"
+        "                        pool_stats_reset: same as pool_stats, then restart the\n"
+        "                           peaks and counters\n"
         "\n"
         "  -s, --sensor       Specify sensor type, and parameters for the command.\n"
         "                     Format is sensor_type[:rate[:latency_ms]][=cal_ref].\n"
@@ -488,6 +511,26 @@ int main(int argc, char **argv) {
         success = hub->PrintBridgeVersion();
         break;
       }
+      case NanotoolCommand::SleepStats:
+      case NanotoolCommand::SleepStatsReset: {
+        success = hub->PrintSleepStats(
+            args->command == NanotoolCommand::SleepStatsReset);
+        break;
+      }
+      case NanotoolCommand::BootStats: {
+        success = hub->PrintBootStats();
+        break;
+      }
+      case NanotoolCommand::LoadStats: {
+        success = hub->PrintLoadStats();
+        break;
+      }
+      case NanotoolCommand::PoolStats:
+      case NanotoolCommand::PoolStatsReset: {
+        success = hub->PrintPoolStats(
+            args->command == NanotoolCommand::PoolStatsReset);
+        break;
+      }
       default:
         LOGE("Command not implemented");
         return 1;
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2016 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Runs NanoPacketClient against a fake hub that queues requests the way
+ * os/core/hostIntf.c does, one background job per step.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "log.h"
+#include "nanopacket.h"
+#include "nanopacketclient.h"
+
+using namespace android;
+
+static int failures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+class StderrLogger : public Logger {
+  public:
+    void Output(const char *str) override {
+        fputs(str, stderr);
+    }
+
+    void Output(const char *format, va_list arg_list) override {
+        vfprintf(stderr, format, arg_list);
+    }
+};
+
+/*
+ * Firmware chunk and upload replies, see nanohubPacket.h.
+ */
+constexpr uint8_t kChunkAccepted(0);
+constexpr uint8_t kChunkResend(2);
+constexpr uint8_t kChunkRestart(3);
+constexpr uint8_t kUploadSuccess(0);
+constexpr uint8_t kUploadProcessing(1);
+constexpr uint8_t kUploadVerifyFailed(13);
+
+class FakeHub : public PacketTransport {
+  public:
+    // Offsets at which the first chunk gets Resend or Restart.
+    size_t resend_offset = SIZE_MAX;
+    size_t restart_offset = SIZE_MAX;
+
+    std::vector<uint8_t> image;
+    int events_while_queued = 0;
+
+    bool Send(const std::vector<uint8_t>& bytes) override {
+        NanoPacket request;
+        size_t bytes_parsed;
+        std::vector<uint8_t> copy(bytes);
+
+        if (request.Parse(copy.data(), copy.size(), &bytes_parsed)
+                != NanoPacket::ParseResult::Success) {
+            return false;
+        }
+
+        uint32_t seq = request.sequence_number();
+        PacketReason reason = request.TypedReason();
+        const std::vector<uint8_t>& content = request.packet_content();
+        bool queued = request.reason() & kPacketReasonQueueFlag;
+
+        if (reason == PacketReason::GetResponse) {
+            if (!done_.empty()) {
+                // Hand them out newest first; the client must match by seq.
+                Reply(done_.back());
+                done_.pop_back();
+            } else if (jobs_.empty()) {
+                Reply(seq, PacketReason::NAcknowledge);
+            } else {
+                Reply(seq, PacketReason::NAcknowledgeBusy);
+            }
+        } else if (reason == PacketReason::ReadEventRequest) {
+            if (!jobs_.empty()) {
+                events_while_queued++;
+            }
+            Reply(seq, PacketReason::ReadEventRequest);
+        } else if (reason == PacketReason::StartFirmwareUpload) {
+            size_ = content[0] | content[1] << 8 | content[2] << 16
+                | content[3] << 24;
+            crc_ = content[4] | content[5] << 8 | content[6] << 16
+                | content[7] << 24;
+            image.clear();
+            processed_ = false;
+            Reply(seq, reason, 1);
+        } else if (!queued) {
+            Reply(Handle(seq, reason, content));
+        } else if (jobs_.size() == kPacketQueuedMax) {
+            Reply(seq, PacketReason::NAcknowledgeBusy);
+        } else {
+            jobs_.push_back(Job{seq, reason, content});
+            Reply(seq, PacketReason::AcknowledgeQueued);
+        }
+
+        return true;
+    }
+
+    ssize_t Receive(uint8_t *buffer, size_t length) override {
+        if (replies_.empty() || replies_.front().size() > length) {
+            return -1;
+        }
+
+        size_t size = replies_.front().size();
+        memcpy(buffer, replies_.front().data(), size);
+        replies_.pop_front();
+        return size;
+    }
+
+    // Runs the oldest queued request, as the hub's deferred job would.
+    void Step() {
+        if (jobs_.empty()) {
+            return;
+        }
+
+        Job job = jobs_.front();
+        jobs_.pop_front();
+        done_.push_back(Handle(job.seq, job.reason, job.content));
+    }
+
+    size_t queued() const {
+        return jobs_.size() + done_.size();
+    }
+
+  private:
+    struct Job {
+        uint32_t seq;
+        PacketReason reason;
+        std::vector<uint8_t> content;
+    };
+
+    std::deque<Job> jobs_;
+    std::vector<std::vector<uint8_t>> done_;
+    std::deque<std::vector<uint8_t>> replies_;
+    uint32_t size_ = 0;
+    uint32_t crc_ = 0;
+    bool processed_ = false;
+
+    std::vector<uint8_t> Handle(uint32_t seq, PacketReason reason,
+            const std::vector<uint8_t>& content) {
+        if (reason == PacketReason::FirmwareChunk) {
+            size_t offset = content[0] | content[1] << 8 | content[2] << 16
+                | content[3] << 24;
+
+            if (offset == resend_offset) {
+                resend_offset = SIZE_MAX;
+                return Packet(seq, reason, kChunkResend);
+            } else if (offset == restart_offset || offset != image.size()) {
+                restart_offset = SIZE_MAX;
+                image.clear();
+                return Packet(seq, reason, kChunkRestart);
+            }
+
+            image.insert(image.end(), content.begin() + 4, content.end());
+            return Packet(seq, reason, kChunkAccepted);
+        } else if (reason == PacketReason::FinishFirmwareUpload) {
+            if (!processed_) {
+                processed_ = true;
+                return Packet(seq, reason, kUploadProcessing);
+            }
+
+            bool valid = image.size() == size_
+                && ~Crc32(image.data(), image.size()) == crc_;
+            return Packet(seq, reason,
+                valid ? kUploadSuccess : kUploadVerifyFailed);
+        }
+
+        return Packet(seq, PacketReason::NAcknowledge);
+    }
+
+    static std::vector<uint8_t> Packet(uint32_t seq, PacketReason reason) {
+        return NanoPacket(seq, reason).packet_buffer();
+    }
+
+    static std::vector<uint8_t> Packet(uint32_t seq, PacketReason reason,
+            uint8_t reply) {
+        std::vector<uint8_t> data(1, reply);
+        return NanoPacket(seq, reason, &data).packet_buffer();
+    }
+
+    void Reply(const std::vector<uint8_t>& packet) {
+        replies_.push_back(packet);
+    }
+
+    void Reply(uint32_t seq, PacketReason reason) {
+        Reply(Packet(seq, reason));
+    }
+
+    void Reply(uint32_t seq, PacketReason reason, uint8_t reply) {
+        Reply(Packet(seq, reason, reply));
+    }
+};
+
+static std::vector<uint8_t> MakeImage(size_t size) {
+    std::vector<uint8_t> image(size);
+
+    for (size_t i = 0; i < size; i++) {
+        image[i] = i * 37 + (i >> 8);
+    }
+
+    return image;
+}
+
+// Uploads with queued chunks, reading events while each one is in flight.
+static void TestUpload() {
+    FakeHub hub;
+    NanoPacketClient client(&hub);
+    std::vector<uint8_t> image = MakeImage(1001);
+    PacketResponse event;
+
+    hub.resend_offset = 248;
+    hub.restart_offset = 496;
+    client.SetIdleCallback([&]() {
+        CHECK(client.Request(PacketReason::ReadEventRequest,
+            std::vector<uint8_t>(), &event)
+            == NanoPacketClient::Result::Success);
+        hub.Step();
+    });
+
+    CHECK(client.UploadFirmware(image, 1));
+    CHECK(hub.image == image);
+    CHECK(hub.events_while_queued > 0);
+    CHECK(client.queued_count() == 0);
+    CHECK(hub.queued() == 0);
+}
+
+// Responses collected out of order are handed to the right Await().
+static void TestAwaitMatchesSequence() {
+    FakeHub hub;
+    NanoPacketClient client(&hub);
+    std::vector<uint8_t> chunk_at_0 = {0, 0, 0, 0, 0xaa, 0xbb, 0xcc, 0xdd};
+    std::vector<uint8_t> chunk_at_8 = {8, 0, 0, 0, 0xaa, 0xbb, 0xcc, 0xdd};
+    uint32_t first, second;
+    PacketResponse response;
+
+    client.SetIdleCallback([&]() { hub.Step(); });
+
+    CHECK(client.Submit(PacketReason::FirmwareChunk, chunk_at_0, &first,
+        &response) == NanoPacketClient::Result::Queued);
+    CHECK(client.Submit(PacketReason::FirmwareChunk, chunk_at_8, &second,
+        &response) == NanoPacketClient::Result::Queued);
+    CHECK(client.queued_count() == 2);
+
+    // Both finish before the first poll; the hub returns the second first.
+    hub.Step();
+    hub.Step();
+    CHECK(client.Await(first, &response) == NanoPacketClient::Result::Success);
+    CHECK(response.sequence_number == first);
+    CHECK(response.content.size() == 1 && response.content[0] == kChunkAccepted);
+
+    CHECK(client.Await(second, &response)
+        == NanoPacketClient::Result::Success);
+    CHECK(response.sequence_number == second);
+    CHECK(response.content.size() == 1 && response.content[0] == kChunkRestart);
+    CHECK(client.queued_count() == 0);
+
+    CHECK(client.Collect(&response) == NanoPacketClient::Result::Rejected);
+}
+
+// The hub refuses to queue more than kPacketQueuedMax requests.
+static void TestQueueFull() {
+    FakeHub hub;
+    NanoPacketClient client(&hub);
+    uint32_t seq;
+    PacketResponse response;
+
+    for (size_t i = 0; i < kPacketQueuedMax; i++) {
+        CHECK(client.Submit(PacketReason::FinishFirmwareUpload,
+            std::vector<uint8_t>(), &seq, &response)
+            == NanoPacketClient::Result::Queued);
+    }
+    CHECK(client.Submit(PacketReason::FinishFirmwareUpload,
+        std::vector<uint8_t>(), &seq, &response)
+        == NanoPacketClient::Result::Busy);
+    CHECK(client.queued_count() == kPacketQueuedMax);
+
+    CHECK(client.Collect(&response) == NanoPacketClient::Result::Busy);
+    hub.Step();
+    CHECK(client.Collect(&response) == NanoPacketClient::Result::Success);
+    CHECK(client.queued_count() == kPacketQueuedMax - 1);
+}
+
+int main() {
+    StderrLogger logger;
+    Log::Initialize(&logger, Log::LogLevel::Warn);
+
+    TestUpload();
+    TestAwaitMatchesSequence();
+    TestQueueFull();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}